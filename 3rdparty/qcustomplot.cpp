@@ -708,6 +708,14 @@ void QCPScatterStyle::drawShape(QCPPainter *painter, double x, double y) const
   
   When a layer is deleted, the objects on it are not deleted with it, but fall on the layer below
   the deleted layer, see QCustomPlot::removeLayer.
+  
+  Layers whose content rarely changes (e.g. "background", "grid" and "axes" when only graph data is
+  updated) can be rendered into a pixmap cache with \ref setCached. During \ref QCustomPlot::replot
+  a cached layer is only redrawn when its cache is dirty, otherwise the cached pixmap is composited
+  in its place. The caches are invalidated automatically when the viewport, axis rect geometry, axis
+  ranges, selection state or antialiasing settings change. Changing the appearance of a layerable on
+  a cached layer in any other way (e.g. a new axis pen) requires a call to \ref invalidateCache or
+  \ref QCustomPlot::invalidateLayerCaches.
 */
 
 /* start documentation of inline functions */
@@ -741,7 +749,9 @@ QCPLayer::QCPLayer(QCustomPlot *parentPlot, const QString &layerName) :
   mParentPlot(parentPlot),
   mName(layerName),
   mIndex(-1), // will be set to a proper value by the QCustomPlot layer creation function
-  mVisible(true)
+  mVisible(true),
+  mCached(false),
+  mCacheDirty(true)
 {
   // Note: no need to make sure layerName is unique, because layer
   // management is done with QCustomPlot functions.
@@ -772,6 +782,41 @@ QCPLayer::~QCPLayer()
 void QCPLayer::setVisible(bool visible)
 {
   mVisible = visible;
+  mCacheDirty = true;
+}
+
+/*!
+  Sets whether this layer is rendered into a pixmap cache. If \a enabled is true, \ref
+  QCustomPlot::replot draws the layerables of this layer only when the cache is dirty and otherwise
+  composites the cached pixmap. This is useful for layers that don't change when only plottable data
+  is updated, like "background", "grid" and "axes".
+  
+  Cached layers are only used for replots on the widget surface. Exports (\ref QCustomPlot::savePdf,
+  \ref QCustomPlot::toPixmap, etc.) always draw all layers directly.
+  
+  \see invalidateCache, QCustomPlot::invalidateLayerCaches
+*/
+void QCPLayer::setCached(bool enabled)
+{
+  if (mCached != enabled)
+  {
+    mCached = enabled;
+    mCacheDirty = true;
+    if (!mCached)
+      mCache = QPixmap();
+  }
+}
+
+/*!
+  Marks the pixmap cache of this layer as dirty, so the layerables are redrawn on the next \ref
+  QCustomPlot::replot. Call this after changing the appearance of a layerable on a cached layer in a
+  way that isn't detected automatically (see the QCPLayer documentation).
+  
+  \see setCached
+*/
+void QCPLayer::invalidateCache()
+{
+  mCacheDirty = true;
 }
 
 /*! \internal
@@ -792,6 +837,7 @@ void QCPLayer::addChild(QCPLayerable *layerable, bool prepend)
       mChildren.prepend(layerable);
     else
       mChildren.append(layerable);
+    mCacheDirty = true;
   } else
     qDebug() << Q_FUNC_INFO << "layerable is already child of this layer" << reinterpret_cast<quintptr>(layerable);
 }
@@ -807,7 +853,9 @@ void QCPLayer::addChild(QCPLayerable *layerable, bool prepend)
 */
 void QCPLayer::removeChild(QCPLayerable *layerable)
 {
-  if (!mChildren.removeOne(layerable))
+  if (mChildren.removeOne(layerable))
+    mCacheDirty = true;
+  else
     qDebug() << Q_FUNC_INFO << "layerable is not child of this layer" << reinterpret_cast<quintptr>(layerable);
 }
 
@@ -10372,7 +10420,10 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
     painter.setRenderHint(QPainter::HighQualityAntialiasing); // to make Antialiasing look good if using the OpenGL graphicssystem
     if (mBackgroundBrush.style() != Qt::SolidPattern && mBackgroundBrush.style() != Qt::NoBrush)
       painter.fillRect(mViewport, mBackgroundBrush);
-    draw(&painter);
+    if (hasCachedLayers())
+      drawCached(&painter);
+    else
+      draw(&painter);
     painter.end();
     if ((refreshPriority == rpHint && mPlottingHints.testFlag(QCP::phForceRepaint)) || refreshPriority==rpImmediate)
       repaint();
@@ -10877,19 +10928,7 @@ void QCustomPlot::draw(QCPPainter *painter)
 
   // draw all layered objects (grid, axes, plottables, items, legend,...):
   foreach (QCPLayer *layer, mLayers)
-  {
-    foreach (QCPLayerable *child, layer->children())
-    {
-      if (child->realVisibility())
-      {
-        painter->save();
-        painter->setClipRect(child->clipRect().translated(0, -1));
-        child->applyDefaultAntialiasingHint(painter);
-        child->draw(painter);
-        painter->restore();
-      }
-    }
-  }
+    drawLayer(painter, layer);
   
   /* Debug code to draw all layout element rects
   foreach (QCPLayoutElement* el, findChildren<QCPLayoutElement*>())
@@ -10903,6 +10942,131 @@ void QCustomPlot::draw(QCPPainter *painter)
   */
 }
 
+/*! \internal
+  
+  Draws all visible layerables of \a layer with the specified \a painter, in the order of the
+  layer's children.
+*/
+void QCustomPlot::drawLayer(QCPPainter *painter, QCPLayer *layer)
+{
+  foreach (QCPLayerable *child, layer->children())
+  {
+    if (child->realVisibility())
+    {
+      painter->save();
+      painter->setClipRect(child->clipRect().translated(0, -1));
+      child->applyDefaultAntialiasingHint(painter);
+      child->draw(painter);
+      painter->restore();
+    }
+  }
+}
+
+/*! \internal
+  
+  Same as \ref draw, but layers with \ref QCPLayer::setCached enabled are taken from their pixmap
+  cache. A layer cache is redrawn only if it is dirty, if its size doesn't match the paint buffer, or
+  if the \ref layerCacheKey changed since the last replot. Layers without caching are drawn directly,
+  so a replot after a data-only change just redraws the plottables and composites the cached layers
+  around them.
+  
+  This is used by \ref replot only. Exports go through \ref draw and always render every layer.
+*/
+void QCustomPlot::drawCached(QCPPainter *painter)
+{
+  // run through layout phases:
+  mPlotLayout->update(QCPLayoutElement::upPreparation);
+  mPlotLayout->update(QCPLayoutElement::upMargins);
+  mPlotLayout->update(QCPLayoutElement::upLayout);
+  
+  // anything that moves the cached layerables invalidates all caches:
+  QVector<double> cacheKey = layerCacheKey();
+  if (cacheKey != mLayerCacheKey)
+  {
+    mLayerCacheKey = cacheKey;
+    invalidateLayerCaches();
+  }
+  
+  // draw viewport background pixmap:
+  drawBackground(painter);
+  
+  foreach (QCPLayer *layer, mLayers)
+  {
+    if (!layer->cached())
+    {
+      drawLayer(painter, layer);
+      continue;
+    }
+    if (layer->mCacheDirty || layer->mCache.size() != mPaintBuffer.size())
+    {
+      if (layer->mCache.size() != mPaintBuffer.size())
+        layer->mCache = QPixmap(mPaintBuffer.size());
+      layer->mCache.fill(Qt::transparent);
+      QCPPainter cachePainter(&layer->mCache);
+      if (cachePainter.isActive())
+      {
+        cachePainter.setRenderHint(QPainter::HighQualityAntialiasing);
+        drawLayer(&cachePainter, layer);
+        cachePainter.end();
+        layer->mCacheDirty = false;
+      } else
+      {
+        // fall back to direct drawing if the cache can't be painted on:
+        drawLayer(painter, layer);
+        continue;
+      }
+    }
+    painter->drawPixmap(0, 0, layer->mCache);
+  }
+}
+
+/*! \internal
+  
+  Returns whether at least one layer has \ref QCPLayer::setCached enabled.
+*/
+bool QCustomPlot::hasCachedLayers() const
+{
+  foreach (QCPLayer *layer, mLayers)
+  {
+    if (layer->cached())
+      return true;
+  }
+  return false;
+}
+
+/*! \internal
+  
+  Returns a summary of the plot state that determines the appearance of typically cached layers:
+  viewport, antialiasing settings, plottable and item counts, axis rect geometry and the range and
+  selection state of all axes. When this key changes between two replots, all layer caches are
+  invalidated.
+*/
+QVector<double> QCustomPlot::layerCacheKey() const
+{
+  QVector<double> key;
+  key << mViewport.x() << mViewport.y() << mViewport.width() << mViewport.height();
+  key << int(mAntialiasedElements) << int(mNotAntialiasedElements);
+  key << mPlottables.size() << mItems.size();
+  foreach (QCPAxisRect *rect, axisRects())
+  {
+    key << rect->left() << rect->top() << rect->width() << rect->height();
+    foreach (QCPAxis *axis, rect->axes())
+      key << axis->range().lower << axis->range().upper << int(axis->selectedParts());
+  }
+  return key;
+}
+
+/*!
+  Marks the pixmap caches of all layers as dirty, so they are redrawn on the next \ref replot.
+  
+  \see QCPLayer::setCached, QCPLayer::invalidateCache
+*/
+void QCustomPlot::invalidateLayerCaches()
+{
+  foreach (QCPLayer *layer, mLayers)
+    layer->invalidateCache();
+}
+
 /*! \internal
   
   Draws the viewport background pixmap of the plot.
@@ -14410,6 +14574,360 @@ QCPData::QCPData(double key, double value) :
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataLod
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPDataLod
+  \brief Hierarchical min/max summary of a QCPDataMap, used by QCPGraph for adaptive sampling
+  
+  The data points are grouped into leaves of \ref LeafSize consecutive points. Each leaf stores the
+  key span, the value extrema and the number of points it covers. Every higher level summarizes
+  pairs of nodes of the level below, so the value extrema of any run of leaves can be obtained in
+  O(log n) with \ref minMax.
+  
+  The summary is maintained incrementally as long as data is appended in ascending key order (\ref
+  append) and removed from the front (\ref removeBefore), which is the typical pattern of streaming
+  plots. Any other modification invalidates it and it is rebuilt on the next \ref synchronize.
+  Leaves are addressed with absolute indices that stay stable when leaves are dropped from the
+  front.
+  
+  QCPGraph keeps one instance per graph, so \ref QCPGraph::getPreparedData can produce the per-pixel
+  extrema in O(pixels*log n) instead of iterating every visible data point.
+*/
+
+/*!
+  Constructs an empty, valid summary.
+*/
+QCPDataLod::QCPDataLod() :
+  mFirstLeaf(0),
+  mDirtyLeaf(-1),
+  mCount(0),
+  mValid(true)
+{
+}
+
+/*!
+  Removes all nodes. The summary is valid afterwards and corresponds to an empty data map.
+*/
+void QCPDataLod::clear()
+{
+  mLevels.clear();
+  mOffsets.clear();
+  mFirstLeaf = 0;
+  mDirtyLeaf = -1;
+  mCount = 0;
+  mValid = true;
+}
+
+/*!
+  Returns whether the summary is valid and consistent with \a data, i.e. it covers the same number
+  of points and the same key span.
+*/
+bool QCPDataLod::isSynchronized(const QCPDataMap *data) const
+{
+  if (!mValid || mCount != data->size())
+    return false;
+  if (mCount == 0)
+    return true;
+  return node(0, mFirstLeaf).firstKey == data->constBegin().key() &&
+         node(0, leafEnd()-1).lastKey == (data->constEnd()-1).key();
+}
+
+/*!
+  Brings the summary up to date with \a data. If it is consistent with \a data, only the ancestors
+  of leaves changed since the last call are recalculated, otherwise the whole summary is rebuilt.
+*/
+void QCPDataLod::synchronize(const QCPDataMap *data)
+{
+  if (isSynchronized(data))
+    update();
+  else
+    rebuild(data);
+}
+
+/*!
+  Adds a data point with \a key and \a value to the last leaf, or starts a new leaf if the last one
+  is full. If \a key is smaller than the last key in the summary, the summary is invalidated.
+  
+  Ancestor nodes are not updated here, call \ref synchronize before querying.
+*/
+void QCPDataLod::append(double key, double value)
+{
+  if (!mValid)
+    return;
+  if (mCount == 0)
+    clear();
+  else if (key < node(0, leafEnd()-1).lastKey)
+  {
+    mValid = false;
+    return;
+  }
+  
+  if (mLevels.isEmpty())
+  {
+    mLevels.append(QVector<Node>());
+    mOffsets.append(0);
+  }
+  QVector<Node> &leaves = mLevels[0];
+  if (leaves.isEmpty() || leaves.last().count >= LeafSize)
+  {
+    Node leaf;
+    leaf.firstKey = key;
+    leaf.lastKey = key;
+    leaf.minValue = value;
+    leaf.maxValue = value;
+    leaf.count = 1;
+    leaves.append(leaf);
+  } else
+  {
+    Node &leaf = leaves.last();
+    leaf.lastKey = key;
+    if (value < leaf.minValue || qIsNaN(leaf.minValue))
+      leaf.minValue = value;
+    if (value > leaf.maxValue || qIsNaN(leaf.maxValue))
+      leaf.maxValue = value;
+    ++leaf.count;
+  }
+  ++mCount;
+  
+  int leaf = leafEnd()-1;
+  if (mDirtyLeaf < 0 || leaf < mDirtyLeaf)
+    mDirtyLeaf = leaf;
+}
+
+/*!
+  Adjusts the summary after data points at the front of \a data were removed (see \ref
+  QCPGraph::removeDataBefore). Leaves that lie completely before the first remaining key are
+  dropped, a partially removed leaf is recalculated from \a data.
+*/
+void QCPDataLod::removeBefore(const QCPDataMap *data)
+{
+  if (!mValid || mCount == 0)
+    return;
+  if (data->isEmpty())
+  {
+    clear();
+    return;
+  }
+  
+  const double firstKey = data->constBegin().key();
+  const int end = leafEnd();
+  while (mFirstLeaf < end && node(0, mFirstLeaf).lastKey < firstKey)
+  {
+    mCount -= node(0, mFirstLeaf).count;
+    ++mFirstLeaf;
+  }
+  if (mFirstLeaf == end)
+  {
+    mValid = false;
+    return;
+  }
+  
+  Node &leaf = mLevels[0][mFirstLeaf-mOffsets.at(0)];
+  if (leaf.firstKey < firstKey)
+  {
+    // recalculate the partially removed leaf from the remaining points:
+    mCount -= leaf.count;
+    QCPDataMap::const_iterator it = data->constBegin();
+    leaf.firstKey = it.key();
+    leaf.minValue = it.value().value;
+    leaf.maxValue = it.value().value;
+    leaf.count = 0;
+    while (it != data->constEnd() && it.key() <= leaf.lastKey)
+    {
+      if (it.value().value < leaf.minValue || qIsNaN(leaf.minValue))
+        leaf.minValue = it.value().value;
+      if (it.value().value > leaf.maxValue || qIsNaN(leaf.maxValue))
+        leaf.maxValue = it.value().value;
+      ++leaf.count;
+      ++it;
+    }
+    mCount += leaf.count;
+    updateAncestors(mFirstLeaf);
+  }
+  compact();
+}
+
+/*!
+  Returns the absolute index of the first leaf whose first key is greater or equal to \a key. If
+  there is no such leaf, the index one past the last leaf is returned.
+*/
+int QCPDataLod::lowerLeaf(double key) const
+{
+  int low = mFirstLeaf;
+  int high = leafEnd();
+  while (low < high)
+  {
+    int mid = low+(high-low)/2;
+    if (node(0, mid).firstKey < key)
+      low = mid+1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+/*!
+  Returns the absolute index of the first leaf whose last key is greater than \a key. If there is
+  no such leaf, the index one past the last leaf is returned.
+*/
+int QCPDataLod::upperLeaf(double key) const
+{
+  int low = mFirstLeaf;
+  int high = leafEnd();
+  while (low < high)
+  {
+    int mid = low+(high-low)/2;
+    if (node(0, mid).lastKey <= key)
+      low = mid+1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+/*!
+  Expands \a minValue and \a maxValue by the value extrema of the leaves \a beginLeaf (inclusive)
+  to \a endLeaf (exclusive) and adds the number of points in those leaves to \a count. NaN values
+  in \a minValue and \a maxValue are replaced.
+  
+  The summary must be up to date (\ref isUpToDate).
+*/
+void QCPDataLod::minMax(int beginLeaf, int endLeaf, double &minValue, double &maxValue, int &count) const
+{
+  Node result;
+  result.firstKey = 0;
+  result.lastKey = 0;
+  result.minValue = minValue;
+  result.maxValue = maxValue;
+  result.count = count;
+  for (int level=0; beginLeaf < endLeaf; ++level)
+  {
+    if (beginLeaf & 1)
+      mergeNode(result, node(level, beginLeaf++));
+    if (endLeaf & 1)
+      mergeNode(result, node(level, --endLeaf));
+    beginLeaf >>= 1;
+    endLeaf >>= 1;
+  }
+  minValue = result.minValue;
+  maxValue = result.maxValue;
+  count = result.count;
+}
+
+/*! \internal
+  
+  Discards the current summary and builds a new one from all points in \a data.
+*/
+void QCPDataLod::rebuild(const QCPDataMap *data)
+{
+  clear();
+  QCPDataMap::const_iterator it;
+  for (it = data->constBegin(); it != data->constEnd(); ++it)
+    append(it.key(), it.value().value);
+  update();
+}
+
+/*! \internal
+  
+  Recalculates all ancestors of the leaves appended since the last update on every existing level,
+  and creates new levels until the top level consists of a single node.
+*/
+void QCPDataLod::update()
+{
+  if (!mValid || mDirtyLeaf < 0)
+    return;
+  
+  const int lastLeaf = leafEnd()-1;
+  int from = qMax(mDirtyLeaf, mFirstLeaf);
+  for (int level=1; level < mLevels.size() || (mFirstLeaf >> (level-1)) < (lastLeaf >> (level-1)); ++level)
+  {
+    from >>= 1;
+    if (level == mLevels.size())
+    {
+      mLevels.append(QVector<Node>());
+      mOffsets.append(mFirstLeaf >> level);
+      from = mFirstLeaf >> level; // a new level needs all its nodes
+    }
+    const int offset = mOffsets.at(level);
+    const int to = lastLeaf >> level;
+    from = qMax(from, offset);
+    QVector<Node> &nodes = mLevels[level];
+    nodes.resize(to-offset+1);
+    for (int i=from; i<=to; ++i)
+      nodes[i-offset] = mergedChildren(level, i);
+  }
+  mDirtyLeaf = -1;
+}
+
+/*! \internal
+  
+  Recalculates the ancestors of the single \a leaf on all existing levels.
+*/
+void QCPDataLod::updateAncestors(int leaf)
+{
+  for (int level=1; level<mLevels.size(); ++level)
+  {
+    int index = (leaf >> level)-mOffsets.at(level);
+    if (index < 0 || index >= mLevels.at(level).size())
+      break;
+    mLevels[level][index] = mergedChildren(level, leaf >> level);
+  }
+}
+
+/*! \internal
+  
+  Returns the summary of the children of node \a index on \a level. Children that don't hold data
+  anymore (dropped from the front) are skipped.
+*/
+QCPDataLod::Node QCPDataLod::mergedChildren(int level, int index) const
+{
+  const int childBegin = qMax(index*2, qMax(mOffsets.at(level-1), mFirstLeaf >> (level-1)));
+  const int childEnd = qMin(index*2+2, mOffsets.at(level-1)+mLevels.at(level-1).size());
+  Node result = node(level-1, childBegin);
+  for (int i=childBegin+1; i<childEnd; ++i)
+    mergeNode(result, node(level-1, i));
+  return result;
+}
+
+/*! \internal
+  
+  Releases the memory of dropped leaves and their ancestors once they make up more than half of the
+  leaf level.
+*/
+void QCPDataLod::compact()
+{
+  const int dropped = mFirstLeaf-mOffsets.at(0);
+  if (dropped < 64 || dropped < mLevels.at(0).size()/2)
+    return;
+  for (int level=0; level<mLevels.size(); ++level)
+  {
+    int count = qMin((mFirstLeaf >> level)-mOffsets.at(level), mLevels.at(level).size());
+    if (count > 0)
+    {
+      mLevels[level].remove(0, count);
+      mOffsets[level] += count;
+    }
+  }
+}
+
+/*! \internal
+  
+  Merges \a source into \a target, which must precede \a source in key order. NaN extrema are
+  ignored unless both nodes only hold NaN values.
+*/
+void QCPDataLod::mergeNode(Node &target, const Node &source)
+{
+  target.lastKey = source.lastKey;
+  if (source.minValue < target.minValue || qIsNaN(target.minValue))
+    target.minValue = source.minValue;
+  if (source.maxValue > target.maxValue || qIsNaN(target.maxValue))
+    target.maxValue = source.maxValue;
+  target.count += source.count;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPGraph
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -14459,6 +14977,10 @@ QCPData::QCPData(double key, double value) :
   Returns a pointer to the internal data storage of type \ref QCPDataMap. You may use it to
   directly manipulate the data, which may be more convenient and faster than using the regular \ref
   setData or \ref addData methods, in certain situations.
+  
+  Direct manipulation bypasses the incremental update of the graph's level-of-detail summary (see
+  \ref setAdaptiveSampling). It is rebuilt on the next replot if the point count or the key span
+  changed. If data is replaced without changing either, call \ref setData instead.
 */
 
 /* end of documentation of inline functions */
@@ -14491,6 +15013,7 @@ QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   setErrorBarSkipSymbol(true);
   setChannelFillGraph(0);
   setAdaptiveSampling(true);
+  setAdaptiveSamplingResolution(1.0);
 }
 
 QCPGraph::~QCPGraph()
@@ -14523,6 +15046,7 @@ void QCPGraph::setData(QCPDataMap *data, bool copy)
     delete mData;
     mData = data;
   }
+  mLod.invalidate();
 }
 
 /*! \overload
@@ -14534,6 +15058,7 @@ void QCPGraph::setData(QCPDataMap *data, bool copy)
 void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
 {
   mData->clear();
+  mLod.invalidate();
   int n = key.size();
   n = qMin(n, value.size());
   QCPData newData;
@@ -14557,6 +15082,7 @@ void QCPGraph::setData(const QVector<double> &key, const QVector<double> &value)
 void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &valueError)
 {
   mData->clear();
+  mLod.invalidate();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, valueError.size());
@@ -14583,6 +15109,7 @@ void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<doubl
 void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &valueErrorMinus, const QVector<double> &valueErrorPlus)
 {
   mData->clear();
+  mLod.invalidate();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, valueErrorMinus.size());
@@ -14610,6 +15137,7 @@ void QCPGraph::setDataValueError(const QVector<double> &key, const QVector<doubl
 void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyError)
 {
   mData->clear();
+  mLod.invalidate();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, keyError.size());
@@ -14636,6 +15164,7 @@ void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double>
 void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyErrorMinus, const QVector<double> &keyErrorPlus)
 {
   mData->clear();
+  mLod.invalidate();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, keyErrorMinus.size());
@@ -14663,6 +15192,7 @@ void QCPGraph::setDataKeyError(const QVector<double> &key, const QVector<double>
 void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyError, const QVector<double> &valueError)
 {
   mData->clear();
+  mLod.invalidate();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, valueError.size());
@@ -14692,6 +15222,7 @@ void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double
 void QCPGraph::setDataBothError(const QVector<double> &key, const QVector<double> &value, const QVector<double> &keyErrorMinus, const QVector<double> &keyErrorPlus, const QVector<double> &valueErrorMinus, const QVector<double> &valueErrorPlus)
 {
   mData->clear();
+  mLod.invalidate();
   int n = key.size();
   n = qMin(n, value.size());
   n = qMin(n, valueErrorMinus.size());
@@ -14839,12 +15370,32 @@ void QCPGraph::setChannelFillGraph(QCPGraph *targetGraph)
   sampling off. For example, when saving the plot to disk. This can be achieved by setting \a
   enabled to false before issuing a command like \ref QCustomPlot::savePng, and setting \a enabled
   back to true afterwards.
+  
+  For line plots with many data points per pixel, the per-pixel extrema are taken from a
+  hierarchical min/max summary of the data (QCPDataLod) instead of iterating every visible point.
+  The summary is updated incrementally by \ref addData and \ref removeDataBefore, so zooming out on
+  long streamed data sets stays fast.
 */
 void QCPGraph::setAdaptiveSampling(bool enabled)
 {
   mAdaptiveSampling = enabled;
 }
 
+/*!
+  Sets the width of the key intervals, in pixels, that adaptive sampling consolidates into one
+  cluster of line points. The default of 1 pixel reproduces the line without visible difference.
+  Larger values produce fewer line points and thus faster, but coarser, line drawing, which is
+  useful to keep a plot responsive under heavy load. Values below 1 are clamped to 1.
+  
+  This only affects line plots, scatter plots are always sampled at single pixel resolution.
+  
+  \see setAdaptiveSampling
+*/
+void QCPGraph::setAdaptiveSamplingResolution(double pixels)
+{
+  mAdaptiveSamplingResolution = qMax(1.0, pixels);
+}
+
 /*!
   Adds the provided data points in \a dataMap to the current data.
   
@@ -14855,6 +15406,9 @@ void QCPGraph::setAdaptiveSampling(bool enabled)
 */
 void QCPGraph::addData(const QCPDataMap &dataMap)
 {
+  QCPDataMap::const_iterator it;
+  for (it = dataMap.constBegin(); it != dataMap.constEnd(); ++it)
+    mLod.append(it.key(), it.value().value);
   mData->unite(dataMap);
 }
 
@@ -14869,6 +15423,7 @@ void QCPGraph::addData(const QCPDataMap &dataMap)
 void QCPGraph::addData(const QCPData &data)
 {
   mData->insertMulti(data.key, data);
+  mLod.append(data.key, data.value);
 }
 
 /*! \overload
@@ -14885,6 +15440,7 @@ void QCPGraph::addData(double key, double value)
   newData.key = key;
   newData.value = value;
   mData->insertMulti(newData.key, newData);
+  mLod.append(key, value);
 }
 
 /*! \overload
@@ -14904,6 +15460,39 @@ void QCPGraph::addData(const QVector<double> &keys, const QVector<double> &value
     newData.key = keys[i];
     newData.value = values[i];
     mData->insertMulti(newData.key, newData);
+    mLod.append(newData.key, newData.value);
+  }
+}
+
+/*! \overload
+  Adds \a count data points with equidistant keys to the current data. The key of the i-th point is
+  \a firstKey + i*\a keyStep, its value is taken from \a values[i].
+  
+  This is the fastest way to feed a block of streamed samples to a graph: no key or value vectors
+  need to be allocated by the caller, and if \a firstKey is larger than all keys in the graph and \a
+  keyStep is positive, the points are appended at the end of the data map without searching for
+  their positions.
+  
+  \see removeDataBefore
+*/
+void QCPGraph::addData(double firstKey, double keyStep, const double *values, int count)
+{
+  if (count <= 0)
+    return;
+  const bool append = keyStep > 0 && (mData->isEmpty() || firstKey > (mData->constEnd()-1).key());
+  Q_UNUSED(append)
+  QCPData newData;
+  for (int i=0; i<count; ++i)
+  {
+    newData.key = firstKey+i*keyStep;
+    newData.value = values[i];
+#if QT_VERSION >= QT_VERSION_CHECK(5, 1, 0)
+    if (append)
+      mData->insertMulti(mData->constEnd(), newData.key, newData);
+    else
+#endif
+      mData->insertMulti(newData.key, newData);
+    mLod.append(newData.key, newData.value);
   }
 }
 
@@ -14916,6 +15505,7 @@ void QCPGraph::removeDataBefore(double key)
   QCPDataMap::iterator it = mData->begin();
   while (it != mData->end() && it.key() < key)
     it = mData->erase(it);
+  mLod.removeBefore(mData);
 }
 
 /*!
@@ -14928,6 +15518,7 @@ void QCPGraph::removeDataAfter(double key)
   QCPDataMap::iterator it = mData->upperBound(key);
   while (it != mData->end())
     it = mData->erase(it);
+  mLod.invalidate();
 }
 
 /*!
@@ -14944,6 +15535,7 @@ void QCPGraph::removeData(double fromKey, double toKey)
   QCPDataMap::iterator itEnd = mData->upperBound(toKey);
   while (it != itEnd)
     it = mData->erase(it);
+  mLod.invalidate();
 }
 
 /*! \overload
@@ -14957,6 +15549,7 @@ void QCPGraph::removeData(double fromKey, double toKey)
 void QCPGraph::removeData(double key)
 {
   mData->remove(key);
+  mLod.invalidate();
 }
 
 /*!
@@ -14966,6 +15559,7 @@ void QCPGraph::removeData(double key)
 void QCPGraph::clearData()
 {
   mData->clear();
+  mLod.clear();
 }
 
 /* inherits documentation from base class */
@@ -15074,6 +15668,10 @@ void QCPGraph::draw(QCPPainter *painter)
   if (mKeyAxis.data()->range().size() <= 0 || mData->isEmpty()) return;
   if (mLineStyle == lsNone && mScatterStyle.isNone()) return;
   
+  // bring the level-of-detail summary used by adaptive sampling up to date:
+  if (mAdaptiveSampling)
+    mLod.synchronize(mData);
+  
   // allocate line and (if necessary) point vectors:
   QVector<QPointF> *lineData = new QVector<QPointF>;
   QVector<QCPData> *scatterData = 0;
@@ -15559,21 +16157,6 @@ void QCPGraph::drawLinePlot(QCPPainter *painter, QVector<QPointF> *lineData) con
     painter->setPen(mainPen());
     painter->setBrush(Qt::NoBrush);
     
-    /* Draws polyline in batches, currently not used:
-    int p = 0;
-    while (p < lineData->size())
-    {
-      int batch = qMin(25, lineData->size()-p);
-      if (p != 0)
-      {
-        ++batch;
-        --p; // to draw the connection lines between two batches
-      }
-      painter->drawPolyline(lineData->constData()+p, batch);
-      p += batch;
-    }
-    */
-    
     // if drawing solid line and not in PDF, use much faster line drawing instead of polyline:
     if (mParentPlot->plottingHints().testFlag(QCP::phFastPolylines) &&
         painter->pen().style() == Qt::SolidLine &&
@@ -15607,17 +16190,89 @@ void QCPGraph::drawLinePlot(QCPPainter *painter, QVector<QPointF> *lineData) con
       {
         if (qIsNaN(lineData->at(i).y()) || qIsNaN(lineData->at(i).x())) // NaNs create a gap in the line
         {
-          painter->drawPolyline(lineData->constData()+segmentStart, i-segmentStart); // i, because we don't want to include the current NaN point
+          drawPolylineChunked(painter, lineData->constData()+segmentStart, i-segmentStart); // i, because we don't want to include the current NaN point
           segmentStart = i+1;
         }
         ++i;
       }
       // draw last segment:
-      painter->drawPolyline(lineData->constData()+segmentStart, lineDataSize-segmentStart);
+      drawPolylineChunked(painter, lineData->constData()+segmentStart, lineDataSize-segmentStart);
     }
   }
 }
 
+/*! \internal
+  
+  Draws the polyline through the \a count pixel \a points, which must not contain NaN coordinates,
+  with the current pen of \a painter. This is used by \ref drawLinePlot.
+  
+  QPainter's stroker gets disproportionately slow on very long paths, especially with antialiasing
+  or thick pens. For screen output, the polyline is therefore reduced and drawn in chunks:
+  
+  \li Consecutive points that fall into the same pixel column along the key axis are reduced to the
+  first, the lowest, the highest and the last of them, in their original order. The dropped
+  segments lie completely inside the span drawn by the remaining ones, so the result looks the same.
+  \li Zero-length segments are removed.
+  \li The remaining points are passed to QPainter in chunks of a few hundred points. Consecutive
+  chunks share their boundary point, so the line stays connected.
+  
+  For vectorized output (e.g. PDF) and exports, the polyline is drawn unmodified in a single call.
+*/
+void QCPGraph::drawPolylineChunked(QCPPainter *painter, const QPointF *points, int count) const
+{
+  const int chunkSize = 512;
+  if (count <= 0)
+    return;
+  if (count <= 2 || painter->modes().testFlag(QCPPainter::pmVectorized) || painter->modes().testFlag(QCPPainter::pmNoCaching))
+  {
+    painter->drawPolyline(points, count);
+    return;
+  }
+  
+  const bool keyIsX = mKeyAxis.data()->orientation() == Qt::Horizontal;
+  QVector<QPointF> chunk;
+  chunk.reserve(qMin(count, chunkSize)+4);
+  int i = 0;
+  while (i < count)
+  {
+    // collect the points of one pixel column and find the extrema of their value coordinate:
+    const int column = qFloor(keyIsX ? points[i].x() : points[i].y());
+    int minIndex = i;
+    int maxIndex = i;
+    int j = i+1;
+    while (j < count && qFloor(keyIsX ? points[j].x() : points[j].y()) == column)
+    {
+      const double value = keyIsX ? points[j].y() : points[j].x();
+      if (value < (keyIsX ? points[minIndex].y() : points[minIndex].x()))
+        minIndex = j;
+      if (value > (keyIsX ? points[maxIndex].y() : points[maxIndex].x()))
+        maxIndex = j;
+      ++j;
+    }
+    
+    // keep first, extrema and last point of the column in their original order:
+    int keep[4] = {i, qMin(minIndex, maxIndex), qMax(minIndex, maxIndex), j-1};
+    for (int k=0; k<4; ++k)
+    {
+      if (k > 0 && keep[k] == keep[k-1])
+        continue;
+      if (chunk.isEmpty() || chunk.last() != points[keep[k]]) // skip zero-length segments
+        chunk.append(points[keep[k]]);
+    }
+    i = j;
+    
+    if (chunk.size() >= chunkSize)
+    {
+      painter->drawPolyline(chunk.constData(), chunk.size());
+      QPointF joint = chunk.last();
+      chunk.resize(0);
+      chunk.append(joint);
+    }
+  }
+  if (chunk.size() > 1)
+    painter->drawPolyline(chunk.constData(), chunk.size());
+}
+
 /*! \internal
   
   Draws impulses from the provided data, i.e. it connects all line pairs in \a lineData, which was
@@ -15664,16 +16319,23 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
   
   // count points in visible range, taking into account that we only need to count to the limit maxCount if using adaptive sampling:
   int maxCount = std::numeric_limits<int>::max();
+  int keyPixelSpan = 0;
   if (mAdaptiveSampling)
   {
-    int keyPixelSpan = qAbs(keyAxis->coordToPixel(lower.key())-keyAxis->coordToPixel(upper.key()));
+    keyPixelSpan = qAbs(keyAxis->coordToPixel(lower.key())-keyAxis->coordToPixel(upper.key()))/mAdaptiveSamplingResolution;
     maxCount = 2*keyPixelSpan+2;
   }
   int dataCount = countDataInBounds(lower, upper, maxCount);
   
   if (mAdaptiveSampling && dataCount >= maxCount) // use adaptive sampling only if there are at least two points per pixel on average
   {
-    if (lineData)
+    // with at least one full level-of-detail leaf per pixel on average, take the pixel extrema from the summary:
+    bool useLod = lineData && mLod.isUpToDate() && mLod.dataCount() == mData->size() &&
+                  mLod.lowerLeaf(upper.key())-mLod.lowerLeaf(lower.key()) >= keyPixelSpan;
+    if (useLod)
+    {
+      getLodLineData(lineData, lower, upper);
+    } else if (lineData)
     {
       QCPDataMap::const_iterator it = lower;
       QCPDataMap::const_iterator upperEnd = upper+1;
@@ -15684,7 +16346,7 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
       int reversedRound = keyAxis->rangeReversed() != (keyAxis->orientation()==Qt::Vertical) ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
       double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(lower.key())+reversedRound));
       double lastIntervalEndKey = currentIntervalStartKey;
-      double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
+      double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+mAdaptiveSamplingResolution*reversedFactor)); // interval of one sampling resolution on screen when mapped to plot key coordinates
       bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
       int intervalDataCount = 1;
       ++it; // advance iterator to second data point because adaptive sampling works in 1 point retrospect
@@ -15715,7 +16377,7 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
           currentIntervalFirstPoint = it;
           currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(it.key())+reversedRound));
           if (keyEpsilonVariable)
-            keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
+            keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+mAdaptiveSamplingResolution*reversedFactor));
           intervalDataCount = 1;
         }
         ++it;
@@ -15832,6 +16494,95 @@ void QCPGraph::getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *sca
   }
 }
 
+/*!  \internal
+  
+  Generates the adaptively sampled \a lineData for the data points between \a lower and \a upper
+  (both inclusive), like the line branch of \ref getPreparedData. Instead of iterating every point,
+  the value extrema of each pixel interval are obtained from the level-of-detail summary: only the
+  points before the first and after the last full leaf inside the interval are visited directly, the
+  leaves in between are queried from the summary in O(log n). The produced points are the same as
+  those of the iterating algorithm.
+  
+  The summary must be up to date, see \ref QCPDataLod::isUpToDate.
+*/
+void QCPGraph::getLodLineData(QVector<QCPData> *lineData, const QCPDataMap::const_iterator &lower, const QCPDataMap::const_iterator &upper) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPDataMap::const_iterator it = lower;
+  QCPDataMap::const_iterator upperEnd = upper+1;
+  int reversedFactor = keyAxis->rangeReversed() != (keyAxis->orientation()==Qt::Vertical) ? -1 : 1; // is used to calculate keyEpsilon pixel into the correct direction
+  int reversedRound = keyAxis->rangeReversed() != (keyAxis->orientation()==Qt::Vertical) ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
+  double currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(lower.key())+reversedRound));
+  double lastIntervalEndKey = currentIntervalStartKey;
+  double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+mAdaptiveSamplingResolution*reversedFactor)); // interval of one sampling resolution on screen when mapped to plot key coordinates
+  bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
+  while (it != upperEnd)
+  {
+    // find the end of the current pixel interval:
+    QCPDataMap::const_iterator intervalEnd = mData->lowerBound(currentIntervalStartKey+keyEpsilon);
+    if (intervalEnd == mData->constEnd() || intervalEnd.key() > upper.key())
+      intervalEnd = upperEnd;
+    if (intervalEnd == it) // rounding put the interval start behind the data point, make sure we advance
+      intervalEnd = it+1;
+    QCPDataMap::const_iterator intervalFirstPoint = it;
+    QCPDataMap::const_iterator intervalLastPoint = intervalEnd-1;
+    
+    // determine value extrema of the interval, using the summary for the full leaves inside it:
+    double minValue = it.value().value;
+    double maxValue = it.value().value;
+    int intervalDataCount = 0;
+    int leafBegin = mLod.lowerLeaf(intervalFirstPoint.key());
+    int leafEnd = mLod.upperLeaf(intervalLastPoint.key());
+    if (leafBegin < leafEnd)
+    {
+      const double leafFirstKey = mLod.leafFirstKey(leafBegin);
+      while (it != intervalEnd && it.key() < leafFirstKey)
+      {
+        if (it.value().value < minValue)
+          minValue = it.value().value;
+        else if (it.value().value > maxValue)
+          maxValue = it.value().value;
+        ++intervalDataCount;
+        ++it;
+      }
+      mLod.minMax(leafBegin, leafEnd, minValue, maxValue, intervalDataCount);
+      it = mData->upperBound(mLod.leafLastKey(leafEnd-1));
+      if (it == mData->constEnd() || it.key() > upper.key())
+        it = upperEnd;
+    }
+    while (it != intervalEnd)
+    {
+      if (it.value().value < minValue)
+        minValue = it.value().value;
+      else if (it.value().value > maxValue)
+        maxValue = it.value().value;
+      ++intervalDataCount;
+      ++it;
+    }
+    
+    // add the interval to the line data the same way the iterating algorithm does:
+    if (intervalDataCount >= 2) // pixel has multiple data points, consolidate them to a cluster
+    {
+      if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
+        lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.2, intervalFirstPoint.value().value));
+      lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
+      lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
+      if (intervalEnd != upperEnd && intervalEnd.key() > currentIntervalStartKey+keyEpsilon*2) // new pixel starts further away from this cluster, so make sure the last point of the cluster is at a real data point
+        lineData->append(QCPData(currentIntervalStartKey+keyEpsilon*0.8, intervalLastPoint.value().value));
+    } else
+      lineData->append(QCPData(intervalFirstPoint.key(), intervalFirstPoint.value().value));
+    lastIntervalEndKey = intervalLastPoint.key();
+    
+    it = intervalEnd;
+    if (it != upperEnd)
+    {
+      currentIntervalStartKey = keyAxis->pixelToCoord((int)(keyAxis->coordToPixel(it.key())+reversedRound));
+      if (keyEpsilonVariable)
+        keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+mAdaptiveSamplingResolution*reversedFactor));
+    }
+  }
+}
+
 /*!  \internal
   
   called by the scatter drawing function (\ref drawScatterPlot) to draw the error bars on one data
@@ -19625,7 +20376,9 @@ QCPColorMapData::QCPColorMapData(int keySize, int valueSize, const QCPRange &key
   mValueRange(valueRange),
   mIsEmpty(true),
   mData(0),
-  mDataModified(true)
+  mDataModified(true),
+  mValueOffset(0),
+  mAddedValueRows(0)
 {
   setSize(keySize, valueSize);
   fill(0);
@@ -19645,7 +20398,9 @@ QCPColorMapData::QCPColorMapData(const QCPColorMapData &other) :
   mValueSize(0),
   mIsEmpty(true),
   mData(0),
-  mDataModified(true)
+  mDataModified(true),
+  mValueOffset(0),
+  mAddedValueRows(0)
 {
   *this = other;
 }
@@ -19665,6 +20420,8 @@ QCPColorMapData &QCPColorMapData::operator=(const QCPColorMapData &other)
       memcpy(mData, other.mData, sizeof(mData[0])*keySize*valueSize);
     mDataBounds = other.mDataBounds;
     mDataModified = true;
+    mValueOffset = other.mValueOffset;
+    mAddedValueRows = 0;
   }
   return *this;
 }
@@ -19675,7 +20432,7 @@ double QCPColorMapData::data(double key, double value)
   int keyCell = (key-mKeyRange.lower)/(mKeyRange.upper-mKeyRange.lower)*(mKeySize-1)+0.5;
   int valueCell = (value-mValueRange.lower)/(mValueRange.upper-mValueRange.lower)*(mValueSize-1)+0.5;
   if (keyCell >= 0 && keyCell < mKeySize && valueCell >= 0 && valueCell < mValueSize)
-    return mData[valueCell*mKeySize + keyCell];
+    return mData[rowIndex(valueCell)*mKeySize + keyCell];
   else
     return 0;
 }
@@ -19684,7 +20441,7 @@ double QCPColorMapData::data(double key, double value)
 double QCPColorMapData::cell(int keyIndex, int valueIndex)
 {
   if (keyIndex >= 0 && keyIndex < mKeySize && valueIndex >= 0 && valueIndex < mValueSize)
-    return mData[valueIndex*mKeySize + keyIndex];
+    return mData[rowIndex(valueIndex)*mKeySize + keyIndex];
   else
     return 0;
 }
@@ -19725,6 +20482,8 @@ void QCPColorMapData::setSize(int keySize, int valueSize)
         qDebug() << Q_FUNC_INFO << "out of memory for data dimensions "<< mKeySize << "*" << mValueSize;
     } else
       mData = 0;
+    mValueOffset = 0;
+    mAddedValueRows = 0;
     mDataModified = true;
   }
 }
@@ -19823,7 +20582,7 @@ void QCPColorMapData::setData(double key, double value, double z)
   int valueCell = (value-mValueRange.lower)/(mValueRange.upper-mValueRange.lower)*(mValueSize-1)+0.5;
   if (keyCell >= 0 && keyCell < mKeySize && valueCell >= 0 && valueCell < mValueSize)
   {
-    mData[valueCell*mKeySize + keyCell] = z;
+    mData[rowIndex(valueCell)*mKeySize + keyCell] = z;
     if (z < mDataBounds.lower)
       mDataBounds.lower = z;
     if (z > mDataBounds.upper)
@@ -19847,7 +20606,7 @@ void QCPColorMapData::setCell(int keyIndex, int valueIndex, double z)
 {
   if (keyIndex >= 0 && keyIndex < mKeySize && valueIndex >= 0 && valueIndex < mValueSize)
   {
-    mData[valueIndex*mKeySize + keyIndex] = z;
+    mData[rowIndex(valueIndex)*mKeySize + keyIndex] = z;
     if (z < mDataBounds.lower)
       mDataBounds.lower = z;
     if (z > mDataBounds.upper)
@@ -19907,9 +20666,44 @@ void QCPColorMapData::fill(double z)
   for (int i=0; i<dataCount; ++i)
     mData[i] = z;
   mDataBounds = QCPRange(z, z);
+  mValueOffset = 0;
+  mAddedValueRows = 0;
   mDataModified = true;
 }
 
+/*!
+  Scrolls the map by one cell in the value dimension: The row at value index 0 is dropped, all
+  other rows move down by one value index and \a z, an array of \ref keySize values, becomes the
+  row at value index valueSize-1.
+
+  Rows are stored in a ring internally, so this costs O(keySize) instead of moving the whole data
+  array. If nothing else modified the data since the last replot, \ref QCPColorMap only colorizes
+  the newly added rows instead of the whole map. This makes scrolling displays like waterfall
+  diagrams cheap, even for large maps.
+
+  The buffered data bounds are expanded by the new values like in \ref setCell.
+
+  \see setCell, fill
+*/
+void QCPColorMapData::addValueRow(const double *z)
+{
+  if (mIsEmpty || !mData)
+    return;
+  
+  double *row = mData + mValueOffset*mKeySize; // physical row of value index 0, is overwritten by the new top row
+  for (int i=0; i<mKeySize; ++i)
+  {
+    row[i] = z[i];
+    if (z[i] < mDataBounds.lower)
+      mDataBounds.lower = z[i];
+    if (z[i] > mDataBounds.upper)
+      mDataBounds.upper = z[i];
+  }
+  mValueOffset = mValueOffset+1 < mValueSize ? mValueOffset+1 : 0;
+  if (mAddedValueRows < mValueSize)
+    ++mAddedValueRows;
+}
+
 /*!
   Transforms plot coordinates given by \a key and \a value to cell indices of this QCPColorMapData
   instance. The resulting cell indices are returned via the output parameters \a keyIndex and \a
@@ -20070,7 +20864,8 @@ QCPColorMap::QCPColorMap(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   mMapData(new QCPColorMapData(10, 10, QCPRange(0, 5), QCPRange(0, 5))),
   mInterpolate(true),
   mTightBoundary(false),
-  mMapImageInvalidated(true)
+  mMapImageInvalidated(true),
+  mMapImageRowOffset(0)
 {
 }
 
@@ -20275,8 +21070,8 @@ void QCPColorMap::rescaleDataRange(bool recalculateDataBounds)
 */
 void QCPColorMap::updateLegendIcon(Qt::TransformationMode transformMode, const QSize &thumbSize)
 {
-  if (mMapImage.isNull() && !data()->isEmpty())
-    updateMapImage(); // try to update map image if it's null (happens if no draw has happened yet)
+  if ((mMapImage.isNull() || mMapImageRowOffset != 0) && !data()->isEmpty())
+    updateMapImage(); // try to update map image if it's null (happens if no draw has happened yet) or its rows are rotated by updateMapImageRows
   
   if (!mMapImage.isNull()) // might still be null, e.g. if data is empty, so check here again
   {
@@ -20364,7 +21159,7 @@ void QCPColorMap::updateMapImage()
     for (int line=0; line<lineCount; ++line)
     {
       QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
-      mGradient.colorize(rawData+line*rowCount, mDataRange, pixels, rowCount, 1, mDataScaleType==QCPAxis::stLogarithmic);
+      mGradient.colorize(rawData+mMapData->rowIndex(line)*rowCount, mDataRange, pixels, rowCount, 1, mDataScaleType==QCPAxis::stLogarithmic);
     }
   } else // keyAxis->orientation() == Qt::Vertical
   {
@@ -20373,7 +21168,11 @@ void QCPColorMap::updateMapImage()
     for (int line=0; line<lineCount; ++line)
     {
       QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
-      mGradient.colorize(rawData+line, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
+      // value rows are stored in a ring (see QCPColorMapData::addValueRow), so colorize the two contiguous parts separately:
+      const int offset = mMapData->mValueOffset;
+      mGradient.colorize(rawData+offset*lineCount+line, mDataRange, pixels, rowCount-offset, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
+      if (offset > 0)
+        mGradient.colorize(rawData+line, mDataRange, pixels+rowCount-offset, offset, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
     }
   }
   
@@ -20385,7 +21184,41 @@ void QCPColorMap::updateMapImage()
       mMapImage = mUndersampledMapImage.scaled(valueSize*valueOversamplingFactor, keySize*keyOversamplingFactor, Qt::IgnoreAspectRatio, Qt::FastTransformation);
   }
   mMapData->mDataModified = false;
+  mMapData->mAddedValueRows = 0;
   mMapImageInvalidated = false;
+  mMapImageRowOffset = 0;
+}
+
+/*! \internal
+  
+  Colorizes only the rows that were added with \ref QCPColorMapData::addValueRow since the last
+  update of the map image, instead of the whole map. The image rows are kept in a ring just like
+  the data rows, \ref mMapImageRowOffset tells \ref draw where the ring starts.
+  
+  This is only possible if the map image has the plain layout, i.e. a horizontal key axis and no
+  oversampling. Returns false if the map image must be updated completely with \ref
+  updateMapImage instead.
+*/
+bool QCPColorMap::updateMapImageRows()
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  if (!keyAxis || keyAxis->orientation() != Qt::Horizontal) return false;
+  
+  const int keySize = mMapData->keySize();
+  const int valueSize = mMapData->valueSize();
+  const int addedRows = mMapData->mAddedValueRows;
+  if (mMapImage.width() != keySize || mMapImage.height() != valueSize || addedRows >= valueSize)
+    return false;
+  
+  // rows that were already colorized move down by addedRows value indices, so the image ring advances by the same amount:
+  mMapImageRowOffset = (mMapImageRowOffset+addedRows) % valueSize;
+  for (int line=valueSize-addedRows; line<valueSize; ++line)
+  {
+    QRgb* pixels = reinterpret_cast<QRgb*>(mMapImage.scanLine(valueSize-1-(line+mMapImageRowOffset)%valueSize));
+    mGradient.colorize(mMapData->mData+mMapData->rowIndex(line)*keySize, mDataRange, pixels, keySize, 1, mDataScaleType==QCPAxis::stLogarithmic);
+  }
+  mMapData->mAddedValueRows = 0;
+  return true;
 }
 
 /* inherits documentation from base class */
@@ -20397,6 +21230,8 @@ void QCPColorMap::draw(QCPPainter *painter)
   
   if (mMapData->mDataModified || mMapImageInvalidated)
     updateMapImage();
+  else if (mMapData->mAddedValueRows > 0 && !updateMapImageRows())
+    updateMapImage();
   
   // use buffer if painting vectorized (PDF):
   bool useBuffer = painter->modes().testFlag(QCPPainter::pmVectorized);
@@ -20435,6 +21270,8 @@ void QCPColorMap::draw(QCPPainter *painter)
   imageRect.adjust(-halfCellWidth, -halfCellHeight, halfCellWidth, halfCellHeight);
   bool mirrorX = (keyAxis()->orientation() == Qt::Horizontal ? keyAxis() : valueAxis())->rangeReversed();
   bool mirrorY = (valueAxis()->orientation() == Qt::Vertical ? valueAxis() : keyAxis())->rangeReversed();
+  if (mMapImageRowOffset != 0 && (mirrorX || mirrorY))
+    updateMapImage(); // rotated image rows are only drawn unmirrored, bring the image to the plain layout
   bool smoothBackup = localPainter->renderHints().testFlag(QPainter::SmoothPixmapTransform);
   localPainter->setRenderHint(QPainter::SmoothPixmapTransform, mInterpolate);
   QRegion clipBackup;
@@ -20445,7 +21282,19 @@ void QCPColorMap::draw(QCPPainter *painter)
                                   coordsToPixels(mMapData->keyRange().upper, mMapData->valueRange().upper)).normalized();
     localPainter->setClipRect(tightClipRect, Qt::IntersectClip);
   }
-  localPainter->drawImage(imageRect, mMapImage.mirrored(mirrorX, mirrorY));
+  if (mMapImageRowOffset == 0)
+  {
+    localPainter->drawImage(imageRect, mMapImage.mirrored(mirrorX, mirrorY));
+  } else
+  {
+    // image rows are rotated by updateMapImageRows, draw the newest rows at the top and the older ones below:
+    const int rows = mMapImage.height();
+    const double rowHeight = imageRect.height()/(double)rows;
+    QRectF topRect(imageRect.left(), imageRect.top(), imageRect.width(), mMapImageRowOffset*rowHeight);
+    QRectF bottomRect(imageRect.left(), topRect.bottom(), imageRect.width(), imageRect.height()-topRect.height());
+    localPainter->drawImage(topRect, mMapImage, QRectF(0, rows-mMapImageRowOffset, mMapImage.width(), mMapImageRowOffset));
+    localPainter->drawImage(bottomRect, mMapImage, QRectF(0, 0, mMapImage.width(), rows-mMapImageRowOffset));
+  }
   if (mTightBoundary)
     localPainter->setClipRegion(clipBackup);
   localPainter->setRenderHint(QPainter::SmoothPixmapTransform, smoothBackup);
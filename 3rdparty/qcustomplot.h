@@ -371,6 +371,7 @@ class QCP_LIB_DECL QCPLayer : public QObject
   Q_PROPERTY(int index READ index)
   Q_PROPERTY(QList<QCPLayerable*> children READ children)
   Q_PROPERTY(bool visible READ visible WRITE setVisible)
+  Q_PROPERTY(bool cached READ cached WRITE setCached)
   /// \endcond
 public:
   QCPLayer(QCustomPlot* parentPlot, const QString &layerName);
@@ -382,9 +383,14 @@ public:
   int index() const { return mIndex; }
   QList<QCPLayerable*> children() const { return mChildren; }
   bool visible() const { return mVisible; }
+  bool cached() const { return mCached; }
   
   // setters:
   void setVisible(bool visible);
+  void setCached(bool enabled);
+  
+  // non-property methods:
+  void invalidateCache();
   
 protected:
   // property members:
@@ -393,6 +399,11 @@ protected:
   int mIndex;
   QList<QCPLayerable*> mChildren;
   bool mVisible;
+  bool mCached;
+  
+  // non-property members:
+  QPixmap mCache;
+  bool mCacheDirty;
   
   // non-virtual methods:
   void addChild(QCPLayerable *layerable, bool prepend);
@@ -1795,6 +1806,7 @@ public:
   bool addLayer(const QString &name, QCPLayer *otherLayer=0, LayerInsertMode insertMode=limAbove);
   bool removeLayer(QCPLayer *layer);
   bool moveLayer(QCPLayer *layer, QCPLayer *otherLayer, LayerInsertMode insertMode=limAbove);
+  void invalidateLayerCaches();
   
   // axis rect/layout interface:
   int axisRectCount() const;
@@ -1865,6 +1877,7 @@ protected:
   
   // non-property members:
   QPixmap mPaintBuffer;
+  QVector<double> mLayerCacheKey;
   QPoint mMousePressPos;
   QPointer<QCPLayoutElement> mMouseEventElement;
   bool mReplotting;
@@ -1889,6 +1902,10 @@ protected:
   void updateLayerIndices() const;
   QCPLayerable *layerableAt(const QPointF &pos, bool onlySelectable, QVariant *selectionDetails=0) const;
   void drawBackground(QCPPainter *painter);
+  void drawLayer(QCPPainter *painter, QCPLayer *layer);
+  void drawCached(QCPPainter *painter);
+  bool hasCachedLayers() const;
+  QVector<double> layerCacheKey() const;
   
   friend class QCPLegend;
   friend class QCPAxis;
@@ -2487,6 +2504,66 @@ typedef QMapIterator<double, QCPData> QCPDataMapIterator;
 typedef QMutableMapIterator<double, QCPData> QCPDataMutableMapIterator;
 
 
+class QCP_LIB_DECL QCPDataLod
+{
+public:
+  /*!
+    Number of consecutive data points summarized by one leaf of the pyramid.
+  */
+  enum { LeafSize = 32 };
+  
+  /*!
+    Summary of a contiguous run of data points: key span, value extrema and number of points.
+  */
+  struct Node
+  {
+    double firstKey, lastKey;
+    double minValue, maxValue;
+    int count;
+  };
+  
+  QCPDataLod();
+  
+  // getters:
+  bool isValid() const { return mValid; }
+  bool isUpToDate() const { return mValid && mDirtyLeaf < 0; }
+  int dataCount() const { return mCount; }
+  
+  // non-property methods:
+  void clear();
+  void invalidate() { mValid = false; }
+  bool isSynchronized(const QCPDataMap *data) const;
+  void synchronize(const QCPDataMap *data);
+  void append(double key, double value);
+  void removeBefore(const QCPDataMap *data);
+  int lowerLeaf(double key) const;
+  int upperLeaf(double key) const;
+  double leafFirstKey(int leaf) const { return node(0, leaf).firstKey; }
+  double leafLastKey(int leaf) const { return node(0, leaf).lastKey; }
+  void minMax(int beginLeaf, int endLeaf, double &minValue, double &maxValue, int &count) const;
+  
+protected:
+  // non-property members:
+  QVector<QVector<Node> > mLevels; // mLevels[0] are the leaves, mLevels[l] summarizes pairs of mLevels[l-1]
+  QVector<int> mOffsets; // absolute node index of the first element stored in each level
+  int mFirstLeaf; // absolute index of the first leaf that still holds data
+  int mDirtyLeaf; // absolute index of the first leaf whose ancestors are outdated, -1 if none
+  int mCount;
+  bool mValid;
+  
+  // non-virtual methods:
+  const Node &node(int level, int index) const { return mLevels.at(level).at(index-mOffsets.at(level)); }
+  int leafEnd() const { return mOffsets.isEmpty() ? 0 : mOffsets.at(0)+mLevels.at(0).size(); }
+  void rebuild(const QCPDataMap *data);
+  void update();
+  void updateAncestors(int leaf);
+  Node mergedChildren(int level, int index) const;
+  void compact();
+  static void mergeNode(Node &target, const Node &source);
+};
+Q_DECLARE_TYPEINFO(QCPDataLod::Node, Q_PRIMITIVE_TYPE);
+
+
 class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable
 {
   Q_OBJECT
@@ -2499,6 +2576,7 @@ class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable
   Q_PROPERTY(bool errorBarSkipSymbol READ errorBarSkipSymbol WRITE setErrorBarSkipSymbol)
   Q_PROPERTY(QCPGraph* channelFillGraph READ channelFillGraph WRITE setChannelFillGraph)
   Q_PROPERTY(bool adaptiveSampling READ adaptiveSampling WRITE setAdaptiveSampling)
+  Q_PROPERTY(double adaptiveSamplingResolution READ adaptiveSamplingResolution WRITE setAdaptiveSamplingResolution)
   /// \endcond
 public:
   /*!
@@ -2538,6 +2616,7 @@ public:
   bool errorBarSkipSymbol() const { return mErrorBarSkipSymbol; }
   QCPGraph *channelFillGraph() const { return mChannelFillGraph.data(); }
   bool adaptiveSampling() const { return mAdaptiveSampling; }
+  double adaptiveSamplingResolution() const { return mAdaptiveSamplingResolution; }
   
   // setters:
   void setData(QCPDataMap *data, bool copy=false);
@@ -2556,12 +2635,14 @@ public:
   void setErrorBarSkipSymbol(bool enabled);
   void setChannelFillGraph(QCPGraph *targetGraph);
   void setAdaptiveSampling(bool enabled);
+  void setAdaptiveSamplingResolution(double pixels);
   
   // non-property methods:
   void addData(const QCPDataMap &dataMap);
   void addData(const QCPData &data);
   void addData(double key, double value);
   void addData(const QVector<double> &keys, const QVector<double> &values);
+  void addData(double firstKey, double keyStep, const double *values, int count);
   void removeDataBefore(double key);
   void removeDataAfter(double key);
   void removeData(double fromKey, double toKey);
@@ -2588,6 +2669,10 @@ protected:
   bool mErrorBarSkipSymbol;
   QPointer<QCPGraph> mChannelFillGraph;
   bool mAdaptiveSampling;
+  double mAdaptiveSamplingResolution;
+  
+  // non-property members:
+  QCPDataLod mLod;
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter);
@@ -2604,7 +2689,9 @@ protected:
   virtual void drawImpulsePlot(QCPPainter *painter, QVector<QPointF> *lineData) const;
   
   // non-virtual methods:
+  void drawPolylineChunked(QCPPainter *painter, const QPointF *points, int count) const;
   void getPreparedData(QVector<QCPData> *lineData, QVector<QCPData> *scatterData) const;
+  void getLodLineData(QVector<QCPData> *lineData, const QCPDataMap::const_iterator &lower, const QCPDataMap::const_iterator &upper) const;
   void getPlotData(QVector<QPointF> *lineData, QVector<QCPData> *scatterData) const;
   void getScatterPlotData(QVector<QCPData> *scatterData) const;
   void getLinePlotData(QVector<QPointF> *linePixelData, QVector<QCPData> *scatterData) const;
@@ -3025,6 +3112,7 @@ public:
   void recalculateDataBounds();
   void clear();
   void fill(double z);
+  void addValueRow(const double *z);
   bool isEmpty() const { return mIsEmpty; }
   void coordToCell(double key, double value, int *keyIndex, int *valueIndex) const;
   void cellToCoord(int keyIndex, int valueIndex, double *key, double *value) const;
@@ -3038,6 +3126,11 @@ protected:
   double *mData;
   QCPRange mDataBounds;
   bool mDataModified;
+  int mValueOffset;
+  int mAddedValueRows;
+  
+  // non-virtual methods:
+  int rowIndex(int valueIndex) const { int row = valueIndex+mValueOffset; return row < mValueSize ? row : row-mValueSize; }
   
   friend class QCPColorMap;
 };
@@ -3102,9 +3195,11 @@ protected:
   QImage mMapImage, mUndersampledMapImage;
   QPixmap mLegendIcon;
   bool mMapImageInvalidated;
+  int mMapImageRowOffset;
   
   // introduced virtual methods:
   virtual void updateMapImage();
+  virtual bool updateMapImageRows();
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter);
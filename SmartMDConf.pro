@@ -15,11 +15,59 @@ TEMPLATE = app
 SOURCES += main.cpp\
         mainwindow.cpp\
         serialthread.cpp\
+        plotqualitymanager.cpp\
+        decimator.cpp\
+        streamkernels.cpp\
+        fft.cpp\
+        spectrumthread.cpp\
+        biquad.cpp\
+        streamstats.cpp\
+        trigger.cpp\
+        multistream.cpp\
+        scananalyzer.cpp\
+        bodeanalyzer.cpp\
+        recorderthread.cpp\
+        recordingreader.cpp\
+        capturecodec.cpp\
+        capturewriter.cpp\
+        capturereader.cpp\
+        blackbox.cpp\
+        captureview.cpp\
+        exportthread.cpp\
+        captureevents.cpp\
+        workpool.cpp\
+        capturecompare.cpp\
+        bundle.cpp\
         3rdparty/qcustomplot.cpp
 
 HEADERS  += mainwindow.h\
         serialthread.h\
         telemetry.h\
+        plotqualitymanager.h\
+        decimator.h\
+        streamkernels.h\
+        fft.h\
+        spectrumthread.h\
+        biquad.h\
+        streamstats.h\
+        trigger.h\
+        multistream.h\
+        scananalyzer.h\
+        bodeanalyzer.h\
+        recording.h\
+        recorderthread.h\
+        recordingreader.h\
+        capturecodec.h\
+        capture.h\
+        capturewriter.h\
+        capturereader.h\
+        blackbox.h\
+        captureview.h\
+        exportthread.h\
+        captureevents.h\
+        workpool.h\
+        capturecompare.h\
+        bundle.h\
         3rdparty/qcustomplot.h
 
 FORMS    += mainwindow.ui
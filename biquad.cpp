@@ -0,0 +1,113 @@
+#include "biquad.h"
+
+#include <qmath.h>
+
+/**
+ * @brief BiquadChain::BiquadChain
+ */
+BiquadChain::BiquadChain()
+{
+    // Empty;
+}
+
+/**
+ * @brief BiquadChain::setSections
+ * @param sections - filter sections, applied in the given order.
+ * @param sampleRate - rate of the processed samples, Hz.
+ *
+ * Coefficients follow the audio EQ cookbook formulas. Frequencies are
+ * limited to the open interval (0, sampleRate / 2).
+ */
+void BiquadChain::setSections(const QVector<Section> &sections, double sampleRate)
+{
+    const int n = qMin(sections.size(), BIQUAD_SECTIONS_MAX);
+
+    m_b0.resize(n);
+    m_b1.resize(n);
+    m_b2.resize(n);
+    m_a1.resize(n);
+    m_a2.resize(n);
+
+    for (int i = 0; i < n; i++) {
+        const Section &s = sections[i];
+        double freq = qBound(sampleRate * 1e-6, s.freq, sampleRate * 0.4999);
+        double w0 = 2.0 * M_PI * freq / sampleRate;
+        double cosW0 = qCos(w0);
+        double alpha = qSin(w0) / (2.0 * qMax(s.q, 0.01));
+        double b0, b1, b2;
+
+        switch (s.type) {
+        case TypeHighPass:
+            b0 = (1.0 + cosW0) / 2.0;
+            b1 = -(1.0 + cosW0);
+            b2 = (1.0 + cosW0) / 2.0;
+            break;
+        case TypeBandPass:
+            b0 = alpha;
+            b1 = 0.0;
+            b2 = -alpha;
+            break;
+        case TypeNotch:
+            b0 = 1.0;
+            b1 = -2.0 * cosW0;
+            b2 = 1.0;
+            break;
+        default:
+            b0 = (1.0 - cosW0) / 2.0;
+            b1 = 1.0 - cosW0;
+            b2 = (1.0 - cosW0) / 2.0;
+            break;
+        }
+
+        double a0 = 1.0 + alpha;
+        m_b0[i] = b0 / a0;
+        m_b1[i] = b1 / a0;
+        m_b2[i] = b2 / a0;
+        m_a1[i] = -2.0 * cosW0 / a0;
+        m_a2[i] = (1.0 - alpha) / a0;
+    }
+
+    reset();
+}
+
+/**
+ * @brief BiquadChain::reset
+ */
+void BiquadChain::reset()
+{
+    m_z1.fill(0.0, m_b0.size());
+    m_z2.fill(0.0, m_b0.size());
+}
+
+/**
+ * @brief BiquadChain::process
+ * @param samples - filtered in place.
+ * @param count - number of samples.
+ *
+ * The block passes each section in turn with the section state held in
+ * locals, which keeps the recursion in registers and the inner loop free
+ * of indexing.
+ */
+void BiquadChain::process(double *samples, int count)
+{
+    for (int i = 0; i < m_b0.size(); i++) {
+        const double b0 = m_b0[i];
+        const double b1 = m_b1[i];
+        const double b2 = m_b2[i];
+        const double a1 = m_a1[i];
+        const double a2 = m_a2[i];
+        double z1 = m_z1[i];
+        double z2 = m_z2[i];
+
+        for (int n = 0; n < count; n++) {
+            double x = samples[n];
+            double y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            samples[n] = y;
+        }
+
+        m_z1[i] = z1;
+        m_z2[i] = z2;
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef BIQUAD_H
+#define BIQUAD_H
+
+#include <QVector>
+
+/* Maximum number of sections in a chain.  */
+#define BIQUAD_SECTIONS_MAX             4
+
+class BiquadChain
+{
+public:
+    /* Section responses, designed from frequency and Q. */
+    enum Type {
+        TypeLowPass = 0,
+        TypeHighPass,
+        TypeBandPass,   /* Unity gain at the center frequency. */
+        TypeNotch
+    };
+
+    typedef struct tagSection {
+        Type type;
+        double freq;    /* Cut-off or center frequency, Hz. */
+        double q;
+    } Section;
+
+    BiquadChain();
+
+    void setSections(const QVector<Section> &sections, double sampleRate);
+    void reset();
+    bool isEmpty() const { return m_b0.isEmpty(); }
+    int count() const { return m_b0.size(); }
+
+    void process(double *samples, int count);
+
+private:
+    /* Coefficients normalized to a0 = 1 and transposed direct form II
+     * state, one array per coefficient so a block runs section by section.
+     */
+    QVector<double> m_b0;
+    QVector<double> m_b1;
+    QVector<double> m_b2;
+    QVector<double> m_a1;
+    QVector<double> m_a2;
+    QVector<double> m_z1;
+    QVector<double> m_z2;
+};
+
+#endif // BIQUAD_H
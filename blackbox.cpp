@@ -0,0 +1,303 @@
+#include "blackbox.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QObject>
+
+/**
+ * @brief BlackBox::BlackBox
+ */
+BlackBox::BlackBox() :
+    m_map(0),
+    m_header(0),
+    m_ring(0),
+    m_ringSize(0),
+    m_head(0),
+    m_tail(0)
+{
+    // Empty;
+}
+
+/**
+ * @brief BlackBox::~BlackBox
+ */
+BlackBox::~BlackBox()
+{
+    close();
+}
+
+/**
+ * @brief BlackBox::open
+ * @param fileName - ring file, created if it does not exist.
+ * @return false if the ring can't be mapped, see errorString().
+ *
+ * If the previous session did not close the ring, its records are saved
+ * as a recording next to the ring file first, see recoveredFileName().
+ */
+bool BlackBox::open(const QString &fileName)
+{
+    close();
+
+    QMutexLocker locker(&m_mutex);
+    m_recovered.clear();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    if ((m_file.size() != BLACKBOX_FILE_SIZE) && !m_file.resize(BLACKBOX_FILE_SIZE)) {
+        m_error = m_file.errorString();
+        m_file.close();
+        return false;
+    }
+    m_map = m_file.map(0, BLACKBOX_FILE_SIZE);
+    if (!m_map) {
+        m_error = m_file.errorString();
+        m_file.close();
+        return false;
+    }
+    m_header = (BlackBoxHeader *)m_map;
+    m_ring = m_map + BLACKBOX_HEADER_SIZE;
+    m_ringSize = BLACKBOX_FILE_SIZE - BLACKBOX_HEADER_SIZE;
+
+    if ((memcmp(m_header->magic, BLACKBOX_MAGIC, sizeof(BLACKBOX_MAGIC)) == 0) &&
+        (m_header->version == BLACKBOX_VERSION) &&
+        (m_header->header_size == BLACKBOX_HEADER_SIZE) &&
+        (m_header->ring_size == m_ringSize) &&
+        !m_header->clean && (m_header->head != m_header->tail)) {
+        m_head = m_header->head;
+        m_tail = m_header->tail;
+        if (validRing()) {
+            const QString name = QFileInfo(fileName).absolutePath() +
+                QDateTime::fromMSecsSinceEpoch(m_header->start_time)
+                    .toString("'/incident-'yyyyMMdd-hhmmss'.smdrec'");
+            QFile file(name);
+            locker.unlock();
+            const QByteArray data = incident(0);
+            locker.relock();
+            if (file.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+                (file.write(data) == data.size())) {
+                m_recovered = name;
+            }
+        }
+    }
+
+    memset((void *)m_header, 0, sizeof(BlackBoxHeader));
+    memcpy(m_header->magic, BLACKBOX_MAGIC, sizeof(BLACKBOX_MAGIC));
+    m_header->version = BLACKBOX_VERSION;
+    m_header->header_size = BLACKBOX_HEADER_SIZE;
+    m_header->ring_size = m_ringSize;
+    m_header->start_time = QDateTime::currentMSecsSinceEpoch();
+    m_head = 0;
+    m_tail = 0;
+    m_clock.start();
+    return true;
+}
+
+/**
+ * @brief BlackBox::close
+ * Marks the ring as closed, the next open() does not recover it.
+ */
+void BlackBox::close()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_map) {
+        m_header->clean = 1;
+        m_file.unmap(m_map);
+        m_map = 0;
+        m_header = 0;
+        m_ring = 0;
+    }
+    m_file.close();
+}
+
+/**
+ * @brief BlackBox::addFrame
+ * @param msg - header of a received telemetry message.
+ * @param data - message data, msg.data_size bytes.
+ */
+void BlackBox::addFrame(const TelemetryMessage &msg, const char *data)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_map) {
+        append(msg.msg_id, msg.signature, data, msg.data_size);
+    }
+}
+
+/**
+ * @brief BlackBox::addCommand
+ * @param data - bytes sent to the board.
+ * @param size - number of bytes.
+ */
+void BlackBox::addCommand(const char *data, int size)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_map) {
+        return;
+    }
+    while (size > 0) {
+        const int n = qMin(size, TELEMETRY_MSG_SIZE_BYTES_MAX);
+        append(0, RECORDING_COMMAND_SIGNATURE, data, n);
+        data += n;
+        size -= n;
+    }
+}
+
+/**
+ * @brief BlackBox::incident
+ * @param window - time before the newest record to keep, ns, 0 for all.
+ * @return the records as a recording file, starting at timestamp 0.
+ */
+QByteArray BlackBox::incident(qint64 window)
+{
+    QMutexLocker locker(&m_mutex);
+    RecordingHeader hdr;
+    RecordHeader rec;
+    QByteArray data;
+    qint64 last = 0;
+    qint64 first = -1;
+
+    if (!m_map) {
+        return data;
+    }
+    for (qint64 pos = m_tail; pos < m_head; pos += recordSize(pos)) {
+        const qint64 offset = pos % m_ringSize;
+        if (m_ringSize - offset >= (qint64)sizeof(rec)) {
+            memcpy((void *)&rec, m_ring + offset, sizeof(rec));
+            if (rec.signature) {
+                last = rec.timestamp;
+            }
+        }
+    }
+
+    data.reserve(sizeof(hdr) + (m_head - m_tail));
+    data.resize(sizeof(hdr));
+    for (qint64 pos = m_tail; pos < m_head; pos += recordSize(pos)) {
+        const qint64 offset = pos % m_ringSize;
+        if (m_ringSize - offset < (qint64)sizeof(rec)) {
+            continue;
+        }
+        memcpy((void *)&rec, m_ring + offset, sizeof(rec));
+        if (!rec.signature || ((window > 0) && (rec.timestamp < last - window))) {
+            continue;
+        }
+        if (first < 0) {
+            first = rec.timestamp;
+        }
+        rec.timestamp -= first;
+        data.append((const char *)&rec, sizeof(rec));
+        data.append((const char *)m_ring + offset + sizeof(rec), rec.data_size);
+    }
+
+    memset((void *)&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    hdr.version = RECORDING_VERSION;
+    hdr.header_size = sizeof(hdr);
+    hdr.start_time = m_header->start_time + qMax(first, (qint64)0) / 1000000;
+    memcpy(data.data(), (const char *)&hdr, sizeof(hdr));
+    return data;
+}
+
+/**
+ * @brief BlackBox::append
+ * Writes a record at the head, the oldest records make room for it.
+ */
+void BlackBox::append(quint8 msgId, quint8 signature, const char *data, int size)
+{
+    RecordHeader rec;
+    const qint64 recSize = sizeof(rec) + size;
+    qint64 offset = m_head % m_ringSize;
+
+    if (offset + recSize > m_ringSize) {
+        /* Records are not split, the rest of the ring is skipped. */
+        reserve(m_ringSize - offset);
+        if (m_ringSize - offset >= (qint64)sizeof(rec)) {
+            memset(m_ring + offset, 0, sizeof(rec));
+        }
+        m_head += m_ringSize - offset;
+        offset = 0;
+    }
+    reserve(recSize);
+
+    rec.timestamp = m_clock.nsecsElapsed();
+    rec.msg_id = msgId;
+    rec.signature = signature;
+    rec.data_size = size;
+    memcpy(m_ring + offset, (const void *)&rec, sizeof(rec));
+    memcpy(m_ring + offset + sizeof(rec), data, size);
+
+    /* The record is complete in the mapping before the head covers it. */
+    __sync_synchronize();
+    m_head += recSize;
+    m_header->head = m_head;
+}
+
+/**
+ * @brief BlackBox::reserve
+ * @param size - bytes needed after the head.
+ *
+ * Drops the oldest records until they fit. The tail is published before
+ * the records are overwritten, the ring stays consistent at any time.
+ */
+void BlackBox::reserve(qint64 size)
+{
+    if (m_head - m_tail + size <= m_ringSize) {
+        return;
+    }
+    while (m_head - m_tail + size > m_ringSize) {
+        m_tail += recordSize(m_tail);
+    }
+    m_header->tail = m_tail;
+    __sync_synchronize();
+}
+
+/**
+ * @brief BlackBox::recordSize
+ * @param pos - start of a record, or of the skipped end of the ring.
+ * @return bytes to the next record.
+ */
+qint64 BlackBox::recordSize(qint64 pos) const
+{
+    RecordHeader rec;
+    const qint64 offset = pos % m_ringSize;
+
+    if (m_ringSize - offset < (qint64)sizeof(rec)) {
+        return m_ringSize - offset;
+    }
+    memcpy((void *)&rec, m_ring + offset, sizeof(rec));
+    if (!rec.signature) {
+        return m_ringSize - offset;
+    }
+    return sizeof(rec) + rec.data_size;
+}
+
+/**
+ * @brief BlackBox::validRing
+ * @return true if the records from the tail end exactly at the head.
+ */
+bool BlackBox::validRing() const
+{
+    RecordHeader rec;
+    qint64 pos = m_tail;
+
+    if ((m_tail < 0) || (m_head < m_tail) || (m_head - m_tail > m_ringSize)) {
+        return false;
+    }
+    while (pos < m_head) {
+        const qint64 offset = pos % m_ringSize;
+        if (m_ringSize - offset >= (qint64)sizeof(rec)) {
+            memcpy((void *)&rec, m_ring + offset, sizeof(rec));
+            if (rec.signature && (((rec.signature != TELEMETRY_MSG_SIGNATURE) &&
+                                   (rec.signature != RECORDING_COMMAND_SIGNATURE)) ||
+                                  (rec.data_size > TELEMETRY_MSG_SIZE_BYTES_MAX) ||
+                                  (offset + (qint64)sizeof(rec) + rec.data_size > m_ringSize))) {
+                return false;
+            }
+        }
+        pos += recordSize(pos);
+    }
+    return pos == m_head;
+}
@@ -0,0 +1,83 @@
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include <QFile>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QByteArray>
+
+#include "telemetry.h"
+#include "recording.h"
+
+/* Ring file signature.                    */
+#define BLACKBOX_MAGIC                  "SMDRING"
+/* Ring file format version.               */
+#define BLACKBOX_VERSION                1
+/* Ring file size including the header.    */
+#define BLACKBOX_FILE_SIZE              (32 * 1024 * 1024)
+/* Ring file header size, one page.        */
+#define BLACKBOX_HEADER_SIZE            4096
+/* Time saved as an incident, minutes.     */
+#define BLACKBOX_INCIDENT_MINUTES       10
+
+/* The ring holds records as in a recording (see recording.h), a record is
+ * never split at the end of the ring, a zero signature or less than a
+ * record header left skips to the start. Head and tail are byte counts
+ * since the start, the ring offset is the count modulo ring_size.
+ */
+typedef struct tagBlackBoxHeader {
+    char magic[8];          /* BLACKBOX_MAGIC, zero terminated.            */
+    quint32 version;        /* BLACKBOX_VERSION.                           */
+    quint32 header_size;    /* Offset of the ring, BLACKBOX_HEADER_SIZE.   */
+    qint64 ring_size;       /* Size of the ring.                           */
+    qint64 start_time;      /* Host time of record timestamp 0, ms since
+                             * 1970-01-01 UTC.                             */
+    qint64 head;            /* End of the newest record.                   */
+    qint64 tail;            /* Start of the oldest record.                 */
+    quint32 clean;          /* Non-zero if closed by BlackBox::close().    */
+    quint32 reserved;
+} __attribute__((packed)) BlackBoxHeader;
+
+/* Always-on recorder of the last received frames and sent commands in a
+ * memory mapped ring file. A record costs a copy into the mapping, the
+ * kernel writes the pages back, so the ring survives a crash of the
+ * application. The ring of a session that did not close it is saved as
+ * a recording by the next open().
+ */
+class BlackBox
+{
+public:
+    BlackBox();
+    ~BlackBox();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return m_map != 0; }
+    QString errorString() const { return m_error; }
+    QString recoveredFileName() const { return m_recovered; }
+
+    void addFrame(const TelemetryMessage &msg, const char *data);
+    void addCommand(const char *data, int size);
+    QByteArray incident(qint64 window);
+
+private:
+    void append(quint8 msgId, quint8 signature, const char *data, int size);
+    void reserve(qint64 size);
+    qint64 recordSize(qint64 pos) const;
+    bool validRing() const;
+
+private:
+    QMutex m_mutex;
+    QFile m_file;
+    uchar *m_map;
+    BlackBoxHeader *m_header;   /* In the mapping.                  */
+    uchar *m_ring;
+    qint64 m_ringSize;
+    qint64 m_head;
+    qint64 m_tail;
+    QElapsedTimer m_clock;      /* Record timestamps.               */
+    QString m_recovered;
+    QString m_error;
+};
+
+#endif // BLACKBOX_H
@@ -0,0 +1,437 @@
+#include "bodeanalyzer.h"
+
+#include <qmath.h>
+#include <limits>
+
+/**
+ * @brief BodeAnalyzer::BodeAnalyzer
+ */
+BodeAnalyzer::BodeAnalyzer() :
+    m_state(StateIdle),
+    m_tone(0),
+    m_n(0),
+    m_settleSamples(0),
+    m_measureSamples(0),
+    m_held(0.0),
+    m_position(0),
+    m_commandPending(false),
+    m_omega(0.0),
+    m_chirpLo(1.0),
+    m_chirpHi(1.0)
+{
+    m_settings.excitation = ExcitationSteppedSine;
+    m_settings.sampleRate = 1.0;
+    m_settings.freqStart = 1.0;
+    m_settings.freqStop = 100.0;
+    m_settings.points = 20;
+    m_settings.offset = 0;
+    m_settings.amplitude = 0;
+    m_settings.settleCycles = 2;
+    m_settings.measureCycles = 10;
+    m_settings.chirpDuration = 10.0;
+}
+
+/**
+ * @brief BodeAnalyzer::freqMax
+ * @param sampleRate - stream sample rate, Hz.
+ * @return highest excitation frequency, half the rate of the actuator
+ * commands, Hz.
+ */
+double BodeAnalyzer::freqMax(double sampleRate)
+{
+    return sampleRate / (2.0 * BODE_COMMAND_SAMPLES);
+}
+
+/**
+ * @brief BodeAnalyzer::chirpDurationMax
+ * @param sampleRate - stream sample rate, Hz.
+ * @return longest chirp, the sweep is transformed as a whole, s.
+ */
+double BodeAnalyzer::chirpDurationMax(double sampleRate)
+{
+    return FFT_SIZE_MAX / qMax(1.0, sampleRate);
+}
+
+/**
+ * @brief BodeAnalyzer::start
+ * @param settings - excitation and frequency range of the measurement.
+ *
+ * The amplitude is limited so that the excitation stays within the
+ * actuator range around the offset, the chirp duration to
+ * chirpDurationMax(). settings() holds the values actually used. The
+ * first command, the offset itself, is available from takeCommand()
+ * right away.
+ */
+void BodeAnalyzer::start(const Settings &settings)
+{
+    m_settings = settings;
+    m_settings.sampleRate = qMax(1.0, m_settings.sampleRate);
+    m_settings.offset = qBound(0, m_settings.offset, BODE_POSITION_MAX);
+    m_settings.amplitude = qBound(1, m_settings.amplitude,
+                                  qMin(BODE_AMPLITUDE_MAX,
+                                       qMin(m_settings.offset, BODE_POSITION_MAX - m_settings.offset)));
+    m_settings.points = qBound(BODE_POINTS_MIN, m_settings.points, BODE_POINTS_MAX);
+    m_settings.freqStop = qBound(0.0, m_settings.freqStop, freqMax(m_settings.sampleRate));
+    m_settings.freqStart = qBound(m_settings.freqStop / 1e6, m_settings.freqStart, m_settings.freqStop);
+    m_settings.settleCycles = qMax(0, m_settings.settleCycles);
+    m_settings.measureCycles = qMax(1, m_settings.measureCycles);
+
+    const double ratio = m_settings.freqStop / m_settings.freqStart;
+    m_freqs.resize(m_settings.points);
+    for (int i = 0; i < m_settings.points; i++) {
+        m_freqs[i] = m_settings.freqStart * qPow(ratio, (double)i / (m_settings.points - 1));
+    }
+
+    m_points.clear();
+    if (m_settings.excitation == ExcitationChirp) {
+        /* Sweep half a point step beyond both ends, the outer bands get excitation too. */
+        const double halfStep = qPow(ratio, 0.5 / (m_settings.points - 1));
+        m_chirpLo = m_settings.freqStart / halfStep;
+        m_chirpHi = qMin(m_settings.freqStop * halfStep, freqMax(m_settings.sampleRate));
+        m_measureSamples = qBound(BODE_TONE_SAMPLES_MIN,
+                                  qRound(m_settings.chirpDuration * m_settings.sampleRate),
+                                  FFT_SIZE_MAX);
+        m_settings.chirpDuration = m_measureSamples / m_settings.sampleRate;
+        m_chirpE.clear();
+        m_chirpY.clear();
+        m_chirpE.reserve(m_measureSamples);
+        m_chirpY.reserve(m_measureSamples);
+        m_n = 0;
+        m_state = StateChirp;
+    } else {
+        startTone(0);
+    }
+    command(excitation(m_n));
+}
+
+/**
+ * @brief BodeAnalyzer::stop
+ * Aborts the measurement and returns the actuator to the offset.
+ */
+void BodeAnalyzer::stop()
+{
+    if (m_state == StateIdle) {
+        return;
+    }
+    m_state = StateIdle;
+    m_chirpE = QVector<double>();
+    m_chirpY = QVector<double>();
+    command(0.0);
+}
+
+/**
+ * @brief BodeAnalyzer::process
+ * @param samples - raw response samples.
+ * @param count - number of samples.
+ */
+void BodeAnalyzer::process(const qint16 *samples, int count)
+{
+    processSamples(samples, count);
+}
+
+/**
+ * @brief BodeAnalyzer::process
+ * @param samples - filtered response samples.
+ * @param count - number of samples.
+ */
+void BodeAnalyzer::process(const double *samples, int count)
+{
+    processSamples(samples, count);
+}
+
+/**
+ * @brief BodeAnalyzer::takeCommand
+ * @param position - receives the actuator position to send.
+ * @return false if the position did not change since the last call.
+ */
+bool BodeAnalyzer::takeCommand(quint16 &position)
+{
+    if (!m_commandPending) {
+        return false;
+    }
+    position = m_position;
+    m_commandPending = false;
+    return true;
+}
+
+/**
+ * @brief BodeAnalyzer::takePoint
+ * @param point - receives the oldest measured frequency point.
+ * @return false if there is no new point.
+ */
+bool BodeAnalyzer::takePoint(BodePoint &point)
+{
+    if (m_points.isEmpty()) {
+        return false;
+    }
+    point = m_points.first();
+    m_points.remove(0);
+    return true;
+}
+
+/**
+ * @brief BodeAnalyzer::processSamples
+ *
+ * Every sample is paired with the excitation commanded before it arrived.
+ * A finished tone is evaluated and the next one started within the same
+ * block, the command after the block already belongs to the new tone.
+ */
+template <typename T>
+void BodeAnalyzer::processSamples(const T *samples, int count)
+{
+    if (m_state == StateIdle) {
+        return;
+    }
+
+    resyncOscillator();
+    for (int i = 0; i < count; i++) {
+        const double y = samples[i];
+
+        if (m_state == StateMeasure) {
+            m_sumRefC += m_cos;
+            m_sumRefS += m_sin;
+            m_sumY += y;
+            m_sumYY += y * y;
+            m_sumYC += y * m_cos;
+            m_sumYS += y * m_sin;
+            m_sumE += m_held;
+            m_sumEC += m_held * m_cos;
+            m_sumES += m_held * m_sin;
+            const double c = m_cos * m_stepCos - m_sin * m_stepSin;
+            m_sin = m_sin * m_stepCos + m_cos * m_stepSin;
+            m_cos = c;
+        } else if (m_state == StateChirp) {
+            m_chirpE.append(m_held);
+            m_chirpY.append(y);
+        }
+        m_n++;
+
+        if ((m_state == StateSettle) && (m_n >= m_settleSamples)) {
+            m_state = StateMeasure;
+            resyncOscillator();
+        } else if ((m_state == StateMeasure) && (m_n >= m_settleSamples + m_measureSamples)) {
+            finishTone();
+        } else if ((m_state == StateChirp) && (m_n >= m_measureSamples)) {
+            finishChirp();
+        }
+        if (m_state == StateIdle) {
+            return;
+        }
+    }
+
+    command(excitation(m_n));
+}
+
+/**
+ * @brief BodeAnalyzer::startTone
+ * @param tone - index of the frequency point.
+ *
+ * The tone is measured over an integer number of its periods, at least
+ * BODE_TONE_SAMPLES_MIN samples, so the demodulation has no leakage.
+ */
+void BodeAnalyzer::startTone(int tone)
+{
+    const double f = m_freqs[tone];
+    const double periodSamples = m_settings.sampleRate / f;
+    const int cycles = qMax(m_settings.measureCycles, qCeil(BODE_TONE_SAMPLES_MIN / periodSamples));
+
+    m_tone = tone;
+    m_n = 0;
+    m_omega = 2.0 * M_PI * f / m_settings.sampleRate;
+    m_stepCos = qCos(m_omega);
+    m_stepSin = qSin(m_omega);
+    m_settleSamples = qCeil(m_settings.settleCycles * periodSamples);
+    m_measureSamples = qMax((qint64)1, (qint64)qRound64(cycles * periodSamples));
+    m_sumRefC = 0.0;
+    m_sumRefS = 0.0;
+    m_sumY = 0.0;
+    m_sumYY = 0.0;
+    m_sumYC = 0.0;
+    m_sumYS = 0.0;
+    m_sumE = 0.0;
+    m_sumEC = 0.0;
+    m_sumES = 0.0;
+    m_state = (m_settleSamples > 0) ? StateSettle : StateMeasure;
+    resyncOscillator();
+}
+
+/**
+ * @brief BodeAnalyzer::finishTone
+ *
+ * Response and excitation phasors are taken from the demodulator sums
+ * with the means removed, the point is their ratio. The coherence is the
+ * power of the response phasor relative to the whole response variance.
+ */
+void BodeAnalyzer::finishTone()
+{
+    const double n = (double)m_measureSamples;
+    const double meanY = m_sumY / n;
+    const double meanE = m_sumE / n;
+    const double yRe = m_sumYC - meanY * m_sumRefC;
+    const double yIm = -(m_sumYS - meanY * m_sumRefS);
+    const double eRe = m_sumEC - meanE * m_sumRefC;
+    const double eIm = -(m_sumES - meanE * m_sumRefS);
+    const double eAbs2 = eRe * eRe + eIm * eIm;
+    const double yAbs2 = yRe * yRe + yIm * yIm;
+    const double variance = m_sumYY - n * meanY * meanY;
+    BodePoint point;
+
+    point.frequency = m_freqs[m_tone];
+    if (eAbs2 > 0.0) {
+        point.gain = qSqrt(yAbs2 / eAbs2);
+        point.phase = qAtan2(yIm * eRe - yRe * eIm, yRe * eRe + yIm * eIm) * 180.0 / M_PI;
+    } else {
+        point.gain = std::numeric_limits<double>::quiet_NaN();
+        point.phase = std::numeric_limits<double>::quiet_NaN();
+    }
+    point.coherence = (variance > 0.0) ? qMin(1.0, 2.0 * yAbs2 / n / variance) : 0.0;
+    m_points.append(point);
+
+    if (m_tone + 1 < m_freqs.size()) {
+        startTone(m_tone + 1);
+    } else {
+        m_state = StateIdle;
+        command(0.0);
+    }
+}
+
+/**
+ * @brief BodeAnalyzer::finishChirp
+ *
+ * The records are transformed and the cross spectrum is averaged in a
+ * band of bins around every frequency point (H1 estimate). Coherence is
+ * the magnitude squared coherence over the bins of the band.
+ */
+void BodeAnalyzer::finishChirp()
+{
+    const int count = m_chirpY.size();
+    int size = FFT_SIZE_MIN;
+    while (size < count) {
+        size <<= 1;
+    }
+    const int half = size / 2;
+
+    double meanE = 0.0;
+    double meanY = 0.0;
+    for (int i = 0; i < count; i++) {
+        meanE += m_chirpE[i];
+        meanY += m_chirpY[i];
+    }
+    meanE /= count;
+    meanY /= count;
+    m_chirpE.resize(size);
+    m_chirpY.resize(size);
+    for (int i = 0; i < size; i++) {
+        m_chirpE[i] = (i < count) ? m_chirpE[i] - meanE : 0.0;
+        m_chirpY[i] = (i < count) ? m_chirpY[i] - meanY : 0.0;
+    }
+
+    QVector<double> eRe(half + 1);
+    QVector<double> eIm(half + 1);
+    QVector<double> yRe(half + 1);
+    QVector<double> yIm(half + 1);
+    m_fft.setSize(size);
+    m_fft.transform(m_chirpE.constData(), eRe.data(), eIm.data());
+    m_fft.transform(m_chirpY.constData(), yRe.data(), yIm.data());
+
+    const double binsPerHz = size / m_settings.sampleRate;
+    const double halfStep = qPow(m_settings.freqStop / m_settings.freqStart,
+                                 0.5 / (m_freqs.size() - 1));
+    for (int i = 0; i < m_freqs.size(); i++) {
+        const double f = m_freqs[i];
+        int kLo = qMax(1, qCeil(f / halfStep * binsPerHz));
+        int kHi = qMin(half, qFloor(f * halfStep * binsPerHz));
+        if (kLo > kHi) {
+            kLo = kHi = qBound(1, qRound(f * binsPerHz), half);
+        }
+
+        double sxyRe = 0.0;
+        double sxyIm = 0.0;
+        double sxx = 0.0;
+        double syy = 0.0;
+        for (int k = kLo; k <= kHi; k++) {
+            sxyRe += yRe[k] * eRe[k] + yIm[k] * eIm[k];
+            sxyIm += yIm[k] * eRe[k] - yRe[k] * eIm[k];
+            sxx += eRe[k] * eRe[k] + eIm[k] * eIm[k];
+            syy += yRe[k] * yRe[k] + yIm[k] * yIm[k];
+        }
+
+        const double sxy2 = sxyRe * sxyRe + sxyIm * sxyIm;
+        BodePoint point;
+        point.frequency = f;
+        if (sxx > 0.0) {
+            point.gain = qSqrt(sxy2) / sxx;
+            point.phase = qAtan2(sxyIm, sxyRe) * 180.0 / M_PI;
+        } else {
+            point.gain = std::numeric_limits<double>::quiet_NaN();
+            point.phase = std::numeric_limits<double>::quiet_NaN();
+        }
+        point.coherence = ((sxx > 0.0) && (syy > 0.0)) ? sxy2 / (sxx * syy) : 0.0;
+        m_points.append(point);
+    }
+
+    m_chirpE = QVector<double>();
+    m_chirpY = QVector<double>();
+    m_state = StateIdle;
+    command(0.0);
+}
+
+/**
+ * @brief BodeAnalyzer::resyncOscillator
+ * Sets the reference oscillator to the exact phase of the current sample,
+ * the recursion only runs for a block.
+ */
+void BodeAnalyzer::resyncOscillator()
+{
+    if (m_state == StateMeasure) {
+        const double theta = m_omega * m_n;
+        m_cos = qCos(theta);
+        m_sin = qSin(theta);
+    }
+}
+
+/**
+ * @brief BodeAnalyzer::excitation
+ * @param n - samples since the tone or sweep started.
+ * @return excitation relative to the offset.
+ */
+double BodeAnalyzer::excitation(qint64 n) const
+{
+    switch (m_state) {
+    case StateSettle:
+    case StateMeasure:
+        return m_settings.amplitude * qSin(m_omega * n);
+    case StateChirp:
+        if (n < m_measureSamples) {
+            /* Exponential sweep, the phase is the integral of f0 * k^(t / T). */
+            const double k = m_chirpHi / m_chirpLo;
+            const double duration = m_measureSamples / m_settings.sampleRate;
+            const double t = n / m_settings.sampleRate;
+            const double phase = (k > 1.0) ?
+                                 2.0 * M_PI * m_chirpLo * duration / qLn(k) * (qPow(k, t / duration) - 1.0) :
+                                 2.0 * M_PI * m_chirpLo * t;
+            return m_settings.amplitude * qSin(phase);
+        }
+        return 0.0;
+    default:
+        return 0.0;
+    }
+}
+
+/**
+ * @brief BodeAnalyzer::command
+ * @param value - excitation relative to the offset.
+ *
+ * The position is rounded as it will be sent, the rounded value is what
+ * the following samples are demodulated against.
+ */
+void BodeAnalyzer::command(double value)
+{
+    const int position = qBound(0, qRound(m_settings.offset + value), BODE_POSITION_MAX);
+
+    m_held = position - m_settings.offset;
+    if ((position != m_position) || (m_state == StateIdle)) {
+        m_commandPending = true;
+    }
+    m_position = position;
+}
@@ -0,0 +1,127 @@
+#ifndef BODEANALYZER_H
+#define BODEANALYZER_H
+
+#include <QMetaType>
+#include <QVector>
+
+#include "fft.h"
+#include "telemetry.h"
+
+/* Frequency points of a measurement.      */
+#define BODE_POINTS_MIN                 2
+#define BODE_POINTS_MAX                 200
+/* Minimum samples demodulated per tone.   */
+#define BODE_TONE_SAMPLES_MIN           256
+/* Maximum excitation amplitude.           */
+#define BODE_AMPLITUDE_MAX              2047
+/* Largest actuator position.              */
+#define BODE_POSITION_MAX               4095
+/* Samples per command, one per message.   */
+#define BODE_COMMAND_SAMPLES            STREAMING_BUF_DEPTH
+
+typedef struct tagBodePoint {
+    double frequency;   /* Hz.                                                   */
+    double gain;        /* Response per excitation amplitude, linear.            */
+    double phase;       /* Response phase against the excitation, degrees.       */
+    double coherence;   /* Share of the response explained by the excitation.    */
+} BodePoint;
+
+Q_DECLARE_METATYPE(BodePoint);
+
+/* Frequency response measurement. The excitation is generated here as
+ * actuator positions, one per stream message, and the stream is the
+ * response. Both the response and the position staircase actually
+ * commanded are demodulated, so the hold between commands does not bias
+ * the result; the latency of the serial link shows up as phase lag.
+ * With one command per message, tones above half the command rate
+ * would alias, freqMax() is the highest frequency measured.
+ */
+class BodeAnalyzer
+{
+public:
+    enum Excitation {
+        ExcitationSteppedSine = 0,  /* One tone per point, demodulated.   */
+        ExcitationChirp             /* Log sweep, cross spectrum in bands. */
+    };
+
+    typedef struct tagSettings {
+        Excitation excitation;
+        double sampleRate;      /* Stream sample rate, Hz.                 */
+        double freqStart;       /* Hz.                                     */
+        double freqStop;
+        int points;
+        int offset;             /* Actuator position of zero excitation.   */
+        int amplitude;          /* Actuator position units.                */
+        int settleCycles;       /* Stepped sine: cycles before measuring.  */
+        int measureCycles;      /* Stepped sine: cycles demodulated.       */
+        double chirpDuration;   /* Chirp: sweep time, s.                   */
+    } Settings;
+
+    BodeAnalyzer();
+
+    static double freqMax(double sampleRate);
+    static double chirpDurationMax(double sampleRate);
+
+    void start(const Settings &settings);
+    void stop();
+    bool isRunning() const { return m_state != StateIdle; }
+    const Settings &settings() const { return m_settings; }
+    const QVector<double> &frequencies() const { return m_freqs; }
+
+    void process(const qint16 *samples, int count);
+    void process(const double *samples, int count);
+    bool takeCommand(quint16 &position);
+    bool takePoint(BodePoint &point);
+
+private:
+    enum State {
+        StateIdle = 0,
+        StateSettle,    /* Tone running, response not settled yet. */
+        StateMeasure,   /* Tone running, demodulating.             */
+        StateChirp      /* Sweep running, recording.               */
+    };
+
+    template <typename T> void processSamples(const T *samples, int count);
+    void startTone(int tone);
+    void finishTone();
+    void finishChirp();
+    void resyncOscillator();
+    double excitation(qint64 n) const;
+    void command(double value);
+
+private:
+    Settings m_settings;
+    State m_state;
+    QVector<double> m_freqs;
+    int m_tone;
+    qint64 m_n;             /* Samples since the tone or sweep started. */
+    qint64 m_settleSamples;
+    qint64 m_measureSamples;
+    double m_held;          /* Excitation of the last command, applies now. */
+    quint16 m_position;
+    bool m_commandPending;
+    /* Reference oscillator and demodulator sums of the running tone. */
+    double m_omega;         /* Radians per sample. */
+    double m_cos;
+    double m_sin;
+    double m_stepCos;
+    double m_stepSin;
+    double m_sumRefC;
+    double m_sumRefS;
+    double m_sumY;
+    double m_sumYY;
+    double m_sumYC;
+    double m_sumYS;
+    double m_sumE;
+    double m_sumEC;
+    double m_sumES;
+    /* Chirp sweep range and records of the excitation and the response. */
+    double m_chirpLo;
+    double m_chirpHi;
+    QVector<double> m_chirpE;
+    QVector<double> m_chirpY;
+    RealFFT m_fft;
+    QVector<BodePoint> m_points;
+};
+
+#endif // BODEANALYZER_H
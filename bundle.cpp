@@ -0,0 +1,79 @@
+#include "bundle.h"
+
+#include <QFile>
+#include <QObject>
+
+/**
+ * @brief bundleWrite
+ * @param fileName - bundle file.
+ * @param snapshot - device settings, magic, version and size are set here.
+ * @param recording - stream around the snapshot as a recording file, may
+ * be empty.
+ * @param error - set if writing failed.
+ * @return false if the file can't be written.
+ */
+bool bundleWrite(const QString &fileName, const BundleSnapshot &snapshot,
+                 const QByteArray &recording, QString &error)
+{
+    RecordingHeader hdr;
+    BundleSnapshot snap = snapshot;
+    int first = recording.size();   /* Offset of the first record. */
+
+    if (recording.size() >= (int)sizeof(hdr)) {
+        memcpy((void *)&hdr, recording.constData(), sizeof(hdr));
+        first = qMin((int)hdr.header_size, recording.size());
+    } else {
+        memset((void *)&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+        hdr.version = RECORDING_VERSION;
+        hdr.start_time = snapshot.snapshot_time;
+    }
+    hdr.header_size = sizeof(hdr) + sizeof(snap);
+
+    memset(snap.magic, 0, sizeof(snap.magic));
+    memcpy(snap.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC));
+    snap.version = BUNDLE_VERSION;
+    snap.size = sizeof(snap);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        (file.write((const char *)&hdr, sizeof(hdr)) != sizeof(hdr)) ||
+        (file.write((const char *)&snap, sizeof(snap)) != sizeof(snap)) ||
+        (file.write(recording.constData() + first, recording.size() - first) != recording.size() - first) ||
+        !file.flush()) {
+        error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief bundleRead
+ * @param fileName - bundle file.
+ * @param snapshot - set to the device settings of the bundle.
+ * @param error - set if the file is not a bundle.
+ * @return false if the file is not a bundle or unsupported version.
+ *
+ * Reads the headers only, the stream is left to the replay.
+ */
+bool bundleRead(const QString &fileName, BundleSnapshot &snapshot, QString &error)
+{
+    QFile file(fileName);
+    RecordingHeader hdr;
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    memset((void *)&snapshot, 0, sizeof(snapshot));
+    if ((file.read((char *)&hdr, sizeof(hdr)) != sizeof(hdr)) ||
+        (memcmp(hdr.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0) ||
+        (hdr.header_size < sizeof(hdr) + sizeof(snapshot)) ||
+        (file.read((char *)&snapshot, sizeof(snapshot)) != sizeof(snapshot)) ||
+        (memcmp(snapshot.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) != 0) ||
+        (snapshot.version != BUNDLE_VERSION) || (snapshot.size != sizeof(snapshot))) {
+        error = QObject::tr("Not a bundle or unsupported version");
+        return false;
+    }
+    return true;
+}
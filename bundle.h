@@ -0,0 +1,74 @@
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include <QString>
+#include <QByteArray>
+
+#include "telemetry.h"
+#include "recording.h"
+
+/* Bundle snapshot signature.              */
+#define BUNDLE_MAGIC                    "SMDBND1"
+/* Bundle snapshot format version.         */
+#define BUNDLE_VERSION                  1
+/* Bundle file suffix.                     */
+#define BUNDLE_SUFFIX                   ".smdbnd"
+/* Stream kept before the snapshot, s.     */
+#define BUNDLE_STREAM_SECONDS           30
+/* Stream recorded after the snapshot, s.  */
+#define BUNDLE_POST_SECONDS             10
+/* Wait for the settings replies, ms.      */
+#define BUNDLE_SETTINGS_TIMEOUT_MS      500
+
+/* Settings replies received, BundleSnapshot.received. */
+#define BUNDLE_HAVE_FOC                 0x01    /* 'a' */
+#define BUNDLE_HAVE_RAD                 0x02    /* 'b' */
+#define BUNDLE_HAVE_FBK                 0x04    /* 'c' */
+#define BUNDLE_HAVE_MOTOR               0x08    /* 'o' */
+#define BUNDLE_HAVE_SPEED               0x10    /* 'p' */
+#define BUNDLE_HAVE_ALL                 0x1F
+
+/* PID loop values as entered on the PID tab. They are GUI state only,
+ * the board is never sent them and can't be asked for them.
+ */
+typedef struct tagBundlePid {
+    float p;
+    float i;
+    float d;
+    qint32 setpoint;
+    quint8 enabled;
+    quint8 reverse;
+    quint16 reserved;
+} __attribute__((packed)) BundlePid;
+
+/* Device settings at the time of the bundle. */
+typedef struct tagBundleSnapshot {
+    char magic[8];          /* BUNDLE_MAGIC, zero terminated.              */
+    quint32 version;        /* BUNDLE_VERSION.                             */
+    quint32 size;           /* Size of the snapshot.                       */
+    qint64 snapshot_time;   /* Host time of the settings request, ms since
+                             * 1970-01-01 UTC.                             */
+    quint32 read_ms;        /* Time to receive the replies.                */
+    quint8 received;        /* BUNDLE_HAVE_* of the replies received.      */
+    quint8 stream_channel;  /* STREAMING_CHANNEL_* selected.               */
+    quint8 multi_mask;      /* Channels of the multi-channel stream.       */
+    quint8 reserved;
+    quint16 actuator[3];    /* FOC, RAD and FBK positions.                 */
+    quint8 motor_power;     /* Motor settings, 'o'.                        */
+    quint8 motor_flags;     /* PWM_OUT_FLAG_*.                             */
+    quint32 motor_speed;    /* Motor speed as read, 'p'.                   */
+    BundlePid gui_pid[2];   /* PID tab, Z and FOC, GUI values only.        */
+    LinkStatistics link;    /* Serial link at the time of the bundle.      */
+} __attribute__((packed)) BundleSnapshot;
+
+/* A bundle is a recording (see recording.h) of the stream from
+ * BUNDLE_STREAM_SECONDS before to BUNDLE_POST_SECONDS after a settings
+ * snapshot, the snapshot is stored between the recording header and the
+ * first record, header_size skips it. Bundles replay and export as any
+ * recording, bundleRead() only reads the snapshot.
+ */
+bool bundleWrite(const QString &fileName, const BundleSnapshot &snapshot,
+                 const QByteArray &recording, QString &error);
+bool bundleRead(const QString &fileName, BundleSnapshot &snapshot, QString &error);
+
+#endif // BUNDLE_H
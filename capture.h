@@ -0,0 +1,98 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <QtGlobal>
+
+/* Capture file signature.                 */
+#define CAPTURE_MAGIC                   "SMDCAP1"
+/* Capture file format version.            */
+#define CAPTURE_VERSION                 1
+/* Samples per chunk.                      */
+#define CAPTURE_CHUNK_SAMPLES           4096
+/* Chunk header signature, "CHNK".         */
+#define CAPTURE_CHUNK_MAGIC             0x4B4E4843
+/* Trailer signature, "CIDX".              */
+#define CAPTURE_TRAILER_MAGIC           0x58444943
+/* Event index file signature.             */
+#define CAPTURE_EVENTS_MAGIC            "SMDEVT1"
+/* Event index format version.             */
+#define CAPTURE_EVENTS_VERSION          1
+/* Event index file suffix.                */
+#define CAPTURE_EVENTS_SUFFIX           ".smdevt"
+/* Maximum event data, notes are cut.      */
+#define CAPTURE_EVENT_DATA_MAX          1024
+
+/* Event types. */
+#define CAPTURE_EVENT_COMMAND           0x01    /* Command sent to the board.  */
+#define CAPTURE_EVENT_CHANNEL           0x02    /* Stream channel switch, 'S'. */
+#define CAPTURE_EVENT_STREAM_START      0x03    /* Streaming or scanning, 'T'. */
+#define CAPTURE_EVENT_STREAM_STOP       0x04    /* Streaming stopped.          */
+#define CAPTURE_EVENT_MARKER            0x05    /* Period marker, '.'.         */
+#define CAPTURE_EVENT_NOTE              0x06    /* Operator note, UTF-8 text.  */
+
+/* A capture stores the stream samples of each channel compressed in
+ * chunks of up to CAPTURE_CHUNK_SAMPLES samples (see captureEncode()).
+ * The layout is the file header, the chunks as they were filled, each a
+ * chunk header followed by the encoded samples, then the index of all
+ * chunk headers and the trailer. Everything is packed without padding in
+ * host byte order. A capture without a valid trailer was not closed, its
+ * chunks are found by walking the chunk headers.
+ */
+typedef struct tagCaptureHeader {
+    char magic[8];          /* CAPTURE_MAGIC, zero terminated.             */
+    quint32 version;        /* CAPTURE_VERSION.                            */
+    quint32 header_size;    /* Offset of the first chunk.                  */
+    qint64 start_time;      /* Host time of timestamp 0, ms since
+                             * 1970-01-01 UTC.                             */
+} __attribute__((packed)) CaptureHeader;
+
+typedef struct tagCaptureChunk {
+    quint32 magic;          /* CAPTURE_CHUNK_MAGIC.                        */
+    quint8 channel;         /* Streaming channel ID.                       */
+    quint8 reserved;
+    quint16 count;          /* Number of samples.                          */
+    quint32 size;           /* Size of the encoded samples.                */
+    qint64 first_sample;    /* Index of the first sample in the channel.   */
+    qint64 time_first;      /* Host receive time of the first and of the   */
+    qint64 time_last;       /* last sample since start_time, ns.           */
+    qint16 min;             /* Sample range.                               */
+    qint16 max;
+} __attribute__((packed)) CaptureChunk;
+
+typedef struct tagCaptureIndexEntry {
+    qint64 offset;          /* File offset of the chunk header.            */
+    CaptureChunk chunk;     /* Copy of the chunk header.                   */
+} __attribute__((packed)) CaptureIndexEntry;
+
+typedef struct tagCaptureTrailer {
+    qint64 index_offset;    /* File offset of the index.                   */
+    quint32 index_count;    /* Number of index entries.                    */
+    quint32 magic;          /* CAPTURE_TRAILER_MAGIC.                      */
+} __attribute__((packed)) CaptureTrailer;
+
+/* The events of a capture are kept next to it, in a file of the same
+ * name with the suffix CAPTURE_EVENTS_SUFFIX: the header followed by the
+ * events, each an event header and its data. Events are appended in the
+ * order they happen, notes added later may be out of order. The file is
+ * packed like the capture, a truncated last event is ignored.
+ */
+typedef struct tagCaptureEventsHeader {
+    char magic[8];          /* CAPTURE_EVENTS_MAGIC, zero terminated.      */
+    quint32 version;        /* CAPTURE_EVENTS_VERSION.                     */
+    quint32 header_size;    /* Offset of the first event.                  */
+    qint64 start_time;      /* start_time of the capture.                  */
+} __attribute__((packed)) CaptureEventsHeader;
+
+typedef struct tagCaptureEvent {
+    qint64 timestamp;       /* Time since start_time, ns.                  */
+    qint64 sample;          /* Samples of the channel captured before.     */
+    quint8 type;            /* CAPTURE_EVENT_*.                            */
+    quint8 msg_id;          /* Telemetry message ID of the command.        */
+    quint8 channel;         /* Streaming channel ID the sample counts.     */
+    quint8 reserved;
+    quint16 data_size;      /* Size of the data following the event:
+                             * message data of commands, 'S' and 'T', the
+                             * text of notes.                              */
+} __attribute__((packed)) CaptureEvent;
+
+#endif // CAPTURE_H
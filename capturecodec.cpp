@@ -0,0 +1,109 @@
+#include "capturecodec.h"
+
+/**
+ * @brief captureEncode
+ * @param in - samples.
+ * @param count - number of samples.
+ * @param out - at least CAPTURE_ENCODED_SIZE_MAX(count) bytes.
+ * @return number of bytes written.
+ */
+int captureEncode(const qint16 *in, int count, quint8 *out)
+{
+    quint32 zz[CAPTURE_BLOCK_SAMPLES];
+    quint8 *p = out;
+
+    if (count <= 0) {
+        return 0;
+    }
+    *p++ = (quint8)in[0];
+    *p++ = (quint8)((quint16)in[0] >> 8);
+
+    for (int i = 1; i < count; i += CAPTURE_BLOCK_SAMPLES) {
+        const int n = qMin(CAPTURE_BLOCK_SAMPLES, count - i);
+        quint32 all = 0;
+        for (int j = 0; j < n; j++) {
+            const qint32 d = (qint32)in[i + j] - in[i + j - 1];
+            zz[j] = ((quint32)d << 1) ^ (quint32)(d >> 31);
+            all |= zz[j];
+        }
+        int width = 0;
+        while (all >> width) {
+            width++;
+        }
+        *p++ = (quint8)width;
+
+        /* LSB first, flushed a byte at a time. */
+        quint64 acc = 0;
+        int bits = 0;
+        for (int j = 0; j < n; j++) {
+            acc |= (quint64)zz[j] << bits;
+            bits += width;
+            while (bits >= 8) {
+                *p++ = (quint8)acc;
+                acc >>= 8;
+                bits -= 8;
+            }
+        }
+        if (bits > 0) {
+            *p++ = (quint8)acc;
+        }
+    }
+    return p - out;
+}
+
+/**
+ * @brief captureDecode
+ * @param in - encoded samples.
+ * @param size - number of encoded bytes.
+ * @param out - receives count samples.
+ * @param count - number of samples encoded.
+ * @return false if the data is corrupt.
+ */
+bool captureDecode(const quint8 *in, int size, qint16 *out, int count)
+{
+    const quint8 *p = in;
+    const quint8 *end = in + size;
+
+    if (count <= 0) {
+        return true;
+    }
+    if (size < 2) {
+        return false;
+    }
+    qint16 prev = (qint16)(p[0] | (p[1] << 8));
+    out[0] = prev;
+    p += 2;
+
+    for (int i = 1; i < count; i += CAPTURE_BLOCK_SAMPLES) {
+        const int n = qMin(CAPTURE_BLOCK_SAMPLES, count - i);
+        if (p >= end) {
+            return false;
+        }
+        const int width = *p++;
+        if ((width > CAPTURE_DELTA_BITS_MAX) || (end - p < (n * width + 7) / 8)) {
+            return false;
+        }
+        if (width == 0) {
+            for (int j = 0; j < n; j++) {
+                out[i + j] = prev;
+            }
+            continue;
+        }
+
+        const quint32 mask = (1u << width) - 1;
+        quint64 acc = 0;
+        int bits = 0;
+        for (int j = 0; j < n; j++) {
+            while (bits < width) {
+                acc |= (quint64)*p++ << bits;
+                bits += 8;
+            }
+            const quint32 z = (quint32)acc & mask;
+            acc >>= width;
+            bits -= width;
+            prev = (qint16)(prev + (qint32)((z >> 1) ^ (0u - (z & 1))));
+            out[i + j] = prev;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,22 @@
+#ifndef CAPTURECODEC_H
+#define CAPTURECODEC_H
+
+#include <QtGlobal>
+
+/* Samples sharing one bit width.          */
+#define CAPTURE_BLOCK_SAMPLES           128
+/* Widest zigzag coded int16 delta, bits.  */
+#define CAPTURE_DELTA_BITS_MAX          17
+/* Encoded size limit of count samples.    */
+#define CAPTURE_ENCODED_SIZE_MAX(count) \
+    (2 + (((count) + CAPTURE_BLOCK_SAMPLES - 1) / CAPTURE_BLOCK_SAMPLES) * \
+         (1 + (CAPTURE_BLOCK_SAMPLES * CAPTURE_DELTA_BITS_MAX + 7) / 8))
+
+/* Lossless int16 sample compression. The first sample is stored as is,
+ * the following ones as zigzag coded deltas, bit packed in blocks of
+ * CAPTURE_BLOCK_SAMPLES with the width of the largest delta of the block.
+ */
+int captureEncode(const qint16 *in, int count, quint8 *out);
+bool captureDecode(const quint8 *in, int size, qint16 *out, int count);
+
+#endif // CAPTURECODEC_H
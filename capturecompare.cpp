@@ -0,0 +1,755 @@
+#include "capturecompare.h"
+#include "captureevents.h"
+#include "workpool.h"
+
+#include <QElapsedTimer>
+#include <qmath.h>
+#include <algorithm>
+#include <limits>
+
+/* Sequential reader of a channel, each chunk is decoded once however the
+ * reads are split.
+ */
+class SampleCursor
+{
+public:
+    SampleCursor(const CaptureReader &reader, int channel) :
+        m_reader(reader), m_channel(channel), m_chunk(-1), m_buf(CAPTURE_CHUNK_SAMPLES) {}
+
+    /* Returns the samples read, less than count at the end of the channel
+     * or at a corrupt chunk. */
+    int read(qint64 first, int count, qint16 *samples)
+    {
+        int done = 0;
+
+        while (done < count) {
+            const qint64 s = first + done;
+            if ((m_chunk < 0) || (s < m_first) || (s >= m_first + m_count)) {
+                m_chunk = m_reader.findSample(m_channel, s);
+                if ((m_chunk < 0) || !m_reader.readChunk(m_channel, m_chunk, m_buf.data())) {
+                    m_chunk = -1;
+                    break;
+                }
+                m_first = m_reader.chunk(m_channel, m_chunk).chunk.first_sample;
+                m_count = m_reader.chunk(m_channel, m_chunk).chunk.count;
+            }
+            const int n = (int)qMin((qint64)(count - done), m_first + m_count - s);
+            memcpy((void *)(samples + done), (const void *)(m_buf.constData() + (s - m_first)),
+                   n * sizeof(qint16));
+            done += n;
+        }
+        return done;
+    }
+
+private:
+    const CaptureReader &m_reader;
+    int m_channel;
+    int m_chunk;            /* Decoded chunk, -1 if none.               */
+    qint64 m_first;
+    int m_count;
+    QVector<qint16> m_buf;
+};
+
+/**
+ * @brief clearMoments
+ */
+static void clearMoments(CompareMoments &m)
+{
+    memset((void *)&m, 0, sizeof(m));
+    m.diffMin = std::numeric_limits<int>::max();
+    m.diffMax = std::numeric_limits<int>::min();
+}
+
+/**
+ * @brief addMoments
+ * @param to - receives the sums of both.
+ */
+static void addMoments(CompareMoments &to, const CompareMoments &from)
+{
+    to.count += from.count;
+    to.sumA += from.sumA;
+    to.sumB += from.sumB;
+    to.sumAA += from.sumAA;
+    to.sumBB += from.sumBB;
+    to.sumAB += from.sumAB;
+    to.diffMin = qMin(to.diffMin, from.diffMin);
+    to.diffMax = qMax(to.diffMax, from.diffMax);
+}
+
+/* Sums of one task, merged into the segments once all tasks are done. */
+typedef struct tagCompareOutput {
+    bool ok;                        /* false at a corrupt chunk.        */
+    int firstSegment;
+    QVector<CompareMoments> moments;
+    qint64 firstBlock;
+    QVector<int> blockMin;
+    QVector<int> blockMax;
+} CompareOutput;
+
+/* Comparison of a range of the concatenated segments. */
+class CompareTask : public WorkTask
+{
+public:
+    CompareTask(const CaptureReader &golden, const CaptureReader &suspect, int channel,
+                const QVector<CompareSegment> &segments, const QVector<qint64> &offsets,
+                qint64 from, qint64 to, CompareOutput *out, QAtomicInt *done, const QAtomicInt *cancel) :
+        m_golden(golden), m_suspect(suspect), m_channel(channel), m_segments(segments),
+        m_offsets(offsets), m_from(from), m_to(to), m_out(out), m_done(done), m_cancel(cancel) {}
+
+    void run(WorkPool &pool, int worker) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(pool);
+        Q_UNUSED(worker);
+        SampleCursor a(m_golden, m_channel);
+        SampleCursor b(m_suspect, m_channel);
+        qint16 sa[COMPARE_BLOCK_SAMPLES];
+        qint16 sb[COMPARE_BLOCK_SAMPLES];
+        CompareOutput &out = *m_out;
+
+        /* Last segment starting at or before the range. */
+        int seg = std::upper_bound(m_offsets.constBegin(), m_offsets.constEnd(), m_from) -
+                  m_offsets.constBegin() - 1;
+        out.ok = true;
+        out.firstSegment = seg;
+        out.firstBlock = (m_segments[seg].firstA + m_from - m_offsets[seg]) / COMPARE_BLOCK_SAMPLES;
+
+        for (qint64 pos = m_from; (pos < m_to) && !m_cancel->load(); seg++) {
+            const CompareSegment &segment = m_segments[seg];
+            const qint64 end = qMin(m_to, m_offsets[seg] + segment.length);
+            CompareMoments m;
+            clearMoments(m);
+
+            while (pos < end) {
+                const qint64 first = segment.firstA + pos - m_offsets[seg];
+                /* Pieces follow the block grid, a piece updates one block. */
+                const int k = (int)qMin(end - pos, COMPARE_BLOCK_SAMPLES - first % COMPARE_BLOCK_SAMPLES);
+                if ((a.read(first, k, sa) != k) ||
+                    (b.read(segment.firstB + pos - m_offsets[seg], k, sb) != k)) {
+                    out.ok = false;
+                    return;
+                }
+                int dmin = std::numeric_limits<int>::max();
+                int dmax = std::numeric_limits<int>::min();
+                for (int i = 0; i < k; i++) {
+                    const int x = sa[i];
+                    const int y = sb[i];
+                    m.sumA += x;
+                    m.sumB += y;
+                    m.sumAA += x * x;
+                    m.sumBB += y * y;
+                    m.sumAB += x * y;
+                    dmin = qMin(dmin, y - x);
+                    dmax = qMax(dmax, y - x);
+                }
+                m.count += k;
+                m.diffMin = qMin(m.diffMin, dmin);
+                m.diffMax = qMax(m.diffMax, dmax);
+
+                /* Marker segments may skip blocks, those stay uncovered. */
+                const int block = first / COMPARE_BLOCK_SAMPLES - out.firstBlock;
+                while (out.blockMin.size() <= block) {
+                    out.blockMin.append(std::numeric_limits<int>::max());
+                    out.blockMax.append(std::numeric_limits<int>::min());
+                }
+                out.blockMin[block] = qMin(out.blockMin[block], dmin);
+                out.blockMax[block] = qMax(out.blockMax[block], dmax);
+                pos += k;
+                m_done->fetchAndAddRelaxed(1);
+                if (m_cancel->load()) {
+                    break;
+                }
+            }
+            out.moments.append(m);
+        }
+    }
+
+private:
+    const CaptureReader &m_golden;
+    const CaptureReader &m_suspect;
+    int m_channel;
+    const QVector<CompareSegment> &m_segments;
+    const QVector<qint64> &m_offsets;   /* Start of each segment in the
+                                         * concatenated segments.       */
+    qint64 m_from;
+    qint64 m_to;
+    CompareOutput *m_out;
+    QAtomicInt *m_done;                 /* Pieces compared.             */
+    const QAtomicInt *m_cancel;
+};
+
+/**
+ * @brief CaptureCompare::CaptureCompare
+ * @param parent
+ */
+CaptureCompare::CaptureCompare(QObject *parent) :
+    QThread(parent)
+{
+    m_settings.channel = 0;
+    m_settings.alignment = AlignMarkers;
+}
+
+/**
+ * @brief CaptureCompare::~CaptureCompare
+ */
+CaptureCompare::~CaptureCompare()
+{
+    cancel();
+    wait();
+}
+
+/**
+ * @brief CaptureCompare::startCompare
+ * @param settings - captures to compare, a running comparison is
+ * cancelled first.
+ *
+ * The result of the previous comparison is invalid from here on.
+ */
+void CaptureCompare::startCompare(const Settings &settings)
+{
+    cancel();
+    wait();
+    m_settings = settings;
+    m_cancel.store(0);
+    start(QThread::LowPriority);
+}
+
+/**
+ * @brief CaptureCompare::cancel
+ */
+void CaptureCompare::cancel()
+{
+    m_cancel.store(1);
+}
+
+/**
+ * @brief CaptureCompare::stats
+ * @param moments - sums of an aligned range.
+ * @return deltas of the range, count 0 if it is empty.
+ */
+CompareStats CaptureCompare::stats(const CompareMoments &moments)
+{
+    CompareStats s;
+    const double n = moments.count;
+
+    memset((void *)&s, 0, sizeof(s));
+    s.correlation = qQNaN();
+    if (moments.count == 0) {
+        return s;
+    }
+    s.count = moments.count;
+    s.meanA = moments.sumA / n;
+    s.meanB = moments.sumB / n;
+    const double varA = qMax(moments.sumAA / n - s.meanA * s.meanA, 0.0);
+    const double varB = qMax(moments.sumBB / n - s.meanB * s.meanB, 0.0);
+    s.stdA = qSqrt(varA);
+    s.stdB = qSqrt(varB);
+    s.deltaMean = s.meanB - s.meanA;
+    s.deltaStd = s.stdB - s.stdA;
+    /* Sum of the squared differences, exact in integers. */
+    s.rmsDiff = qSqrt((moments.sumAA + moments.sumBB - 2 * moments.sumAB) / n);
+    s.maxAbsDiff = qMax(qAbs(moments.diffMin), qAbs(moments.diffMax));
+    if ((varA > 0.0) && (varB > 0.0)) {
+        s.correlation = (moments.sumAB / n - s.meanA * s.meanB) / (s.stdA * s.stdB);
+    }
+    return s;
+}
+
+/**
+ * @brief CaptureCompare::total
+ * @return deltas of all segments.
+ */
+CompareStats CaptureCompare::total() const
+{
+    CompareMoments m;
+
+    clearMoments(m);
+    for (int i = 0; i < m_segments.size(); i++) {
+        addMoments(m, m_segments[i].moments);
+    }
+    return stats(m);
+}
+
+/**
+ * @brief CaptureCompare::suspectSample
+ * @param sample - golden sample index.
+ * @return suspect sample aligned to it, by the lag of the segment at or
+ * before the sample.
+ */
+qint64 CaptureCompare::suspectSample(qint64 sample) const
+{
+    const int i = qMax(findSegment(sample), 0);
+
+    if (m_segments.isEmpty()) {
+        return sample;
+    }
+    return sample + m_segments[i].firstB - m_segments[i].firstA;
+}
+
+/**
+ * @brief CaptureCompare::differenceEnvelope
+ * @param first - first visible golden sample index.
+ * @param last - last visible golden sample index.
+ * @param pixels - horizontal resolution.
+ * @param keys - receives the golden sample index of each point.
+ * @param min - receives the minimum of suspect - golden of each point,
+ * NaN where no segment covers it.
+ * @param max - receives the maximum, equal to the minimum when the
+ * differences themselves are returned.
+ * @return number of points.
+ *
+ * Zoomed out the block summaries are used, zoomed in only the visible
+ * samples of both captures are decoded.
+ */
+int CaptureCompare::differenceEnvelope(double first, double last, int pixels, QVector<double> &keys,
+                                       QVector<double> &min, QVector<double> &max) const
+{
+    const qint64 count = m_golden.reader().sampleCount(m_settings.channel);
+    const qint64 a = qBound((qint64)0, (qint64)qFloor(first), count);
+    const qint64 b = qBound((qint64)0, (qint64)qCeil(last) + 1, count);
+    const qint64 n = b - a;
+
+    keys.resize(0);
+    min.resize(0);
+    max.resize(0);
+    if ((n <= 0) || (pixels <= 0) || m_segments.isEmpty()) {
+        return 0;
+    }
+    /* Zoomed in to single differences. */
+    const int points = (n <= 2 * (qint64)pixels) ? (int)n : pixels;
+    const double step = (double)n / points;
+    keys.resize(points);
+    min.resize(points);
+    max.resize(points);
+
+    if (step >= COMPARE_BLOCK_SAMPLES) {
+        for (int p = 0; p < points; p++) {
+            const qint64 s0 = a + (qint64)(p * step);
+            const qint64 s1 = (p == points - 1) ? b : a + (qint64)((p + 1) * step);
+            int lo = std::numeric_limits<int>::max();
+            int hi = std::numeric_limits<int>::min();
+            for (qint64 i = s0 / COMPARE_BLOCK_SAMPLES; i <= (s1 - 1) / COMPARE_BLOCK_SAMPLES; i++) {
+                lo = qMin(lo, m_blockMin[i]);
+                hi = qMax(hi, m_blockMax[i]);
+            }
+            keys[p] = s0;
+            min[p] = (lo <= hi) ? lo : qQNaN();
+            max[p] = (lo <= hi) ? hi : qQNaN();
+        }
+        return points;
+    }
+
+    SampleCursor ca(m_golden.reader(), m_settings.channel);
+    SampleCursor cb(m_suspect.reader(), m_settings.channel);
+    qint16 sa[COMPARE_BLOCK_SAMPLES];
+    qint16 sb[COMPARE_BLOCK_SAMPLES];
+    int seg = qMax(findSegment(a), 0);
+    for (int p = 0; p < points; p++) {
+        const qint64 s0 = a + (qint64)(p * step);
+        const qint64 s1 = (p == points - 1) ? b : a + (qint64)((p + 1) * step);
+        int lo = std::numeric_limits<int>::max();
+        int hi = std::numeric_limits<int>::min();
+        for (qint64 s = s0; (s < s1) && (seg < m_segments.size()); ) {
+            const CompareSegment &segment = m_segments[seg];
+            if (s >= segment.firstA + segment.length) {
+                seg++;
+                continue;
+            }
+            if (s < segment.firstA) {
+                s = segment.firstA;
+                continue;
+            }
+            const int k = (int)qMin(qMin(s1, segment.firstA + segment.length) - s,
+                                    (qint64)COMPARE_BLOCK_SAMPLES);
+            if ((ca.read(s, k, sa) != k) || (cb.read(s + segment.firstB - segment.firstA, k, sb) != k)) {
+                break;
+            }
+            for (int i = 0; i < k; i++) {
+                lo = qMin(lo, sb[i] - sa[i]);
+                hi = qMax(hi, sb[i] - sa[i]);
+            }
+            s += k;
+        }
+        keys[p] = s0;
+        min[p] = (lo <= hi) ? lo : qQNaN();
+        max[p] = (lo <= hi) ? hi : qQNaN();
+    }
+    return points;
+}
+
+/**
+ * @brief CaptureCompare::run
+ */
+void CaptureCompare::run()
+{
+    QElapsedTimer timer;
+    QString text;
+    const int channel = m_settings.channel;
+
+    timer.start();
+    m_segments.clear();
+    m_blockMin.clear();
+    m_blockMax.clear();
+    m_suspect.close();
+    if (!m_golden.open(m_settings.golden)) {
+        emit compareFinished(false, tr("Can't open %1. %2.").arg(m_settings.golden)
+                                    .arg(m_golden.reader().errorString()));
+        return;
+    }
+    if (!m_suspect.open(m_settings.suspect)) {
+        emit compareFinished(false, tr("Can't open %1. %2.").arg(m_settings.suspect)
+                                    .arg(m_suspect.reader().errorString()));
+        return;
+    }
+    if ((m_golden.reader().sampleCount(channel) == 0) || (m_suspect.reader().sampleCount(channel) == 0)) {
+        emit compareFinished(false, tr("Both captures need samples of the channel"));
+        return;
+    }
+
+    const bool aligned = (m_settings.alignment == AlignMarkers) ? alignMarkers(text) : alignCorrelation(text);
+    if (!aligned) {
+        m_segments.clear();
+        emit compareFinished(false, text);
+        return;
+    }
+    if (m_cancel.load()) {
+        m_segments.clear();
+        emit compareFinished(false, tr("Cancelled"));
+        return;
+    }
+
+    compareSegments();
+    if (m_cancel.load()) {
+        m_segments.clear();
+        emit compareFinished(false, tr("Cancelled"));
+        return;
+    }
+    if (m_segments.isEmpty()) {
+        emit compareFinished(false, tr("Corrupt chunk in a capture"));
+        return;
+    }
+
+    const CompareStats all = total();
+    emit compareProgress(100);
+    emit compareFinished(true, tr("%1 samples in %2 segments, %3, RMS difference %4, correlation %5, %6 ms")
+        .arg(all.count).arg(m_segments.size()).arg(text).arg(all.rmsDiff, 0, 'g', 4)
+        .arg(all.correlation, 0, 'f', 4).arg(timer.elapsed()));
+}
+
+/**
+ * @brief CaptureCompare::alignMarkers
+ * @param text - receives the error, or a description of the alignment.
+ * @return false if either capture has less than two period markers.
+ *
+ * The range between the k-th and the next marker of the golden capture
+ * is compared to the same range of the suspect, cut to the shorter one.
+ */
+bool CaptureCompare::alignMarkers(QString &text)
+{
+    const CaptureView *views[2] = {&m_golden, &m_suspect};
+    QVector<qint64> markers[2];
+
+    for (int side = 0; side < 2; side++) {
+        const CaptureReader &reader = views[side]->reader();
+        const QString &fileName = side ? m_settings.suspect : m_settings.golden;
+        CaptureEventReader events;
+        if (!events.open(CaptureEventWriter::fileName(fileName))) {
+            text = tr("No event index of %1. %2.").arg(fileName).arg(events.errorString());
+            return false;
+        }
+        for (int i = events.findType(0, CAPTURE_EVENT_MARKER); i < events.count();
+             i = events.findType(i + 1, CAPTURE_EVENT_MARKER)) {
+            const qint64 sample = events.eventSample(i, m_settings.channel, reader);
+            if (sample < reader.sampleCount(m_settings.channel)) {
+                markers[side].append(sample);
+            }
+        }
+        if (markers[side].size() < 2) {
+            text = tr("%1 has less than two period markers").arg(fileName);
+            return false;
+        }
+    }
+
+    const int pairs = qMin(markers[0].size(), markers[1].size());
+    for (int k = 0; k + 1 < pairs; k++) {
+        CompareSegment segment;
+        segment.firstA = markers[0][k];
+        segment.firstB = markers[1][k];
+        segment.length = qMin(markers[0][k + 1] - markers[0][k], markers[1][k + 1] - markers[1][k]);
+        if (segment.length > 0) {
+            m_segments.append(segment);
+        }
+    }
+    if (m_segments.isEmpty()) {
+        text = tr("The period markers enclose no samples");
+        return false;
+    }
+    text = tr("%1 period markers matched").arg(pairs);
+    return true;
+}
+
+/**
+ * @brief CaptureCompare::alignCorrelation
+ * @param text - receives the error, or a description of the alignment.
+ * @return false if the captures can't be correlated.
+ *
+ * The overlap at the lag found is split into COMPARE_SEGMENT_SAMPLES
+ * segments.
+ */
+bool CaptureCompare::alignCorrelation(QString &text)
+{
+    const qint64 countA = m_golden.reader().sampleCount(m_settings.channel);
+    const qint64 countB = m_suspect.reader().sampleCount(m_settings.channel);
+    qint64 lag;
+    double peak;
+
+    if (!findLag(lag, peak, text)) {
+        return false;
+    }
+    const qint64 first = qMax((qint64)0, -lag);
+    const qint64 end = qMin(countA, countB - lag);
+    for (qint64 s = first; s < end; s += COMPARE_SEGMENT_SAMPLES) {
+        CompareSegment segment;
+        segment.firstA = s;
+        segment.firstB = s + lag;
+        segment.length = qMin((qint64)COMPARE_SEGMENT_SAMPLES, end - s);
+        m_segments.append(segment);
+    }
+    if (m_segments.isEmpty()) {
+        text = tr("The captures do not overlap at lag %1").arg(lag);
+        return false;
+    }
+    text = tr("lag %1 samples, peak correlation %2").arg(lag).arg(peak, 0, 'f', 4);
+    return true;
+}
+
+/**
+ * @brief correlate
+ * @param t - template, zero mean.
+ * @param n - template length.
+ * @param tt - sum of the squared template.
+ * @param b - window of the other signal, n values.
+ * @return normalized correlation, 0 if the window is constant.
+ */
+static double correlate(const double *t, int n, double tt, const double *b)
+{
+    double sb = 0.0;
+    double sbb = 0.0;
+    double stb = 0.0;
+
+    for (int i = 0; i < n; i++) {
+        sb += b[i];
+        sbb += b[i] * b[i];
+        stb += t[i] * b[i];
+    }
+    const double var = sbb - sb * sb / n;
+    return (var > 0.0) ? stb / qSqrt(tt * var) : 0.0;
+}
+
+/**
+ * @brief readValues
+ * @param cursor - channel to read.
+ * @param first - first sample index.
+ * @param decimation - samples per value, divides COMPARE_BLOCK_SAMPLES.
+ * @param values - receives the means of values.size() blocks of
+ * decimation samples each.
+ * @return false at a corrupt chunk.
+ */
+static bool readValues(SampleCursor &cursor, qint64 first, int decimation, QVector<double> &values)
+{
+    QVector<qint16> samples(COMPARE_BLOCK_SAMPLES);
+    const int perRead = COMPARE_BLOCK_SAMPLES / decimation;
+
+    for (int i = 0; i < values.size(); i += perRead) {
+        const int n = qMin(perRead, values.size() - i);
+        if (cursor.read(first + (qint64)i * decimation, n * decimation, samples.data()) != n * decimation) {
+            return false;
+        }
+        for (int j = 0; j < n; j++) {
+            int sum = 0;
+            for (int k = 0; k < decimation; k++) {
+                sum += samples[j * decimation + k];
+            }
+            values[i + j] = (double)sum / decimation;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief removeMean
+ * @param values - made zero mean.
+ * @return sum of the squared values left.
+ */
+static double removeMean(QVector<double> &values)
+{
+    double mean = 0.0;
+    double sum = 0.0;
+
+    for (int i = 0; i < values.size(); i++) {
+        mean += values[i];
+    }
+    mean /= values.size();
+    for (int i = 0; i < values.size(); i++) {
+        values[i] -= mean;
+        sum += values[i] * values[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief CaptureCompare::findLag
+ * @param lag - receives the suspect sample index minus the golden one.
+ * @param peak - receives the normalized correlation at the lag.
+ * @param error - receives the error.
+ * @return false if the captures are too short or the golden is constant.
+ *
+ * A coarse search over block means of COMPARE_DECIMATION samples near
+ * the start of the captures, refined at the full rate around its peak.
+ * Both searches are direct sums, a few ten million products at most.
+ */
+bool CaptureCompare::findLag(qint64 &lag, double &peak, QString &error)
+{
+    const int channel = m_settings.channel;
+    const qint64 countA = m_golden.reader().sampleCount(channel);
+    const qint64 countB = m_suspect.reader().sampleCount(channel);
+    const qint64 span = COMPARE_CORR_WINDOW + 2 * COMPARE_CORR_LAG_MAX;
+    const int decA = (int)qMin(countA / COMPARE_DECIMATION, span);
+    const int decB = (int)qMin(countB / COMPARE_DECIMATION, span);
+    const int maxLag = qMin(COMPARE_CORR_LAG_MAX, qMin(decA, decB) / 4);
+    const int window = qMin(COMPARE_CORR_WINDOW, qMin(decA - maxLag, decB - 2 * maxLag));
+    SampleCursor ca(m_golden.reader(), channel);
+    SampleCursor cb(m_suspect.reader(), channel);
+
+    if (window < 64) {
+        error = tr("The captures are too short to correlate");
+        return false;
+    }
+
+    /* The golden template starts maxLag blocks in, so that negative lags
+     * are searched too. */
+    const qint64 start = (qint64)maxLag * COMPARE_DECIMATION;
+    QVector<double> t(window);
+    QVector<double> b(2 * maxLag + window);
+    if (!readValues(ca, start, COMPARE_DECIMATION, t) || !readValues(cb, 0, COMPARE_DECIMATION, b)) {
+        error = tr("Corrupt chunk in a capture");
+        return false;
+    }
+    double tt = removeMean(t);
+    if (tt <= 0.0) {
+        error = tr("The golden capture is constant, use the period markers");
+        return false;
+    }
+    int best = 0;
+    peak = -2.0;
+    for (int k = -maxLag; (k <= maxLag) && !m_cancel.load(); k++) {
+        const double r = correlate(t.constData(), window, tt, b.constData() + maxLag + k);
+        if (r > peak) {
+            peak = r;
+            best = k;
+        }
+    }
+    lag = (qint64)best * COMPARE_DECIMATION;
+
+    /* Full rate, a block either side of the coarse peak. */
+    const int n = qMin(window * COMPARE_DECIMATION, COMPARE_SEGMENT_SAMPLES);
+    const qint64 from = qMax(lag - COMPARE_DECIMATION, -start);
+    const qint64 to = qMin(lag + COMPARE_DECIMATION, countB - start - n);
+    if (from > to) {
+        return true;
+    }
+    QVector<double> fa(n);
+    QVector<double> fb((int)(to - from) + n);
+    if (!readValues(ca, start, 1, fa) || !readValues(cb, start + from, 1, fb)) {
+        error = tr("Corrupt chunk in a capture");
+        return false;
+    }
+    tt = removeMean(fa);
+    if (tt <= 0.0) {
+        return true;
+    }
+    peak = -2.0;
+    for (qint64 k = from; k <= to; k++) {
+        const double r = correlate(fa.constData(), n, tt, fb.constData() + (k - from));
+        if (r > peak) {
+            peak = r;
+            lag = k;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief CaptureCompare::compareSegments
+ * Splits the segments into COMPARE_TASK_SAMPLES tasks on a WorkPool and
+ * merges their sums. Clears the segments if a task hit a corrupt chunk.
+ */
+void CaptureCompare::compareSegments()
+{
+    QVector<qint64> offsets(m_segments.size());
+    qint64 total = 0;
+
+    for (int i = 0; i < m_segments.size(); i++) {
+        offsets[i] = total;
+        total += m_segments[i].length;
+        clearMoments(m_segments[i].moments);
+    }
+    const qint64 blocks = (m_golden.reader().sampleCount(m_settings.channel) + COMPARE_BLOCK_SAMPLES - 1) /
+                          COMPARE_BLOCK_SAMPLES;
+    m_blockMin.fill(std::numeric_limits<int>::max(), blocks);
+    m_blockMax.fill(std::numeric_limits<int>::min(), blocks);
+
+    const int tasks = (int)((total + COMPARE_TASK_SAMPLES - 1) / COMPARE_TASK_SAMPLES);
+    QVector<CompareOutput> outputs(tasks);
+    QAtomicInt done(0);
+    {
+        WorkPool pool;
+        for (int i = 0; i < tasks; i++) {
+            const qint64 from = (qint64)i * COMPARE_TASK_SAMPLES;
+            pool.start(new CompareTask(m_golden.reader(), m_suspect.reader(), m_settings.channel,
+                                       m_segments, offsets, from, qMin(from + COMPARE_TASK_SAMPLES, total),
+                                       &outputs[i], &done, &m_cancel));
+        }
+        /* Pieces are mostly whole blocks, the estimate is close enough. */
+        const double pieces = qMax((double)total / COMPARE_BLOCK_SAMPLES, 1.0);
+        while (!pool.waitForDone(COMPARE_PROGRESS_MS)) {
+            emit compareProgress(qMin((int)(done.load() * 100.0 / pieces), 99));
+        }
+    }
+
+    for (int i = 0; i < tasks; i++) {
+        const CompareOutput &out = outputs[i];
+        if (!out.ok) {
+            m_segments.clear();
+            return;
+        }
+        for (int j = 0; j < out.moments.size(); j++) {
+            addMoments(m_segments[out.firstSegment + j].moments, out.moments[j]);
+        }
+        for (int j = 0; j < out.blockMin.size(); j++) {
+            m_blockMin[out.firstBlock + j] = qMin(m_blockMin[out.firstBlock + j], out.blockMin[j]);
+            m_blockMax[out.firstBlock + j] = qMax(m_blockMax[out.firstBlock + j], out.blockMax[j]);
+        }
+    }
+}
+
+/**
+ * @brief CaptureCompare::findSegment
+ * @param sample - golden sample index.
+ * @return index of the last segment starting at or before the sample,
+ * -1 if there is none.
+ */
+int CaptureCompare::findSegment(qint64 sample) const
+{
+    int lo = 0;
+    int hi = m_segments.size();
+
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (m_segments[mid].firstA <= sample) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo - 1;
+}
@@ -0,0 +1,129 @@
+#ifndef CAPTURECOMPARE_H
+#define CAPTURECOMPARE_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QVector>
+
+#include "captureview.h"
+
+/* Segment length of the correlation alignment. */
+#define COMPARE_SEGMENT_SAMPLES         65536
+/* Samples compared by one pool task.      */
+#define COMPARE_TASK_SAMPLES            (1024 * 1024)
+/* Samples per difference summary block.   */
+#define COMPARE_BLOCK_SAMPLES           CAPTURE_CHUNK_SAMPLES
+/* Decimation of the coarse lag search.    */
+#define COMPARE_DECIMATION              16
+/* Coarse search window, decimated.        */
+#define COMPARE_CORR_WINDOW             8192
+/* Largest lag searched, decimated.        */
+#define COMPARE_CORR_LAG_MAX            2048
+/* Interval between progress signals, ms.  */
+#define COMPARE_PROGRESS_MS             100
+
+/* Sums of a pair of aligned sample ranges. Kept as integers, partial
+ * sums of the tasks add up exactly whatever the split.
+ */
+typedef struct tagCompareMoments {
+    qint64 count;
+    qint64 sumA;            /* Golden samples.                          */
+    qint64 sumB;            /* Suspect samples.                         */
+    qint64 sumAA;
+    qint64 sumBB;
+    qint64 sumAB;
+    int diffMin;            /* Of suspect - golden.                     */
+    int diffMax;
+} CompareMoments;
+
+/* Statistical deltas of an aligned range, suspect against golden. */
+typedef struct tagCompareStats {
+    qint64 count;
+    double meanA;
+    double meanB;
+    double stdA;
+    double stdB;
+    double deltaMean;       /* meanB - meanA.                           */
+    double deltaStd;        /* stdB - stdA.                             */
+    double rmsDiff;         /* RMS of suspect - golden.                 */
+    int maxAbsDiff;
+    double correlation;     /* Pearson, NaN if a side is constant.      */
+} CompareStats;
+
+/* Aligned pair of sample ranges. */
+typedef struct tagCompareSegment {
+    qint64 firstA;          /* First golden sample.                     */
+    qint64 firstB;          /* First suspect sample.                    */
+    qint64 length;
+    CompareMoments moments;
+} CompareSegment;
+
+/* Compares a suspect capture against a golden one. The captures are
+ * aligned by their period markers or by cross-correlation, the aligned
+ * ranges are split into segments and compared in parallel on a
+ * WorkPool. Each task keeps integer sums of its share, so the result
+ * does not depend on the number of threads. Difference min/max per
+ * block of golden samples let the overlay plot any zoom level without
+ * decoding the whole captures again.
+ */
+class CaptureCompare : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Alignment {
+        AlignMarkers = 0,   /* k-th period marker to k-th marker.       */
+        AlignCorrelation    /* Single lag, normalized cross-correlation.*/
+    };
+
+    typedef struct tagSettings {
+        QString golden;     /* Reference capture.                       */
+        QString suspect;    /* Capture compared against it.             */
+        int channel;        /* Streaming channel ID.                    */
+        Alignment alignment;
+    } Settings;
+
+    CaptureCompare(QObject *parent = 0);
+    ~CaptureCompare();
+
+    void startCompare(const Settings &settings);
+    void cancel();
+
+    /* Valid once compareFinished() reported success. */
+    const Settings &settings() const { return m_settings; }
+    const CaptureView &golden() const { return m_golden; }
+    const CaptureView &suspect() const { return m_suspect; }
+    const QVector<CompareSegment> &segments() const { return m_segments; }
+    CompareStats total() const;
+    static CompareStats stats(const CompareMoments &moments);
+    qint64 suspectSample(qint64 sample) const;
+    int differenceEnvelope(double first, double last, int pixels, QVector<double> &keys,
+                           QVector<double> &min, QVector<double> &max) const;
+
+signals:
+    void compareProgress(int percent);
+    void compareFinished(bool ok, const QString &s);
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    bool alignMarkers(QString &text);
+    bool alignCorrelation(QString &text);
+    bool findLag(qint64 &lag, double &peak, QString &error);
+    void compareSegments();
+    int findSegment(qint64 sample) const;
+
+private:
+    Settings m_settings;
+    QAtomicInt m_cancel;
+    CaptureView m_golden;
+    CaptureView m_suspect;
+    QVector<CompareSegment> m_segments;
+    /* Difference min/max of each block of golden samples, min > max
+     * where no segment covers the block. */
+    QVector<int> m_blockMin;
+    QVector<int> m_blockMax;
+};
+
+#endif // CAPTURECOMPARE_H
@@ -0,0 +1,288 @@
+#include "captureevents.h"
+#include "capturereader.h"
+
+#include <QFileInfo>
+#include <QObject>
+#include <algorithm>
+
+/* Orders event positions by the time of the events. */
+typedef struct tagEventTimeLess {
+    const QVector<CaptureEvent> *events;
+    bool operator()(int a, int b) const { return (*events)[a].timestamp < (*events)[b].timestamp; }
+} EventTimeLess;
+
+/**
+ * @brief CaptureEventWriter::CaptureEventWriter
+ */
+CaptureEventWriter::CaptureEventWriter() :
+    m_failed(false)
+{
+    // Empty;
+}
+
+/**
+ * @brief CaptureEventWriter::~CaptureEventWriter
+ */
+CaptureEventWriter::~CaptureEventWriter()
+{
+    if (m_file.isOpen()) {
+        close();
+    }
+}
+
+/**
+ * @brief CaptureEventWriter::fileName
+ * @param captureFileName - capture file.
+ * @return event index file of the capture.
+ */
+QString CaptureEventWriter::fileName(const QString &captureFileName)
+{
+    const QFileInfo info(captureFileName);
+
+    return info.path() + "/" + info.completeBaseName() + CAPTURE_EVENTS_SUFFIX;
+}
+
+/**
+ * @brief CaptureEventWriter::open
+ * @param fileName - event index file.
+ * @param startTime - start_time of the capture, ms since epoch.
+ * @param append - keep the events of an existing index.
+ * @return false if the file can't be written or is not an event index,
+ * see errorString().
+ */
+bool CaptureEventWriter::open(const QString &fileName, qint64 startTime, bool append)
+{
+    CaptureEventsHeader hdr;
+
+    m_file.setFileName(fileName);
+    m_failed = false;
+    if (!m_file.open(append ? (QIODevice::ReadWrite | QIODevice::Append)
+                            : (QIODevice::WriteOnly | QIODevice::Truncate))) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    if (append && (m_file.size() > 0)) {
+        m_file.seek(0);
+        if ((m_file.read((char *)&hdr, sizeof(hdr)) != sizeof(hdr)) ||
+            (memcmp(hdr.magic, CAPTURE_EVENTS_MAGIC, sizeof(CAPTURE_EVENTS_MAGIC)) != 0) ||
+            (hdr.version != CAPTURE_EVENTS_VERSION)) {
+            m_error = QObject::tr("Not an event index or unsupported version");
+            m_file.close();
+            return false;
+        }
+        m_file.seek(m_file.size());
+        return true;
+    }
+
+    memset((void *)&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CAPTURE_EVENTS_MAGIC, sizeof(CAPTURE_EVENTS_MAGIC));
+    hdr.version = CAPTURE_EVENTS_VERSION;
+    hdr.header_size = sizeof(hdr);
+    hdr.start_time = startTime;
+    if (m_file.write((const char *)&hdr, sizeof(hdr)) != sizeof(hdr)) {
+        m_error = m_file.errorString();
+        m_failed = true;
+    }
+    return !m_failed;
+}
+
+/**
+ * @brief CaptureEventWriter::close
+ * @return false if writing failed, see errorString().
+ */
+bool CaptureEventWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    if (!m_file.flush() && !m_failed) {
+        m_error = m_file.errorString();
+        m_failed = true;
+    }
+    m_file.close();
+    return !m_failed;
+}
+
+/**
+ * @brief CaptureEventWriter::addEvent
+ * @param event - event, data_size is cut to CAPTURE_EVENT_DATA_MAX.
+ * @param data - event data, event.data_size bytes.
+ * @return false if writing failed, see errorString().
+ */
+bool CaptureEventWriter::addEvent(const CaptureEvent &event, const char *data)
+{
+    CaptureEvent e = event;
+
+    if (m_failed) {
+        return false;
+    }
+    e.data_size = qMin((int)e.data_size, CAPTURE_EVENT_DATA_MAX);
+    e.reserved = 0;
+    if ((m_file.write((const char *)&e, sizeof(e)) != sizeof(e)) ||
+        (m_file.write(data, e.data_size) != e.data_size)) {
+        m_error = m_file.errorString();
+        m_failed = true;
+    }
+    return !m_failed;
+}
+
+/**
+ * @brief CaptureEventReader::CaptureEventReader
+ */
+CaptureEventReader::CaptureEventReader()
+{
+    memset((void *)&m_header, 0, sizeof(m_header));
+}
+
+/**
+ * @brief CaptureEventReader::open
+ * @param fileName - event index file.
+ * @return false if the file is not an event index, see errorString().
+ */
+bool CaptureEventReader::open(const QString &fileName)
+{
+    QFile file(fileName);
+    CaptureEvent event;
+
+    close();
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_error = file.errorString();
+        return false;
+    }
+    const QByteArray bytes = file.readAll();
+    const char *p = bytes.constData();
+
+    if (bytes.size() >= (int)sizeof(m_header)) {
+        memcpy((void *)&m_header, p, sizeof(m_header));
+    }
+    if ((bytes.size() < (int)sizeof(m_header)) ||
+        (memcmp(m_header.magic, CAPTURE_EVENTS_MAGIC, sizeof(CAPTURE_EVENTS_MAGIC)) != 0) ||
+        (m_header.version != CAPTURE_EVENTS_VERSION) ||
+        (m_header.header_size < sizeof(m_header)) || (m_header.header_size > (quint32)bytes.size())) {
+        m_error = QObject::tr("Not an event index or unsupported version");
+        close();
+        return false;
+    }
+
+    QVector<CaptureEvent> events;
+    QVector<int> offsets;
+    int pos = m_header.header_size;
+    while (pos + (int)sizeof(event) <= bytes.size()) {
+        memcpy((void *)&event, p + pos, sizeof(event));
+        if ((event.data_size > CAPTURE_EVENT_DATA_MAX) ||
+            (pos + (int)sizeof(event) + event.data_size > bytes.size())) {
+            break;
+        }
+        events.append(event);
+        offsets.append(pos + sizeof(event));
+        pos += sizeof(event) + event.data_size;
+    }
+    m_data = bytes;
+
+    /* Notes added to a closed capture come last, the searches need time order. */
+    QVector<int> order(events.size());
+    for (int i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    EventTimeLess less;
+    less.events = &events;
+    std::stable_sort(order.begin(), order.end(), less);
+    m_events.resize(events.size());
+    m_offsets.resize(events.size());
+    for (int i = 0; i < order.size(); i++) {
+        m_events[i] = events[order[i]];
+        m_offsets[i] = offsets[order[i]];
+    }
+    return true;
+}
+
+/**
+ * @brief CaptureEventReader::close
+ */
+void CaptureEventReader::close()
+{
+    memset((void *)&m_header, 0, sizeof(m_header));
+    m_events.clear();
+    m_offsets.clear();
+    m_data.clear();
+}
+
+/**
+ * @brief CaptureEventReader::data
+ * @param index - event index.
+ * @return data of the event.
+ */
+QByteArray CaptureEventReader::data(int index) const
+{
+    return m_data.mid(m_offsets[index], m_events[index].data_size);
+}
+
+/**
+ * @brief CaptureEventReader::eventSample
+ * @param index - event index.
+ * @param channel - streaming channel ID.
+ * @param capture - the capture of the index.
+ * @return index of the first sample of the channel at or after the
+ * event, stored for the channel the event counts.
+ */
+qint64 CaptureEventReader::eventSample(int index, int channel, const CaptureReader &capture) const
+{
+    const CaptureEvent &event = m_events[index];
+
+    if (event.channel == channel) {
+        return event.sample;
+    }
+    return capture.timeSample(channel, event.timestamp);
+}
+
+/**
+ * @brief CaptureEventReader::findTime
+ * @param timestamp - time since the start, ns.
+ * @return index of the first event at or after the time, count() if
+ * there is none.
+ */
+int CaptureEventReader::findTime(qint64 timestamp) const
+{
+    int lo = 0;
+    int hi = m_events.size();
+
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (m_events[mid].timestamp < timestamp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief CaptureEventReader::findType
+ * @param index - first event index to look at.
+ * @param type - CAPTURE_EVENT_*, 0 for any.
+ * @return index of the first such event, count() if there is none.
+ */
+int CaptureEventReader::findType(int index, int type) const
+{
+    while ((index < m_events.size()) && type && (m_events[index].type != type)) {
+        index++;
+    }
+    return index;
+}
+
+/**
+ * @brief CaptureEventReader::segmentEnd
+ * @param index - event starting the segment.
+ * @param type - CAPTURE_EVENT_* ending the segment, 0 for any.
+ * @return time of the first later event of the type, -1 if the segment
+ * lasts to the end of the capture.
+ *
+ * Events at the same time as the start do not end the segment.
+ */
+qint64 CaptureEventReader::segmentEnd(int index, int type) const
+{
+    const int next = findType(findTime(m_events[index].timestamp + 1), type);
+
+    return (next < m_events.size()) ? m_events[next].timestamp : -1;
+}
@@ -0,0 +1,67 @@
+#ifndef CAPTUREEVENTS_H
+#define CAPTUREEVENTS_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QVector>
+
+#include "capture.h"
+
+class CaptureReader;
+
+/* Writer of the event index of a capture. Events are appended to the
+ * file, an index is reopened to add notes to a closed capture.
+ */
+class CaptureEventWriter
+{
+public:
+    CaptureEventWriter();
+    ~CaptureEventWriter();
+
+    static QString fileName(const QString &captureFileName);
+
+    bool open(const QString &fileName, qint64 startTime, bool append = false);
+    bool close();
+    bool isOpen() const { return m_file.isOpen(); }
+    QString errorString() const { return m_error; }
+
+    bool addEvent(const CaptureEvent &event, const char *data);
+
+private:
+    QFile m_file;
+    bool m_failed;
+    QString m_error;
+};
+
+/* Event index of a capture, read as a whole and sorted by time. Events
+ * are found by binary search, the sample index of an event locates it in
+ * the capture without decoding any samples.
+ */
+class CaptureEventReader
+{
+public:
+    CaptureEventReader();
+
+    bool open(const QString &fileName);
+    void close();
+    QString errorString() const { return m_error; }
+
+    qint64 startTime() const { return m_header.start_time; }
+    int count() const { return m_events.size(); }
+    const CaptureEvent &event(int index) const { return m_events[index]; }
+    QByteArray data(int index) const;
+    qint64 eventSample(int index, int channel, const CaptureReader &capture) const;
+
+    int findTime(qint64 timestamp) const;
+    int findType(int index, int type) const;
+    qint64 segmentEnd(int index, int type = 0) const;
+
+private:
+    CaptureEventsHeader m_header;
+    QVector<CaptureEvent> m_events;
+    QVector<int> m_offsets;     /* Data of each event within m_data.    */
+    QByteArray m_data;
+    QString m_error;
+};
+
+#endif // CAPTUREEVENTS_H
@@ -0,0 +1,348 @@
+#include "capturereader.h"
+#include "capturecodec.h"
+
+#include <QObject>
+
+/**
+ * @brief CaptureReader::CaptureReader
+ */
+CaptureReader::CaptureReader() :
+    m_data(0),
+    m_size(0),
+    m_complete(false),
+    m_duration(0)
+{
+    memset((void *)&m_header, 0, sizeof(m_header));
+}
+
+/**
+ * @brief CaptureReader::~CaptureReader
+ */
+CaptureReader::~CaptureReader()
+{
+    close();
+}
+
+/**
+ * @brief CaptureReader::open
+ * @param fileName - capture file.
+ * @return false if the file is not a capture, see errorString().
+ *
+ * Reads the index from the end of the file. A capture that was not
+ * closed has no index, its chunk headers are walked instead.
+ */
+bool CaptureReader::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size < (qint64)sizeof(CaptureHeader)) {
+        m_error = QObject::tr("Not a capture");
+        m_file.close();
+        return false;
+    }
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        m_error = m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    memcpy((void *)&m_header, m_data, sizeof(m_header));
+    if ((memcmp(m_header.magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0) ||
+        (m_header.version != CAPTURE_VERSION) ||
+        (m_header.header_size < sizeof(m_header)) || (m_header.header_size > m_size)) {
+        m_error = QObject::tr("Not a capture or unsupported version");
+        close();
+        return false;
+    }
+
+    m_complete = readIndex();
+    if (!m_complete) {
+        scanChunks();
+    }
+    return true;
+}
+
+/**
+ * @brief CaptureReader::close
+ */
+void CaptureReader::close()
+{
+    if (m_data) {
+        m_file.unmap((uchar *)m_data);
+        m_data = 0;
+    }
+    m_file.close();
+    m_size = 0;
+    m_complete = false;
+    m_duration = 0;
+    for (int i = 0; i < STREAMING_CHANNEL_COUNT; i++) {
+        m_chunks[i].clear();
+    }
+}
+
+/**
+ * @brief CaptureReader::sampleCount
+ * @param channel - streaming channel ID.
+ */
+qint64 CaptureReader::sampleCount(int channel) const
+{
+    const QVector<CaptureIndexEntry> &chunks = m_chunks[channel];
+
+    if (chunks.isEmpty()) {
+        return 0;
+    }
+    return chunks.last().chunk.first_sample + chunks.last().chunk.count;
+}
+
+/**
+ * @brief CaptureReader::sampleTime
+ * @param channel - streaming channel ID.
+ * @param sample - sample index within the channel.
+ * @return time of the sample since the start, ns, -1 if there is none.
+ */
+qint64 CaptureReader::sampleTime(int channel, qint64 sample) const
+{
+    const int i = findSample(channel, sample);
+
+    if (i < 0) {
+        return -1;
+    }
+    const CaptureChunk &chunk = m_chunks[channel][i].chunk;
+    return chunkTime(chunk, sample - chunk.first_sample);
+}
+
+/**
+ * @brief CaptureReader::chunkTime
+ * @param chunk - chunk header.
+ * @param index - sample index within the chunk.
+ * @return time of the sample, spread evenly between the times of the
+ * first and the last sample of the chunk.
+ */
+qint64 CaptureReader::chunkTime(const CaptureChunk &chunk, int index)
+{
+    if (chunk.count < 2) {
+        return chunk.time_first;
+    }
+    return chunk.time_first + (chunk.time_last - chunk.time_first) * index / (chunk.count - 1);
+}
+
+/**
+ * @brief CaptureReader::findSample
+ * @param channel - streaming channel ID.
+ * @param sample - sample index within the channel.
+ * @return index of the chunk holding the sample, -1 if there is none.
+ */
+int CaptureReader::findSample(int channel, qint64 sample) const
+{
+    const QVector<CaptureIndexEntry> &chunks = m_chunks[channel];
+    int lo = 0;
+    int hi = chunks.size();
+
+    /* First chunk starting after the sample, the one before holds it. */
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (chunks[mid].chunk.first_sample <= sample) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if ((lo == 0) || (sample >= chunks[lo - 1].chunk.first_sample + chunks[lo - 1].chunk.count)) {
+        return -1;
+    }
+    return lo - 1;
+}
+
+/**
+ * @brief CaptureReader::findTime
+ * @param channel - streaming channel ID.
+ * @param timestamp - time since the start, ns.
+ * @return index of the first chunk ending at or after the time,
+ * chunkCount() if the time is past the end.
+ */
+int CaptureReader::findTime(int channel, qint64 timestamp) const
+{
+    const QVector<CaptureIndexEntry> &chunks = m_chunks[channel];
+    int lo = 0;
+    int hi = chunks.size();
+
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        if (chunks[mid].chunk.time_last < timestamp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief CaptureReader::timeSample
+ * @param channel - streaming channel ID.
+ * @param timestamp - time since the start, ns.
+ * @return index of the first sample at or after the time, by the times
+ * chunkTime() gives, sampleCount() if the time is past the end.
+ */
+qint64 CaptureReader::timeSample(int channel, qint64 timestamp) const
+{
+    const int i = findTime(channel, timestamp);
+
+    if (i == m_chunks[channel].size()) {
+        return sampleCount(channel);
+    }
+    const CaptureChunk &chunk = m_chunks[channel][i].chunk;
+    if ((timestamp <= chunk.time_first) || (chunk.count < 2)) {
+        return chunk.first_sample;
+    }
+    /* Smallest index whose interpolated time is not before the timestamp. */
+    const qint64 span = chunk.time_last - chunk.time_first;
+    const qint64 index = ((timestamp - chunk.time_first) * (chunk.count - 1) + span - 1) / span;
+    return chunk.first_sample + qMin(index, (qint64)chunk.count - 1);
+}
+
+/**
+ * @brief CaptureReader::readChunk
+ * @param channel - streaming channel ID.
+ * @param index - chunk index.
+ * @param samples - receives chunk(channel, index).chunk.count samples.
+ * @return false if the chunk is corrupt.
+ */
+bool CaptureReader::readChunk(int channel, int index, qint16 *samples) const
+{
+    const CaptureIndexEntry &entry = m_chunks[channel][index];
+
+    return captureDecode(m_data + entry.offset + sizeof(CaptureChunk), entry.chunk.size,
+                         samples, entry.chunk.count);
+}
+
+/**
+ * @brief CaptureReader::readSamples
+ * @param channel - streaming channel ID.
+ * @param first - index of the first sample.
+ * @param count - number of samples.
+ * @param samples - receives the samples.
+ * @return number of samples read, less than count at the end of the
+ * channel or at a corrupt chunk.
+ */
+int CaptureReader::readSamples(int channel, qint64 first, int count, qint16 *samples) const
+{
+    qint16 buf[CAPTURE_CHUNK_SAMPLES];
+    int done = 0;
+    int i = findSample(channel, first);
+
+    if (i < 0) {
+        return 0;
+    }
+    while ((done < count) && (i < m_chunks[channel].size())) {
+        const CaptureChunk &chunk = m_chunks[channel][i].chunk;
+        const int skip = first + done - chunk.first_sample;
+        const int n = qMin(count - done, chunk.count - skip);
+
+        if ((skip == 0) && (n == chunk.count)) {
+            /* Whole chunk, decoded in place. */
+            if (!readChunk(channel, i, samples + done)) {
+                break;
+            }
+        } else {
+            if (!readChunk(channel, i, buf)) {
+                break;
+            }
+            memcpy((void *)(samples + done), (const void *)(buf + skip), n * sizeof(qint16));
+        }
+        done += n;
+        i++;
+    }
+    return done;
+}
+
+/**
+ * @brief CaptureReader::readIndex
+ * @return false if there is no valid index.
+ */
+bool CaptureReader::readIndex()
+{
+    CaptureTrailer trailer;
+    CaptureIndexEntry entry;
+
+    if (m_size < m_header.header_size + (qint64)sizeof(trailer)) {
+        return false;
+    }
+    memcpy((void *)&trailer, m_data + m_size - sizeof(trailer), sizeof(trailer));
+    if ((trailer.magic != CAPTURE_TRAILER_MAGIC) ||
+        (trailer.index_offset < m_header.header_size) ||
+        (trailer.index_offset + trailer.index_count * (qint64)sizeof(entry) !=
+         m_size - (qint64)sizeof(trailer))) {
+        return false;
+    }
+
+    for (quint32 i = 0; i < trailer.index_count; i++) {
+        memcpy((void *)&entry, m_data + trailer.index_offset + i * sizeof(entry), sizeof(entry));
+        if ((entry.offset + (qint64)sizeof(CaptureChunk) + entry.chunk.size > trailer.index_offset) ||
+            !addChunk(entry)) {
+            for (int c = 0; c < STREAMING_CHANNEL_COUNT; c++) {
+                m_chunks[c].clear();
+            }
+            m_duration = 0;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief CaptureReader::scanChunks
+ * Walks the chunk headers up to the first incomplete or invalid chunk.
+ */
+void CaptureReader::scanChunks()
+{
+    CaptureIndexEntry entry;
+    qint64 pos = m_header.header_size;
+
+    while (pos + (qint64)sizeof(CaptureChunk) <= m_size) {
+        memcpy((void *)&entry.chunk, m_data + pos, sizeof(CaptureChunk));
+        entry.offset = pos;
+        if ((pos + (qint64)sizeof(CaptureChunk) + entry.chunk.size > m_size) || !addChunk(entry)) {
+            break;
+        }
+        pos += sizeof(CaptureChunk) + entry.chunk.size;
+    }
+}
+
+/**
+ * @brief CaptureReader::addChunk
+ * @return false if the chunk header is invalid, out of sequence or not
+ * within the chunk area of the file.
+ */
+bool CaptureReader::addChunk(const CaptureIndexEntry &entry)
+{
+    const CaptureChunk &chunk = entry.chunk;
+
+    /* readChunk() decodes at the offset, negative ones included. */
+    if ((entry.offset < m_header.header_size) ||
+        (entry.offset > m_size - (qint64)sizeof(CaptureChunk))) {
+        return false;
+    }
+    if ((chunk.magic != CAPTURE_CHUNK_MAGIC) || (chunk.channel >= STREAMING_CHANNEL_COUNT) ||
+        (chunk.count == 0) || (chunk.count > CAPTURE_CHUNK_SAMPLES) ||
+        (chunk.size > (quint32)CAPTURE_ENCODED_SIZE_MAX(chunk.count))) {
+        return false;
+    }
+    /* Chunks of a channel are contiguous, the searches rely on it. */
+    QVector<CaptureIndexEntry> &chunks = m_chunks[chunk.channel];
+    if (!chunks.isEmpty() &&
+        ((chunk.first_sample != chunks.last().chunk.first_sample + chunks.last().chunk.count) ||
+         (chunk.time_first < chunks.last().chunk.time_last))) {
+        return false;
+    }
+    chunks.append(entry);
+    m_duration = qMax(m_duration, chunk.time_last);
+    return true;
+}
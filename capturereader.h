@@ -0,0 +1,56 @@
+#ifndef CAPTUREREADER_H
+#define CAPTUREREADER_H
+
+#include <QFile>
+#include <QVector>
+
+#include "telemetry.h"
+#include "capture.h"
+
+/* Random access reader of a capture. The file is mapped as a whole, the
+ * chunk index is kept per channel so that sample and time ranges are
+ * found by binary search.
+ */
+class CaptureReader
+{
+public:
+    CaptureReader();
+    ~CaptureReader();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return m_data != 0; }
+    bool isComplete() const { return m_complete; }
+    QString errorString() const { return m_error; }
+
+    qint64 startTime() const { return m_header.start_time; }
+    qint64 duration() const { return m_duration; }
+    int chunkCount(int channel) const { return m_chunks[channel].size(); }
+    const CaptureIndexEntry &chunk(int channel, int index) const { return m_chunks[channel][index]; }
+    qint64 sampleCount(int channel) const;
+    qint64 sampleTime(int channel, qint64 sample) const;
+    static qint64 chunkTime(const CaptureChunk &chunk, int index);
+
+    int findSample(int channel, qint64 sample) const;
+    int findTime(int channel, qint64 timestamp) const;
+    qint64 timeSample(int channel, qint64 timestamp) const;
+    bool readChunk(int channel, int index, qint16 *samples) const;
+    int readSamples(int channel, qint64 first, int count, qint16 *samples) const;
+
+private:
+    bool readIndex();
+    void scanChunks();
+    bool addChunk(const CaptureIndexEntry &entry);
+
+private:
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    CaptureHeader m_header;
+    bool m_complete;            /* Index read from the trailer.     */
+    qint64 m_duration;          /* Latest sample time.              */
+    QVector<CaptureIndexEntry> m_chunks[STREAMING_CHANNEL_COUNT];
+    QString m_error;
+};
+
+#endif // CAPTUREREADER_H
@@ -0,0 +1,230 @@
+#include "captureview.h"
+
+#include <qmath.h>
+
+/**
+ * @brief CaptureView::CaptureView
+ */
+CaptureView::CaptureView()
+{
+    m_decoded.resize(CAPTURE_CHUNK_SAMPLES);
+}
+
+/**
+ * @brief CaptureView::open
+ * @param fileName - capture file.
+ * @return false if the file is not a capture, see reader().errorString().
+ *
+ * Only the chunk index is read, the summaries are built from it.
+ */
+bool CaptureView::open(const QString &fileName)
+{
+    close();
+    if (!m_reader.open(fileName)) {
+        return false;
+    }
+    for (int i = 0; i < STREAMING_CHANNEL_COUNT; i++) {
+        buildPyramid(i);
+    }
+    return true;
+}
+
+/**
+ * @brief CaptureView::close
+ */
+void CaptureView::close()
+{
+    m_reader.close();
+    for (int i = 0; i < STREAMING_CHANNEL_COUNT; i++) {
+        m_min[i].clear();
+        m_max[i].clear();
+    }
+}
+
+/**
+ * @brief CaptureView::range
+ * @param channel - streaming channel ID.
+ * @return false if the channel has no samples.
+ */
+bool CaptureView::range(int channel, qint16 &min, qint16 &max) const
+{
+    if (m_min[channel].isEmpty()) {
+        return false;
+    }
+    min = m_min[channel].last()[0];
+    max = m_max[channel].last()[0];
+    return true;
+}
+
+/**
+ * @brief CaptureView::envelope
+ * @param channel - streaming channel ID.
+ * @param first - first visible sample index.
+ * @param last - last visible sample index.
+ * @param pixels - horizontal resolution.
+ * @param keys - receives the sample index of each point.
+ * @param min - receives the minimum of each point.
+ * @param max - receives the maximum of each point, equal to the minimum
+ * when the samples themselves are returned.
+ * @return number of points.
+ */
+int CaptureView::envelope(int channel, double first, double last, int pixels,
+                          QVector<double> &keys, QVector<double> &min, QVector<double> &max) const
+{
+    const qint64 count = m_reader.sampleCount(channel);
+    const qint64 a = qBound((qint64)0, (qint64)qFloor(first), count);
+    const qint64 b = qBound((qint64)0, (qint64)qCeil(last) + 1, count);
+    const qint64 n = b - a;
+
+    keys.resize(0);
+    min.resize(0);
+    max.resize(0);
+    if ((n <= 0) || (pixels <= 0)) {
+        return 0;
+    }
+
+    if (n <= 2 * (qint64)pixels) {
+        /* Zoomed in to single samples. */
+        keys.resize(n);
+        min.resize(n);
+        max.resize(n);
+        qint16 *s = m_decoded.data();
+        for (qint64 i = a; i < b; ) {
+            const int k = qMin((qint64)CAPTURE_CHUNK_SAMPLES, b - i);
+            const int got = m_reader.readSamples(channel, i, k, s);
+            for (int j = 0; j < got; j++) {
+                keys[i - a + j] = i + j;
+                min[i - a + j] = s[j];
+                max[i - a + j] = s[j];
+            }
+            if (got < k) {
+                keys.resize(i - a + got);
+                min.resize(i - a + got);
+                max.resize(i - a + got);
+                break;
+            }
+            i += k;
+        }
+        return keys.size();
+    }
+
+    const double step = (double)n / pixels;
+    keys.resize(pixels);
+    min.resize(pixels);
+    max.resize(pixels);
+
+    if (step >= CAPTURE_CHUNK_SAMPLES) {
+        /* A pixel spans whole chunks, their summaries are enough. */
+        for (int p = 0; p < pixels; p++) {
+            const qint64 s0 = a + (qint64)(p * step);
+            const qint64 s1 = (p == pixels - 1) ? b : a + (qint64)((p + 1) * step);
+            qint16 lo, hi;
+            chunkRange(channel, m_reader.findSample(channel, s0), m_reader.findSample(channel, s1 - 1), lo, hi);
+            keys[p] = s0;
+            min[p] = lo;
+            max[p] = hi;
+        }
+        return pixels;
+    }
+
+    /* Decode the visible chunks once, each pixel takes its share. */
+    int chunk = m_reader.findSample(channel, a);
+    int decoded = -1;
+    for (int p = 0; p < pixels; p++) {
+        const qint64 s0 = a + (qint64)(p * step);
+        const qint64 s1 = (p == pixels - 1) ? b : a + (qint64)((p + 1) * step);
+        qint16 lo = 32767;
+        qint16 hi = -32768;
+        for (qint64 s = s0; s < s1; ) {
+            const CaptureChunk &c = m_reader.chunk(channel, chunk).chunk;
+            if (s >= c.first_sample + c.count) {
+                chunk++;
+                continue;
+            }
+            if (decoded != chunk) {
+                if (!m_reader.readChunk(channel, chunk, m_decoded.data())) {
+                    /* Corrupt chunk, its summary stands in. */
+                    for (int i = 0; i < c.count; i++) {
+                        m_decoded[i] = (i & 1) ? c.max : c.min;
+                    }
+                }
+                decoded = chunk;
+            }
+            const qint64 e = qMin(s1, c.first_sample + c.count);
+            const qint16 *d = m_decoded.constData() + (s - c.first_sample);
+            for (qint64 i = 0; i < e - s; i++) {
+                lo = qMin(lo, d[i]);
+                hi = qMax(hi, d[i]);
+            }
+            s = e;
+        }
+        keys[p] = s0;
+        min[p] = lo;
+        max[p] = hi;
+    }
+    return pixels;
+}
+
+/**
+ * @brief CaptureView::buildPyramid
+ * @param channel - streaming channel ID.
+ */
+void CaptureView::buildPyramid(int channel)
+{
+    QVector<QVector<qint16> > &mins = m_min[channel];
+    QVector<QVector<qint16> > &maxs = m_max[channel];
+    const int chunks = m_reader.chunkCount(channel);
+
+    if (chunks == 0) {
+        return;
+    }
+    mins.resize(1);
+    maxs.resize(1);
+    mins[0].resize(chunks);
+    maxs[0].resize(chunks);
+    for (int i = 0; i < chunks; i++) {
+        mins[0][i] = m_reader.chunk(channel, i).chunk.min;
+        maxs[0][i] = m_reader.chunk(channel, i).chunk.max;
+    }
+    while (mins.last().size() > 1) {
+        const QVector<qint16> &lo = mins.last();
+        const QVector<qint16> &hi = maxs.last();
+        const int n = (lo.size() + 1) / 2;
+        QVector<qint16> nextLo(n);
+        QVector<qint16> nextHi(n);
+        for (int i = 0; i < n; i++) {
+            const int j = qMin(2 * i + 1, lo.size() - 1);
+            nextLo[i] = qMin(lo[2 * i], lo[j]);
+            nextHi[i] = qMax(hi[2 * i], hi[j]);
+        }
+        mins.append(nextLo);
+        maxs.append(nextHi);
+    }
+}
+
+/**
+ * @brief CaptureView::chunkRange
+ * @param channel - streaming channel ID.
+ * @param first - first chunk index.
+ * @param last - last chunk index, included.
+ *
+ * Takes the largest aligned block of the pyramid at each step.
+ */
+void CaptureView::chunkRange(int channel, int first, int last, qint16 &min, qint16 &max) const
+{
+    const QVector<QVector<qint16> > &mins = m_min[channel];
+    const QVector<QVector<qint16> > &maxs = m_max[channel];
+
+    min = 32767;
+    max = -32768;
+    while (first <= last) {
+        int level = 0;
+        while ((level + 1 < mins.size()) && !(first & ((2 << level) - 1)) &&
+               (first + (2 << level) - 1 <= last)) {
+            level++;
+        }
+        min = qMin(min, mins[level][first >> level]);
+        max = qMax(max, maxs[level][first >> level]);
+        first += 1 << level;
+    }
+}
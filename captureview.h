@@ -0,0 +1,38 @@
+#ifndef CAPTUREVIEW_H
+#define CAPTUREVIEW_H
+
+#include <QVector>
+
+#include "capturereader.h"
+
+/* Level of detail source for plotting a capture of any size. The chunk
+ * min/max of each channel form a pyramid, a range of whole chunks is
+ * summarized in a few lookups. Only ranges narrower than a chunk per
+ * pixel decode samples, and only those of the visible chunks.
+ */
+class CaptureView
+{
+public:
+    CaptureView();
+
+    bool open(const QString &fileName);
+    void close();
+    const CaptureReader &reader() const { return m_reader; }
+
+    bool range(int channel, qint16 &min, qint16 &max) const;
+    int envelope(int channel, double first, double last, int pixels,
+                 QVector<double> &keys, QVector<double> &min, QVector<double> &max) const;
+
+private:
+    void buildPyramid(int channel);
+    void chunkRange(int channel, int first, int last, qint16 &min, qint16 &max) const;
+
+private:
+    CaptureReader m_reader;
+    /* Level k holds the min/max of 2^k chunks. */
+    QVector<QVector<qint16> > m_min[STREAMING_CHANNEL_COUNT];
+    QVector<QVector<qint16> > m_max[STREAMING_CHANNEL_COUNT];
+    mutable QVector<qint16> m_decoded;
+};
+
+#endif // CAPTUREVIEW_H
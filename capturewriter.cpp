@@ -0,0 +1,178 @@
+#include "capturewriter.h"
+#include "capturecodec.h"
+
+/**
+ * @brief CaptureWriter::CaptureWriter
+ */
+CaptureWriter::CaptureWriter() :
+    m_pos(0),
+    m_failed(false)
+{
+    m_encoded.resize(sizeof(CaptureChunk) + CAPTURE_ENCODED_SIZE_MAX(CAPTURE_CHUNK_SAMPLES));
+}
+
+/**
+ * @brief CaptureWriter::~CaptureWriter
+ */
+CaptureWriter::~CaptureWriter()
+{
+    if (m_file.isOpen()) {
+        close();
+    }
+}
+
+/**
+ * @brief CaptureWriter::open
+ * @param fileName - capture file, truncated if it exists.
+ * @param startTime - host time of timestamp 0, ms since epoch.
+ * @return false if the file can't be written, see errorString().
+ */
+bool CaptureWriter::open(const QString &fileName, qint64 startTime)
+{
+    CaptureHeader hdr;
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    m_pos = 0;
+    m_failed = false;
+    m_index.clear();
+    for (int i = 0; i < STREAMING_CHANNEL_COUNT; i++) {
+        m_pending[i].samples.reserve(CAPTURE_CHUNK_SAMPLES);
+        m_pending[i].samples.resize(0);
+        m_pending[i].first_sample = 0;
+    }
+
+    memset((void *)&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    hdr.version = CAPTURE_VERSION;
+    hdr.header_size = sizeof(hdr);
+    hdr.start_time = startTime;
+    return write(&hdr, sizeof(hdr));
+}
+
+/**
+ * @brief CaptureWriter::close
+ * Writes the partial chunks, the index and the trailer.
+ * @return false if writing failed, see errorString().
+ */
+bool CaptureWriter::close()
+{
+    CaptureTrailer trailer;
+
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    for (int i = 0; i < STREAMING_CHANNEL_COUNT; i++) {
+        writeChunk(i);
+    }
+    trailer.index_offset = m_pos;
+    trailer.index_count = m_index.size();
+    trailer.magic = CAPTURE_TRAILER_MAGIC;
+    write(m_index.constData(), m_index.size() * (qint64)sizeof(CaptureIndexEntry));
+    write(&trailer, sizeof(trailer));
+
+    const bool ok = !m_failed && m_file.flush();
+    m_file.close();
+    m_index.clear();
+    return ok;
+}
+
+/**
+ * @brief CaptureWriter::sampleCount
+ * @param channel - streaming channel ID.
+ * @return samples of the channel added so far.
+ */
+qint64 CaptureWriter::sampleCount(int channel) const
+{
+    return m_pending[channel].first_sample + m_pending[channel].samples.size();
+}
+
+/**
+ * @brief CaptureWriter::addSamples
+ * @param channel - streaming channel ID.
+ * @param samples - the next samples of the channel.
+ * @param count - number of samples.
+ * @param timestamp - host receive time of the samples since the start, ns.
+ * @return false if writing failed, see errorString().
+ */
+bool CaptureWriter::addSamples(int channel, const qint16 *samples, int count, qint64 timestamp)
+{
+    if ((channel < 0) || (channel >= STREAMING_CHANNEL_COUNT)) {
+        return true;
+    }
+    PendingChunk &p = m_pending[channel];
+
+    while (count > 0) {
+        if (p.samples.isEmpty()) {
+            p.time_first = timestamp;
+        }
+        const int n = qMin(count, CAPTURE_CHUNK_SAMPLES - p.samples.size());
+        const int size = p.samples.size();
+        p.samples.resize(size + n);
+        memcpy((void *)(p.samples.data() + size), (const void *)samples, n * sizeof(qint16));
+        p.time_last = timestamp;
+        samples += n;
+        count -= n;
+        if (p.samples.size() == CAPTURE_CHUNK_SAMPLES) {
+            writeChunk(channel);
+        }
+    }
+    return !m_failed;
+}
+
+/**
+ * @brief CaptureWriter::writeChunk
+ * @param channel - streaming channel ID, its pending samples are written.
+ */
+bool CaptureWriter::writeChunk(int channel)
+{
+    PendingChunk &p = m_pending[channel];
+    CaptureIndexEntry entry;
+    CaptureChunk &chunk = entry.chunk;
+
+    if (p.samples.isEmpty()) {
+        return true;
+    }
+    const qint16 *s = p.samples.constData();
+    const int count = p.samples.size();
+
+    chunk.magic = CAPTURE_CHUNK_MAGIC;
+    chunk.channel = channel;
+    chunk.reserved = 0;
+    chunk.count = count;
+    chunk.first_sample = p.first_sample;
+    chunk.time_first = p.time_first;
+    chunk.time_last = p.time_last;
+    chunk.min = s[0];
+    chunk.max = s[0];
+    for (int i = 1; i < count; i++) {
+        chunk.min = qMin(chunk.min, s[i]);
+        chunk.max = qMax(chunk.max, s[i]);
+    }
+    chunk.size = captureEncode(s, count, m_encoded.data() + sizeof(chunk));
+    memcpy((void *)m_encoded.data(), (const void *)&chunk, sizeof(chunk));
+
+    entry.offset = m_pos;
+    m_index.append(entry);
+    p.first_sample += count;
+    p.samples.resize(0);
+    return write(m_encoded.constData(), sizeof(chunk) + chunk.size);
+}
+
+/**
+ * @brief CaptureWriter::write
+ */
+bool CaptureWriter::write(const void *data, qint64 size)
+{
+    if (m_failed) {
+        return false;
+    }
+    if (m_file.write((const char *)data, size) != size) {
+        m_failed = true;
+        return false;
+    }
+    m_pos += size;
+    return true;
+}
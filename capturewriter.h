@@ -0,0 +1,49 @@
+#ifndef CAPTUREWRITER_H
+#define CAPTUREWRITER_H
+
+#include <QFile>
+#include <QVector>
+
+#include "telemetry.h"
+#include "capture.h"
+
+/* Writer of a capture file. Samples are collected per channel, a full
+ * chunk is compressed and appended, close() writes the remaining chunks
+ * and the index.
+ */
+class CaptureWriter
+{
+public:
+    CaptureWriter();
+    ~CaptureWriter();
+
+    bool open(const QString &fileName, qint64 startTime);
+    bool close();
+    bool isOpen() const { return m_file.isOpen(); }
+    QString errorString() const { return m_file.errorString(); }
+    qint64 size() const { return m_pos; }
+    qint64 sampleCount(int channel) const;
+
+    bool addSamples(int channel, const qint16 *samples, int count, qint64 timestamp);
+
+private:
+    bool writeChunk(int channel);
+    bool write(const void *data, qint64 size);
+
+private:
+    typedef struct tagPendingChunk {
+        QVector<qint16> samples;
+        qint64 first_sample;
+        qint64 time_first;
+        qint64 time_last;
+    } PendingChunk;
+
+    QFile m_file;
+    qint64 m_pos;               /* End of the written data.         */
+    bool m_failed;
+    PendingChunk m_pending[STREAMING_CHANNEL_COUNT];
+    QVector<CaptureIndexEntry> m_index;
+    QVector<quint8> m_encoded;
+};
+
+#endif // CAPTUREWRITER_H
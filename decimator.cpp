@@ -0,0 +1,237 @@
+#include "decimator.h"
+#include "streamkernels.h"
+
+#include <qmath.h>
+
+/* CIC input in fixed point, fractions of filtered samples are kept. */
+static inline qint64 cicInput(qint16 sample)
+{
+    return (qint64)sample * (1 << DECIMATOR_CIC_FRACTION_BITS);
+}
+
+static inline qint64 cicInput(double sample)
+{
+    return qRound64(sample * (1 << DECIMATOR_CIC_FRACTION_BITS));
+}
+
+/**
+ * @brief Decimator::Decimator
+ */
+Decimator::Decimator()
+{
+    configure(TypeBoxcar, 1);
+}
+
+/**
+ * @brief Decimator::configure
+ * @param type - decimation filter type.
+ * @param ratio - number of input samples per output sample.
+ */
+void Decimator::configure(Type type, int ratio)
+{
+    m_type = type;
+    m_ratio = qBound(1, ratio, DECIMATOR_RATIO_MAX);
+    m_cicGain = qPow(m_ratio, DECIMATOR_CIC_ORDER) * (1 << DECIMATOR_CIC_FRACTION_BITS);
+    designFIR();
+    reset();
+}
+
+/**
+ * @brief Decimator::reset
+ * Clears filter state. The next output sample uses input samples
+ * received after the reset only.
+ */
+void Decimator::reset()
+{
+    m_phase = 0;
+    m_boxcarAccum = 0;
+    m_boxcarSum = 0.0;
+    for (int i = 0; i < DECIMATOR_CIC_ORDER; i++) {
+        m_cicIntegrator[i] = 0;
+        m_cicComb[i] = 0;
+    }
+    m_firHistory.fill(0.0);
+    m_firPos = 0;
+}
+
+/**
+ * @brief Decimator::process
+ * @param samples - raw input samples.
+ * @param count - number of input samples.
+ * @param out - decimated samples are appended to this vector.
+ *
+ * Partial output periods carry over to the next call, so frames of any
+ * size may be passed in.
+ */
+void Decimator::process(const qint16 *samples, int count, QVector<double> &out)
+{
+    out.reserve(out.size() + (m_phase + count) / m_ratio);
+
+    switch (m_type) {
+    case TypeCIC:
+        processCIC(samples, count, out);
+        break;
+    case TypeFIR:
+        processFIR(samples, count, out);
+        break;
+    default:
+        processBoxcar(samples, count, out);
+        break;
+    }
+}
+
+/**
+ * @brief Decimator::process
+ * @param samples - conditioned input samples, e.g. the output of a filter.
+ * @param count - number of input samples.
+ * @param out - decimated samples are appended to this vector.
+ */
+void Decimator::process(const double *samples, int count, QVector<double> &out)
+{
+    out.reserve(out.size() + (m_phase + count) / m_ratio);
+
+    switch (m_type) {
+    case TypeCIC:
+        processCIC(samples, count, out);
+        break;
+    case TypeFIR:
+        processFIR(samples, count, out);
+        break;
+    default:
+        processBoxcar(samples, count, out);
+        break;
+    }
+}
+
+/**
+ * @brief Decimator::processBoxcar
+ * A group left open by the previous frame is completed first, whole groups
+ * are then averaged by the vectorized kernel and the remainder is carried.
+ */
+void Decimator::processBoxcar(const qint16 *samples, int count, QVector<double> &out)
+{
+    int i = 0;
+
+    if (m_phase) {
+        for (; (i < count) && (m_phase < m_ratio); i++, m_phase++) {
+            m_boxcarAccum += samples[i];
+        }
+        if (m_phase < m_ratio) {
+            return;
+        }
+        out.append(m_boxcarAccum * (1.0 / m_ratio));
+        m_boxcarAccum = 0;
+        m_phase = 0;
+    }
+
+    int groups = (count - i) / m_ratio;
+    if (groups) {
+        int outPos = out.size();
+        out.resize(outPos + groups);
+        streamBoxcar(samples + i, groups, m_ratio, out.data() + outPos);
+        i += groups * m_ratio;
+    }
+
+    for (; i < count; i++, m_phase++) {
+        m_boxcarAccum += samples[i];
+    }
+}
+
+/**
+ * @brief Decimator::processBoxcar
+ */
+void Decimator::processBoxcar(const double *samples, int count, QVector<double> &out)
+{
+    for (int i = 0; i < count; i++) {
+        m_boxcarSum += samples[i];
+        if (++m_phase == m_ratio) {
+            out.append(m_boxcarSum * (1.0 / m_ratio));
+            m_boxcarSum = 0.0;
+            m_phase = 0;
+        }
+    }
+}
+
+/**
+ * @brief Decimator::processCIC
+ * Integrators run at the input rate and combs at the output rate. The
+ * state uses modulo 2^64 arithmetic, the wrap-arounds cancel out in the
+ * combs as long as the output fits into 64 bits.
+ */
+template <typename T>
+void Decimator::processCIC(const T *samples, int count, QVector<double> &out)
+{
+    for (int i = 0; i < count; i++) {
+        m_cicIntegrator[0] += (quint64)cicInput(samples[i]);
+        for (int s = 1; s < DECIMATOR_CIC_ORDER; s++) {
+            m_cicIntegrator[s] += m_cicIntegrator[s - 1];
+        }
+        if (++m_phase == m_ratio) {
+            quint64 value = m_cicIntegrator[DECIMATOR_CIC_ORDER - 1];
+            for (int s = 0; s < DECIMATOR_CIC_ORDER; s++) {
+                quint64 delayed = m_cicComb[s];
+                m_cicComb[s] = value;
+                value -= delayed;
+            }
+            out.append((double)(qint64)value / m_cicGain);
+            m_phase = 0;
+        }
+    }
+}
+
+/**
+ * @brief Decimator::processFIR
+ * The delay line is stored twice back to back, so the taps always see a
+ * contiguous window. The filter is evaluated only at output instants,
+ * i.e. every input phase is convolved with its own polyphase branch.
+ */
+template <typename T>
+void Decimator::processFIR(const T *samples, int count, QVector<double> &out)
+{
+    const int numTaps = m_firTaps.size();
+    const double *taps = m_firTaps.constData();
+    double *history = m_firHistory.data();
+
+    for (int i = 0; i < count; i++) {
+        m_firPos = (m_firPos == 0) ? (numTaps - 1) : (m_firPos - 1);
+        history[m_firPos] = samples[i];
+        history[m_firPos + numTaps] = samples[i];
+        if (++m_phase == m_ratio) {
+            const double *x = history + m_firPos;
+            double accum = 0.0;
+            for (int k = 0; k < numTaps; k++) {
+                accum += taps[k] * x[k];
+            }
+            out.append(accum);
+            m_phase = 0;
+        }
+    }
+}
+
+/**
+ * @brief Decimator::designFIR
+ * Blackman windowed-sinc low-pass with unity DC gain and the cut-off
+ * slightly below the output Nyquist frequency.
+ */
+void Decimator::designFIR()
+{
+    const int numTaps = m_ratio * DECIMATOR_FIR_TAPS_PER_PHASE;
+    const double fc = DECIMATOR_FIR_CUTOFF * 0.5 / m_ratio;
+    const double center = (numTaps - 1) / 2.0;
+    double sum = 0.0;
+
+    m_firTaps.resize(numTaps);
+    for (int n = 0; n < numTaps; n++) {
+        double t = n - center;
+        double sinc = (t == 0.0) ? 2.0 * fc : qSin(2.0 * M_PI * fc * t) / (M_PI * t);
+        double window = 0.42 - 0.5 * qCos(2.0 * M_PI * n / (numTaps - 1))
+                      + 0.08 * qCos(4.0 * M_PI * n / (numTaps - 1));
+        m_firTaps[n] = sinc * window;
+        sum += m_firTaps[n];
+    }
+    for (int n = 0; n < numTaps; n++) {
+        m_firTaps[n] /= sum;
+    }
+
+    m_firHistory.resize(2 * numTaps);
+}
@@ -0,0 +1,59 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <QtGlobal>
+#include <QVector>
+
+/* Number of CIC integrator/comb stages.   */
+#define DECIMATOR_CIC_ORDER             3
+/* FIR taps per polyphase branch.          */
+#define DECIMATOR_FIR_TAPS_PER_PHASE    16
+/* Fixed point fraction bits of the CIC.   */
+#define DECIMATOR_CIC_FRACTION_BITS     8
+/* FIR cut-off relative to output Nyquist. */
+#define DECIMATOR_FIR_CUTOFF            0.9
+/* Maximum supported decimation ratio.     */
+#define DECIMATOR_RATIO_MAX             256
+
+class Decimator
+{
+public:
+    /* Available decimation filters. */
+    enum Type {
+        TypeBoxcar = 0,  /* Block average of ratio samples.          */
+        TypeCIC,         /* Cascaded integrator-comb, normalized.    */
+        TypeFIR          /* Windowed-sinc low-pass, polyphase.       */
+    };
+
+    Decimator();
+
+    void configure(Type type, int ratio);
+    void reset();
+    void process(const qint16 *samples, int count, QVector<double> &out);
+    void process(const double *samples, int count, QVector<double> &out);
+
+    Type type() const { return m_type; }
+    int ratio() const { return m_ratio; }
+
+private:
+    void processBoxcar(const qint16 *samples, int count, QVector<double> &out);
+    void processBoxcar(const double *samples, int count, QVector<double> &out);
+    template <typename T> void processCIC(const T *samples, int count, QVector<double> &out);
+    template <typename T> void processFIR(const T *samples, int count, QVector<double> &out);
+    void designFIR();
+
+private:
+    Type m_type;
+    int m_ratio;
+    int m_phase;            /* Input samples since the last output sample. */
+    qint64 m_boxcarAccum;
+    double m_boxcarSum;     /* Accumulator of the floating point input.    */
+    quint64 m_cicIntegrator[DECIMATOR_CIC_ORDER];
+    quint64 m_cicComb[DECIMATOR_CIC_ORDER];
+    double m_cicGain;
+    QVector<double> m_firTaps;
+    QVector<double> m_firHistory; /* Two copies of the delay line back to back. */
+    int m_firPos;
+};
+
+#endif // DECIMATOR_H
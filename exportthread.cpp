@@ -0,0 +1,318 @@
+#include "exportthread.h"
+#include "telemetry.h"
+#include "multistream.h"
+#include "capturereader.h"
+#include "recordingreader.h"
+
+/**
+ * @brief ExportThread::ExportThread
+ * @param parent
+ */
+ExportThread::ExportThread(QObject *parent) :
+    QThread(parent),
+    m_nextId(1),
+    m_current(0),
+    m_active(false),
+    m_cancel(false),
+    m_samples(0)
+{
+    // Empty;
+}
+
+/**
+ * @brief ExportThread::~ExportThread
+ */
+ExportThread::~ExportThread()
+{
+    cancelAll();
+    wait();
+}
+
+/**
+ * @brief ExportThread::addJob
+ * @param job - export to queue, the ID is ignored.
+ * @return ID of the job in the signals.
+ */
+int ExportThread::addJob(const Job &job)
+{
+    m_mutex.lock();
+    m_jobs.append(job);
+    const int id = m_jobs.last().id = m_nextId++;
+    if (m_active) {
+        m_mutex.unlock();
+        return id;
+    }
+    m_active = true;
+    m_mutex.unlock();
+
+    /* The worker may still be returning from an earlier queue. */
+    wait();
+    start(QThread::LowPriority);
+    return id;
+}
+
+/**
+ * @brief ExportThread::cancelJob
+ * @param id - queued or running job.
+ */
+void ExportThread::cancelJob(int id)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (id == m_current) {
+        m_cancel = true;
+        return;
+    }
+    for (int i = 0; i < m_jobs.size(); i++) {
+        if (m_jobs[i].id == id) {
+            m_jobs.removeAt(i);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief ExportThread::cancelAll
+ * Drops the queued jobs and cancels the running one.
+ */
+void ExportThread::cancelAll()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_jobs.clear();
+    m_cancel = (m_current != 0);
+}
+
+/**
+ * @brief ExportThread::pendingJobs
+ * @return number of queued and running jobs.
+ */
+int ExportThread::pendingJobs() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_jobs.size() + (m_current ? 1 : 0);
+}
+
+/**
+ * @brief ExportThread::run
+ */
+void ExportThread::run()
+{
+    forever {
+        m_mutex.lock();
+        if (m_jobs.isEmpty()) {
+            m_active = false;
+            m_mutex.unlock();
+            return;
+        }
+        const Job job = m_jobs.takeFirst();
+        m_current = job.id;
+        m_cancel = false;
+        m_mutex.unlock();
+
+        emit this->exportStarted(job.id);
+
+        QString error;
+        bool ok = false;
+        m_out.setFileName(job.target);
+        m_buf.resize(0);
+        m_samples = 0;
+        m_progressTimer.start();
+        if (!m_out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            error = tr("Can't write %1. %2.").arg(job.target).arg(m_out.errorString());
+        } else {
+            if (job.format == FormatCsv) {
+                m_buf.append("sample,time_s,value\n");
+            }
+            if (job.source.endsWith(".smdcap", Qt::CaseInsensitive)) {
+                ok = exportCapture(job, error);
+            } else {
+                ok = exportRecording(job, error);
+            }
+            if (ok && !flush()) {
+                error = tr("Can't write %1. %2.").arg(job.target).arg(m_out.errorString());
+                ok = false;
+            }
+            m_out.close();
+            if (!ok) {
+                m_out.remove();
+            }
+        }
+
+        m_mutex.lock();
+        m_current = 0;
+        m_mutex.unlock();
+
+        if (ok) {
+            emit this->exportProgress(job.id, 100);
+            emit this->exportFinished(job.id, true, tr("%1 samples exported to %2").arg(m_samples).arg(job.target));
+        } else {
+            emit this->exportFinished(job.id, false, error);
+        }
+        m_buf.resize(0);
+        m_buf.squeeze();
+    }
+}
+
+/**
+ * @brief ExportThread::exportCapture
+ * @return false if the job failed or was cancelled, see error.
+ */
+bool ExportThread::exportCapture(const Job &job, QString &error)
+{
+    CaptureReader reader;
+    qint16 samples[CAPTURE_CHUNK_SAMPLES];
+
+    if (!reader.open(job.source)) {
+        error = tr("Can't export %1. %2.").arg(job.source).arg(reader.errorString());
+        return false;
+    }
+    if ((job.channel < 0) || (job.channel >= STREAMING_CHANNEL_COUNT)) {
+        error = tr("Captures have no single stream, select a channel.");
+        return false;
+    }
+    const qint64 end = (job.to < 0) ? reader.duration() : job.to;
+
+    for (int i = reader.findTime(job.channel, job.from); i < reader.chunkCount(job.channel); i++) {
+        const CaptureChunk &chunk = reader.chunk(job.channel, i).chunk;
+        if (chunk.time_first > end) {
+            break;
+        }
+        if (!reader.readChunk(job.channel, i, samples)) {
+            error = tr("Can't export %1. Chunk %2 is corrupt.").arg(job.source).arg(i);
+            return false;
+        }
+        for (int j = 0; j < chunk.count; j++) {
+            const qint64 t = CaptureReader::chunkTime(chunk, j);
+            if ((t >= job.from) && (t <= end)) {
+                addSample(job, chunk.first_sample + j, t, samples[j]);
+            }
+        }
+        if (!progress(job, chunk.time_last, end)) {
+            error = m_out.error() ? tr("Can't write %1. %2.").arg(job.target).arg(m_out.errorString())
+                                  : tr("Export cancelled.");
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief ExportThread::exportRecording
+ * @return false if the job failed or was cancelled, see error.
+ *
+ * Sample indices count every sample of the channel in the recording,
+ * the samples of a message share its receive time.
+ */
+bool ExportThread::exportRecording(const Job &job, QString &error)
+{
+    RecordingReader reader;
+    RecordHeader hdr;
+    const char *data;
+    qint64 sample = 0;
+
+    if (!reader.open(job.source)) {
+        error = tr("Can't export %1. %2.").arg(job.source).arg(reader.errorString());
+        return false;
+    }
+    const qint64 end = (job.to < 0) ? reader.duration() : job.to;
+
+    while (reader.next(hdr, &data) && (hdr.timestamp <= end)) {
+        if (hdr.signature != TELEMETRY_MSG_SIGNATURE) {
+            continue;
+        }
+        const qint16 *s = (const qint16 *)data;
+        const bool inRange = (hdr.timestamp >= job.from);
+        if (job.channel == EXPORT_CHANNEL_STREAM) {
+            if ((hdr.msg_id == 's') || (hdr.msg_id == 'r')) {
+                const int n = hdr.data_size / (int)sizeof(qint16);
+                for (int i = 0; inRange && (i < n); i++) {
+                    addSample(job, sample + i, hdr.timestamp, s[i]);
+                }
+                sample += n;
+            }
+        } else if ((hdr.msg_id == 'm') && (hdr.data_size >= MULTISTREAM_HDR_SIZE) &&
+                   ((quint8)data[0] & (1 << job.channel))) {
+            /* Frames hold the selected channels in ascending ID order. */
+            const quint8 mask = (quint8)data[0];
+            int count = 0;
+            int index = 0;
+            for (int c = 0; c < STREAMING_CHANNEL_COUNT; c++) {
+                if (mask & (1 << c)) {
+                    if (c == job.channel) {
+                        index = count;
+                    }
+                    count++;
+                }
+            }
+            s = (const qint16 *)(data + MULTISTREAM_HDR_SIZE);
+            const int frames = (hdr.data_size - MULTISTREAM_HDR_SIZE) / (count * (int)sizeof(qint16));
+            for (int i = 0; inRange && (i < frames); i++) {
+                addSample(job, sample + i, hdr.timestamp, s[i * count + index]);
+            }
+            sample += frames;
+        }
+        if (!progress(job, hdr.timestamp, end)) {
+            error = m_out.error() ? tr("Can't write %1. %2.").arg(job.target).arg(m_out.errorString())
+                                  : tr("Export cancelled.");
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief ExportThread::addSample
+ * Appends a sample to the output buffer.
+ */
+void ExportThread::addSample(const Job &job, qint64 sample, qint64 timestamp, qint16 value)
+{
+    char line[64];
+
+    if (job.format == FormatCsv) {
+        const int n = qsnprintf(line, sizeof(line), "%lld,%lld.%09lld,%d\n", sample,
+                                timestamp / 1000000000LL, timestamp % 1000000000LL, value);
+        m_buf.append(line, n);
+    } else {
+        m_buf.append((const char *)&value, sizeof(value));
+    }
+    m_samples++;
+}
+
+/**
+ * @brief ExportThread::flush
+ * @return false if writing failed.
+ */
+bool ExportThread::flush()
+{
+    const bool ok = (m_out.write(m_buf) == m_buf.size());
+
+    m_buf.resize(0);
+    return ok;
+}
+
+/**
+ * @brief ExportThread::progress
+ * @param timestamp - source time reached, ns.
+ * @param end - end of the exported range, ns.
+ * @return false if the job is cancelled or writing failed.
+ *
+ * Writes the buffer once it is full. The progress is reported and the
+ * cancellation checked every EXPORT_PROGRESS_MS.
+ */
+bool ExportThread::progress(const Job &job, qint64 timestamp, qint64 end)
+{
+    if ((m_buf.size() >= EXPORT_BUFFER_SIZE) && !flush()) {
+        return false;
+    }
+    if (m_progressTimer.elapsed() < EXPORT_PROGRESS_MS) {
+        return true;
+    }
+    const qint64 span = qMax(end - job.from, (qint64)1);
+    emit this->exportProgress(job.id, (int)qBound((qint64)0, (timestamp - job.from) * 100 / span, (qint64)99));
+    m_progressTimer.start();
+
+    QMutexLocker locker(&m_mutex);
+    return !m_cancel;
+}
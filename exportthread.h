@@ -0,0 +1,84 @@
+#ifndef EXPORTTHREAD_H
+#define EXPORTTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+
+/* Output bytes written at once.           */
+#define EXPORT_BUFFER_SIZE              (64 * 1024)
+/* Interval between progress signals, ms.  */
+#define EXPORT_PROGRESS_MS              100
+/* Channel of the 's' and 'r' messages.    */
+#define EXPORT_CHANNEL_STREAM           -1
+
+/* Exporter of the samples of a recording or a capture. Jobs are queued
+ * and run one after the other on the worker thread, which stops when the
+ * queue is empty. The source is mapped and the output is written in
+ * EXPORT_BUFFER_SIZE pieces, memory use does not depend on the size of
+ * the export.
+ */
+class ExportThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    /* Output formats. */
+    enum Format {
+        FormatCsv = 0,      /* sample,time_s,value rows.                */
+        FormatBinary        /* qint16 values in host byte order.        */
+    };
+
+    typedef struct tagJob {
+        int id;             /* Assigned by addJob().                    */
+        QString source;     /* Recording or capture file.               */
+        QString target;     /* Output file, removed if the job fails.   */
+        Format format;
+        int channel;        /* Streaming channel ID, in recordings of the
+                             * 'm' messages or EXPORT_CHANNEL_STREAM.   */
+        qint64 from;        /* Time range since the start of the        */
+        qint64 to;          /* source, ns, to < 0 for the end.          */
+    } Job;
+
+    ExportThread(QObject *parent = 0);
+    ~ExportThread();
+
+    int addJob(const Job &job);
+    void cancelJob(int id);
+    void cancelAll();
+    int pendingJobs() const;
+
+signals:
+    void exportStarted(int id);
+    void exportProgress(int id, int percent);
+    void exportFinished(int id, bool ok, const QString &s);
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    bool exportCapture(const Job &job, QString &error);
+    bool exportRecording(const Job &job, QString &error);
+    void addSample(const Job &job, qint64 sample, qint64 timestamp, qint16 value);
+    bool flush();
+    bool progress(const Job &job, qint64 timestamp, qint64 end);
+
+private:
+    mutable QMutex m_mutex;
+    QList<Job> m_jobs;
+    int m_nextId;
+    int m_current;              /* ID of the running job, 0 if none.    */
+    bool m_active;              /* Worker started and not yet leaving.  */
+    bool m_cancel;              /* Cancel the running job.              */
+    /* Worker thread state. */
+    QFile m_out;
+    QByteArray m_buf;
+    qint64 m_samples;
+    QElapsedTimer m_progressTimer;
+};
+
+#endif // EXPORTTHREAD_H
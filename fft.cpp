@@ -0,0 +1,146 @@
+#include "fft.h"
+
+#include <qmath.h>
+
+/**
+ * @brief RealFFT::RealFFT
+ * @param size - number of real input samples, power of two.
+ */
+RealFFT::RealFFT(int size) :
+    m_size(0)
+{
+    setSize(size);
+}
+
+/**
+ * @brief RealFFT::setSize
+ * @param size - number of real input samples, rounded down to a power of two.
+ *
+ * A real transform of size N is computed as a complex transform of N / 2
+ * points on the even/odd interleaved samples, followed by a split step.
+ */
+void RealFFT::setSize(int size)
+{
+    size = qBound(FFT_SIZE_MIN, size, FFT_SIZE_MAX);
+    int n = FFT_SIZE_MIN;
+    while ((n << 1) <= size) {
+        n <<= 1;
+    }
+    if (n == m_size) {
+        return;
+    }
+
+    m_size = n;
+    const int half = n / 2;
+
+    int bits = 0;
+    while ((1 << bits) < half) {
+        bits++;
+    }
+    m_bitRev.resize(half);
+    for (int i = 0; i < half; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitRev[i] = r;
+    }
+
+    m_twCos.resize(half / 2);
+    m_twSin.resize(half / 2);
+    for (int k = 0; k < half / 2; k++) {
+        m_twCos[k] = qCos(2.0 * M_PI * k / half);
+        m_twSin[k] = -qSin(2.0 * M_PI * k / half);
+    }
+
+    m_postCos.resize(half + 1);
+    m_postSin.resize(half + 1);
+    for (int k = 0; k <= half; k++) {
+        m_postCos[k] = qCos(2.0 * M_PI * k / n);
+        m_postSin[k] = qSin(2.0 * M_PI * k / n);
+    }
+
+    m_workRe.resize(half);
+    m_workIm.resize(half);
+    m_binIm.resize(half + 1);
+}
+
+/**
+ * @brief RealFFT::transform
+ * @param in - size() real samples.
+ * @param re - real parts of bins 0 .. size() / 2.
+ * @param im - imaginary parts of bins 0 .. size() / 2.
+ */
+void RealFFT::transform(const double *in, double *re, double *im)
+{
+    const int half = m_size / 2;
+
+    for (int i = 0; i < half; i++) {
+        m_workRe[m_bitRev[i]] = in[2 * i];
+        m_workIm[m_bitRev[i]] = in[2 * i + 1];
+    }
+
+    complexFFT();
+
+    for (int k = 0; k <= half; k++) {
+        int k1 = (k == half) ? 0 : k;
+        int k2 = (k == 0) ? 0 : (half - k);
+        double a = m_workRe[k1];
+        double b = m_workIm[k1];
+        double c = m_workRe[k2];
+        double d = -m_workIm[k2];
+        /* Even part (Z[k] + Z*[N/2-k]) / 2, odd part -i (Z[k] - Z*[N/2-k]) / 2. */
+        double er = 0.5 * (a + c);
+        double ei = 0.5 * (b + d);
+        double or_ = 0.5 * (b - d);
+        double oi = -0.5 * (a - c);
+        re[k] = er + or_ * m_postCos[k] + oi * m_postSin[k];
+        im[k] = ei + oi * m_postCos[k] - or_ * m_postSin[k];
+    }
+}
+
+/**
+ * @brief RealFFT::powerSpectrum
+ * @param in - size() real samples.
+ * @param power - squared magnitudes of bins 0 .. size() / 2.
+ */
+void RealFFT::powerSpectrum(const double *in, double *power)
+{
+    const int bins = m_size / 2 + 1;
+    const double *im = m_binIm.constData();
+
+    transform(in, power, m_binIm.data());
+    for (int k = 0; k < bins; k++) {
+        power[k] = power[k] * power[k] + im[k] * im[k];
+    }
+}
+
+/**
+ * @brief RealFFT::complexFFT
+ * In-place iterative radix-2 transform of the bit reversed work buffers.
+ */
+void RealFFT::complexFFT()
+{
+    const int n = m_size / 2;
+    double *re = m_workRe.data();
+    double *im = m_workIm.data();
+
+    for (int len = 2; len <= n; len <<= 1) {
+        const int halfLen = len / 2;
+        const int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < halfLen; j++) {
+                double wr = m_twCos[j * step];
+                double wi = m_twSin[j * step];
+                int p = i + j;
+                int q = p + halfLen;
+                double vr = re[q] * wr - im[q] * wi;
+                double vi = re[q] * wi + im[q] * wr;
+                re[q] = re[p] - vr;
+                im[q] = im[p] - vi;
+                re[p] += vr;
+                im[p] += vi;
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <QVector>
+
+/* Smallest supported transform size.      */
+#define FFT_SIZE_MIN                    4
+/* Largest supported transform size.       */
+#define FFT_SIZE_MAX                    65536
+
+class RealFFT
+{
+public:
+    RealFFT(int size = FFT_SIZE_MIN);
+
+    void setSize(int size);
+    int size() const { return m_size; }
+
+    void transform(const double *in, double *re, double *im);
+    void powerSpectrum(const double *in, double *power);
+
+private:
+    void complexFFT();
+
+private:
+    int m_size;                 /* Real transform size, power of two.       */
+    QVector<int> m_bitRev;      /* Bit reversal permutation, size / 2.      */
+    QVector<double> m_twCos;    /* Half size complex FFT twiddles.          */
+    QVector<double> m_twSin;
+    QVector<double> m_postCos;  /* Real spectrum split twiddles.            */
+    QVector<double> m_postSin;
+    QVector<double> m_workRe;
+    QVector<double> m_workIm;
+    QVector<double> m_binIm;    /* Imaginary parts for powerSpectrum().     */
+};
+
+#endif // FFT_H
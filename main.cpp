@@ -6,6 +6,9 @@ int main(int argc, char *argv[])
     QApplication a(argc, argv);
     qRegisterMetaType<TelemetryMessage>();
     qRegisterMetaType<QVector<double> >();
+    qRegisterMetaType<StreamStatistics>();
+    qRegisterMetaType<ScanFeatures>();
+    qRegisterMetaType<BodePoint>();
     MainWindow w;
     w.show();
 
@@ -3,11 +3,81 @@
 
 #include <QtSerialPort/QSerialPortInfo>
 #include <QDebug>
+#include <QtNumeric>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QStandardPaths>
+
+/* Names of the streaming channels, indexed by channel ID. */
+static const char *streamingChannelNames[STREAMING_CHANNEL_COUNT] = {
+    "FE", "CE", "SUM", "A", "B", "C", "D"
+};
+
+/* Headroom added when a value axis grows. */
+#define PLOT_GROW_MARGIN        0.05
+
+/**
+ * @brief plotCacheStatic
+ * @param plot - plot whose axes stay put between data updates, called
+ * before its graphs are added.
+ * The graphs go on a layer of their own, the background, grid and axes
+ * layers are cached, so a data update only redraws the graphs. Value axes
+ * of such plots follow the data through plotGrowValueAxis().
+ */
+static void plotCacheStatic(QCustomPlot *plot)
+{
+    plot->addLayer("data", plot->layer("main"), QCustomPlot::limAbove);
+    plot->setCurrentLayer("data");
+    plot->layer("background")->setCached(true);
+    plot->layer("grid")->setCached(true);
+    plot->layer("axes")->setCached(true);
+}
+
+/**
+ * @brief plotGrowValueAxis
+ * @param graph - graph whose value axis follows its data.
+ * @param reset - fit the axis to the data instead of only growing it.
+ * The axis is left alone while the data stays inside it, so the cached
+ * layers of the plot survive the update. Data leaving it grows the axis
+ * with some headroom, rescaling on every update would redraw them each time.
+ */
+static void plotGrowValueAxis(QCPGraph *graph, bool reset)
+{
+    QCPAxis *axis = graph->valueAxis();
+    const QCPRange old = axis->range();
+
+    graph->rescaleValueAxis(false);
+    QCPRange range = axis->range();
+    if (!reset) {
+        if ((range.lower >= old.lower) && (range.upper <= old.upper)) {
+            axis->setRange(old);
+            return;
+        }
+        range.expand(old);
+    }
+    const double margin = range.size() * PLOT_GROW_MARGIN;
+    axis->setRange(range.lower - margin, range.upper + margin);
+}
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow),
     m_serialPortList(new QComboBox),
+    m_plotQualityLabel(new QLabel),
+    m_recorderLabel(new QLabel),
+    m_triggerCount(0),
+    m_multiMask(0),
+    m_multiUpdateCnt(0),
+    m_scanCount(0),
+    m_bodeRunning(false),
+    m_bodePointCnt(0),
+    m_bodePhase(0.0),
+    m_replaying(false),
+    m_replayDuration(0),
+    m_compareValid(false),
+    m_bundlePending(false),
     m_serialConnected(false),
     m_breakLoopFOC(false),
     m_breakLoopRAD(false),
@@ -29,6 +99,55 @@ MainWindow::MainWindow(QWidget *parent) :
             this, SLOT(scaningGO()));
     connect(ui->actionReboot, SIGNAL(triggered()),
             this, SLOT(boardReboot()));
+    connect(ui->actionRecord, SIGNAL(triggered()),
+            this, SLOT(recordingGO()));
+    connect(ui->actionIncident, SIGNAL(triggered()),
+            this, SLOT(saveIncident()));
+    connect(ui->actionBundle, SIGNAL(triggered()),
+            this, SLOT(saveBundle()));
+    m_bundleTimeout.setSingleShot(true);
+    connect(&m_bundleTimeout, SIGNAL(timeout()),
+            this, SLOT(bundleFinish()));
+    m_bundlePost.setSingleShot(true);
+    connect(&m_bundlePost, SIGNAL(timeout()),
+            this, SLOT(bundleSave()));
+
+    m_serialThread.setRecorder(&m_recorder);
+
+    /* The black box always runs, a crashed session is saved on the next start. */
+    const QString blackBoxDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(blackBoxDir);
+    if (m_blackBox.open(blackBoxDir + "/blackbox.smdring")) {
+        m_serialThread.setBlackBox(&m_blackBox);
+        if (!m_blackBox.recoveredFileName().isEmpty()) {
+            ui->statusBar->showMessage(tr("The previous session did not end cleanly, its black box is saved to %1")
+                .arg(QDir::toNativeSeparators(m_blackBox.recoveredFileName())));
+        }
+    } else {
+        ui->statusBar->showMessage(tr("Black box disabled, incidents can't be saved. %1.")
+            .arg(m_blackBox.errorString()));
+        ui->actionIncident->setEnabled(false);
+    }
+
+    connect(&m_recorder, SIGNAL(recorderError(QString)),
+            this, SLOT(recorderError(QString)), Qt::QueuedConnection);
+    connect(&m_recorder, SIGNAL(recorderStatus(qint64,qint64,qint64)),
+            this, SLOT(recorderStatus(qint64,qint64,qint64)), Qt::QueuedConnection);
+
+    connect(ui->pushReplayOpen, SIGNAL(pressed()),
+            this, SLOT(replayOpen()));
+    connect(ui->pushReplayStop, SIGNAL(pressed()),
+            this, SLOT(replayStop()));
+    connect(ui->comboReplaySpeed, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(replaySpeedUpdate(int)));
+    connect(ui->checkReplayLoop, SIGNAL(toggled(bool)),
+            this, SLOT(replayLoopUpdate(bool)));
+    connect(ui->sliderReplayPosition, SIGNAL(sliderReleased()),
+            this, SLOT(replaySeek()));
+    connect(&m_serialThread, SIGNAL(replayPosition(qint64,qint64,double)),
+            this, SLOT(processReplayPosition(qint64,qint64,double)), Qt::QueuedConnection);
+    connect(&m_serialThread, SIGNAL(replayFinished()),
+            this, SLOT(replayFinished()), Qt::QueuedConnection);
 
     connect(&m_serialTimer, SIGNAL(timeout()),
             this, SLOT(processTimeout()));
@@ -85,6 +204,298 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->plotFast->xAxis->setAutoTickStep(false);
     ui->plotFast->xAxis->setTickStep(512);
 
+    /* One more graph per channel for simultaneous streaming, graph 1 + ID. */
+    const QColor channelColors[STREAMING_CHANNEL_COUNT] = {
+        Qt::red, Qt::blue, Qt::darkGreen, Qt::magenta, Qt::darkCyan, Qt::darkYellow, Qt::black
+    };
+    for (int id = 0; id < STREAMING_CHANNEL_COUNT; id++) {
+        QCPGraph *graph = ui->plotFast->addGraph();
+        graph->setPen(QPen(channelColors[id]));
+        graph->setName(streamingChannelNames[id]);
+        graph->setVisible(false);
+        m_multiSampleCnt[id] = 1;
+    }
+    ui->plotFast->graph(0)->removeFromLegend();
+    connect(&m_serialThread, SIGNAL(multiStreamDataReady(int,QVector<double>)),
+            this, SLOT(processMultiStreamData(int,QVector<double>)), Qt::QueuedConnection);
+    connect(&m_serialThread, SIGNAL(multiStreamRates(QVector<double>)),
+            this, SLOT(processMultiStreamRates(QVector<double>)), Qt::QueuedConnection);
+    connect(ui->groupMultiChannel, SIGNAL(toggled(bool)),
+            this, SLOT(multiChannelUpdate()));
+    foreach (QCheckBox *check, ui->groupMultiChannel->findChildren<QCheckBox *>()) {
+        connect(check, SIGNAL(toggled(bool)),
+                this, SLOT(multiChannelUpdate()));
+    }
+
+    /* Degrade plot rendering quality when replots get too slow. */
+    m_plotQuality.addPlot(ui->plotSlow);
+    m_plotQuality.addPlot(ui->plotFast);
+    m_plotQuality.setBudget(ui->spinPlotBudget->value());
+    ui->statusBar->addPermanentWidget(m_plotQualityLabel);
+    ui->statusBar->addPermanentWidget(m_recorderLabel);
+    connect(ui->comboPlotQuality, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(plotQualityModeUpdate(int)));
+    connect(ui->spinPlotBudget, SIGNAL(valueChanged(double)),
+            this, SLOT(plotQualityBudgetUpdate(double)));
+    connect(&m_plotQuality, SIGNAL(qualityChanged(int)),
+            this, SLOT(plotQualityStatusUpdate()));
+    connect(&m_plotQuality, SIGNAL(replotTimeChanged(double)),
+            this, SLOT(plotQualityStatusUpdate()));
+    plotQualityStatusUpdate();
+
+    /* Before decimationUpdate(), the spectrum settings clear the spectrogram. */
+    plotCacheStatic(ui->plotSpectrum);
+    ui->plotSpectrum->addGraph();
+    ui->plotSpectrum->graph(0)->setPen(QPen(Qt::blue));
+    ui->plotSpectrum->xAxis->setLabel(tr("Frequency, Hz"));
+    ui->plotSpectrum->setVisible(false);
+    m_plotQuality.addPlot(ui->plotSpectrum);
+
+    m_spectrogram = new QCPColorMap(ui->plotSpectrogram->xAxis, ui->plotSpectrogram->yAxis);
+    ui->plotSpectrogram->addPlottable(m_spectrogram);
+    m_spectrogram->setGradient(QCPColorGradient::gpJet);
+    m_spectrogram->setInterpolate(false);
+    m_spectrogram->data()->clear();
+    ui->plotSpectrogram->xAxis->setLabel(tr("Frequency, Hz"));
+    ui->plotSpectrogram->yAxis->setLabel(tr("Time, s"));
+    ui->plotSpectrogram->setVisible(false);
+    m_plotQuality.addPlot(ui->plotSpectrogram);
+
+    ui->spinDecimationRatio->setMaximum(DECIMATOR_RATIO_MAX);
+    ui->spinDecimationRatio->setValue(DECIMATION_RATIO_DEFAULT);
+    ui->spinPlotBlockSize->setMaximum(PLOTTING_BUF_DEPTH_MAX);
+    ui->spinPlotBlockSize->setValue(PLOTTING_BUF_DEPTH_DEFAULT);
+    connect(ui->comboDecimationType, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(decimationUpdate()));
+    connect(ui->spinDecimationRatio, SIGNAL(valueChanged(int)),
+            this, SLOT(decimationUpdate()));
+    connect(ui->spinPlotBlockSize, SIGNAL(valueChanged(int)),
+            this, SLOT(decimationUpdate()));
+    decimationUpdate();
+
+    connect(ui->spinSampleRate, SIGNAL(valueChanged(double)),
+            this, SLOT(filterUpdate()));
+    foreach (QComboBox *combo, ui->tabFilters->findChildren<QComboBox *>()) {
+        connect(combo, SIGNAL(currentIndexChanged(int)),
+                this, SLOT(filterUpdate()));
+    }
+    foreach (QDoubleSpinBox *spin, ui->tabFilters->findChildren<QDoubleSpinBox *>()) {
+        connect(spin, SIGNAL(valueChanged(double)),
+                this, SLOT(filterUpdate()));
+    }
+    foreach (QCheckBox *check, ui->tabFilters->findChildren<QCheckBox *>()) {
+        connect(check, SIGNAL(toggled(bool)),
+                this, SLOT(filterUpdate()));
+    }
+    filterUpdate();
+
+    /* Spectrum thread is fed straight from the serial thread, the GUI only
+     * receives the finished spectra at the configured update rate.
+     */
+    connect(&m_serialThread, SIGNAL(streamDataReady(QVector<double>)),
+            &m_spectrumThread, SLOT(addSamples(QVector<double>)), Qt::DirectConnection);
+    connect(&m_spectrumThread, SIGNAL(spectrumReady(QVector<double>,QVector<double>)),
+            this, SLOT(processSpectrum(QVector<double>,QVector<double>)), Qt::QueuedConnection);
+    connect(ui->checkSpectrum, SIGNAL(toggled(bool)),
+            this, SLOT(spectrumEnable(bool)));
+    connect(ui->spinSampleRate, SIGNAL(valueChanged(double)),
+            this, SLOT(spectrumSettingsUpdate()));
+    connect(ui->comboFFTSize, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(spectrumSettingsUpdate()));
+    connect(ui->comboFFTWindow, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(spectrumSettingsUpdate()));
+    connect(ui->spinFFTOverlap, SIGNAL(valueChanged(int)),
+            this, SLOT(spectrumSettingsUpdate()));
+    connect(ui->comboFFTAveraging, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(spectrumSettingsUpdate()));
+    connect(ui->spinFFTAverages, SIGNAL(valueChanged(int)),
+            this, SLOT(spectrumSettingsUpdate()));
+    connect(ui->comboFFTScale, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(spectrumSettingsUpdate()));
+    connect(ui->spinSpectrumRate, SIGNAL(valueChanged(int)),
+            this, SLOT(spectrumSettingsUpdate()));
+    connect(ui->pushSpectrumReset, SIGNAL(pressed()),
+            this, SLOT(spectrumReset()));
+    connect(ui->checkSpectrogram, SIGNAL(toggled(bool)),
+            this, SLOT(spectrogramEnable(bool)));
+    spectrumSettingsUpdate();
+
+    for (int row = 0; row < ui->tableStatistics->rowCount(); row++) {
+        for (int column = 0; column < ui->tableStatistics->columnCount(); column++) {
+            QTableWidgetItem *item = new QTableWidgetItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            ui->tableStatistics->setItem(row, column, item);
+        }
+    }
+    connect(&m_serialThread, SIGNAL(statisticsReady(StreamStatistics,StreamStatistics)),
+            this, SLOT(processStatistics(StreamStatistics,StreamStatistics)), Qt::QueuedConnection);
+    connect(ui->spinStatsWindow, SIGNAL(valueChanged(int)),
+            this, SLOT(statisticsWindowUpdate(int)));
+    connect(ui->pushStatsReset, SIGNAL(pressed()),
+            this, SLOT(statisticsReset()));
+    statisticsWindowUpdate(ui->spinStatsWindow->value());
+
+    ui->plotTrigger->addGraph();
+    ui->plotTrigger->graph(0)->setPen(QPen(Qt::red));
+    ui->plotTrigger->xAxis->setLabel(tr("Samples from trigger"));
+    ui->plotTrigger->setVisible(false);
+    m_plotQuality.addPlot(ui->plotTrigger);
+    connect(&m_serialThread, SIGNAL(triggerCaptured(QVector<double>,int,bool)),
+            this, SLOT(processTriggerCapture(QVector<double>,int,bool)), Qt::QueuedConnection);
+    connect(ui->spinSampleRate, SIGNAL(valueChanged(double)),
+            this, SLOT(triggerSettingsUpdate()));
+    connect(ui->checkTrigger, SIGNAL(toggled(bool)),
+            this, SLOT(triggerSettingsUpdate()));
+    foreach (QComboBox *combo, ui->tabTrigger->findChildren<QComboBox *>()) {
+        connect(combo, SIGNAL(currentIndexChanged(int)),
+                this, SLOT(triggerSettingsUpdate()));
+    }
+    foreach (QDoubleSpinBox *spin, ui->tabTrigger->findChildren<QDoubleSpinBox *>()) {
+        connect(spin, SIGNAL(valueChanged(double)),
+                this, SLOT(triggerSettingsUpdate()));
+    }
+    foreach (QSpinBox *spin, ui->tabTrigger->findChildren<QSpinBox *>()) {
+        connect(spin, SIGNAL(valueChanged(int)),
+                this, SLOT(triggerSettingsUpdate()));
+    }
+    connect(ui->pushTriggerArm, SIGNAL(pressed()),
+            this, SLOT(triggerArm()));
+    triggerSettingsUpdate();
+
+    plotCacheStatic(ui->plotScan);
+    ui->plotScan->addGraph();
+    ui->plotScan->graph(0)->setPen(QPen(Qt::red));
+    ui->plotScan->addGraph();
+    ui->plotScan->graph(1)->setLineStyle(QCPGraph::lsNone);
+    ui->plotScan->graph(1)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, Qt::blue, 8));
+    ui->plotScan->xAxis->setLabel(tr("Samples from sweep start"));
+    ui->plotScan->setVisible(false);
+    m_plotQuality.addPlot(ui->plotScan);
+    connect(&m_serialThread, SIGNAL(scanSweepReady(QVector<double>,ScanFeatures)),
+            this, SLOT(processScanSweep(QVector<double>,ScanFeatures)), Qt::QueuedConnection);
+    connect(ui->checkScanAnalysis, SIGNAL(toggled(bool)),
+            this, SLOT(scanAnalysisEnable(bool)));
+    connect(ui->pushScanClear, SIGNAL(pressed()),
+            this, SLOT(scanClear()));
+    scanClear();
+
+    plotCacheStatic(ui->plotBode);
+    ui->plotBode->addGraph();
+    ui->plotBode->graph(0)->setPen(QPen(Qt::red));
+    ui->plotBode->graph(0)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, 5));
+    ui->plotBode->graph(0)->setName(tr("Gain"));
+    ui->plotBode->addGraph(ui->plotBode->xAxis, ui->plotBode->yAxis2);
+    ui->plotBode->graph(1)->setPen(QPen(Qt::blue));
+    ui->plotBode->graph(1)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle, 5));
+    ui->plotBode->graph(1)->setName(tr("Phase"));
+    ui->plotBode->xAxis->setScaleType(QCPAxis::stLogarithmic);
+    ui->plotBode->xAxis->setScaleLogBase(10);
+    ui->plotBode->xAxis->setLabel(tr("Frequency [Hz]"));
+    ui->plotBode->yAxis->setLabel(tr("Gain [dB]"));
+    ui->plotBode->yAxis2->setLabel(tr("Phase [deg]"));
+    ui->plotBode->yAxis2->setVisible(true);
+    ui->plotBode->legend->setVisible(true);
+    ui->plotBode->setVisible(false);
+    m_plotQuality.addPlot(ui->plotBode);
+    connect(&m_serialThread, SIGNAL(bodePointReady(BodePoint)),
+            this, SLOT(processBodePoint(BodePoint)), Qt::QueuedConnection);
+    connect(&m_serialThread, SIGNAL(bodeFinished()),
+            this, SLOT(bodeFinished()), Qt::QueuedConnection);
+    connect(ui->pushBodeStart, SIGNAL(pressed()),
+            this, SLOT(bodeStart()));
+    connect(ui->spinSampleRate, SIGNAL(valueChanged(double)),
+            this, SLOT(bodeLimitsUpdate()));
+    bodeLimitsUpdate();
+
+    /* Capture viewer, the maximum graph fills down to the minimum graph. */
+    ui->plotCapture->addGraph();
+    ui->plotCapture->graph(0)->setPen(QPen(Qt::blue));
+    ui->plotCapture->graph(0)->setBrush(QBrush(QColor(0, 0, 255, 64)));
+    ui->plotCapture->addGraph();
+    ui->plotCapture->graph(1)->setPen(QPen(Qt::blue));
+    ui->plotCapture->graph(0)->setChannelFillGraph(ui->plotCapture->graph(1));
+    ui->plotCapture->xAxis->setLabel(tr("Sample"));
+    ui->plotCapture->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    ui->plotCapture->axisRect()->setRangeDrag(Qt::Horizontal);
+    ui->plotCapture->axisRect()->setRangeZoom(Qt::Horizontal);
+    ui->plotCapture->setVisible(false);
+    connect(ui->plotCapture->xAxis, SIGNAL(rangeChanged(QCPRange)),
+            this, SLOT(captureRangeChanged(QCPRange)));
+    connect(ui->pushCaptureOpen, SIGNAL(pressed()),
+            this, SLOT(captureOpen()));
+    connect(ui->pushCaptureClose, SIGNAL(pressed()),
+            this, SLOT(captureClose()));
+    connect(ui->comboCaptureChannel, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(captureChannelUpdate(int)));
+    connect(ui->pushCaptureExport, SIGNAL(pressed()),
+            this, SLOT(captureExport()));
+    connect(ui->comboCaptureEvent, SIGNAL(activated(int)),
+            this, SLOT(captureEventSelect(int)));
+    connect(ui->pushCaptureEventPrev, SIGNAL(pressed()),
+            this, SLOT(captureEventPrev()));
+    connect(ui->pushCaptureEventNext, SIGNAL(pressed()),
+            this, SLOT(captureEventNext()));
+    connect(ui->pushCaptureNote, SIGNAL(pressed()),
+            this, SLOT(captureNote()));
+    connect(ui->lineCaptureNote, SIGNAL(returnPressed()),
+            this, SLOT(captureNote()));
+
+    connect(ui->pushExportSource, SIGNAL(pressed()),
+            this, SLOT(exportSource()));
+    connect(ui->pushExportStart, SIGNAL(pressed()),
+            this, SLOT(exportStart()));
+    connect(ui->pushExportCancel, SIGNAL(pressed()),
+            this, SLOT(exportCancel()));
+    connect(&m_exporter, SIGNAL(exportStarted(int)),
+            this, SLOT(exportStarted(int)), Qt::QueuedConnection);
+    connect(&m_exporter, SIGNAL(exportProgress(int,int)),
+            this, SLOT(processExportProgress(int,int)), Qt::QueuedConnection);
+    connect(&m_exporter, SIGNAL(exportFinished(int,bool,QString)),
+            this, SLOT(exportFinished(int,bool,QString)), Qt::QueuedConnection);
+
+    /* Capture comparison, golden in blue, suspect in red and their
+     * difference in green on the right axis. Each is a maximum graph
+     * filling down to a minimum graph. */
+    const QColor compareColors[3] = {Qt::blue, Qt::red, QColor(0, 160, 0)};
+    const QString compareNames[3] = {tr("Golden"), tr("Suspect"), tr("Difference")};
+    for (int i = 0; i < 3; i++) {
+        QCPAxis *valueAxis = (i == 2) ? ui->plotCompare->yAxis2 : ui->plotCompare->yAxis;
+        QCPGraph *max = ui->plotCompare->addGraph(ui->plotCompare->xAxis, valueAxis);
+        QCPGraph *min = ui->plotCompare->addGraph(ui->plotCompare->xAxis, valueAxis);
+        QColor fill = compareColors[i];
+        fill.setAlpha(64);
+        max->setPen(QPen(compareColors[i]));
+        max->setBrush(QBrush(fill));
+        max->setName(compareNames[i]);
+        max->setChannelFillGraph(min);
+        min->setPen(QPen(compareColors[i]));
+        min->removeFromLegend();
+    }
+    ui->plotCompare->xAxis->setLabel(tr("Golden sample"));
+    ui->plotCompare->yAxis2->setLabel(tr("Suspect - golden"));
+    ui->plotCompare->yAxis2->setVisible(true);
+    ui->plotCompare->legend->setVisible(true);
+    ui->plotCompare->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    ui->plotCompare->axisRect()->setRangeDrag(Qt::Horizontal);
+    ui->plotCompare->axisRect()->setRangeZoom(Qt::Horizontal);
+    ui->plotCompare->setVisible(false);
+    connect(ui->plotCompare->xAxis, SIGNAL(rangeChanged(QCPRange)),
+            this, SLOT(compareRangeChanged(QCPRange)));
+    connect(ui->pushCompareGolden, SIGNAL(pressed()),
+            this, SLOT(compareGolden()));
+    connect(ui->pushCompareSuspect, SIGNAL(pressed()),
+            this, SLOT(compareSuspect()));
+    connect(ui->pushCompareStart, SIGNAL(pressed()),
+            this, SLOT(compareStart()));
+    connect(ui->pushCompareCancel, SIGNAL(pressed()),
+            this, SLOT(compareCancel()));
+    connect(ui->tableCompare, SIGNAL(cellClicked(int,int)),
+            this, SLOT(compareSegmentSelect(int,int)));
+    connect(&m_compare, SIGNAL(compareProgress(int)),
+            this, SLOT(processCompareProgress(int)), Qt::QueuedConnection);
+    connect(&m_compare, SIGNAL(compareFinished(bool,QString)),
+            this, SLOT(compareFinished(bool,QString)), Qt::QueuedConnection);
+
     m_msg.msg_id    = TELEMETRY_MSG_NOMSG;
     m_msg.signature = TELEMETRY_MSG_SIGNATURE;
     m_msg.data_size = 0;
@@ -149,6 +560,12 @@ void MainWindow::serialPortConnect()
         ui->statusBar->showMessage(tr("Disconnected from: %1").arg(m_serialPortList->currentText()));
         ui->actionStream->setEnabled(false);
         ui->actionScan->setEnabled(false);
+        if (m_bodeRunning) {
+            bodeSetRunning(false);
+            ui->labelBodeStatus->setText(tr("Aborted, not connected"));
+        }
+        m_bundleTimeout.stop();
+        m_bundlePending = false;
         m_serialConnected = false;
     } else {
         m_serialThread.connect(m_serialPortList->currentData().toString());
@@ -173,6 +590,7 @@ void MainWindow::streamingGO()
 
     if (m_serialTimer.isActive()) {
         m_serialTimer.stop();
+        m_recorder.addEvent(CAPTURE_EVENT_STREAM_STOP, 0, 0, 0);
         ui->actionStream->setText(tr("Stream"));
         ui->actionScan->setEnabled(true);
     } else {
@@ -199,6 +617,7 @@ void MainWindow::scaningGO()
 
     if (m_serialTimer.isActive()) {
         m_serialTimer.stop();
+        m_recorder.addEvent(CAPTURE_EVENT_STREAM_STOP, 0, 0, 0);
         ui->actionScan->setText(tr("Scan"));
         ui->actionStream->setEnabled(true);
     } else {
@@ -214,6 +633,242 @@ void MainWindow::scaningGO()
     }
 }
 
+/**
+ * @brief MainWindow::recordingGO
+ * Starts recording every received message or only the stream samples
+ * to a file, or stops it.
+ */
+void MainWindow::recordingGO()
+{
+    if (m_recorder.isRecording()) {
+        m_recorder.stopRecording();
+        ui->actionRecord->setText(tr("Record"));
+        return;
+    }
+
+    const QString captureFilter = tr("Sample captures (*.smdcap)");
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Record telemetry"),
+        QDateTime::currentDateTime().toString("'recording-'yyyyMMdd-hhmmss'.smdrec'"),
+        tr("Recordings (*.smdrec);;%1;;All files (*)").arg(captureFilter), &selectedFilter);
+    if (fileName.isEmpty()) {
+        return;
+    }
+    /* Long sessions are kept as compressed stream samples only. */
+    if ((selectedFilter == captureFilter) || fileName.endsWith(".smdcap", Qt::CaseInsensitive)) {
+        m_recorder.startRecording(fileName, RecorderThread::FormatCapture);
+    } else {
+        m_recorder.startRecording(fileName, RecorderThread::FormatRecording);
+    }
+    ui->actionRecord->setText(tr("STOP REC"));
+    m_recorderLabel->setText(tr("Rec: %1").arg(QFileInfo(fileName).fileName()));
+}
+
+/**
+ * @brief MainWindow::recorderError
+ * @param s - error string.
+ */
+void MainWindow::recorderError(const QString &s)
+{
+    ui->actionRecord->setText(tr("Record"));
+    m_recorderLabel->setText(tr("Rec: failed"));
+    QMessageBox::warning(this, tr("Recording failed!"), s);
+}
+
+/**
+ * @brief MainWindow::recorderStatus
+ * @param bytes - size of the recording.
+ * @param frames - recorded messages.
+ * @param dropped - messages lost because the writer fell behind.
+ */
+void MainWindow::recorderStatus(qint64 bytes, qint64 frames, qint64 dropped)
+{
+    m_recorderLabel->setText(tr("Rec: %1 MB, %2 frames, %3 dropped")
+        .arg(bytes / (1024.0 * 1024.0), 0, 'f', 1).arg(frames).arg(dropped));
+}
+
+/**
+ * @brief MainWindow::saveIncident
+ * Saves the last minutes of the black box as a recording.
+ */
+void MainWindow::saveIncident()
+{
+    /* Taken before the dialog, the ring moves on while it is open. */
+    const QByteArray data = m_blackBox.incident((qint64)BLACKBOX_INCIDENT_MINUTES * 60 * 1000000000LL);
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save incident"),
+        QDateTime::currentDateTime().toString("'incident-'yyyyMMdd-hhmmss'.smdrec'"),
+        tr("Recordings (*.smdrec);;All files (*)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || (file.write(data) != data.size())) {
+        QMessageBox::warning(this, tr("Saving incident failed!"),
+            tr("Can't write %1. %2.").arg(fileName).arg(file.errorString()));
+        return;
+    }
+    ui->statusBar->showMessage(tr("Incident saved to %1").arg(QDir::toNativeSeparators(fileName)));
+}
+
+/**
+ * @brief MainWindow::saveBundle
+ * Reads the device settings, bundleFinish() takes over once all replies
+ * arrived or after BUNDLE_SETTINGS_TIMEOUT_MS and bundleSave() writes the
+ * bundle BUNDLE_POST_SECONDS later.
+ */
+void MainWindow::saveBundle()
+{
+    if (!m_serialConnected) {
+        QMessageBox::information(this, tr("No connection!"), tr("Connect to the serial port first!"));
+        return;
+    }
+    if (m_bundlePending || m_bundlePost.isActive()) {
+        return;
+    }
+
+    memset((void *)&m_bundle, 0, sizeof(m_bundle));
+    m_bundle.snapshot_time = QDateTime::currentMSecsSinceEpoch();
+    m_bundle.stream_channel = streamingChannelID();
+    m_bundle.multi_mask = m_multiMask;
+    /* The PID tab is never sent to the board, its values are kept as GUI state. */
+    m_bundle.gui_pid[0].p = ui->spinPidZP->value();
+    m_bundle.gui_pid[0].i = ui->spinPidZI->value();
+    m_bundle.gui_pid[0].d = ui->spinPidZD->value();
+    m_bundle.gui_pid[0].setpoint = ui->spinPidZSetpoint->value();
+    m_bundle.gui_pid[0].enabled = ui->groupPidZ->isChecked();
+    m_bundle.gui_pid[0].reverse = ui->checkPidZReverse->isChecked();
+    m_bundle.gui_pid[1].p = ui->spinPidFOCP->value();
+    m_bundle.gui_pid[1].i = ui->spinPidFOCI->value();
+    m_bundle.gui_pid[1].d = ui->spinPidFOCD->value();
+    m_bundle.gui_pid[1].setpoint = ui->spinPidFOCSetpoint->value();
+    m_bundle.gui_pid[1].enabled = ui->groupPidFOC->isChecked();
+    m_bundle.gui_pid[1].reverse = ui->checkPidFOCReverse->isChecked();
+
+    m_bundlePending = true;
+    m_bundleReadTimer.start();
+    m_bundleTimeout.start(BUNDLE_SETTINGS_TIMEOUT_MS);
+    boardReadSettings();
+    ui->statusBar->showMessage(tr("Reading device settings..."));
+}
+
+/**
+ * @brief MainWindow::bundleStoreReply
+ * @param msg - reply to a settings request of boardReadSettings().
+ */
+void MainWindow::bundleStoreReply(const TelemetryMessage &msg)
+{
+    switch (msg.msg_id) {
+    case 'a':
+    case 'b':
+    case 'c':
+        if (msg.data_size == sizeof(quint16)) {
+            m_bundle.actuator[msg.msg_id - 'a'] = ((quint16*)msg.data)[0];
+            m_bundle.received |= BUNDLE_HAVE_FOC << (msg.msg_id - 'a');
+        }
+        break;
+    case 'o':
+        if (msg.data_size == sizeof(PWMOutputStruct)) {
+            m_bundle.motor_power = msg.data[0];
+            m_bundle.motor_flags = msg.data[1];
+            m_bundle.received |= BUNDLE_HAVE_MOTOR;
+        }
+        break;
+    case 'p':
+        if (msg.data_size == sizeof(quint32)) {
+            m_bundle.motor_speed = ((quint32*)msg.data)[0];
+            m_bundle.received |= BUNDLE_HAVE_SPEED;
+        }
+        break;
+    }
+    m_bundle.read_ms = m_bundleReadTimer.elapsed();
+}
+
+/**
+ * @brief MainWindow::bundleFinish
+ * Completes the settings read by saveBundle() with the link statistics,
+ * bundleSave() follows once the stream after the snapshot is recorded.
+ */
+void MainWindow::bundleFinish()
+{
+    if (!m_bundlePending) {
+        return;
+    }
+    m_bundleTimeout.stop();
+    m_bundlePending = false;
+    m_bundle.link = m_serialThread.linkStatistics();
+    m_bundlePost.start(BUNDLE_POST_SECONDS * 1000);
+    ui->statusBar->showMessage(tr("Recording %1 s after the snapshot...").arg(BUNDLE_POST_SECONDS));
+}
+
+/**
+ * @brief MainWindow::bundleSave
+ * Saves the snapshot with the black box from BUNDLE_STREAM_SECONDS before
+ * the snapshot up to now.
+ */
+void MainWindow::bundleSave()
+{
+    /* Taken before the dialog, the ring moves on while it is open. */
+    const qint64 windowMs = BUNDLE_STREAM_SECONDS * 1000LL + m_bundleReadTimer.elapsed();
+    const QByteArray data = m_blackBox.incident(windowMs * 1000000LL);
+    const BundleSnapshot snapshot = m_bundle;
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save bundle"),
+        QDateTime::fromMSecsSinceEpoch(snapshot.snapshot_time).toString("'bundle-'yyyyMMdd-hhmmss'" BUNDLE_SUFFIX "'"),
+        tr("Bundles (*%1);;All files (*)").arg(BUNDLE_SUFFIX));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    QString error;
+    if (!bundleWrite(fileName, snapshot, data, error)) {
+        QMessageBox::warning(this, tr("Saving bundle failed!"),
+            tr("Can't write %1. %2.").arg(fileName).arg(error));
+        return;
+    }
+    ui->statusBar->showMessage(tr("Bundle saved to %1").arg(QDir::toNativeSeparators(fileName)));
+}
+
+/**
+ * @brief MainWindow::bundleText
+ * @param snapshot - settings of a bundle.
+ * @return the settings for the Replay tab.
+ */
+QString MainWindow::bundleText(const BundleSnapshot &snapshot) const
+{
+    static const char *pidNames[2] = { "Z", "FOC" };
+    const QString missing = tr("n/a");
+    QString s;
+
+    s = tr("Bundle of %1, settings read in %2 ms.\n")
+        .arg(QDateTime::fromMSecsSinceEpoch(snapshot.snapshot_time).toString("yyyy-MM-dd hh:mm:ss"))
+        .arg(snapshot.read_ms);
+    s += tr("Actuators: FOC %1, RAD %2, FBK %3.\n")
+        .arg((snapshot.received & BUNDLE_HAVE_FOC) ? QString::number(snapshot.actuator[0]) : missing)
+        .arg((snapshot.received & BUNDLE_HAVE_RAD) ? QString::number(snapshot.actuator[1]) : missing)
+        .arg((snapshot.received & BUNDLE_HAVE_FBK) ? QString::number(snapshot.actuator[2]) : missing);
+    s += tr("Motor: power %1%2, speed %3.\n")
+        .arg((snapshot.received & BUNDLE_HAVE_MOTOR) ? QString::number(snapshot.motor_power) : missing)
+        .arg((snapshot.motor_flags & PWM_OUT_FLAG_REVERSE) ? tr(" reverse") : QString())
+        .arg((snapshot.received & BUNDLE_HAVE_SPEED) ? QString::number(snapshot.motor_speed / 64) : missing);
+    s += tr("Streaming channel: %1, multi-channel mask 0x%2.\n")
+        .arg((snapshot.stream_channel < STREAMING_CHANNEL_COUNT) ?
+             streamingChannelNames[snapshot.stream_channel] : "?")
+        .arg(snapshot.multi_mask, 2, 16, QChar('0'));
+    for (int i = 0; i < 2; i++) {
+        const BundlePid &pid = snapshot.gui_pid[i];
+        s += tr("%1 PID tab (GUI values, not read from the board): P %2, I %3, D %4, set-point %5%6%7.\n").arg(pidNames[i])
+            .arg(pid.p).arg(pid.i).arg(pid.d).arg(pid.setpoint)
+            .arg(pid.enabled ? QString() : tr(", disabled"))
+            .arg(pid.reverse ? tr(", reverse") : QString());
+    }
+    s += tr("Link: %1 bytes received, %2 sent, %3 messages, %4 corrupt headers, %5 incomplete, "
+            "connected for %6 s.")
+        .arg(snapshot.link.bytes_received).arg(snapshot.link.bytes_sent).arg(snapshot.link.messages)
+        .arg(snapshot.link.corrupt_headers).arg(snapshot.link.incomplete)
+        .arg(snapshot.link.connected_ms / 1000.0, 0, 'f', 1);
+    return s;
+}
+
 /**
  * @brief MainWindow::serialPortError
  * @param s - error string;
@@ -230,9 +885,19 @@ void MainWindow::serialPortError(const QString &s)
         m_serialPortList->setEnabled(true);
         ui->actionStream->setEnabled(false);
         ui->actionScan->setEnabled(false);
+        if (m_bodeRunning) {
+            bodeSetRunning(false);
+            ui->labelBodeStatus->setText(tr("Aborted, not connected"));
+        }
+        m_bundleTimeout.stop();
+        m_bundlePending = false;
         m_serialConnected = false;
         ui->statusBar->showMessage(s);
     }
+    if (m_replaying) {
+        replaySetActive(false);
+        ui->labelReplayPosition->setText(s);
+    }
 }
 
 /**
@@ -251,6 +916,12 @@ void MainWindow::serialPortTimeout(const QString &s)
         m_serialPortList->setEnabled(true);
         ui->actionStream->setEnabled(false);
         ui->actionScan->setEnabled(false);
+        if (m_bodeRunning) {
+            bodeSetRunning(false);
+            ui->labelBodeStatus->setText(tr("Aborted, not connected"));
+        }
+        m_bundleTimeout.stop();
+        m_bundlePending = false;
         m_serialConnected = false;
         ui->statusBar->showMessage(s);
     }
@@ -282,6 +953,10 @@ void MainWindow::processTelemetryMessage(const TelemetryMessage &msg)
     quint32 utmp32;
     static quint32 newPeriodCnt = 0;
 
+    if (m_bundlePending) {
+        bundleStoreReply(msg);
+    }
+
     switch (msg.msg_id) {
     /*
      * T R A N S M I T T E R   S E C T I O N
@@ -344,6 +1019,10 @@ void MainWindow::processTelemetryMessage(const TelemetryMessage &msg)
     default:
         qDebug() << "Unhandled message received!";
     }
+
+    if (m_bundlePending && (m_bundle.received == BUNDLE_HAVE_ALL)) {
+        bundleFinish();
+    }
 }
 
 #define SAMPLES_PER_PLOT    2048
@@ -359,17 +1038,24 @@ void MainWindow::processStreamData(QVector<double> y)
     static qint64 sampleCntFastS = 1;
     static quint8 updateCntS = 1;
 
-    QVector<double> x(PLOTTING_BUF_DEPTH);
+    const int numPts = y.size();
     double accumY = 0.0;
 
-    for (int i = 0; i < PLOTTING_BUF_DEPTH; i++) {
-        x[i] = sampleCntFastS++;
+    m_serialThread.streamDataDone();
+
+    if (numPts == 0) {
+        return;
+    }
+
+    for (int i = 0; i < numPts; i++) {
         accumY += y[i];
     }
 
-    accumY /= PLOTTING_BUF_DEPTH;
+    accumY /= numPts;
     ui->plotSlow->graph(0)->addData(sampleCntSlowS++, accumY);
-    ui->plotFast->graph(0)->addData(x, y);
+    /* Append the whole block with equidistant keys, no key vector needed. */
+    ui->plotFast->graph(0)->addData(sampleCntFastS, 1.0, y.constData(), numPts);
+    sampleCntFastS += numPts;
 
     if (sampleCntSlowS > SAMPLES_PER_PLOT) {
         ui->plotSlow->graph(0)->removeDataBefore(sampleCntSlowS - SAMPLES_PER_PLOT);
@@ -392,12 +1078,245 @@ void MainWindow::processStreamData(QVector<double> y)
     }
 }
 
+/**
+ * @brief MainWindow::plotQualityModeUpdate
+ * @param index - index of the selected plot quality mode.
+ */
+void MainWindow::plotQualityModeUpdate(int index)
+{
+    m_plotQuality.setMode((PlotQualityManager::Mode)index);
+    plotQualityStatusUpdate();
+}
+
+/**
+ * @brief MainWindow::plotQualityBudgetUpdate
+ * @param ms - new replot time budget.
+ */
+void MainWindow::plotQualityBudgetUpdate(double ms)
+{
+    m_plotQuality.setBudget(ms);
+}
+
+/**
+ * @brief MainWindow::decimationUpdate
+ * Passes the decimation settings of the Streaming tab to the serial thread.
+ */
+void MainWindow::decimationUpdate()
+{
+    m_serialThread.setDecimation((Decimator::Type)ui->comboDecimationType->currentIndex(),
+                                 ui->spinDecimationRatio->value(),
+                                 ui->spinPlotBlockSize->value());
+    /* Spectrum sample rate follows the decimation ratio. */
+    spectrumSettingsUpdate();
+}
+
+/**
+ * @brief MainWindow::filterUpdate
+ * Passes the filter sections of the Filters tab to the serial thread.
+ * Sections are designed for the undecimated stream rate.
+ */
+void MainWindow::filterUpdate()
+{
+    QComboBox *types[BIQUAD_SECTIONS_MAX] = {
+        ui->comboFilterType1, ui->comboFilterType2, ui->comboFilterType3, ui->comboFilterType4
+    };
+    QDoubleSpinBox *freqs[BIQUAD_SECTIONS_MAX] = {
+        ui->spinFilterFreq1, ui->spinFilterFreq2, ui->spinFilterFreq3, ui->spinFilterFreq4
+    };
+    QDoubleSpinBox *qs[BIQUAD_SECTIONS_MAX] = {
+        ui->spinFilterQ1, ui->spinFilterQ2, ui->spinFilterQ3, ui->spinFilterQ4
+    };
+    QCheckBox *bypass[STREAMING_CHANNEL_COUNT] = {
+        ui->checkFilterBypassFE, ui->checkFilterBypassCE, ui->checkFilterBypassSUM,
+        ui->checkFilterBypassA, ui->checkFilterBypassB, ui->checkFilterBypassC,
+        ui->checkFilterBypassD
+    };
+    QVector<BiquadChain::Section> sections;
+    quint8 bypassMask = 0;
+
+    for (int i = 0; i < BIQUAD_SECTIONS_MAX; i++) {
+        /* Index 0 is "Off", the rest follow BiquadChain::Type. */
+        int index = types[i]->currentIndex();
+        if (index > 0) {
+            BiquadChain::Section section;
+            section.type = (BiquadChain::Type)(index - 1);
+            section.freq = freqs[i]->value();
+            section.q = qs[i]->value();
+            sections.append(section);
+        }
+        freqs[i]->setEnabled(index > 0);
+        qs[i]->setEnabled(index > 0);
+    }
+    for (int i = 0; i < STREAMING_CHANNEL_COUNT; i++) {
+        if (bypass[i]->isChecked()) {
+            bypassMask |= 1 << i;
+        }
+    }
+
+    m_serialThread.setFilter(sections, ui->spinSampleRate->value(), bypassMask);
+}
+
+/**
+ * @brief MainWindow::spectrumEnable
+ * @param enable - show the spectrum plot and run the analysis thread.
+ */
+void MainWindow::spectrumEnable(bool enable)
+{
+    if (enable) {
+        m_spectrumThread.startAnalysis();
+    } else {
+        m_spectrumThread.stopAnalysis();
+        ui->plotSpectrum->graph(0)->clearData();
+    }
+    ui->plotSpectrum->setVisible(enable);
+    ui->plotSpectrogram->setVisible(enable && ui->checkSpectrogram->isChecked());
+}
+
+/**
+ * @brief MainWindow::spectrumSettingsUpdate
+ * Passes the settings of the Spectrum tab to the spectrum thread.
+ */
+void MainWindow::spectrumSettingsUpdate()
+{
+    SpectrumThread::Settings settings;
+
+    settings.fftSize = ui->comboFFTSize->currentText().toInt();
+    settings.window = (SpectrumThread::Window)ui->comboFFTWindow->currentIndex();
+    settings.overlap = ui->spinFFTOverlap->value();
+    settings.averaging = (SpectrumThread::Averaging)ui->comboFFTAveraging->currentIndex();
+    settings.averages = ui->spinFFTAverages->value();
+    settings.scale = (SpectrumThread::Scale)ui->comboFFTScale->currentIndex();
+    settings.sampleRate = ui->spinSampleRate->value() / ui->spinDecimationRatio->value();
+    settings.updateMs = 1000 / ui->spinSpectrumRate->value();
+    m_spectrumThread.setSettings(settings);
+
+    ui->spinFFTAverages->setEnabled(settings.averaging == SpectrumThread::AveragingLinear ||
+                                    settings.averaging == SpectrumThread::AveragingExponential);
+    ui->plotSpectrum->yAxis->setLabel((settings.scale == SpectrumThread::ScaleDb) ?
+                                      tr("Amplitude, dB") : tr("Amplitude"));
+    /* A new label is not seen by the layer caches. */
+    ui->plotSpectrum->invalidateLayerCaches();
+    ui->plotSpectrum->xAxis->setRange(0.0, settings.sampleRate / 2.0);
+    /* The value axis is fitted anew to the first spectrum. */
+    ui->plotSpectrum->graph(0)->clearData();
+
+    /* Rows of the old settings do not fit the new ones, start over. */
+    m_spectrogram->data()->clear();
+}
+
+/**
+ * @brief MainWindow::spectrumReset
+ */
+void MainWindow::spectrumReset()
+{
+    m_spectrumThread.resetAveraging();
+    ui->plotSpectrum->graph(0)->clearData();
+    m_spectrogram->data()->clear();
+}
+
+/**
+ * @brief MainWindow::spectrogramEnable
+ * @param enable - show the spectrogram below the spectrum.
+ */
+void MainWindow::spectrogramEnable(bool enable)
+{
+    if (!enable) {
+        m_spectrogram->data()->clear();
+    }
+    ui->plotSpectrogram->setVisible(enable && ui->checkSpectrum->isChecked());
+}
+
+/**
+ * @brief MainWindow::processSpectrum
+ * @param freq - bin frequencies.
+ * @param mag - bin magnitudes in the selected scale.
+ */
+void MainWindow::processSpectrum(QVector<double> freq, QVector<double> mag)
+{
+    if (!ui->plotSpectrum->isVisible() || mag.isEmpty()) {
+        return;
+    }
+
+    const bool first = ui->plotSpectrum->graph(0)->data()->isEmpty();
+    ui->plotSpectrum->graph(0)->setData(freq, mag);
+    plotGrowValueAxis(ui->plotSpectrum->graph(0), first);
+    ui->plotSpectrum->replot();
+
+    if (ui->plotSpectrogram->isVisible()) {
+        spectrogramAddRow(freq, mag);
+    }
+}
+
+#define SPECTROGRAM_ROWS            256
+#define SPECTROGRAM_COLUMNS_MAX     1024
+
+/**
+ * @brief MainWindow::spectrogramAddRow
+ * @param freq - bin frequencies.
+ * @param mag - bin magnitudes, become the newest spectrogram row.
+ *
+ * Rows are pushed with QCPColorMapData::addValueRow, so a replot only
+ * colorizes the new row instead of the whole map.
+ */
+void MainWindow::spectrogramAddRow(const QVector<double> &freq, const QVector<double> &mag)
+{
+    QCPColorMapData *data = m_spectrogram->data();
+    const int bins = mag.size();
+    const int columns = qMin(bins, SPECTROGRAM_COLUMNS_MAX);
+
+    /* Keep the peaks when several bins fall into one column. */
+    m_spectrogramRow.resize(columns);
+    double rowMin = mag[0];
+    double rowMax = mag[0];
+    for (int c = 0; c < columns; c++) {
+        int first = (int)((qint64)c * bins / columns);
+        int last = (int)((qint64)(c + 1) * bins / columns);
+        double peak = mag[first];
+        for (int k = first + 1; k < last; k++) {
+            peak = qMax(peak, mag[k]);
+        }
+        m_spectrogramRow[c] = peak;
+        rowMin = qMin(rowMin, peak);
+        rowMax = qMax(rowMax, peak);
+    }
+
+    if (data->keySize() != columns) {
+        double rowTime = 1.0 / ui->spinSpectrumRate->value();
+        data->setSize(columns, SPECTROGRAM_ROWS);
+        data->setRange(QCPRange(freq.first(), freq.last()),
+                       QCPRange(-(SPECTROGRAM_ROWS - 1) * rowTime, 0.0));
+        data->fill(rowMin);
+        m_spectrogram->setDataRange(QCPRange(rowMin, rowMax));
+        ui->plotSpectrogram->rescaleAxes();
+    }
+
+    data->addValueRow(m_spectrogramRow.constData());
+
+    /* Changing the color range recolors the whole map, so only ever widen it. */
+    QCPRange range = m_spectrogram->dataRange();
+    if ((rowMin < range.lower) || (rowMax > range.upper)) {
+        m_spectrogram->rescaleDataRange();
+    }
+
+    ui->plotSpectrogram->replot();
+}
+
+/**
+ * @brief MainWindow::plotQualityStatusUpdate
+ */
+void MainWindow::plotQualityStatusUpdate()
+{
+    m_plotQualityLabel->setText(tr("Plot: %1 (%2 ms)")
+        .arg(PlotQualityManager::qualityName(m_plotQuality.quality()))
+        .arg(m_plotQuality.replotTime(), 0, 'f', 1));
+}
+
 /**
  * @brief MainWindow::processTimeout
  */
 void MainWindow::processTimeout()
 {
-    m_msg.msg_id    = 's';
+    m_msg.msg_id    = m_multiMask ? 'm' : 's';
     m_msg.signature = TELEMETRY_MSG_SIGNATURE;
     m_msg.data_size = 0;
 
@@ -524,14 +1443,27 @@ void MainWindow::motorSetSettings()
     }
 }
 
-/* Available streaming channels. */
-#define STREAMING_CHANNEL_FE    0x00
-#define STREAMING_CHANNEL_CE    0x01
-#define STREAMING_CHANNEL_SUM   0x02
-#define STREAMING_CHANNEL_A     0x03
-#define STREAMING_CHANNEL_B     0x04
-#define STREAMING_CHANNEL_C     0x05
-#define STREAMING_CHANNEL_D     0x06
+/**
+ * @brief MainWindow::streamingChannelID
+ * @return STREAMING_CHANNEL_* of the checked channel radio button.
+ */
+quint8 MainWindow::streamingChannelID() const
+{
+    if (ui->radioCE->isChecked()) {
+        return STREAMING_CHANNEL_CE;
+    } else if (ui->radioSum->isChecked()) {
+        return STREAMING_CHANNEL_SUM;
+    } else if (ui->radioChnA->isChecked()) {
+        return STREAMING_CHANNEL_A;
+    } else if (ui->radioChnB->isChecked()) {
+        return STREAMING_CHANNEL_B;
+    } else if (ui->radioChnC->isChecked()) {
+        return STREAMING_CHANNEL_C;
+    } else if (ui->radioChnD->isChecked()) {
+        return STREAMING_CHANNEL_D;
+    }
+    return STREAMING_CHANNEL_FE;
+}
 
 /**
  * @brief MainWindow::streamingUpdateChannelID
@@ -545,23 +1477,9 @@ void MainWindow::streamingUpdateChannelID(bool checked)
     m_msg.msg_id    = 'S';
     m_msg.signature = TELEMETRY_MSG_SIGNATURE;
     m_msg.data_size = sizeof(quint8);
+    m_msg.data[0]   = streamingChannelID();
 
-    if (ui->radioCE->isChecked()) {
-        m_msg.data[0] = STREAMING_CHANNEL_CE;
-    } else if (ui->radioSum->isChecked()) {
-        m_msg.data[0] = STREAMING_CHANNEL_SUM;
-    } else if (ui->radioChnA->isChecked()) {
-        m_msg.data[0] = STREAMING_CHANNEL_A;
-    } else if (ui->radioChnB->isChecked()) {
-        m_msg.data[0] = STREAMING_CHANNEL_B;
-    } else if (ui->radioChnC->isChecked()) {
-        m_msg.data[0] = STREAMING_CHANNEL_C;
-    }  else if (ui->radioChnD->isChecked()) {
-        m_msg.data[0] = STREAMING_CHANNEL_D;
-    } else {
-        m_msg.data[0] = STREAMING_CHANNEL_FE;
-    }
-
+    m_serialThread.setStreamChannel(m_msg.data[0]);
     sendTelemetryMessage(m_msg);
 }
 
@@ -576,27 +1494,1264 @@ void MainWindow::boardReboot()
     sendTelemetryMessage(m_msg);
 }
 
+/**
+ * @brief MainWindow::boardReadSettings
+ * Requests the settings in a single write, the serial thread sends them
+ * in one go and the replies arrive together.
+ */
 void MainWindow::boardReadSettings()
 {
-    /* Reads FOC actuator position. */
-    m_msg.msg_id    = 'a';
+    /* FOC, RAD and FBK actuator positions, motor settings and speed. */
+    static const char requests[] = { 'a', 'b', 'c', 'o', 'p' };
+    QByteArray data;
+
     m_msg.signature = TELEMETRY_MSG_SIGNATURE;
     m_msg.data_size = 0;
-    sendTelemetryMessage(m_msg);
+    for (int i = 0; i < (int)sizeof(requests); i++) {
+        m_msg.msg_id = requests[i];
+        data.append((const char *)&m_msg, TELEMETRY_MSG_HDR_SIZE);
+    }
+    if (m_serialConnected) {
+        m_serialThread.write(data);
+    } else {
+        QMessageBox::information(this, tr("No connection!"), tr("Connect to the serial port first!"));
+    }
+}
 
-    /* Reads RAD actuator position. */
-    m_msg.msg_id    = 'b';
-    sendTelemetryMessage(m_msg);
+/**
+ * @brief MainWindow::statisticsWindowUpdate
+ * @param samples - sliding window length in stream samples.
+ */
+void MainWindow::statisticsWindowUpdate(int samples)
+{
+    m_serialThread.setStatisticsWindow(samples);
+}
 
-    /* Reads FBK actuator position. */
-    m_msg.msg_id    = 'c';
-    sendTelemetryMessage(m_msg);
+/**
+ * @brief MainWindow::statisticsReset
+ */
+void MainWindow::statisticsReset()
+{
+    m_serialThread.resetStatistics();
+}
 
-    /* Reads Motor speed. */
-    m_msg.msg_id    = 'o';
-    sendTelemetryMessage(m_msg);
+/**
+ * @brief MainWindow::processStatistics
+ * @param session - statistics since the stream (or the channel) was started.
+ * @param window - statistics of the sliding window.
+ */
+void MainWindow::processStatistics(const StreamStatistics &session, const StreamStatistics &window)
+{
+    statisticsFillColumn(0, window);
+    statisticsFillColumn(1, session);
+}
 
-    /* Reads Motor PWM settings. */
-    m_msg.msg_id    = 'p';
-    sendTelemetryMessage(m_msg);
+/**
+ * @brief MainWindow::statisticsFillColumn
+ * @param column - column of the statistics table.
+ * @param stats - values to show, rows as laid out in the form.
+ */
+void MainWindow::statisticsFillColumn(int column, const StreamStatistics &stats)
+{
+    double values[6 + STREAMSTATS_QUANTILES] = {
+        stats.mean, stats.std, stats.rms, stats.min, stats.max, stats.max - stats.min
+    };
+
+    for (int i = 0; i < STREAMSTATS_QUANTILES; i++) {
+        values[6 + i] = stats.quantile[i];
+    }
+
+    for (int row = 0; row < ui->tableStatistics->rowCount(); row++) {
+        ui->tableStatistics->item(row, column)->setText(stats.count ? QString::number(values[row], 'f', 2) : QString());
+    }
+}
+
+/**
+ * @brief MainWindow::triggerSettingsUpdate
+ * Passes the settings of the Trigger tab to the serial thread. Widths and
+ * lengths are in samples of the undecimated stream.
+ */
+void MainWindow::triggerSettingsUpdate()
+{
+    Trigger::Settings settings;
+    bool enabled = ui->checkTrigger->isChecked();
+
+    settings.mode = (Trigger::Mode)ui->comboTriggerMode->currentIndex();
+    settings.condition = (Trigger::Condition)ui->comboTriggerCondition->currentIndex();
+    settings.slope = (Trigger::Slope)ui->comboTriggerSlope->currentIndex();
+    settings.level = ui->spinTriggerLevel->value();
+    settings.levelHigh = ui->spinTriggerLevelHigh->value();
+    settings.hysteresis = ui->spinTriggerHysteresis->value();
+    settings.widthMin = ui->spinTriggerWidthMin->value();
+    settings.widthMax = ui->spinTriggerWidthMax->value();
+    settings.preSamples = ui->spinTriggerPre->value();
+    settings.postSamples = ui->spinTriggerPost->value();
+    settings.autoSamples = qMax(1, qRound(ui->spinSampleRate->value() * ui->spinTriggerAuto->value() / 1000.0));
+    m_serialThread.setTrigger(settings, enabled);
+
+    ui->spinTriggerLevelHigh->setEnabled(settings.condition == Trigger::ConditionWindow);
+    ui->spinTriggerWidthMin->setEnabled(settings.condition == Trigger::ConditionPulseWidth);
+    ui->spinTriggerWidthMax->setEnabled(settings.condition == Trigger::ConditionPulseWidth);
+    ui->spinTriggerAuto->setEnabled(settings.mode == Trigger::ModeAuto);
+    ui->labelTriggerLevel->setText((settings.condition == Trigger::ConditionWindow) ?
+                                   tr("Lower level:") : tr("Level:"));
+    ui->plotTrigger->setVisible(enabled);
+    if (!enabled) {
+        ui->plotTrigger->graph(0)->clearData();
+    }
+
+    m_triggerCount = 0;
+    ui->labelTriggerStatus->setText(enabled ? tr("Armed") : QString());
+}
+
+/**
+ * @brief MainWindow::triggerArm
+ */
+void MainWindow::triggerArm()
+{
+    m_serialThread.armTrigger();
+    if (ui->checkTrigger->isChecked()) {
+        ui->labelTriggerStatus->setText(tr("Armed"));
+    }
+}
+
+#define TRIGGER_PLOT_INTERVAL_MS    50
+
+/**
+ * @brief MainWindow::processTriggerCapture
+ * @param samples - captured segment.
+ * @param preSamples - index of the trigger sample in the segment.
+ * @param forced - auto mode capture without a trigger.
+ *
+ * The plot keeps the segment until the next capture replaces it. Captures
+ * arriving faster than the plot interval are counted, not drawn.
+ */
+void MainWindow::processTriggerCapture(QVector<double> samples, int preSamples, bool forced)
+{
+    const bool single = (ui->comboTriggerMode->currentIndex() == Trigger::ModeSingle);
+
+    if (!ui->plotTrigger->isVisible()) {
+        return;
+    }
+
+    m_triggerCount++;
+    if (single) {
+        ui->labelTriggerStatus->setText(tr("Triggered, press Arm for the next capture"));
+    } else {
+        ui->labelTriggerStatus->setText(tr("%1: %2").arg(forced ? tr("Auto") : tr("Triggered"))
+                                                    .arg(m_triggerCount));
+    }
+
+    if (!single && m_triggerPlotTimer.isValid() &&
+        (m_triggerPlotTimer.elapsed() < TRIGGER_PLOT_INTERVAL_MS)) {
+        return;
+    }
+    m_triggerPlotTimer.start();
+
+    QVector<double> x(samples.size());
+    for (int i = 0; i < x.size(); i++) {
+        x[i] = i - preSamples;
+    }
+    ui->plotTrigger->graph(0)->setData(x, samples);
+    ui->plotTrigger->rescaleAxes();
+    ui->plotTrigger->replot();
+}
+
+/**
+ * @brief MainWindow::multiChannelUpdate
+ * Selects the channels streamed at once. An empty selection returns the
+ * board to streaming the single channel chosen with 'S'.
+ */
+void MainWindow::multiChannelUpdate()
+{
+    QCheckBox *checks[STREAMING_CHANNEL_COUNT] = {
+        ui->checkMultiFE, ui->checkMultiCE, ui->checkMultiSUM,
+        ui->checkMultiA, ui->checkMultiB, ui->checkMultiC, ui->checkMultiD
+    };
+    quint8 mask = 0;
+
+    if (ui->groupMultiChannel->isChecked()) {
+        for (int id = 0; id < STREAMING_CHANNEL_COUNT; id++) {
+            if (checks[id]->isChecked()) {
+                mask |= 1 << id;
+            }
+        }
+    }
+    if (mask == m_multiMask) {
+        return;
+    }
+
+    m_msg.msg_id    = 'M';
+    m_msg.signature = TELEMETRY_MSG_SIGNATURE;
+    m_msg.data_size = sizeof(quint8);
+    m_msg.data[0]   = mask;
+    m_serialThread.setMultiChannel(mask);
+    sendTelemetryMessage(m_msg);
+    m_multiMask = mask;
+
+    ui->plotFast->graph(0)->setVisible(mask == 0);
+    for (int id = 0; id < STREAMING_CHANNEL_COUNT; id++) {
+        QCPGraph *graph = ui->plotFast->graph(1 + id);
+        graph->clearData();
+        graph->setVisible(mask & (1 << id));
+        m_multiSampleCnt[id] = 1;
+    }
+    ui->plotFast->legend->setVisible(mask != 0);
+    ui->plotFast->replot();
+    ui->labelMultiRate->clear();
+}
+
+/**
+ * @brief MainWindow::processMultiStreamData
+ * @param channel - channel ID of the block.
+ * @param y - decimated samples of the channel.
+ */
+void MainWindow::processMultiStreamData(int channel, QVector<double> y)
+{
+    const int numPts = y.size();
+
+    m_serialThread.streamDataDone();
+    if (!(m_multiMask & (1 << channel)) || (numPts == 0)) {
+        return;
+    }
+
+    QCPGraph *graph = ui->plotFast->graph(1 + channel);
+    graph->addData(m_multiSampleCnt[channel], 1.0, y.constData(), numPts);
+    m_multiSampleCnt[channel] += numPts;
+    if (m_multiSampleCnt[channel] > SAMPLES_PER_PLOT) {
+        graph->removeDataBefore(m_multiSampleCnt[channel] - SAMPLES_PER_PLOT);
+    }
+
+    /* Replot once per 16 blocks of the lowest selected channel. */
+    if (!(m_multiMask & ((1 << channel) - 1)) && (m_multiUpdateCnt++ >= (16 - 1))) {
+        ui->plotFast->rescaleAxes(true);
+        ui->plotFast->xAxis->setRange(m_multiSampleCnt[channel], SAMPLES_PER_PLOT, Qt::AlignRight);
+        ui->plotFast->replot();
+        m_multiUpdateCnt = 0;
+    }
+}
+
+/**
+ * @brief MainWindow::processMultiStreamRates
+ * @param samplesPerSecond - raw sample rate per channel ID.
+ */
+void MainWindow::processMultiStreamRates(QVector<double> samplesPerSecond)
+{
+    QStringList rates;
+
+    for (int id = 0; id < samplesPerSecond.size(); id++) {
+        if (m_multiMask & (1 << id)) {
+            rates << tr("%1: %2 S/s").arg(streamingChannelNames[id]).arg(samplesPerSecond[id], 0, 'f', 0);
+        }
+    }
+    ui->labelMultiRate->setText(rates.join(", "));
+}
+
+/* Rows above the sweeps in the scan table, mean and standard deviation. */
+#define SCAN_TABLE_STAT_ROWS    2
+/* Sweeps listed in the scan table.        */
+#define SCAN_TABLE_SWEEPS_MAX   1000
+
+/**
+ * @brief MainWindow::scanAnalysisEnable
+ * @param enable - analyze the sweeps of the stream and show the last one.
+ */
+void MainWindow::scanAnalysisEnable(bool enable)
+{
+    m_serialThread.setScanAnalysis(enable);
+    ui->plotScan->setVisible(enable);
+}
+
+/**
+ * @brief MainWindow::scanClear
+ * Removes the listed sweeps and restarts the averages.
+ */
+void MainWindow::scanClear()
+{
+    const int columns = ui->tableScan->columnCount();
+
+    ui->tableScan->setRowCount(SCAN_TABLE_STAT_ROWS);
+    for (int row = 0; row < SCAN_TABLE_STAT_ROWS; row++) {
+        for (int column = 0; column < columns; column++) {
+            QTableWidgetItem *item = new QTableWidgetItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            ui->tableScan->setItem(row, column, item);
+        }
+    }
+    for (int column = 0; column < columns; column++) {
+        m_scanStats[column].reset();
+    }
+    m_scanCount = 0;
+}
+
+/**
+ * @brief MainWindow::processScanSweep
+ * @param sweep - samples of the sweep, aligned to its period marker.
+ * @param features - S-curve features of the sweep.
+ *
+ * The newest sweep is listed first below the mean and standard deviation
+ * rows. Features that could not be found are shown as "-" and do not
+ * enter the averages.
+ */
+void MainWindow::processScanSweep(QVector<double> sweep, const ScanFeatures &features)
+{
+    const double values[6] = {
+        (double)features.length, features.peakToPeak, features.zeroCrossing,
+        features.zeroPosition * 100.0, features.slope, features.asymmetry
+    };
+    const int columns = ui->tableScan->columnCount();
+
+    m_scanCount++;
+    ui->tableScan->insertRow(SCAN_TABLE_STAT_ROWS);
+    ui->tableScan->setVerticalHeaderItem(SCAN_TABLE_STAT_ROWS,
+                                         new QTableWidgetItem(tr("Sweep %1").arg(m_scanCount)));
+    for (int column = 0; column < columns; column++) {
+        QTableWidgetItem *item = new QTableWidgetItem(qIsNaN(values[column]) ?
+                                                      QString("-") : QString::number(values[column], 'g', 5));
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        ui->tableScan->setItem(SCAN_TABLE_STAT_ROWS, column, item);
+
+        if (!qIsNaN(values[column])) {
+            StreamStatistics stats;
+            m_scanStats[column].add(values[column]);
+            m_scanStats[column].result(stats);
+            ui->tableScan->item(0, column)->setText(QString::number(stats.mean, 'g', 5));
+            ui->tableScan->item(1, column)->setText(QString::number(stats.std, 'g', 5));
+        }
+    }
+    if (ui->tableScan->rowCount() > SCAN_TABLE_STAT_ROWS + SCAN_TABLE_SWEEPS_MAX) {
+        ui->tableScan->removeRow(ui->tableScan->rowCount() - 1);
+    }
+
+    ui->plotScan->graph(0)->clearData();
+    ui->plotScan->graph(0)->addData(0.0, 1.0, sweep.constData(), sweep.size());
+    ui->plotScan->graph(1)->clearData();
+    if (features.valid) {
+        ui->plotScan->graph(1)->addData(features.zeroCrossing, 0.0);
+    }
+    ui->plotScan->graph(0)->rescaleKeyAxis(false, false);
+    plotGrowValueAxis(ui->plotScan->graph(0), m_scanCount == 1);
+    ui->plotScan->replot();
+}
+
+/**
+ * @brief MainWindow::bodeSetRunning
+ * @param running - a measurement drives the actuators, lock their controls
+ * and the multi-channel selection, which would stop the single channel stream.
+ */
+void MainWindow::bodeSetRunning(bool running)
+{
+    m_bodeRunning = running;
+    ui->pushBodeStart->setText(running ? tr("Stop") : tr("Start"));
+    ui->tabActuators->setEnabled(!running);
+    ui->groupMultiChannel->setEnabled(!running);
+    foreach (QWidget *widget, ui->tabBode->findChildren<QAbstractSpinBox *>()) {
+        widget->setEnabled(!running);
+    }
+    foreach (QWidget *widget, ui->tabBode->findChildren<QComboBox *>()) {
+        widget->setEnabled(!running);
+    }
+}
+
+/**
+ * @brief MainWindow::bodeLimitsUpdate
+ * Limits the Bode frequencies to what the actuator commands can excite
+ * at the stream sample rate.
+ */
+void MainWindow::bodeLimitsUpdate()
+{
+    const double freqMax = BodeAnalyzer::freqMax(ui->spinSampleRate->value());
+
+    ui->spinBodeFreqStart->setMaximum(freqMax);
+    ui->spinBodeFreqStop->setMaximum(freqMax);
+    ui->labelBodeLimits->setText(tr("Up to %1 Hz, the actuator is commanded once per %2 samples. "
+                                    "Chirps up to %3 s.")
+        .arg(freqMax, 0, 'f', 2).arg(BODE_COMMAND_SAMPLES)
+        .arg(BodeAnalyzer::chirpDurationMax(ui->spinSampleRate->value()), 0, 'g', 3));
+}
+
+/**
+ * @brief MainWindow::bodeStart
+ * Starts a frequency response measurement around the current position of
+ * the selected actuator, or aborts the running one.
+ */
+void MainWindow::bodeStart()
+{
+    if (m_bodeRunning) {
+        m_serialThread.stopBode();
+        bodeSetRunning(false);
+        ui->labelBodeStatus->setText(tr("Stopped after %1 points").arg(m_bodePointCnt));
+        return;
+    }
+    if (!m_serialTimer.isActive()) {
+        QMessageBox::information(this, tr("No stream!"), tr("Start streaming the response channel first!"));
+        return;
+    }
+    /* The multi-channel stream replaces the samples the analyzer needs. */
+    if (m_multiMask) {
+        QMessageBox::information(this, tr("Multi-channel stream!"),
+            tr("Turn the multi-channel stream off first, the Bode analyzer needs the single channel stream!"));
+        return;
+    }
+
+    const QSlider *sliders[3] = { ui->sliderFOC, ui->sliderRAD, ui->sliderFBK };
+    const int actuator = ui->comboBodeActuator->currentIndex();
+    BodeAnalyzer::Settings settings;
+
+    settings.excitation = (BodeAnalyzer::Excitation)ui->comboBodeExcitation->currentIndex();
+    settings.sampleRate = ui->spinSampleRate->value();
+    settings.freqStart = ui->spinBodeFreqStart->value();
+    settings.freqStop = ui->spinBodeFreqStop->value();
+    settings.points = ui->spinBodePoints->value();
+    settings.offset = sliders[actuator]->value();
+    settings.amplitude = ui->spinBodeAmplitude->value();
+    settings.settleCycles = ui->spinBodeSettle->value();
+    settings.measureCycles = ui->spinBodeMeasure->value();
+    settings.chirpDuration = ui->spinBodeChirpDuration->value();
+    if ((settings.excitation == BodeAnalyzer::ExcitationChirp) &&
+        (settings.chirpDuration > BodeAnalyzer::chirpDurationMax(settings.sampleRate))) {
+        QMessageBox::information(this, tr("Chirp too long!"),
+            tr("At %1 Hz a chirp can last up to %2 s.").arg(settings.sampleRate)
+            .arg(BodeAnalyzer::chirpDurationMax(settings.sampleRate), 0, 'g', 3));
+        return;
+    }
+    m_serialThread.startBode(settings, actuator);
+
+    m_bodePointCnt = 0;
+    ui->plotBode->graph(0)->clearData();
+    ui->plotBode->graph(1)->clearData();
+    ui->plotBode->xAxis->setRange(qMin(settings.freqStart, settings.freqStop),
+                                  qMax(settings.freqStart, settings.freqStop));
+    ui->plotBode->setVisible(true);
+    ui->plotBode->replot();
+    bodeSetRunning(true);
+    ui->labelBodeStatus->setText(settings.excitation == BodeAnalyzer::ExcitationChirp ?
+                                 tr("Sweeping for %1 s...").arg(settings.chirpDuration) :
+                                 tr("Measuring point 1 of %1...").arg(settings.points));
+}
+
+/**
+ * @brief MainWindow::processBodePoint
+ * @param point - measured frequency point.
+ */
+void MainWindow::processBodePoint(const BodePoint &point)
+{
+    if (!m_bodeRunning) {
+        return;
+    }
+
+    m_bodePointCnt++;
+    if (!qIsNaN(point.gain) && (point.gain > 0.0)) {
+        /* Unwrap against the previous point, the phase keeps falling past -180. */
+        double phase = point.phase;
+        const bool first = ui->plotBode->graph(1)->data()->isEmpty();
+        if (first) {
+            m_bodePhase = phase;
+        } else {
+            phase += 360.0 * qRound((m_bodePhase - phase) / 360.0);
+            m_bodePhase = phase;
+        }
+        ui->plotBode->graph(0)->addData(point.frequency, 20.0 * log10(point.gain));
+        ui->plotBode->graph(1)->addData(point.frequency, phase);
+        plotGrowValueAxis(ui->plotBode->graph(0), first);
+        plotGrowValueAxis(ui->plotBode->graph(1), first);
+        ui->plotBode->replot();
+    }
+    ui->labelBodeStatus->setText(tr("Point %1 of %2: %3 Hz, coherence %4")
+                                 .arg(m_bodePointCnt).arg(ui->spinBodePoints->value())
+                                 .arg(point.frequency, 0, 'g', 4).arg(point.coherence, 0, 'f', 3));
+}
+
+/**
+ * @brief MainWindow::bodeFinished
+ */
+void MainWindow::bodeFinished()
+{
+    if (!m_bodeRunning) {
+        return;
+    }
+    bodeSetRunning(false);
+    ui->labelBodeStatus->setText(tr("Finished, %1 points").arg(m_bodePointCnt));
+}
+
+/* Replay speeds of comboReplaySpeed, 0 for as fast as possible. */
+static const double replaySpeeds[] = { 1.0, 2.0, 5.0, 10.0, 0.0 };
+
+/**
+ * @brief MainWindow::replaySetActive
+ * @param active - a recording replaces the serial connection.
+ */
+void MainWindow::replaySetActive(bool active)
+{
+    m_replaying = active;
+    ui->pushReplayOpen->setEnabled(!active);
+    ui->pushReplayStop->setEnabled(active);
+    ui->sliderReplayPosition->setEnabled(active);
+    ui->actionConnect->setEnabled(!active);
+    m_serialPortList->setEnabled(!active);
+}
+
+/**
+ * @brief MainWindow::replayOpen
+ * Replays a recording through the stream processing and the plots.
+ */
+void MainWindow::replayOpen()
+{
+    if (m_serialConnected) {
+        QMessageBox::information(this, tr("Connected!"), tr("Disconnect from the serial port first!"));
+        return;
+    }
+
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Replay recording"), QString(),
+        tr("Recordings (*.smdrec *%1);;All files (*)").arg(BUNDLE_SUFFIX));
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    /* The settings of a bundle show before its stream starts. */
+    BundleSnapshot snapshot;
+    QString error;
+    if (bundleRead(fileName, snapshot, error)) {
+        ui->labelReplayBundle->setText(bundleText(snapshot));
+    } else {
+        ui->labelReplayBundle->clear();
+    }
+
+    m_replayDuration = 0;
+    ui->sliderReplayPosition->setValue(0);
+    ui->labelReplayPosition->setText(QFileInfo(fileName).fileName());
+    m_serialThread.setReplaySpeed(replaySpeeds[ui->comboReplaySpeed->currentIndex()]);
+    m_serialThread.setReplayLoop(ui->checkReplayLoop->isChecked());
+    m_serialThread.replay(fileName);
+    replaySetActive(true);
+}
+
+/**
+ * @brief MainWindow::replayStop
+ */
+void MainWindow::replayStop()
+{
+    m_serialThread.disconnect();
+    replaySetActive(false);
+}
+
+/**
+ * @brief MainWindow::replaySpeedUpdate
+ * @param index - index of comboReplaySpeed.
+ */
+void MainWindow::replaySpeedUpdate(int index)
+{
+    m_serialThread.setReplaySpeed(replaySpeeds[index]);
+}
+
+/**
+ * @brief MainWindow::replayLoopUpdate
+ * @param loop - restart at the end of the recording.
+ */
+void MainWindow::replayLoopUpdate(bool loop)
+{
+    m_serialThread.setReplayLoop(loop);
+}
+
+/**
+ * @brief MainWindow::replaySeek
+ * Continues the replay at the released slider position.
+ */
+void MainWindow::replaySeek()
+{
+    const QSlider *slider = ui->sliderReplayPosition;
+
+    m_serialThread.seekReplay(m_replayDuration * slider->value() / slider->maximum());
+}
+
+/**
+ * @brief MainWindow::processReplayPosition
+ * @param position - recording time of the last replayed message, ns.
+ * @param duration - recording length, ns.
+ * @param speed - achieved replay speed since the last update.
+ */
+void MainWindow::processReplayPosition(qint64 position, qint64 duration, double speed)
+{
+    if (!m_replaying) {
+        return;
+    }
+
+    QSlider *slider = ui->sliderReplayPosition;
+    m_replayDuration = duration;
+    if (!slider->isSliderDown() && (duration > 0)) {
+        slider->setValue(slider->maximum() * position / duration);
+    }
+    ui->labelReplayPosition->setText(tr("%1 s / %2 s, %3x")
+        .arg(position / 1e9, 0, 'f', 1).arg(duration / 1e9, 0, 'f', 1).arg(speed, 0, 'f', 1));
+}
+
+/**
+ * @brief MainWindow::replayFinished
+ */
+void MainWindow::replayFinished()
+{
+    if (m_replaying) {
+        ui->labelReplayPosition->setText(tr("Finished at %1 s").arg(m_replayDuration / 1e9, 0, 'f', 1));
+    }
+}
+
+/**
+ * @brief MainWindow::captureOpen
+ * Shows a capture of any size, only the summaries of the visible range
+ * are read.
+ */
+void MainWindow::captureOpen()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open capture"), QString(),
+        tr("Sample captures (*.smdcap);;All files (*)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    captureClose();
+    if (!m_captureView.open(fileName)) {
+        QMessageBox::warning(this, tr("Can't open capture!"),
+            tr("Can't open %1. %2.").arg(fileName).arg(m_captureView.reader().errorString()));
+        return;
+    }
+
+    m_captureFileName = fileName;
+    const CaptureReader &reader = m_captureView.reader();
+    qint64 samples = 0;
+    ui->comboCaptureChannel->blockSignals(true);
+    for (int i = 0; i < STREAMING_CHANNEL_COUNT; i++) {
+        if (reader.sampleCount(i) > 0) {
+            ui->comboCaptureChannel->addItem(streamingChannelNames[i], i);
+            samples += reader.sampleCount(i);
+        }
+    }
+    ui->comboCaptureChannel->blockSignals(false);
+    ui->labelCaptureInfo->setText(tr("%1: %2 samples in %3 s%4")
+        .arg(QFileInfo(fileName).fileName()).arg(samples).arg(reader.duration() / 1e9, 0, 'f', 1)
+        .arg(reader.isComplete() ? QString() : tr(", not closed")));
+    ui->comboCaptureChannel->setEnabled(ui->comboCaptureChannel->count() > 0);
+    ui->pushCaptureExport->setEnabled(ui->comboCaptureChannel->count() > 0);
+    ui->pushCaptureClose->setEnabled(true);
+    ui->plotCapture->setVisible(true);
+    captureEventsLoad();
+    captureChannelUpdate(ui->comboCaptureChannel->currentIndex());
+}
+
+/**
+ * @brief MainWindow::captureClose
+ */
+void MainWindow::captureClose()
+{
+    m_captureView.close();
+    m_captureEvents.close();
+    m_captureFileName.clear();
+    ui->comboCaptureEvent->clear();
+    ui->comboCaptureEvent->setEnabled(false);
+    ui->pushCaptureEventPrev->setEnabled(false);
+    ui->pushCaptureEventNext->setEnabled(false);
+    ui->comboCaptureChannel->blockSignals(true);
+    ui->comboCaptureChannel->clear();
+    ui->comboCaptureChannel->blockSignals(false);
+    ui->comboCaptureChannel->setEnabled(false);
+    ui->pushCaptureClose->setEnabled(false);
+    ui->pushCaptureExport->setEnabled(false);
+    ui->labelCaptureInfo->setText(tr("No capture"));
+    ui->plotCapture->graph(0)->clearData();
+    ui->plotCapture->graph(1)->clearData();
+    ui->plotCapture->setVisible(false);
+}
+
+/**
+ * @brief MainWindow::captureChannelUpdate
+ * @param index - combo box index, shows the whole channel.
+ */
+void MainWindow::captureChannelUpdate(int index)
+{
+    qint16 min, max;
+
+    if (index < 0) {
+        return;
+    }
+    const int channel = ui->comboCaptureChannel->itemData(index).toInt();
+    if (m_captureView.range(channel, min, max)) {
+        ui->plotCapture->yAxis->setRange(min, max);
+    }
+    ui->plotCapture->xAxis->setRange(0, m_captureView.reader().sampleCount(channel));
+    captureRefresh();
+}
+
+/**
+ * @brief MainWindow::captureRangeChanged
+ * @param range - visible samples, kept within the capture.
+ */
+void MainWindow::captureRangeChanged(const QCPRange &range)
+{
+    const int index = ui->comboCaptureChannel->currentIndex();
+
+    if (index < 0) {
+        return;
+    }
+    const double count = m_captureView.reader().sampleCount(ui->comboCaptureChannel->itemData(index).toInt());
+    if (range.size() > count) {
+        ui->plotCapture->xAxis->setRange(0, count);
+    } else if (range.lower < 0) {
+        ui->plotCapture->xAxis->setRange(0, range.size());
+    } else if (range.upper > count) {
+        ui->plotCapture->xAxis->setRange(count - range.size(), count);
+    } else {
+        captureRefresh();
+    }
+}
+
+/**
+ * @brief MainWindow::captureExport
+ * Exports the visible range of the capture channel.
+ */
+void MainWindow::captureExport()
+{
+    ExportThread::Job job;
+    const int index = ui->comboCaptureChannel->currentIndex();
+
+    if (index < 0) {
+        return;
+    }
+    const CaptureReader &reader = m_captureView.reader();
+    const QCPRange range = ui->plotCapture->xAxis->range();
+    job.source = m_captureFileName;
+    job.channel = ui->comboCaptureChannel->itemData(index).toInt();
+    const qint64 last = reader.sampleCount(job.channel) - 1;
+    job.from = reader.sampleTime(job.channel, qBound((qint64)0, (qint64)range.lower, last));
+    job.to = reader.sampleTime(job.channel, qBound((qint64)0, (qint64)range.upper, last));
+    job.format = (ExportThread::Format)ui->comboExportFormat->currentIndex();
+    exportQueue(job);
+}
+
+/**
+ * @brief MainWindow::captureEventSelect
+ * @param index - combo box index of the event list.
+ */
+void MainWindow::captureEventSelect(int index)
+{
+    if (index >= 0) {
+        captureShowEvent(ui->comboCaptureEvent->itemData(index).toInt());
+    }
+}
+
+/**
+ * @brief MainWindow::captureEventPrev
+ * Shows the last event before the visible range, markers included.
+ */
+void MainWindow::captureEventPrev()
+{
+    const int index = ui->comboCaptureChannel->currentIndex();
+
+    if ((index < 0) || (m_captureEvents.count() == 0)) {
+        return;
+    }
+    const int channel = ui->comboCaptureChannel->itemData(index).toInt();
+    const CaptureReader &reader = m_captureView.reader();
+    const qint64 first = qBound((qint64)0, (qint64)ui->plotCapture->xAxis->range().lower,
+                                reader.sampleCount(channel) - 1);
+    const int event = m_captureEvents.findTime(reader.sampleTime(channel, first)) - 1;
+    if (event >= 0) {
+        captureShowEvent(event);
+    }
+}
+
+/**
+ * @brief MainWindow::captureEventNext
+ * Shows the first event after the center of the view, markers included.
+ */
+void MainWindow::captureEventNext()
+{
+    const int index = ui->comboCaptureChannel->currentIndex();
+
+    if ((index < 0) || (m_captureEvents.count() == 0)) {
+        return;
+    }
+    const int channel = ui->comboCaptureChannel->itemData(index).toInt();
+    const CaptureReader &reader = m_captureView.reader();
+    const qint64 center = qBound((qint64)0, (qint64)ui->plotCapture->xAxis->range().center(),
+                                 reader.sampleCount(channel) - 1);
+    const int event = m_captureEvents.findTime(reader.sampleTime(channel, center) + 1);
+    if (event < m_captureEvents.count()) {
+        captureShowEvent(event);
+    }
+}
+
+/**
+ * @brief MainWindow::captureNote
+ * Adds the note to the capture being recorded, else to the open capture
+ * at the center of the view.
+ */
+void MainWindow::captureNote()
+{
+    const QByteArray text = ui->lineCaptureNote->text().trimmed().toUtf8();
+    const int index = ui->comboCaptureChannel->currentIndex();
+    CaptureEventWriter writer;
+    CaptureEvent event;
+
+    if (text.isEmpty()) {
+        return;
+    }
+    if (m_recorder.addEvent(CAPTURE_EVENT_NOTE, 0, text.constData(), text.size())) {
+        ui->lineCaptureNote->clear();
+        ui->statusBar->showMessage(tr("Note added to the recording"));
+        return;
+    }
+    if (index < 0) {
+        QMessageBox::information(this, tr("No capture!"), tr("Record a capture or open one first!"));
+        return;
+    }
+
+    const CaptureReader &reader = m_captureView.reader();
+    memset((void *)&event, 0, sizeof(event));
+    event.channel = ui->comboCaptureChannel->itemData(index).toInt();
+    event.sample = qBound((qint64)0, (qint64)ui->plotCapture->xAxis->range().center(),
+                          reader.sampleCount(event.channel) - 1);
+    event.timestamp = reader.sampleTime(event.channel, event.sample);
+    event.type = CAPTURE_EVENT_NOTE;
+    event.data_size = qMin(text.size(), CAPTURE_EVENT_DATA_MAX);
+    if (!writer.open(CaptureEventWriter::fileName(m_captureFileName), reader.startTime(), true) ||
+        !writer.addEvent(event, text.constData()) || !writer.close()) {
+        QMessageBox::warning(this, tr("Can't add the note!"), writer.errorString());
+        return;
+    }
+    ui->lineCaptureNote->clear();
+    captureEventsLoad();
+}
+
+/**
+ * @brief MainWindow::captureEventsLoad
+ * Reads the event index of the open capture, if it has one. The list
+ * leaves out the period markers, Previous and Next step through them.
+ */
+void MainWindow::captureEventsLoad()
+{
+    ui->comboCaptureEvent->clear();
+    if (!m_captureEvents.open(CaptureEventWriter::fileName(m_captureFileName))) {
+        m_captureEvents.close();
+    }
+    for (int i = 0; i < m_captureEvents.count(); i++) {
+        if (m_captureEvents.event(i).type != CAPTURE_EVENT_MARKER) {
+            ui->comboCaptureEvent->addItem(captureEventText(i), i);
+        }
+    }
+    ui->comboCaptureEvent->setEnabled(ui->comboCaptureEvent->count() > 0);
+    ui->pushCaptureEventPrev->setEnabled(m_captureEvents.count() > 0);
+    ui->pushCaptureEventNext->setEnabled(m_captureEvents.count() > 0);
+}
+
+/**
+ * @brief MainWindow::captureEventText
+ * @param index - event index.
+ * @return time and description of the event.
+ */
+QString MainWindow::captureEventText(int index) const
+{
+    const CaptureEvent &event = m_captureEvents.event(index);
+    const QByteArray data = m_captureEvents.data(index);
+    QString text;
+
+    switch (event.type) {
+    case CAPTURE_EVENT_CHANNEL:
+        if (data.size() && ((quint8)data[0] < STREAMING_CHANNEL_COUNT)) {
+            text = tr("Channel %1").arg(streamingChannelNames[(quint8)data[0]]);
+        } else {
+            text = tr("Channel switch");
+        }
+        break;
+    case CAPTURE_EVENT_STREAM_START:
+        text = (data.size() && data[0]) ? tr("Scan start") : tr("Stream start");
+        break;
+    case CAPTURE_EVENT_STREAM_STOP:
+        text = tr("Stream stop");
+        break;
+    case CAPTURE_EVENT_MARKER:
+        text = tr("Period marker");
+        break;
+    case CAPTURE_EVENT_NOTE:
+        text = tr("Note: %1").arg(QString::fromUtf8(data));
+        break;
+    default:
+        text = tr("Command '%1' %2").arg(QChar(event.msg_id)).arg(QString(data.toHex()));
+        break;
+    }
+    return tr("%1 s  %2").arg(event.timestamp / 1e9, 0, 'f', 3).arg(text);
+}
+
+/**
+ * @brief MainWindow::captureShowEvent
+ * @param index - event index.
+ * Shows the samples from the event up to the next one.
+ */
+void MainWindow::captureShowEvent(int index)
+{
+    const int channelIndex = ui->comboCaptureChannel->currentIndex();
+
+    if (channelIndex < 0) {
+        return;
+    }
+    const int channel = ui->comboCaptureChannel->itemData(channelIndex).toInt();
+    const CaptureReader &reader = m_captureView.reader();
+    const qint64 end = m_captureEvents.segmentEnd(index);
+    const double first = m_captureEvents.eventSample(index, channel, reader);
+    double last = (end < 0) ? reader.sampleCount(channel) : reader.timeSample(channel, end);
+
+    /* Events close together still get a readable view. */
+    last = qMax(last, first + 64.0);
+    ui->plotCapture->xAxis->setRange(first, last);
+    ui->statusBar->showMessage(captureEventText(index));
+    const int item = ui->comboCaptureEvent->findData(index);
+    if (item >= 0) {
+        ui->comboCaptureEvent->setCurrentIndex(item);
+    }
+}
+
+/**
+ * @brief MainWindow::exportSource
+ * Selects the recording or capture the Export tab exports from.
+ */
+void MainWindow::exportSource()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Export from"), QString(),
+        tr("Recordings and captures (*.smdrec *%1 *.smdcap);;All files (*)").arg(BUNDLE_SUFFIX));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    m_exportSource = fileName;
+    ui->labelExportSource->setText(QFileInfo(fileName).fileName());
+    ui->pushExportStart->setEnabled(true);
+}
+
+/**
+ * @brief MainWindow::exportStart
+ * Queues the export of the time range selected in the Export tab.
+ */
+void MainWindow::exportStart()
+{
+    ExportThread::Job job;
+
+    job.source = m_exportSource;
+    /* The first entry is the single stream, the others are channel IDs. */
+    job.channel = ui->comboExportChannel->currentIndex() - 1;
+    job.from = (qint64)(ui->spinExportFrom->value() * 1e9);
+    job.to = (ui->spinExportTo->value() > 0.0) ? (qint64)(ui->spinExportTo->value() * 1e9) : -1;
+    job.format = (ExportThread::Format)ui->comboExportFormat->currentIndex();
+    exportQueue(job);
+}
+
+/**
+ * @brief MainWindow::exportQueue
+ * @param job - export to queue once the output file is chosen.
+ */
+void MainWindow::exportQueue(ExportThread::Job &job)
+{
+    const bool csv = (job.format == ExportThread::FormatCsv);
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export to"),
+        QFileInfo(job.source).completeBaseName() + (csv ? ".csv" : ".bin"),
+        csv ? tr("CSV files (*.csv);;All files (*)") : tr("Binary files (*.bin);;All files (*)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    job.target = fileName;
+    m_exporter.addJob(job);
+    ui->pushExportCancel->setEnabled(true);
+    ui->labelExportStatus->setText(tr("%1 export(s) pending").arg(m_exporter.pendingJobs()));
+}
+
+/**
+ * @brief MainWindow::exportCancel
+ * Cancels the running and the queued exports.
+ */
+void MainWindow::exportCancel()
+{
+    m_exporter.cancelAll();
+}
+
+/**
+ * @brief MainWindow::exportStarted
+ * @param id - export job ID.
+ */
+void MainWindow::exportStarted(int id)
+{
+    Q_UNUSED(id);
+    ui->progressExport->setValue(0);
+    ui->labelExportStatus->setText(tr("Exporting, %1 export(s) pending").arg(m_exporter.pendingJobs()));
+}
+
+/**
+ * @brief MainWindow::processExportProgress
+ * @param id - export job ID.
+ * @param percent - share of the time range done.
+ */
+void MainWindow::processExportProgress(int id, int percent)
+{
+    Q_UNUSED(id);
+    ui->progressExport->setValue(percent);
+}
+
+/**
+ * @brief MainWindow::exportFinished
+ * @param id - export job ID.
+ * @param ok - false if the export failed or was cancelled.
+ * @param s - result or error string.
+ */
+void MainWindow::exportFinished(int id, bool ok, const QString &s)
+{
+    Q_UNUSED(id);
+    ui->labelExportStatus->setText(s);
+    if (m_exporter.pendingJobs() == 0) {
+        ui->pushExportCancel->setEnabled(false);
+    }
+    if (!ok) {
+        ui->progressExport->setValue(0);
+    }
+}
+
+/* Segments listed below the total in the compare table. */
+#define COMPARE_TABLE_SEGMENTS_MAX  1000
+
+/**
+ * @brief MainWindow::compareGolden
+ * Selects the reference capture of the Compare tab.
+ */
+void MainWindow::compareGolden()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Golden capture"), QString(),
+        tr("Sample captures (*.smdcap);;All files (*)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    m_compareGolden = fileName;
+    ui->labelCompareGolden->setText(QFileInfo(fileName).fileName());
+    ui->pushCompareStart->setEnabled(!m_compareSuspect.isEmpty() && !ui->pushCompareCancel->isEnabled());
+}
+
+/**
+ * @brief MainWindow::compareSuspect
+ * Selects the capture compared against the golden one.
+ */
+void MainWindow::compareSuspect()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Suspect capture"), QString(),
+        tr("Sample captures (*.smdcap);;All files (*)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    m_compareSuspect = fileName;
+    ui->labelCompareSuspect->setText(QFileInfo(fileName).fileName());
+    ui->pushCompareStart->setEnabled(!m_compareGolden.isEmpty() && !ui->pushCompareCancel->isEnabled());
+}
+
+/**
+ * @brief MainWindow::compareStart
+ * Starts the comparison, Compare stays disabled until it finishes.
+ */
+void MainWindow::compareStart()
+{
+    CaptureCompare::Settings settings;
+
+    settings.golden = m_compareGolden;
+    settings.suspect = m_compareSuspect;
+    settings.channel = ui->comboCompareChannel->currentIndex();
+    settings.alignment = (CaptureCompare::Alignment)ui->comboCompareAlign->currentIndex();
+
+    /* The run replaces the captures the plot reads. */
+    m_compareValid = false;
+    ui->plotCompare->setVisible(false);
+    for (int i = 0; i < ui->plotCompare->graphCount(); i++) {
+        ui->plotCompare->graph(i)->clearData();
+    }
+    ui->tableCompare->setRowCount(0);
+    ui->progressCompare->setValue(0);
+    ui->labelCompareStatus->setText(tr("Comparing"));
+    ui->pushCompareStart->setEnabled(false);
+    ui->pushCompareCancel->setEnabled(true);
+    m_compare.startCompare(settings);
+}
+
+/**
+ * @brief MainWindow::compareCancel
+ */
+void MainWindow::compareCancel()
+{
+    m_compare.cancel();
+}
+
+/**
+ * @brief MainWindow::processCompareProgress
+ * @param percent - share of the aligned samples compared.
+ */
+void MainWindow::processCompareProgress(int percent)
+{
+    ui->progressCompare->setValue(percent);
+}
+
+/**
+ * @brief MainWindow::compareFinished
+ * @param ok - false if the comparison failed or was cancelled.
+ * @param s - summary or error string.
+ *
+ * Lists the total and the first segments, and shows the whole golden
+ * capture with the suspect and the difference overlaid.
+ */
+void MainWindow::compareFinished(bool ok, const QString &s)
+{
+    ui->labelCompareStatus->setText(s);
+    ui->pushCompareCancel->setEnabled(false);
+    ui->pushCompareStart->setEnabled(true);
+    if (!ok) {
+        ui->progressCompare->setValue(0);
+        return;
+    }
+
+    const QVector<CompareSegment> &segments = m_compare.segments();
+    const int rows = qMin(segments.size(), COMPARE_TABLE_SEGMENTS_MAX);
+    const CompareStats total = m_compare.total();
+    ui->tableCompare->setRowCount(rows + 1);
+    compareFillRow(0, tr("All"), segments.first().firstA, segments.first().firstB, total);
+    for (int i = 0; i < rows; i++) {
+        compareFillRow(i + 1, tr("Segment %1").arg(i + 1), segments[i].firstA, segments[i].firstB,
+                       CaptureCompare::stats(segments[i].moments));
+    }
+
+    const int channel = m_compare.settings().channel;
+    qint16 minA, maxA, minB, maxB;
+    m_compare.golden().range(channel, minA, maxA);
+    m_compare.suspect().range(channel, minB, maxB);
+    const double diff = qMax(total.maxAbsDiff, 1);
+    m_compareValid = true;
+    ui->plotCompare->yAxis->setRange(qMin(minA, minB), qMax(maxA, maxB));
+    ui->plotCompare->yAxis2->setRange(-diff, diff);
+    ui->plotCompare->setVisible(true);
+    ui->plotCompare->xAxis->setRange(0, m_compare.golden().reader().sampleCount(channel));
+    compareRefresh();
+}
+
+/**
+ * @brief MainWindow::compareFillRow
+ * @param row - table row.
+ * @param name - row header.
+ * @param firstA - first golden sample of the row.
+ * @param firstB - first suspect sample of the row.
+ * @param stats - deltas of the row.
+ */
+void MainWindow::compareFillRow(int row, const QString &name, qint64 firstA, qint64 firstB,
+                                const CompareStats &stats)
+{
+    const int channel = m_compare.settings().channel;
+    const QString values[8] = {
+        QString::number(m_compare.golden().reader().sampleTime(channel, firstA) / 1e9, 'f', 3),
+        QString::number(m_compare.suspect().reader().sampleTime(channel, firstB) / 1e9, 'f', 3),
+        QString::number(stats.count),
+        QString::number(stats.deltaMean, 'g', 5),
+        QString::number(stats.deltaStd, 'g', 5),
+        QString::number(stats.rmsDiff, 'g', 5),
+        QString::number(stats.maxAbsDiff),
+        qIsNaN(stats.correlation) ? QString("-") : QString::number(stats.correlation, 'f', 5)
+    };
+
+    ui->tableCompare->setVerticalHeaderItem(row, new QTableWidgetItem(name));
+    for (int column = 0; column < 8; column++) {
+        QTableWidgetItem *item = new QTableWidgetItem(values[column]);
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        ui->tableCompare->setItem(row, column, item);
+    }
+}
+
+/**
+ * @brief MainWindow::compareSegmentSelect
+ * @param row - clicked row, the total shows the whole capture.
+ * @param column - clicked column.
+ */
+void MainWindow::compareSegmentSelect(int row, int column)
+{
+    Q_UNUSED(column);
+
+    if (!m_compareValid) {
+        return;
+    }
+    if (row == 0) {
+        ui->plotCompare->xAxis->setRange(0, m_compare.golden().reader().sampleCount(m_compare.settings().channel));
+        return;
+    }
+    const CompareSegment &segment = m_compare.segments()[row - 1];
+    ui->plotCompare->xAxis->setRange(segment.firstA, segment.firstA + qMax(segment.length, (qint64)64));
+}
+
+/**
+ * @brief MainWindow::compareRangeChanged
+ * @param range - visible golden samples, kept within the capture.
+ */
+void MainWindow::compareRangeChanged(const QCPRange &range)
+{
+    if (!m_compareValid) {
+        return;
+    }
+    const double count = m_compare.golden().reader().sampleCount(m_compare.settings().channel);
+    if (range.size() > count) {
+        ui->plotCompare->xAxis->setRange(0, count);
+    } else if (range.lower < 0) {
+        ui->plotCompare->xAxis->setRange(0, range.size());
+    } else if (range.upper > count) {
+        ui->plotCompare->xAxis->setRange(count - range.size(), count);
+    } else {
+        compareRefresh();
+    }
+}
+
+/**
+ * @brief MainWindow::compareRefresh
+ * Replaces the graphs with one min/max point per pixel of the visible
+ * range. The suspect is shifted by the lag of the segment at the center
+ * of the view.
+ */
+void MainWindow::compareRefresh()
+{
+    QVector<double> keys, min, max;
+
+    if (!m_compareValid) {
+        return;
+    }
+    const int channel = m_compare.settings().channel;
+    const QCPRange range = ui->plotCompare->xAxis->range();
+    const int pixels = ui->plotCompare->axisRect()->width();
+
+    m_compare.golden().envelope(channel, range.lower, range.upper, pixels, keys, min, max);
+    ui->plotCompare->graph(0)->setData(keys, max);
+    ui->plotCompare->graph(1)->setData(keys, min);
+
+    const qint64 center = (qint64)range.center();
+    const double shift = m_compare.suspectSample(center) - center;
+    m_compare.suspect().envelope(channel, range.lower + shift, range.upper + shift, pixels, keys, min, max);
+    for (int i = 0; i < keys.size(); i++) {
+        keys[i] -= shift;
+    }
+    ui->plotCompare->graph(2)->setData(keys, max);
+    ui->plotCompare->graph(3)->setData(keys, min);
+
+    m_compare.differenceEnvelope(range.lower, range.upper, pixels, keys, min, max);
+    ui->plotCompare->graph(4)->setData(keys, max);
+    ui->plotCompare->graph(5)->setData(keys, min);
+    ui->plotCompare->replot();
+}
+
+/**
+ * @brief MainWindow::captureRefresh
+ * Replaces the graphs with one min/max point per pixel of the visible range.
+ */
+void MainWindow::captureRefresh()
+{
+    const int index = ui->comboCaptureChannel->currentIndex();
+
+    if (index < 0) {
+        return;
+    }
+    const QCPRange range = ui->plotCapture->xAxis->range();
+    m_captureView.envelope(ui->comboCaptureChannel->itemData(index).toInt(), range.lower, range.upper,
+                           ui->plotCapture->axisRect()->width(), m_captureKeys, m_captureMin, m_captureMax);
+    ui->plotCapture->graph(0)->setData(m_captureKeys, m_captureMax);
+    ui->plotCapture->graph(1)->setData(m_captureKeys, m_captureMin);
+    ui->plotCapture->replot();
 }
@@ -3,10 +3,21 @@
 
 #include <QMainWindow>
 #include <QComboBox>
+#include <QLabel>
 #include <QTimer>
+#include <QElapsedTimer>
 
 #include "telemetry.h"
 #include "serialthread.h"
+#include "plotqualitymanager.h"
+#include "spectrumthread.h"
+#include "recorderthread.h"
+#include "blackbox.h"
+#include "captureview.h"
+#include "captureevents.h"
+#include "exportthread.h"
+#include "capturecompare.h"
+#include "bundle.h"
 
 #define PWM_OUT_PITCH           0x00
 #define PWM_OUT_ROLL            0x01
@@ -38,6 +49,43 @@ private slots:
     void serialPortTimeout(const QString &s);
     void streamingGO();
     void scaningGO();
+    void recordingGO();
+    void recorderError(const QString &s);
+    void recorderStatus(qint64 bytes, qint64 frames, qint64 dropped);
+    void saveIncident();
+    void saveBundle();
+    void bundleFinish();
+    void bundleSave();
+    void replayOpen();
+    void replayStop();
+    void replaySpeedUpdate(int index);
+    void replayLoopUpdate(bool loop);
+    void replaySeek();
+    void processReplayPosition(qint64 position, qint64 duration, double speed);
+    void replayFinished();
+    void captureOpen();
+    void captureClose();
+    void captureChannelUpdate(int index);
+    void captureRangeChanged(const QCPRange &range);
+    void captureExport();
+    void captureEventSelect(int index);
+    void captureEventPrev();
+    void captureEventNext();
+    void captureNote();
+    void exportSource();
+    void exportStart();
+    void exportCancel();
+    void exportStarted(int id);
+    void processExportProgress(int id, int percent);
+    void exportFinished(int id, bool ok, const QString &s);
+    void compareGolden();
+    void compareSuspect();
+    void compareStart();
+    void compareCancel();
+    void processCompareProgress(int percent);
+    void compareFinished(bool ok, const QString &s);
+    void compareRangeChanged(const QCPRange &range);
+    void compareSegmentSelect(int row, int column);
     void streamingUpdateChannelID(bool checked);
     void actFOCUpdatePos(int pos);
     void actRADUpdatePos(int pos);
@@ -49,19 +97,96 @@ private slots:
     void processTelemetryMessage(const TelemetryMessage &msg);
     void processStreamData(QVector<double> y);
     void processTimeout();
+    void plotQualityModeUpdate(int index);
+    void plotQualityBudgetUpdate(double ms);
+    void plotQualityStatusUpdate();
+    void decimationUpdate();
+    void filterUpdate();
+    void spectrumEnable(bool enable);
+    void spectrumSettingsUpdate();
+    void spectrumReset();
+    void spectrogramEnable(bool enable);
+    void processSpectrum(QVector<double> freq, QVector<double> mag);
+    void statisticsWindowUpdate(int samples);
+    void statisticsReset();
+    void processStatistics(const StreamStatistics &session, const StreamStatistics &window);
+    void triggerSettingsUpdate();
+    void triggerArm();
+    void processTriggerCapture(QVector<double> samples, int preSamples, bool forced);
+    void multiChannelUpdate();
+    void processMultiStreamData(int channel, QVector<double> y);
+    void processMultiStreamRates(QVector<double> samplesPerSecond);
+    void scanAnalysisEnable(bool enable);
+    void scanClear();
+    void processScanSweep(QVector<double> sweep, const ScanFeatures &features);
+    void bodeLimitsUpdate();
+    void bodeStart();
+    void processBodePoint(const BodePoint &point);
+    void bodeFinished();
 
 private:
     void boardReadSettings();
+    quint8 streamingChannelID() const;
+    void bundleStoreReply(const TelemetryMessage &msg);
+    QString bundleText(const BundleSnapshot &snapshot) const;
     void motorGetSettings();
     void motorSetSettings();
     void fillSerialPortInfo();
     void sendTelemetryMessage(const TelemetryMessage &msg);
+    void spectrogramAddRow(const QVector<double> &freq, const QVector<double> &mag);
+    void statisticsFillColumn(int column, const StreamStatistics &stats);
+    void bodeSetRunning(bool running);
+    void replaySetActive(bool active);
+    void captureRefresh();
+    void captureEventsLoad();
+    QString captureEventText(int index) const;
+    void captureShowEvent(int index);
+    void exportQueue(ExportThread::Job &job);
+    void compareFillRow(int row, const QString &name, qint64 firstA, qint64 firstB, const CompareStats &stats);
+    void compareRefresh();
 
 private:
     Ui::MainWindow *ui;
     QComboBox *m_serialPortList;
+    RecorderThread m_recorder;      /* Outlives the serial thread feeding it. */
+    BlackBox m_blackBox;            /* Likewise.                                */
     SerialThread m_serialThread;
+    SpectrumThread m_spectrumThread;
+    QCPColorMap *m_spectrogram;
+    QVector<double> m_spectrogramRow;
+    int m_triggerCount;
+    QElapsedTimer m_triggerPlotTimer;
+    quint8 m_multiMask;
+    qint64 m_multiSampleCnt[STREAMING_CHANNEL_COUNT];
+    int m_multiUpdateCnt;
+    RunningStats m_scanStats[6];    /* One per column of the scan table. */
+    int m_scanCount;
+    bool m_bodeRunning;
+    int m_bodePointCnt;
+    double m_bodePhase;     /* Last plotted phase, for unwrapping. */
+    bool m_replaying;
+    qint64 m_replayDuration;
+    QString m_captureFileName;
+    CaptureView m_captureView;
+    CaptureEventReader m_captureEvents;
+    QVector<double> m_captureKeys;
+    QVector<double> m_captureMin;
+    QVector<double> m_captureMax;
+    ExportThread m_exporter;
+    QString m_exportSource;
+    CaptureCompare m_compare;
+    QString m_compareGolden;
+    QString m_compareSuspect;
+    bool m_compareValid;    /* m_compare holds a finished comparison. */
+    BundleSnapshot m_bundle;
+    bool m_bundlePending;   /* Waiting for the settings replies. */
+    QElapsedTimer m_bundleReadTimer;
+    QTimer m_bundleTimeout;
+    QTimer m_bundlePost;    /* Stream recorded after the snapshot. */
     QTimer m_serialTimer;
+    PlotQualityManager m_plotQuality;
+    QLabel *m_plotQualityLabel;
+    QLabel *m_recorderLabel;
     bool m_serialConnected;
     TelemetryMessage m_msg;
     PWMOutputStruct m_pwmOutput;
@@ -0,0 +1,98 @@
+#include "multistream.h"
+#include "streamkernels.h"
+
+/**
+ * @brief MultiStream::MultiStream
+ */
+MultiStream::MultiStream() :
+    m_mask(0),
+    m_count(0),
+    m_ringPos(0)
+{
+    for (int i = 0; i < STREAMING_CHANNEL_COUNT; i++) {
+        m_ring[i].fill(0, MULTISTREAM_RING_DEPTH);
+    }
+    reset();
+}
+
+/**
+ * @brief MultiStream::setChannels
+ * @param mask - bit n set streams channel n.
+ */
+void MultiStream::setChannels(quint8 mask)
+{
+    m_mask = mask & ((1 << STREAMING_CHANNEL_COUNT) - 1);
+    m_count = 0;
+    for (int id = 0; id < STREAMING_CHANNEL_COUNT; id++) {
+        if (m_mask & (1 << id)) {
+            m_ids[m_count++] = id;
+        }
+    }
+    reset();
+}
+
+/**
+ * @brief MultiStream::configure
+ * @param type - decimation filter of every channel.
+ * @param ratio - decimation ratio of every channel.
+ */
+void MultiStream::configure(Decimator::Type type, int ratio)
+{
+    for (int i = 0; i < STREAMING_CHANNEL_COUNT; i++) {
+        m_decimator[i].configure(type, ratio);
+        m_out[i].clear();
+    }
+}
+
+/**
+ * @brief MultiStream::reset
+ */
+void MultiStream::reset()
+{
+    m_ringPos = 0;
+    for (int i = 0; i < STREAMING_CHANNEL_COUNT; i++) {
+        m_decimator[i].reset();
+        m_out[i].clear();
+        m_samples[i] = 0;
+    }
+}
+
+/**
+ * @brief MultiStream::process
+ * @param data - payload of an 'm' message.
+ * @param size - payload size in bytes.
+ * @return false if the payload does not match the selected channels.
+ *
+ * Frames are split straight into the rings, in two parts if they wrap
+ * around, and every channel is decimated from its own contiguous ring
+ * segment into output().
+ */
+bool MultiStream::process(const char *data, int size)
+{
+    if ((m_count == 0) || (size < MULTISTREAM_HDR_SIZE) || ((quint8)data[0] != m_mask)) {
+        /* Frames of a previous selection still in flight. */
+        return false;
+    }
+
+    const int frameBytes = m_count * (int)sizeof(qint16);
+    const qint16 *in = (const qint16 *)(data + MULTISTREAM_HDR_SIZE);
+    int frames = (size - MULTISTREAM_HDR_SIZE) / frameBytes;
+    qint16 *out[STREAMING_CHANNEL_COUNT];
+
+    while (frames > 0) {
+        int n = qMin(frames, MULTISTREAM_RING_DEPTH - m_ringPos);
+        for (int i = 0; i < m_count; i++) {
+            out[i] = m_ring[i].data() + m_ringPos;
+        }
+        streamDeinterleave(in, n, m_count, out);
+        for (int i = 0; i < m_count; i++) {
+            m_decimator[i].process(out[i], n, m_out[i]);
+            m_samples[i] += n;
+        }
+        in += n * m_count;
+        frames -= n;
+        m_ringPos = (m_ringPos + n) % MULTISTREAM_RING_DEPTH;
+    }
+
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef MULTISTREAM_H
+#define MULTISTREAM_H
+
+#include <QVector>
+
+#include "telemetry.h"
+#include "decimator.h"
+
+/* Raw samples kept per channel.           */
+#define MULTISTREAM_RING_DEPTH          4096
+/* Header bytes of a multi-channel frame.  */
+#define MULTISTREAM_HDR_SIZE            2
+
+/* Decoder of the multi-channel stream ('m' messages). The payload starts
+ * with the channel mask and a reserved byte, followed by frames of one
+ * qint16 sample per selected channel in ascending channel ID order.
+ */
+class MultiStream
+{
+public:
+    MultiStream();
+
+    void setChannels(quint8 mask);
+    quint8 channels() const { return m_mask; }
+    int channelCount() const { return m_count; }
+    int channelId(int index) const { return m_ids[index]; }
+    void configure(Decimator::Type type, int ratio);
+    void reset();
+
+    bool process(const char *data, int size);
+    QVector<double> &output(int index) { return m_out[index]; }
+    qint64 sampleCount(int index) const { return m_samples[index]; }
+    const qint16 *ring(int index) const { return m_ring[index].constData(); }
+    int ringPos() const { return m_ringPos; }
+
+private:
+    quint8 m_mask;
+    int m_count;
+    int m_ids[STREAMING_CHANNEL_COUNT];
+    /* Structure of arrays, one ring of raw samples per channel index. */
+    QVector<qint16> m_ring[STREAMING_CHANNEL_COUNT];
+    int m_ringPos;          /* Next write position, same for all rings. */
+    Decimator m_decimator[STREAMING_CHANNEL_COUNT];
+    QVector<double> m_out[STREAMING_CHANNEL_COUNT];
+    qint64 m_samples[STREAMING_CHANNEL_COUNT];
+};
+
+#endif // MULTISTREAM_H
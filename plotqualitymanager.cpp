@@ -0,0 +1,380 @@
+#include "plotqualitymanager.h"
+
+/**
+ * @brief PlotQualityManager::PlotQualityManager
+ * @param parent
+ */
+PlotQualityManager::PlotQualityManager(QObject *parent) :
+    QObject(parent),
+    m_mode(ModeAuto),
+    m_budgetMs(PLOT_QUALITY_BUDGET_MS),
+    m_restoreRatio(PLOT_QUALITY_RESTORE_RATIO),
+    m_holdoff(PLOT_QUALITY_HOLDOFF)
+{
+    // Empty;
+}
+
+/**
+ * @brief PlotQualityManager::~PlotQualityManager
+ */
+PlotQualityManager::~PlotQualityManager()
+{
+    // Empty;
+}
+
+/**
+ * @brief PlotQualityManager::addPlot
+ * @param plot - plot whose replot time is measured and whose quality is managed.
+ *
+ * Each plot has its own replot time average and quality level, a slow
+ * plot does not degrade the others.
+ */
+void PlotQualityManager::addPlot(QCustomPlot *plot)
+{
+    PlotState state;
+    state.plot = plot;
+    state.notAntialiased = plot->notAntialiasedElements();
+    state.graphCount = 0;
+    state.quality = QualityFull;
+    state.avgReplotMs = 0.0;
+    state.holdoffCnt = 0;
+    m_plots.append(state);
+
+    connect(plot, SIGNAL(beforeReplot()), this, SLOT(plotBeforeReplot()));
+    connect(plot, SIGNAL(afterReplot()), this, SLOT(plotAfterReplot()));
+
+    switch (m_mode) {
+    case ModeReduced:
+        setQuality(m_plots.last(), QualityReduced);
+        break;
+    case ModeMinimal:
+        setQuality(m_plots.last(), QualityMinimal);
+        break;
+    default:
+        applyQuality(m_plots.last());
+        break;
+    }
+}
+
+/**
+ * @brief PlotQualityManager::quality
+ * @return lowest quality level of the visible plots.
+ */
+PlotQualityManager::Quality PlotQualityManager::quality() const
+{
+    Quality quality = QualityFull;
+
+    foreach (const PlotState &state, m_plots) {
+        if (!state.plot.isNull() && state.plot->isVisible() && (state.quality > quality)) {
+            quality = state.quality;
+        }
+    }
+    return quality;
+}
+
+/**
+ * @brief PlotQualityManager::replotTime
+ * @return average replot time of the slowest visible plot, ms.
+ */
+double PlotQualityManager::replotTime() const
+{
+    double ms = 0.0;
+
+    foreach (const PlotState &state, m_plots) {
+        if (!state.plot.isNull() && state.plot->isVisible()) {
+            ms = qMax(ms, state.avgReplotMs);
+        }
+    }
+    return ms;
+}
+
+/**
+ * @brief PlotQualityManager::setMode
+ * @param mode - automatic quality selection or one of the fixed quality levels.
+ */
+void PlotQualityManager::setMode(Mode mode)
+{
+    m_mode = mode;
+
+    for (int i = 0; i < m_plots.size(); i++) {
+        m_plots[i].holdoffCnt = 0;
+        switch (mode) {
+        case ModeFull:
+            setQuality(m_plots[i], QualityFull);
+            break;
+        case ModeReduced:
+            setQuality(m_plots[i], QualityReduced);
+            break;
+        case ModeMinimal:
+            setQuality(m_plots[i], QualityMinimal);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief PlotQualityManager::setBudget
+ * @param ms - replot time above which quality is reduced in automatic mode.
+ */
+void PlotQualityManager::setBudget(double ms)
+{
+    m_budgetMs = qMax(1.0, ms);
+}
+
+/**
+ * @brief PlotQualityManager::setRestoreRatio
+ * @param ratio - fraction of the budget below which quality is restored.
+ */
+void PlotQualityManager::setRestoreRatio(double ratio)
+{
+    m_restoreRatio = qBound(0.05, ratio, 0.95);
+}
+
+/**
+ * @brief PlotQualityManager::setHoldoff
+ * @param replots - number of replots to wait between two quality changes.
+ */
+void PlotQualityManager::setHoldoff(int replots)
+{
+    m_holdoff = qMax(1, replots);
+}
+
+/**
+ * @brief PlotQualityManager::qualityName
+ * @param quality
+ * @return human readable name of the quality level.
+ */
+QString PlotQualityManager::qualityName(Quality quality)
+{
+    switch (quality) {
+    case QualityReduced:
+        return tr("reduced");
+    case QualityMinimal:
+        return tr("minimal");
+    default:
+        return tr("full");
+    }
+}
+
+/**
+ * @brief PlotQualityManager::plotIndex
+ * @param plot
+ * @return index of the plot in m_plots, -1 if it is not managed.
+ */
+int PlotQualityManager::plotIndex(QCustomPlot *plot) const
+{
+    for (int i = 0; plot && (i < m_plots.size()); i++) {
+        if (m_plots[i].plot == plot) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief PlotQualityManager::plotBeforeReplot
+ */
+void PlotQualityManager::plotBeforeReplot()
+{
+    QCustomPlot *plot = qobject_cast<QCustomPlot *>(sender());
+    int index = plotIndex(plot);
+
+    if (index < 0) {
+        return;
+    }
+
+    /* Graphs added since the quality was applied get the current level too. */
+    PlotState &state = m_plots[index];
+    if (state.graphCount != plot->graphCount()) {
+        applyQuality(state);
+    }
+    state.replotTimer.start();
+}
+
+/**
+ * @brief PlotQualityManager::plotAfterReplot
+ */
+void PlotQualityManager::plotAfterReplot()
+{
+    int index = plotIndex(qobject_cast<QCustomPlot *>(sender()));
+
+    if ((index < 0) || !m_plots[index].replotTimer.isValid()) {
+        return;
+    }
+
+    PlotState &state = m_plots[index];
+    double replotMs = state.replotTimer.nsecsElapsed() / 1000000.0;
+    state.replotTimer.invalidate();
+
+    if (state.avgReplotMs == 0.0) {
+        state.avgReplotMs = replotMs;
+    } else {
+        state.avgReplotMs += PLOT_QUALITY_AVG_ALPHA * (replotMs - state.avgReplotMs);
+    }
+    emit replotTimeChanged(replotTime());
+
+    if (m_mode != ModeAuto) {
+        return;
+    }
+
+    /* Hysteresis: give every quality level some replots to settle. */
+    if (++state.holdoffCnt < m_holdoff) {
+        return;
+    }
+
+    if ((state.avgReplotMs > m_budgetMs) && (state.quality != QualityMinimal)) {
+        setQuality(state, (Quality)(state.quality + 1));
+    } else if ((state.avgReplotMs < m_budgetMs * m_restoreRatio) && (state.quality != QualityFull)) {
+        setQuality(state, (Quality)(state.quality - 1));
+    }
+}
+
+/**
+ * @brief PlotQualityManager::setQuality
+ * @param state - managed plot.
+ * @param quality - new quality level of the plot.
+ */
+void PlotQualityManager::setQuality(PlotState &state, Quality quality)
+{
+    if (quality == state.quality) {
+        return;
+    }
+
+    state.quality = quality;
+    state.holdoffCnt = 0;
+    if (!state.plot.isNull()) {
+        applyQuality(state);
+    }
+    emit qualityChanged(this->quality());
+}
+
+/**
+ * @brief PlotQualityManager::applyQuality
+ * @param state - managed plot to be configured for its quality level.
+ */
+void PlotQualityManager::applyQuality(PlotState &state)
+{
+    QCustomPlot *plot = state.plot.data();
+
+    state.graphCount = plot->graphCount();
+    if (state.quality == QualityFull) {
+        plot->setNotAntialiasedElements(state.notAntialiased);
+    } else {
+        plot->setNotAntialiasedElements(QCP::aeAll);
+    }
+
+    for (int i = 0; i < plot->graphCount(); i++) {
+        setGraphQuality(plot->graph(i), state.quality != QualityFull, state.quality == QualityMinimal);
+    }
+
+    /* Frozen margins skip the tick label size based re-layout on every replot. */
+    foreach (QCPAxisRect *rect, plot->axisRects()) {
+        setMarginsFrozen(rect, state.quality == QualityMinimal);
+    }
+}
+
+/**
+ * @brief PlotQualityManager::setGraphQuality
+ * @param graph - managed graph.
+ * @param thin - draw with a 1 px pen, or restore the width it had.
+ * @param coarse - use coarse adaptive sampling, or restore the resolution
+ * it had.
+ *
+ * Only the width and the sampling resolution are saved and restored,
+ * other changes made in the meantime are kept.
+ */
+void PlotQualityManager::setGraphQuality(QCPGraph *graph, bool thin, bool coarse)
+{
+    int index = -1;
+
+    /* Forget deleted graphs. */
+    for (int i = m_graphs.size() - 1; i >= 0; i--) {
+        if (m_graphs[i].graph.isNull()) {
+            m_graphs.removeAt(i);
+        }
+    }
+    for (int i = 0; i < m_graphs.size(); i++) {
+        if (m_graphs[i].graph == graph) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        if (!thin && !coarse) {
+            return;
+        }
+        GraphState state;
+        state.graph = graph;
+        state.thin = false;
+        state.penWidth = 0.0;
+        state.coarse = false;
+        state.samplingPx = 0.0;
+        m_graphs.append(state);
+        index = m_graphs.size() - 1;
+    }
+
+    GraphState &state = m_graphs[index];
+    if (thin != state.thin) {
+        QPen pen = graph->pen();
+        if (thin) {
+            state.penWidth = pen.widthF();
+            pen.setWidth(1);
+        } else {
+            pen.setWidthF(state.penWidth);
+        }
+        graph->setPen(pen);
+        state.thin = thin;
+    }
+    if (coarse != state.coarse) {
+        if (coarse) {
+            state.samplingPx = graph->adaptiveSamplingResolution();
+            graph->setAdaptiveSamplingResolution(PLOT_QUALITY_MIN_SAMPLING_PX);
+        } else {
+            graph->setAdaptiveSamplingResolution(state.samplingPx);
+        }
+        state.coarse = coarse;
+    }
+    if (!state.thin && !state.coarse) {
+        m_graphs.removeAt(index);
+    }
+}
+
+/**
+ * @brief PlotQualityManager::setMarginsFrozen
+ * @param rect - axis rect of a managed plot.
+ * @param frozen - fix the margins at their current size, or restore the
+ * automatic margin sides and margins the rect had.
+ */
+void PlotQualityManager::setMarginsFrozen(QCPAxisRect *rect, bool frozen)
+{
+    int index = -1;
+
+    /* Forget deleted axis rects. */
+    for (int i = m_frozenRects.size() - 1; i >= 0; i--) {
+        if (m_frozenRects[i].rect.isNull()) {
+            m_frozenRects.removeAt(i);
+        }
+    }
+    for (int i = 0; i < m_frozenRects.size(); i++) {
+        if (m_frozenRects[i].rect == rect) {
+            index = i;
+            break;
+        }
+    }
+
+    if (frozen && (index < 0)) {
+        RectState state;
+        state.rect = rect;
+        state.autoMargins = rect->autoMargins();
+        state.margins = rect->margins();
+        m_frozenRects.append(state);
+        rect->setMargins(rect->margins());
+        rect->setAutoMargins(QCP::msNone);
+    } else if (!frozen && (index >= 0)) {
+        rect->setMargins(m_frozenRects[index].margins);
+        rect->setAutoMargins(m_frozenRects[index].autoMargins);
+        m_frozenRects.removeAt(index);
+    }
+}
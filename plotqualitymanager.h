@@ -0,0 +1,110 @@
+#ifndef PLOTQUALITYMANAGER_H
+#define PLOTQUALITYMANAGER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QList>
+#include <QPen>
+
+#include "3rdparty/qcustomplot.h"
+
+/* Default replot time budget in milliseconds.             */
+#define PLOT_QUALITY_BUDGET_MS              15.0
+/* Quality is restored below this fraction of the budget.  */
+#define PLOT_QUALITY_RESTORE_RATIO          0.5
+/* Replots to wait between two quality changes.            */
+#define PLOT_QUALITY_HOLDOFF                8
+/* Smoothing factor of the replot time average.            */
+#define PLOT_QUALITY_AVG_ALPHA              0.25
+/* Adaptive sampling resolution at minimal quality, px.    */
+#define PLOT_QUALITY_MIN_SAMPLING_PX        3.0
+
+class PlotQualityManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    /* Rendering quality levels, from best to fastest. */
+    enum Quality {
+        QualityFull = 0,  /* Antialiasing, original pens, 1 px sampling.   */
+        QualityReduced,   /* No antialiasing, 1 px wide pens.              */
+        QualityMinimal    /* Coarse sampling and frozen axis margins too.  */
+    };
+
+    /* Quality selection policy. */
+    enum Mode {
+        ModeAuto = 0,     /* Follow the measured replot time.              */
+        ModeFull,
+        ModeReduced,
+        ModeMinimal
+    };
+
+    PlotQualityManager(QObject *parent = 0);
+    ~PlotQualityManager();
+
+    void addPlot(QCustomPlot *plot);
+    void setMode(Mode mode);
+    void setBudget(double ms);
+    void setRestoreRatio(double ratio);
+    void setHoldoff(int replots);
+
+    Mode mode() const { return m_mode; }
+    Quality quality() const;
+    double budget() const { return m_budgetMs; }
+    double replotTime() const;
+
+    static QString qualityName(Quality quality);
+
+signals:
+    void qualityChanged(int quality);
+    void replotTimeChanged(double ms);
+
+private slots:
+    void plotBeforeReplot();
+    void plotAfterReplot();
+
+private:
+    struct PlotState {
+        QPointer<QCustomPlot> plot;
+        QCP::AntialiasedElements notAntialiased;
+        int graphCount;     /* Graphs when the quality was last applied. */
+        Quality quality;
+        double avgReplotMs; /* Smoothed replot time of this plot.        */
+        int holdoffCnt;
+        QElapsedTimer replotTimer;
+    };
+
+    /* Graph settings changed below full quality, restored above it. */
+    struct GraphState {
+        QPointer<QCPGraph> graph;
+        bool thin;          /* Pen set to 1 px.                          */
+        qreal penWidth;     /* Width to restore at full quality.         */
+        bool coarse;        /* Coarse adaptive sampling.                 */
+        double samplingPx;  /* Resolution to restore above minimal.      */
+    };
+
+    /* Axis rect margins frozen at minimal quality. */
+    struct RectState {
+        QPointer<QCPAxisRect> rect;
+        QCP::MarginSides autoMargins;
+        QMargins margins;
+    };
+
+    int plotIndex(QCustomPlot *plot) const;
+    void setQuality(PlotState &state, Quality quality);
+    void applyQuality(PlotState &state);
+    void setGraphQuality(QCPGraph *graph, bool thin, bool coarse);
+    void setMarginsFrozen(QCPAxisRect *rect, bool frozen);
+
+private:
+    QList<PlotState> m_plots;
+    QList<GraphState> m_graphs;
+    QList<RectState> m_frozenRects;
+    Mode m_mode;
+    double m_budgetMs;
+    double m_restoreRatio;
+    int m_holdoff;
+};
+
+#endif // PLOTQUALITYMANAGER_H
@@ -0,0 +1,472 @@
+#include "recorderthread.h"
+
+#include <QDateTime>
+
+/* Pending samples of the capture format, followed by count qint16, or
+ * with channel RECORDER_EVENT_RECORD an event followed by its data.
+ */
+typedef struct tagSampleRecord {
+    qint64 timestamp;
+    qint32 channel;
+    qint32 count;
+} SampleRecord;
+
+/**
+ * @brief RecorderThread::RecorderThread
+ * @param parent
+ */
+RecorderThread::RecorderThread(QObject *parent) :
+    QThread(parent),
+    m_format(FormatRecording),
+    m_recording(false),
+    m_quit(true),
+    m_startTime(0),
+    m_frames(0),
+    m_dropped(0),
+    m_map(0),
+    m_mapOffset(0),
+    m_mapPos(0),
+    m_eventChannel(STREAMING_CHANNEL_FE)
+{
+    /* Reserved capacity survives resize(0), the batches are swapped without allocation. */
+    m_pending.reserve(RECORDER_BATCH_SIZE * 2);
+    m_batch.reserve(RECORDER_BATCH_SIZE * 2);
+}
+
+/**
+ * @brief RecorderThread::~RecorderThread
+ */
+RecorderThread::~RecorderThread()
+{
+    if (isRunning()) {
+        stopRecording();
+    }
+}
+
+/**
+ * @brief RecorderThread::startRecording
+ * @param fileName - recording file, truncated if it exists.
+ * @param format - file format.
+ *
+ * Frames are accepted from now on, the file is opened by the writer
+ * thread. Failures are reported by recorderError().
+ */
+void RecorderThread::startRecording(const QString &fileName, Format format)
+{
+    if (isRunning()) {
+        stopRecording();
+    }
+
+    m_mutex.lock();
+    m_fileName = fileName;
+    m_format = format;
+    m_quit = false;
+    m_recording = true;
+    m_pending.resize(0);
+    m_commands.resize(0);
+    m_frames = 0;
+    m_dropped = 0;
+    m_startTime = QDateTime::currentMSecsSinceEpoch();
+    m_clock.start();
+    m_mutex.unlock();
+
+    start(QThread::LowPriority);
+}
+
+/**
+ * @brief RecorderThread::stopRecording
+ * Writes the pending frames and closes the file.
+ */
+void RecorderThread::stopRecording()
+{
+    m_mutex.lock();
+    m_recording = false;
+    m_quit = true;
+    m_dataReady.wakeOne();
+    m_mutex.unlock();
+
+    wait();
+}
+
+/**
+ * @brief RecorderThread::isRecording
+ */
+bool RecorderThread::isRecording() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_recording;
+}
+
+/**
+ * @brief RecorderThread::addFrame
+ * @param msg - header of a received telemetry message.
+ * @param data - message data, msg.data_size bytes.
+ *
+ * Called by the serial thread for every message. Only copies the frame,
+ * frames are dropped rather than waiting if the writer falls behind.
+ */
+void RecorderThread::addFrame(const TelemetryMessage &msg, const char *data)
+{
+    RecordHeader hdr;
+
+    m_mutex.lock();
+    if (m_recording && (m_format == FormatCapture) && (msg.msg_id == '.') && (msg.data_size == 0)) {
+        appendEvent(CAPTURE_EVENT_MARKER, msg.msg_id, 0, 0);
+    }
+    if (!m_recording || (m_format != FormatRecording)) {
+        m_mutex.unlock();
+        return;
+    }
+    if (m_pending.size() + (int)sizeof(hdr) + msg.data_size > RECORDER_BACKLOG_MAX) {
+        m_dropped++;
+        m_mutex.unlock();
+        return;
+    }
+
+    hdr.timestamp = m_clock.nsecsElapsed();
+    hdr.msg_id = msg.msg_id;
+    hdr.signature = msg.signature;
+    hdr.data_size = msg.data_size;
+    m_pending.append((const char *)&hdr, sizeof(hdr));
+    m_pending.append(data, msg.data_size);
+    m_frames++;
+    if (m_pending.size() >= RECORDER_BATCH_SIZE) {
+        m_dataReady.wakeOne();
+    }
+    m_mutex.unlock();
+}
+
+/**
+ * @brief RecorderThread::addSamples
+ * @param channel - streaming channel ID.
+ * @param samples - received stream samples of the channel.
+ * @param count - number of samples.
+ *
+ * Called by the serial thread for the decoded stream samples, only used
+ * by the capture format. Samples are dropped like frames if the writer
+ * falls behind.
+ */
+void RecorderThread::addSamples(int channel, const qint16 *samples, int count)
+{
+    SampleRecord rec;
+
+    m_mutex.lock();
+    if (!m_recording || (m_format != FormatCapture)) {
+        m_mutex.unlock();
+        return;
+    }
+    if (m_pending.size() + (int)sizeof(rec) + count * (int)sizeof(qint16) > RECORDER_BACKLOG_MAX) {
+        m_dropped++;
+        m_mutex.unlock();
+        return;
+    }
+
+    rec.timestamp = m_clock.nsecsElapsed();
+    rec.channel = channel;
+    rec.count = count;
+    m_pending.append((const char *)&rec, sizeof(rec));
+    m_pending.append((const char *)samples, count * sizeof(qint16));
+    m_frames++;
+    if (m_pending.size() >= RECORDER_BATCH_SIZE) {
+        m_dataReady.wakeOne();
+    }
+    m_mutex.unlock();
+}
+
+/**
+ * @brief RecorderThread::addCommands
+ * @param data - bytes sent to the board, whole telemetry messages except
+ * that a message may be split between calls.
+ * @param size - number of bytes.
+ *
+ * Called by the serial thread, indexes the commands of a capture.
+ * Requests without data of the lower case IDs only read the board state
+ * and are left out.
+ */
+void RecorderThread::addCommands(const char *data, int size)
+{
+    TelemetryMessage msg;
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_recording || (m_format != FormatCapture)) {
+        return;
+    }
+    m_commands.append(data, size);
+    while (m_commands.size() >= TELEMETRY_MSG_HDR_SIZE) {
+        memcpy((void *)&msg, m_commands.constData(), TELEMETRY_MSG_HDR_SIZE);
+        if ((msg.signature != TELEMETRY_MSG_SIGNATURE) || (msg.data_size > TELEMETRY_MSG_BUFFER_SIZE)) {
+            /* Not a message boundary, start over with the next write. */
+            m_commands.resize(0);
+            break;
+        }
+        if (m_commands.size() < TELEMETRY_MSG_HDR_SIZE + msg.data_size) {
+            break;
+        }
+        const char *msgData = m_commands.constData() + TELEMETRY_MSG_HDR_SIZE;
+        if ((msg.msg_id == 'S') && (msg.data_size >= 1)) {
+            appendEvent(CAPTURE_EVENT_CHANNEL, msg.msg_id, msgData, msg.data_size);
+        } else if (msg.msg_id == 'T') {
+            appendEvent(CAPTURE_EVENT_STREAM_START, msg.msg_id, msgData, msg.data_size);
+        } else if (msg.data_size || (msg.msg_id < 'a') || (msg.msg_id > 'z')) {
+            appendEvent(CAPTURE_EVENT_COMMAND, msg.msg_id, msgData, msg.data_size);
+        }
+        m_commands.remove(0, TELEMETRY_MSG_HDR_SIZE + msg.data_size);
+    }
+}
+
+/**
+ * @brief RecorderThread::addEvent
+ * @param type - CAPTURE_EVENT_*.
+ * @param msgId - telemetry message ID, 0 if none.
+ * @param data - event data.
+ * @param size - number of bytes, cut to CAPTURE_EVENT_DATA_MAX.
+ *
+ * @return false if no capture is being recorded.
+ *
+ * Indexes an event of a capture at the current time.
+ */
+bool RecorderThread::addEvent(int type, int msgId, const char *data, int size)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_recording || (m_format != FormatCapture)) {
+        return false;
+    }
+    appendEvent(type, msgId, data, size);
+    return true;
+}
+
+/**
+ * @brief RecorderThread::appendEvent
+ * Queues an event record, called with the mutex locked. The writer
+ * thread fills in the channel and the sample index.
+ */
+void RecorderThread::appendEvent(int type, int msgId, const char *data, int size)
+{
+    SampleRecord rec;
+    CaptureEvent event;
+
+    size = qBound(0, size, CAPTURE_EVENT_DATA_MAX);
+    if (m_pending.size() + (int)(sizeof(rec) + sizeof(event)) + size > RECORDER_BACKLOG_MAX) {
+        m_dropped++;
+        return;
+    }
+
+    rec.timestamp = m_clock.nsecsElapsed();
+    rec.channel = RECORDER_EVENT_RECORD;
+    rec.count = sizeof(event) + size;
+    memset((void *)&event, 0, sizeof(event));
+    event.timestamp = rec.timestamp;
+    event.type = type;
+    event.msg_id = msgId;
+    event.data_size = size;
+    m_pending.append((const char *)&rec, sizeof(rec));
+    m_pending.append((const char *)&event, sizeof(event));
+    m_pending.append(data, size);
+}
+
+/**
+ * @brief RecorderThread::run
+ */
+void RecorderThread::run()
+{
+    const bool capture = (m_format == FormatCapture);
+    CaptureWriter captureWriter;
+    CaptureEventWriter eventWriter;
+    QFile file(m_fileName);
+    QElapsedTimer statusTimer;
+    RecordingHeader hdr;
+    qint64 frames;
+    qint64 dropped;
+    bool quit;
+    bool ok;
+
+    if (capture) {
+        ok = captureWriter.open(m_fileName, m_startTime);
+        if (ok && !eventWriter.open(CaptureEventWriter::fileName(m_fileName), m_startTime)) {
+            emit this->recorderError(tr("Can't index the events of %1. %2.").arg(m_fileName)
+                .arg(eventWriter.errorString()));
+        }
+        m_eventChannel = STREAMING_CHANNEL_FE;
+    } else {
+        ok = file.open(QIODevice::ReadWrite | QIODevice::Truncate) && mapSegment(file, 0);
+    }
+    if (!ok) {
+        emit this->recorderError(tr("Can't record to %1. %2.").arg(m_fileName)
+            .arg(capture ? captureWriter.errorString() : file.errorString()));
+        m_mutex.lock();
+        m_recording = false;
+        m_pending.resize(0);
+        m_mutex.unlock();
+        return;
+    }
+
+    if (!capture) {
+        memset((void *)&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+        hdr.version = RECORDING_VERSION;
+        hdr.header_size = sizeof(hdr);
+        hdr.start_time = m_startTime;
+        writeData(file, (const char *)&hdr, sizeof(hdr));
+    }
+    statusTimer.start();
+
+    forever {
+        m_mutex.lock();
+        if (!m_quit && (m_pending.size() < RECORDER_BATCH_SIZE)) {
+            m_dataReady.wait(&m_mutex, RECORDER_FLUSH_MS);
+        }
+        /* Hand the batch over, the serial thread continues on the empty buffer. */
+        m_batch.swap(m_pending);
+        frames = m_frames;
+        dropped = m_dropped;
+        quit = m_quit;
+        m_mutex.unlock();
+
+        if (capture) {
+            ok = writeSamples(captureWriter, eventWriter);
+        } else {
+            ok = writeData(file, m_batch.constData(), m_batch.size());
+        }
+        if (!ok) {
+            emit this->recorderError(tr("Recording to %1 failed. %2.").arg(m_fileName)
+                .arg(capture ? captureWriter.errorString() : file.errorString()));
+            m_mutex.lock();
+            m_recording = false;
+            m_mutex.unlock();
+            quit = true;
+        }
+        m_batch.resize(0);
+
+        if (quit || (statusTimer.elapsed() >= RECORDER_STATUS_MS)) {
+            emit this->recorderStatus(capture ? captureWriter.size() : m_mapOffset + m_mapPos,
+                                      frames, dropped);
+            statusTimer.start();
+        }
+        if (quit) {
+            break;
+        }
+    }
+
+    if (!capture) {
+        finish(file);
+    } else {
+        if (!captureWriter.close() && ok) {
+            emit this->recorderError(tr("Recording to %1 failed. %2.").arg(m_fileName)
+                .arg(captureWriter.errorString()));
+        }
+        if (eventWriter.isOpen() && !eventWriter.close()) {
+            emit this->recorderError(tr("Indexing the events of %1 failed. %2.").arg(m_fileName)
+                .arg(eventWriter.errorString()));
+        }
+    }
+}
+
+/**
+ * @brief RecorderThread::mapSegment
+ * @param file - recording file.
+ * @param offset - file offset of the segment, multiple of RECORDER_SEGMENT_SIZE.
+ * @return false if the file could not be grown or mapped.
+ */
+bool RecorderThread::mapSegment(QFile &file, qint64 offset)
+{
+    if (m_map) {
+        file.unmap(m_map);
+        m_map = 0;
+    }
+    if (!file.resize(offset + RECORDER_SEGMENT_SIZE)) {
+        return false;
+    }
+    m_map = file.map(offset, RECORDER_SEGMENT_SIZE);
+    m_mapOffset = offset;
+    m_mapPos = 0;
+    return m_map != 0;
+}
+
+/**
+ * @brief RecorderThread::writeData
+ * @param file - recording file.
+ * @param data - bytes to append.
+ * @param size - number of bytes.
+ * @return false if the next segment could not be mapped.
+ */
+bool RecorderThread::writeData(QFile &file, const char *data, int size)
+{
+    while (size > 0) {
+        if (m_mapPos == RECORDER_SEGMENT_SIZE) {
+            if (!mapSegment(file, m_mapOffset + RECORDER_SEGMENT_SIZE)) {
+                return false;
+            }
+        }
+        const int n = qMin((qint64)size, RECORDER_SEGMENT_SIZE - m_mapPos);
+        memcpy(m_map + m_mapPos, data, n);
+        m_mapPos += n;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+/**
+ * @brief RecorderThread::writeSamples
+ * @param capture - capture the batch of sample records is added to.
+ * @param events - event index of the capture, skipped if not open.
+ * @return false if writing the capture failed.
+ *
+ * An event counts the samples of the channel that was streamed last,
+ * or of the channel it switches to.
+ */
+bool RecorderThread::writeSamples(CaptureWriter &capture, CaptureEventWriter &events)
+{
+    const char *p = m_batch.constData();
+    const char *end = p + m_batch.size();
+    SampleRecord rec;
+    CaptureEvent event;
+
+    while (p < end) {
+        memcpy((void *)&rec, p, sizeof(rec));
+        p += sizeof(rec);
+        if (rec.channel == RECORDER_EVENT_RECORD) {
+            memcpy((void *)&event, p, sizeof(event));
+            if ((event.type == CAPTURE_EVENT_CHANNEL) && event.data_size &&
+                ((quint8)p[sizeof(event)] < STREAMING_CHANNEL_COUNT)) {
+                m_eventChannel = (quint8)p[sizeof(event)];
+            }
+            event.channel = m_eventChannel;
+            event.sample = capture.sampleCount(m_eventChannel);
+            if (events.isOpen() && !events.addEvent(event, p + sizeof(event))) {
+                emit this->recorderError(tr("Indexing the events of %1 failed. %2.").arg(m_fileName)
+                    .arg(events.errorString()));
+                events.close();
+            }
+            p += rec.count;
+            continue;
+        }
+        m_eventChannel = rec.channel;
+        if (!capture.addSamples(rec.channel, (const qint16 *)p, rec.count, rec.timestamp)) {
+            return false;
+        }
+        p += rec.count * sizeof(qint16);
+    }
+    return true;
+}
+
+/**
+ * @brief RecorderThread::finish
+ * @param file - recording file, cut to the written size and closed.
+ */
+void RecorderThread::finish(QFile &file)
+{
+    if (m_map) {
+        file.unmap(m_map);
+        m_map = 0;
+    }
+    if (!file.resize(m_mapOffset + m_mapPos)) {
+        emit this->recorderError(tr("Can't truncate %1, it ends in unused space. %2.").arg(m_fileName)
+            .arg(file.errorString()));
+    }
+    file.close();
+    m_mapOffset = 0;
+    m_mapPos = 0;
+}
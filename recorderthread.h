@@ -0,0 +1,93 @@
+#ifndef RECORDERTHREAD_H
+#define RECORDERTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QFile>
+
+#include "telemetry.h"
+#include "recording.h"
+#include "capturewriter.h"
+#include "captureevents.h"
+
+/* Mapped file segment, grown in advance.  */
+#define RECORDER_SEGMENT_SIZE           (16 * 1024 * 1024)
+/* Pending bytes that wake the writer.     */
+#define RECORDER_BATCH_SIZE             (64 * 1024)
+/* Maximum time frames stay pending, ms.   */
+#define RECORDER_FLUSH_MS               100
+/* Pending bytes before frames are dropped.*/
+#define RECORDER_BACKLOG_MAX            (8 * 1024 * 1024)
+/* Interval between status signals, ms.    */
+#define RECORDER_STATUS_MS              1000
+/* Channel of the pending event records.   */
+#define RECORDER_EVENT_RECORD           -1
+
+/* Append-only recorder of the received telemetry messages. The serial
+ * thread only copies a message into the pending batch, the writer thread
+ * moves whole batches into a memory mapped segment of the file. In the
+ * capture format only the stream samples are kept, the writer thread
+ * compresses them into a CaptureWriter. The commands, period markers and
+ * notes of a capture go to its event index, in order with the samples so
+ * that every event gets its sample index.
+ */
+class RecorderThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Format {
+        FormatRecording,        /* Every message, see recording.h.  */
+        FormatCapture           /* Stream samples, see capture.h.   */
+    };
+
+    RecorderThread(QObject *parent = 0);
+    ~RecorderThread();
+
+    void startRecording(const QString &fileName, Format format = FormatRecording);
+    void stopRecording();
+    bool isRecording() const;
+    void addFrame(const TelemetryMessage &msg, const char *data);
+    void addSamples(int channel, const qint16 *samples, int count);
+    void addCommands(const char *data, int size);
+    bool addEvent(int type, int msgId, const char *data, int size);
+
+signals:
+    void recorderError(const QString &s);
+    void recorderStatus(qint64 bytes, qint64 frames, qint64 dropped);
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    bool mapSegment(QFile &file, qint64 offset);
+    bool writeData(QFile &file, const char *data, int size);
+    void appendEvent(int type, int msgId, const char *data, int size);
+    bool writeSamples(CaptureWriter &capture, CaptureEventWriter &events);
+    void finish(QFile &file);
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_dataReady;
+    QString m_fileName;
+    Format m_format;
+    bool m_recording;
+    bool m_quit;
+    QElapsedTimer m_clock;      /* Record timestamps.                   */
+    qint64 m_startTime;
+    QByteArray m_pending;       /* Records not handed to the writer.    */
+    qint64 m_frames;
+    qint64 m_dropped;
+    QByteArray m_commands;      /* Sent bytes not yet a whole message.  */
+    /* Writer thread state. */
+    QByteArray m_batch;
+    uchar *m_map;
+    qint64 m_mapOffset;         /* File offset of the mapped segment.   */
+    qint64 m_mapPos;            /* Write position within the segment.   */
+    int m_eventChannel;         /* Channel of the latest samples.       */
+};
+
+#endif // RECORDERTHREAD_H
@@ -0,0 +1,38 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <QtGlobal>
+
+/* Recording file signature.               */
+#define RECORDING_MAGIC                 "SMDREC1"
+/* Recording file format version.          */
+#define RECORDING_VERSION               2
+/* Record signature of sent command bytes. */
+#define RECORDING_COMMAND_SIGNATURE     0x55
+
+/* A recording is the file header followed by the received telemetry
+ * messages, each as a record header and the message data. Records are
+ * packed without padding in host byte order. Since version 2 a record
+ * may also hold bytes sent to the board, marked by the signature
+ * RECORDING_COMMAND_SIGNATURE. The file may end in zeros if the recorder
+ * did not stop cleanly, a record with any other signature marks the end.
+ * Readers start at header_size, a bundle (see bundle.h) keeps its
+ * settings snapshot between the header and the first record.
+ */
+typedef struct tagRecordingHeader {
+    char magic[8];          /* RECORDING_MAGIC, zero terminated.           */
+    quint32 version;        /* RECORDING_VERSION.                          */
+    quint32 header_size;    /* Offset of the first record.                 */
+    qint64 start_time;      /* Host time of record timestamp 0, ms since
+                             * 1970-01-01 UTC.                             */
+} __attribute__((packed)) RecordingHeader;
+
+typedef struct tagRecordHeader {
+    qint64 timestamp;       /* Host receive time since start_time, ns.     */
+    quint8 msg_id;          /* Telemetry message ID, 0 for commands.       */
+    quint8 signature;       /* Telemetry message signature or
+                             * RECORDING_COMMAND_SIGNATURE.                */
+    quint16 data_size;      /* Size of the data following the header.      */
+} __attribute__((packed)) RecordHeader;
+
+#endif // RECORDING_H
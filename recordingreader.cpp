@@ -0,0 +1,163 @@
+#include "recordingreader.h"
+#include "telemetry.h"
+
+#include <QObject>
+#include <algorithm>
+
+/**
+ * @brief RecordingReader::RecordingReader
+ */
+RecordingReader::RecordingReader() :
+    m_data(0),
+    m_end(0),
+    m_pos(0),
+    m_count(0),
+    m_duration(0)
+{
+    memset((void *)&m_header, 0, sizeof(m_header));
+}
+
+/**
+ * @brief RecordingReader::~RecordingReader
+ */
+RecordingReader::~RecordingReader()
+{
+    close();
+}
+
+/**
+ * @brief RecordingReader::open
+ * @param fileName - recording file.
+ * @return false if the file is not a recording, see errorString().
+ *
+ * Walks the record headers once to find the end of the records and to
+ * build the seek index.
+ */
+bool RecordingReader::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    const qint64 size = m_file.size();
+    if (size < (qint64)sizeof(RecordingHeader)) {
+        m_error = QObject::tr("Not a recording");
+        m_file.close();
+        return false;
+    }
+    m_data = m_file.map(0, size);
+    if (!m_data) {
+        m_error = m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    memcpy((void *)&m_header, m_data, sizeof(m_header));
+    if ((memcmp(m_header.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0) ||
+        (m_header.version < 1) || (m_header.version > RECORDING_VERSION) ||
+        (m_header.header_size < sizeof(m_header)) || (m_header.header_size > size)) {
+        m_error = QObject::tr("Not a recording or unsupported version");
+        close();
+        return false;
+    }
+
+    RecordHeader hdr;
+    m_end = size;
+    m_pos = m_header.header_size;
+    while (readHeader(m_pos, hdr)) {
+        if (m_count % RECORDING_INDEX_STEP == 0) {
+            m_indexOffset.append(m_pos);
+            m_indexTime.append(hdr.timestamp);
+        }
+        m_duration = hdr.timestamp;
+        m_pos += sizeof(hdr) + hdr.data_size;
+        m_count++;
+    }
+    /* Anything past the last complete record is padding or a cut off record. */
+    m_end = m_pos;
+    m_pos = m_header.header_size;
+    return true;
+}
+
+/**
+ * @brief RecordingReader::close
+ */
+void RecordingReader::close()
+{
+    if (m_data) {
+        m_file.unmap((uchar *)m_data);
+        m_data = 0;
+    }
+    m_file.close();
+    m_end = 0;
+    m_pos = 0;
+    m_count = 0;
+    m_duration = 0;
+    m_indexOffset.clear();
+    m_indexTime.clear();
+}
+
+/**
+ * @brief RecordingReader::seek
+ * @param timestamp - the next record is the first one at or after this time, ns.
+ */
+void RecordingReader::seek(qint64 timestamp)
+{
+    RecordHeader hdr;
+
+    if (!m_data) {
+        return;
+    }
+    /* Last index entry not after the timestamp, then record by record. */
+    const int i = std::upper_bound(m_indexTime.constBegin(), m_indexTime.constEnd(), timestamp) -
+                  m_indexTime.constBegin();
+    m_pos = (i > 0) ? m_indexOffset[i - 1] : m_header.header_size;
+    while (peek(hdr) && (hdr.timestamp < timestamp)) {
+        m_pos += sizeof(hdr) + hdr.data_size;
+    }
+}
+
+/**
+ * @brief RecordingReader::peek
+ * @param hdr - receives the header of the next record.
+ * @return false at the end of the records.
+ */
+bool RecordingReader::peek(RecordHeader &hdr) const
+{
+    return readHeader(m_pos, hdr);
+}
+
+/**
+ * @brief RecordingReader::next
+ * @param hdr - receives the header of the next record.
+ * @param data - receives the record data, valid until close().
+ * @return false at the end of the records.
+ */
+bool RecordingReader::next(RecordHeader &hdr, const char **data)
+{
+    if (!readHeader(m_pos, hdr)) {
+        return false;
+    }
+    *data = (const char *)m_data + m_pos + sizeof(hdr);
+    m_pos += sizeof(hdr) + hdr.data_size;
+    return true;
+}
+
+/**
+ * @brief RecordingReader::readHeader
+ * @return false if there is no valid record at the offset.
+ */
+bool RecordingReader::readHeader(qint64 offset, RecordHeader &hdr) const
+{
+    if (!m_data || (offset + (qint64)sizeof(hdr) > m_end)) {
+        return false;
+    }
+    memcpy((void *)&hdr, m_data + offset, sizeof(hdr));
+    return ((hdr.signature == TELEMETRY_MSG_SIGNATURE) ||
+            (hdr.signature == RECORDING_COMMAND_SIGNATURE)) &&
+           (hdr.data_size <= TELEMETRY_MSG_SIZE_BYTES_MAX) &&
+           (offset + (qint64)sizeof(hdr) + hdr.data_size <= m_end);
+}
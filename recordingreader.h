@@ -0,0 +1,51 @@
+#ifndef RECORDINGREADER_H
+#define RECORDINGREADER_H
+
+#include <QFile>
+#include <QVector>
+
+#include "recording.h"
+
+/* Records between seek index entries.     */
+#define RECORDING_INDEX_STEP            1024
+
+/* Sequential reader of a recording with seeking by time. The file is
+ * mapped as a whole, records are returned in place.
+ */
+class RecordingReader
+{
+public:
+    RecordingReader();
+    ~RecordingReader();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return m_data != 0; }
+    QString errorString() const { return m_error; }
+
+    qint64 startTime() const { return m_header.start_time; }
+    qint64 duration() const { return m_duration; }
+    qint64 recordCount() const { return m_count; }
+
+    void seek(qint64 timestamp);
+    bool peek(RecordHeader &hdr) const;
+    bool next(RecordHeader &hdr, const char **data);
+
+private:
+    bool readHeader(qint64 offset, RecordHeader &hdr) const;
+
+private:
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_end;               /* End of the complete records.     */
+    qint64 m_pos;               /* Offset of the next record.       */
+    RecordingHeader m_header;
+    qint64 m_count;
+    qint64 m_duration;          /* Timestamp of the last record.    */
+    /* Offset and timestamp of every RECORDING_INDEX_STEP-th record. */
+    QVector<qint64> m_indexOffset;
+    QVector<qint64> m_indexTime;
+    QString m_error;
+};
+
+#endif // RECORDINGREADER_H
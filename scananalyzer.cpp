@@ -0,0 +1,190 @@
+#include "scananalyzer.h"
+
+#include <qmath.h>
+#include <limits>
+
+/**
+ * @brief ScanAnalyzer::ScanAnalyzer
+ */
+ScanAnalyzer::ScanAnalyzer()
+{
+    reset();
+}
+
+/**
+ * @brief ScanAnalyzer::reset
+ * Drops the current and the pending sweeps, the next marker starts over.
+ */
+void ScanAnalyzer::reset()
+{
+    m_inSweep = false;
+    m_overflow = false;
+    m_sweep.clear();
+    m_doneSweeps.clear();
+    m_doneFeatures.clear();
+}
+
+/**
+ * @brief ScanAnalyzer::startSweep
+ * Called on a period marker. Completes the running sweep, the samples
+ * before the first marker are only a part of a sweep and are dropped.
+ */
+void ScanAnalyzer::startSweep()
+{
+    if (m_inSweep && !m_overflow && (m_sweep.size() >= SCAN_SWEEP_MIN)) {
+        ScanFeatures features;
+        analyze(m_sweep.constData(), m_sweep.size(), features);
+        if (m_doneSweeps.size() == SCAN_SWEEPS_PENDING_MAX) {
+            m_doneSweeps.remove(0);
+            m_doneFeatures.remove(0);
+        }
+        m_doneSweeps.append(m_sweep);
+        m_doneFeatures.append(features);
+    }
+
+    m_inSweep = true;
+    m_overflow = false;
+    m_sweep = QVector<double>();
+}
+
+/**
+ * @brief ScanAnalyzer::process
+ * @param samples - raw stream samples.
+ * @param count - number of samples.
+ */
+void ScanAnalyzer::process(const qint16 *samples, int count)
+{
+    appendSamples(samples, count);
+}
+
+/**
+ * @brief ScanAnalyzer::process
+ * @param samples - filtered stream samples.
+ * @param count - number of samples.
+ */
+void ScanAnalyzer::process(const double *samples, int count)
+{
+    appendSamples(samples, count);
+}
+
+/**
+ * @brief ScanAnalyzer::takeSweep
+ * @param sweep - receives the samples of the oldest analyzed sweep.
+ * @param features - receives its features.
+ * @return false if there is no analyzed sweep.
+ */
+bool ScanAnalyzer::takeSweep(QVector<double> &sweep, ScanFeatures &features)
+{
+    if (m_doneSweeps.isEmpty()) {
+        return false;
+    }
+    sweep = m_doneSweeps.first();
+    features = m_doneFeatures.first();
+    m_doneSweeps.remove(0);
+    m_doneFeatures.remove(0);
+    return true;
+}
+
+/**
+ * @brief ScanAnalyzer::appendSamples
+ */
+template <typename T>
+void ScanAnalyzer::appendSamples(const T *samples, int count)
+{
+    if (!m_inSweep || m_overflow) {
+        return;
+    }
+    if (m_sweep.size() + count > SCAN_SWEEP_MAX) {
+        /* No marker for too long, this is not a scan. */
+        m_overflow = true;
+        m_sweep = QVector<double>();
+        return;
+    }
+
+    m_sweep.reserve(m_sweep.size() + count);
+    for (int i = 0; i < count; i++) {
+        m_sweep.append(samples[i]);
+    }
+}
+
+/**
+ * @brief ScanAnalyzer::analyze
+ * @param x - samples of one sweep, starting at the period marker.
+ * @param n - number of samples.
+ * @param features - receives the S-curve features.
+ *
+ * The S-curve lies between the global maximum and minimum. Its zero
+ * crossing is interpolated between the two samples around it, the slope
+ * is a least squares fit over the samples around the crossing that stay
+ * within SCAN_SLOPE_BAND of the half peak-to-peak amplitude.
+ */
+void ScanAnalyzer::analyze(const double *x, int n, ScanFeatures &features)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    int iMax = 0;
+    int iMin = 0;
+
+    features.length = n;
+    features.zeroCrossing = nan;
+    features.zeroPosition = nan;
+    features.slope = nan;
+    features.valid = false;
+
+    for (int i = 1; i < n; i++) {
+        if (x[i] > x[iMax]) {
+            iMax = i;
+        }
+        if (x[i] < x[iMin]) {
+            iMin = i;
+        }
+    }
+    features.max = (n > 0) ? x[iMax] : nan;
+    features.min = (n > 0) ? x[iMin] : nan;
+    features.peakToPeak = features.max - features.min;
+    features.asymmetry = (features.peakToPeak > 0.0) ?
+                         (features.max + features.min) / features.peakToPeak : nan;
+    if (!(features.peakToPeak > 0.0)) {
+        return;
+    }
+
+    const int lo = qMin(iMax, iMin);
+    const int hi = qMax(iMax, iMin);
+    int a = -1;
+    for (int i = lo; i < hi; i++) {
+        if (((x[i] <= 0.0) && (x[i + 1] > 0.0)) || ((x[i] >= 0.0) && (x[i + 1] < 0.0))) {
+            a = i;
+            break;
+        }
+    }
+    if (a < 0) {
+        return;
+    }
+
+    features.zeroCrossing = a + x[a] / (x[a] - x[a + 1]);
+    features.zeroPosition = features.zeroCrossing / (n - 1);
+
+    const double band = SCAN_SLOPE_BAND * features.peakToPeak / 2.0;
+    int b = a + 1;
+    while ((a > lo) && (qAbs(x[a - 1]) <= band)) {
+        a--;
+    }
+    while ((b < hi) && (qAbs(x[b + 1]) <= band)) {
+        b++;
+    }
+
+    double sumT = 0.0;
+    double sumX = 0.0;
+    double sumTT = 0.0;
+    double sumTX = 0.0;
+    const int m = b - a + 1;
+    for (int i = a; i <= b; i++) {
+        /* Indices relative to a keep the sums well conditioned. */
+        double t = i - a;
+        sumT += t;
+        sumX += x[i];
+        sumTT += t * t;
+        sumTX += t * x[i];
+    }
+    features.slope = (m * sumTX - sumT * sumX) / (m * sumTT - sumT * sumT);
+    features.valid = true;
+}
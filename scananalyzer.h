@@ -0,0 +1,57 @@
+#ifndef SCANANALYZER_H
+#define SCANANALYZER_H
+
+#include <QMetaType>
+#include <QVector>
+
+/* Minimum samples of an analyzed sweep.   */
+#define SCAN_SWEEP_MIN                  16
+/* Maximum samples of an analyzed sweep.   */
+#define SCAN_SWEEP_MAX                  (1 << 20)
+/* Slope fit band, fraction of half p-p.   */
+#define SCAN_SLOPE_BAND                 0.5
+/* Completed sweeps kept until taken.      */
+#define SCAN_SWEEPS_PENDING_MAX         4
+
+typedef struct tagScanFeatures {
+    int length;             /* Sweep length, samples.                        */
+    double max;
+    double min;
+    double peakToPeak;
+    double zeroCrossing;    /* Zero crossing between the peaks, samples.     */
+    double zeroPosition;    /* Zero crossing relative to the sweep, 0 .. 1.  */
+    double slope;           /* Slope at the zero crossing, units per sample. */
+    double asymmetry;       /* (max + min) / (max - min), 0 if symmetric.    */
+    bool valid;             /* False if no zero crossing was found.          */
+} ScanFeatures;
+
+Q_DECLARE_METATYPE(ScanFeatures);
+
+/* Splits the stream into sweeps at the period markers ('.') of the board
+ * and extracts the S-curve features of every complete sweep.
+ */
+class ScanAnalyzer
+{
+public:
+    ScanAnalyzer();
+
+    void reset();
+    void startSweep();
+    void process(const qint16 *samples, int count);
+    void process(const double *samples, int count);
+    bool takeSweep(QVector<double> &sweep, ScanFeatures &features);
+
+    static void analyze(const double *x, int n, ScanFeatures &features);
+
+private:
+    template <typename T> void appendSamples(const T *samples, int count);
+
+private:
+    bool m_inSweep;         /* A marker was seen, samples belong to a sweep. */
+    bool m_overflow;
+    QVector<double> m_sweep;
+    QVector<QVector<double> > m_doneSweeps;
+    QVector<ScanFeatures> m_doneFeatures;
+};
+
+#endif // SCANANALYZER_H
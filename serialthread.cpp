@@ -7,6 +7,10 @@
 #define SERIAL_READ_TIMEOUT_MS          20
 #define SERIAL_READ_TIMEOUT_EXTRA_MS    10
 #define SERIAL_DISCONNECT_TIMEOUT_MS    5000
+#define SERIAL_RATE_INTERVAL_MS         1000
+#define SERIAL_REPLAY_WAIT_MS           20
+#define SERIAL_REPLAY_STATUS_MS         100
+#define SERIAL_REPLAY_BLOCKS_IN_FLIGHT  16
 
 QT_USE_NAMESPACE
 
@@ -16,9 +20,45 @@ QT_USE_NAMESPACE
  */
 SerialThread::SerialThread(QObject *parent) :
     QThread(parent),
-    m_quit(false)
+    m_quit(false),
+    m_plotBlockSize(PLOTTING_BUF_DEPTH_DEFAULT),
+    m_decType(Decimator::TypeBoxcar),
+    m_decRatio(DECIMATION_RATIO_DEFAULT),
+    m_decBlockSize(PLOTTING_BUF_DEPTH_DEFAULT),
+    m_decChanged(true),
+    m_filterActive(false),
+    m_filterRate(1.0),
+    m_filterBypass(0),
+    m_streamChannel(STREAMING_CHANNEL_FE),
+    m_filterChanged(false),
+    m_statsWindow(STREAMSTATS_WINDOW_DEFAULT),
+    m_statsChanged(false),
+    m_statsReset(false),
+    m_triggerEnabled(false),
+    m_trigSettings(m_trigger.settings()),
+    m_trigEnabled(false),
+    m_trigChanged(false),
+    m_trigArm(false),
+    m_multiMask(0),
+    m_multiChanged(false),
+    m_scanEnabled(false),
+    m_scanRequested(false),
+    m_scanChanged(false),
+    m_bodeMsgId('A'),
+    m_bodeRunning(false),
+    m_bodeSettings(m_bode.settings()),
+    m_bodeActuator(0),
+    m_bodeStart(false),
+    m_bodeStop(false),
+    m_recorder(0),
+    m_blackBox(0),
+    m_replaySpeed(1.0),
+    m_replayLoop(false),
+    m_replaySeekTo(0),
+    m_replaySeek(false)
 {
-    // Empty;
+    memset((void *)&m_link, 0, sizeof(m_link));
+    memset((void *)&m_linkShared, 0, sizeof(m_linkShared));
 }
 
 /**
@@ -39,9 +79,35 @@ void SerialThread::connect(const QString &portName)
 {
     m_mutex.lock();
     m_portName = portName;
+    m_replayFileName.clear();
     m_quit = false;
     m_txBuf.clear();
     m_rxBuf.clear();
+    resetPipeline();
+    m_mutex.unlock();
+
+    if (!isRunning()) {
+        start();
+    }
+}
+
+/**
+ * @brief SerialThread::replay
+ * @param fileName - recording played back instead of the serial port.
+ *
+ * Recorded messages take the path of received ones, from the framing on.
+ * Nothing is sent during a replay.
+ */
+void SerialThread::replay(const QString &fileName)
+{
+    m_mutex.lock();
+    m_replayFileName = fileName;
+    m_replaySeekTo = 0;
+    m_replaySeek = false;
+    m_quit = false;
+    m_txBuf.clear();
+    m_rxBuf.clear();
+    resetPipeline();
     m_mutex.unlock();
 
     if (!isRunning()) {
@@ -56,6 +122,7 @@ void SerialThread::disconnect()
 {
     m_mutex.lock();
     m_quit = true;
+    m_replayWake.wakeAll();
     m_mutex.unlock();
 
     if (!wait(SERIAL_DISCONNECT_TIMEOUT_MS)) {
@@ -68,6 +135,11 @@ void SerialThread::disconnect()
  */
 void SerialThread::run()
 {
+    if (!m_replayFileName.isEmpty()) {
+        runReplay();
+        return;
+    }
+
     QSerialPort serial;
 
     serial.setPortName(m_portName);
@@ -87,15 +159,26 @@ void SerialThread::run()
 
     /* Clear buffer. */
     (void)serial.readAll();
+    memset((void *)&m_link, 0, sizeof(m_link));
+    m_linkTimer.start();
 
     while (!m_quit) {
         /* Protect shared resources while thread is working. */
         m_mutex.lock();
+        m_link.connected_ms = m_linkTimer.elapsed();
+        m_linkShared = m_link;
 
         if (m_txBuf.size() > 0) {
             qint64 bytesWritten = serial.write(m_txBuf);
             if (serial.waitForBytesWritten(SERIAL_WRITE_TIMEOUT_MS)) {
+                if (m_blackBox && (bytesWritten > 0)) {
+                    m_blackBox->addCommand(m_txBuf.constData(), bytesWritten);
+                }
+                if (m_recorder && (bytesWritten > 0)) {
+                    m_recorder->addCommands(m_txBuf.constData(), bytesWritten);
+                }
                 m_txBuf.remove(0, bytesWritten);
+                m_link.bytes_sent += qMax(bytesWritten, (qint64)0);
             } else {
                 qDebug() << "Write request timeout!";
                 /* Unlock resources and exit. */
@@ -109,12 +192,15 @@ void SerialThread::run()
         m_mutex.unlock();
 
         if (serial.waitForReadyRead(SERIAL_READ_TIMEOUT_MS)) {
+            const int buffered = m_rxBuf.size();
             m_rxBuf += serial.readAll();
             while (serial.waitForReadyRead(SERIAL_READ_TIMEOUT_EXTRA_MS)) {
                 m_rxBuf += serial.readAll();
             }
+            m_link.bytes_received += m_rxBuf.size() - buffered;
 
             while (getMessage()) {
+                m_link.messages++;
                 processMessage();
             }
         }
@@ -135,6 +221,365 @@ void SerialThread::write(const QByteArray &ba)
     m_mutex.unlock();
 }
 
+/**
+ * @brief SerialThread::linkStatistics
+ * @return counters of the serial link as of the last poll of the port,
+ * zero before the first connection.
+ */
+LinkStatistics SerialThread::linkStatistics()
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_linkShared;
+}
+
+/**
+ * @brief SerialThread::setDecimation
+ * @param type - decimation filter applied to streamed samples.
+ * @param ratio - number of streamed samples per plotted sample.
+ * @param blockSize - number of plotted samples per streamDataReady() signal.
+ *
+ * Settings are applied by the serial thread before the next stream message.
+ */
+void SerialThread::setDecimation(Decimator::Type type, int ratio, int blockSize)
+{
+    m_mutex.lock();
+    m_decType = type;
+    m_decRatio = qBound(1, ratio, DECIMATOR_RATIO_MAX);
+    m_decBlockSize = qBound(1, blockSize, PLOTTING_BUF_DEPTH_MAX);
+    m_decChanged = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::setFilter
+ * @param sections - biquad sections applied to streamed samples before decimation.
+ * @param sampleRate - rate of the streamed samples, Hz.
+ * @param bypassMask - bit n set streams channel n unfiltered.
+ */
+void SerialThread::setFilter(const QVector<BiquadChain::Section> &sections, double sampleRate, quint8 bypassMask)
+{
+    m_mutex.lock();
+    m_filterSections = sections;
+    m_filterRate = sampleRate;
+    m_filterBypass = bypassMask;
+    m_filterChanged = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::setStreamChannel
+ * @param channel - channel ID the board was asked to stream.
+ */
+void SerialThread::setStreamChannel(int channel)
+{
+    m_mutex.lock();
+    m_streamChannel = channel;
+    m_filterChanged = true;
+    m_statsReset = true;
+    m_trigChanged = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::setStatisticsWindow
+ * @param samples - length of the sliding statistics window, stream samples.
+ */
+void SerialThread::setStatisticsWindow(int samples)
+{
+    m_mutex.lock();
+    m_statsWindow = samples;
+    m_statsChanged = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::resetStatistics
+ * Restarts both the sliding window and the session statistics.
+ */
+void SerialThread::resetStatistics()
+{
+    m_mutex.lock();
+    m_statsReset = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::setTrigger
+ * @param settings - trigger settings, sample counts refer to the undecimated stream.
+ * @param enabled - run the trigger on the stream.
+ */
+void SerialThread::setTrigger(const Trigger::Settings &settings, bool enabled)
+{
+    m_mutex.lock();
+    m_trigSettings = settings;
+    m_trigEnabled = enabled;
+    m_trigChanged = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::armTrigger
+ * Re-arms the trigger, e.g. after a single mode capture.
+ */
+void SerialThread::armTrigger()
+{
+    m_mutex.lock();
+    m_trigArm = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::setMultiChannel
+ * @param mask - channels streamed at once in 'm' messages, bit n is channel n.
+ */
+void SerialThread::setMultiChannel(quint8 mask)
+{
+    m_mutex.lock();
+    m_multiMask = mask;
+    m_multiChanged = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::setScanAnalysis
+ * @param enabled - split the stream into sweeps at the period markers and
+ * analyze every sweep.
+ */
+void SerialThread::setScanAnalysis(bool enabled)
+{
+    m_mutex.lock();
+    m_scanRequested = enabled;
+    m_scanChanged = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::startBode
+ * @param settings - excitation and frequency range of the measurement.
+ * @param actuator - excited actuator, 0 FOC, 1 RAD, 2 FBK.
+ *
+ * The measurement runs with the stream, one actuator command is sent per
+ * stream message.
+ */
+void SerialThread::startBode(const BodeAnalyzer::Settings &settings, int actuator)
+{
+    m_mutex.lock();
+    m_bodeSettings = settings;
+    m_bodeActuator = qBound(0, actuator, 2);
+    m_bodeStart = true;
+    m_bodeStop = false;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::stopBode
+ * Aborts the measurement, the actuator returns to the offset.
+ */
+void SerialThread::stopBode()
+{
+    m_mutex.lock();
+    m_bodeStart = false;
+    m_bodeStop = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::setRecorder
+ * @param recorder - receives every complete message, 0 for none. Set it
+ * while the thread is not running.
+ */
+void SerialThread::setRecorder(RecorderThread *recorder)
+{
+    m_recorder = recorder;
+}
+
+/**
+ * @brief SerialThread::setBlackBox
+ * @param blackBox - receives the messages and commands exchanged with the
+ * board, not the replayed ones, 0 for none. Set it while the thread is
+ * not running.
+ */
+void SerialThread::setBlackBox(BlackBox *blackBox)
+{
+    m_blackBox = blackBox;
+}
+
+/**
+ * @brief SerialThread::setReplaySpeed
+ * @param speed - recording time per wall time, 0 replays as fast as the
+ * GUI takes the stream blocks.
+ */
+void SerialThread::setReplaySpeed(double speed)
+{
+    m_mutex.lock();
+    m_replaySpeed = qMax(0.0, speed);
+    m_replayWake.wakeAll();
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::setReplayLoop
+ * @param loop - restart the replay at the end of the recording.
+ */
+void SerialThread::setReplayLoop(bool loop)
+{
+    m_mutex.lock();
+    m_replayLoop = loop;
+    m_replayWake.wakeAll();
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::seekReplay
+ * @param timestamp - recording time to continue the replay at, ns.
+ */
+void SerialThread::seekReplay(qint64 timestamp)
+{
+    m_mutex.lock();
+    m_replaySeekTo = qMax(Q_INT64_C(0), timestamp);
+    m_replaySeek = true;
+    m_replayWake.wakeAll();
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SerialThread::streamDataDone
+ * Called by the receiver once per streamDataReady() and
+ * multiStreamDataReady() block it processed.
+ */
+void SerialThread::streamDataDone()
+{
+    m_blocksInFlight.deref();
+    m_replayWake.wakeAll();
+}
+
+/**
+ * @brief SerialThread::resetPipeline
+ * Starts the processing over with empty decimation and filter state, call
+ * with m_mutex held.
+ */
+void SerialThread::resetPipeline()
+{
+    m_decChanged = true;
+    m_filterChanged = true;
+    m_statsReset = true;
+    m_trigChanged = true;
+    m_multiChanged = true;
+    m_scanChanged = true;
+    m_bodeStart = false;
+    m_bodeStop = true;
+}
+
+/**
+ * @brief SerialThread::runReplay
+ *
+ * Records are paced by their timestamps scaled by the replay speed. At
+ * the maximum speed the thread only waits for the GUI to take the stream
+ * blocks, the replay then measures the throughput of the whole pipeline.
+ */
+void SerialThread::runReplay()
+{
+    RecordingReader reader;
+    RecordHeader hdr;
+    TelemetryMessage wire;
+    const char *data;
+    QElapsedTimer clock;        /* Wall time since the recording was at base. */
+    QElapsedTimer statusTimer;
+    qint64 base = 0;
+    qint64 position = 0;
+    qint64 statusPosition = 0;
+    double speed = -1.0;
+    bool finished = false;
+
+    if (!reader.open(m_replayFileName)) {
+        emit this->serialError(tr("Can't replay %1. %2.").arg(m_replayFileName).arg(reader.errorString()));
+        return;
+    }
+
+    clock.start();
+    statusTimer.start();
+    while (!m_quit) {
+        m_mutex.lock();
+        m_txBuf.clear();
+        if (m_replaySeek) {
+            reader.seek(m_replaySeekTo);
+            position = m_replaySeekTo;
+            statusPosition = position;
+            base = position;
+            clock.start();
+            m_rxBuf.clear();
+            resetPipeline();
+            m_replaySeek = false;
+            finished = false;
+        }
+        if (m_replaySpeed != speed) {
+            speed = m_replaySpeed;
+            base = position;
+            clock.start();
+        }
+        const bool loop = m_replayLoop;
+        m_mutex.unlock();
+
+        if (!reader.peek(hdr)) {
+            if (loop && (reader.recordCount() > 0)) {
+                seekReplay(0);
+                continue;
+            }
+            if (!finished) {
+                emit this->replayPosition(reader.duration(), reader.duration(), 0.0);
+                emit this->replayFinished();
+                finished = true;
+            }
+            m_mutex.lock();
+            if (!m_quit && !m_replaySeek) {
+                m_replayWake.wait(&m_mutex, SERIAL_REPLAY_WAIT_MS);
+            }
+            m_mutex.unlock();
+            continue;
+        }
+
+        /* Wait for the due time of the record, or for the GUI at full speed. */
+        qint64 waitMs = 0;
+        if (speed > 0.0) {
+            waitMs = ((qint64)((hdr.timestamp - base) / speed) - clock.nsecsElapsed()) / 1000000;
+        } else if (m_blocksInFlight.load() >= SERIAL_REPLAY_BLOCKS_IN_FLIGHT) {
+            waitMs = SERIAL_REPLAY_WAIT_MS;
+        }
+        if (waitMs > 0) {
+            m_mutex.lock();
+            if (!m_quit && !m_replaySeek) {
+                m_replayWake.wait(&m_mutex, qMin(waitMs, (qint64)SERIAL_REPLAY_WAIT_MS));
+            }
+            m_mutex.unlock();
+            continue;
+        }
+
+        reader.next(hdr, &data);
+        position = hdr.timestamp;
+        if (hdr.signature != TELEMETRY_MSG_SIGNATURE) {
+            /* Commands sent to the board, nothing to process. */
+            continue;
+        }
+        /* Back to the wire format, the framing runs on it as on serial data. */
+        wire.msg_id = hdr.msg_id;
+        wire.signature = hdr.signature;
+        wire.data_size = hdr.data_size;
+        m_rxBuf.append((const char *)&wire, TELEMETRY_MSG_HDR_SIZE);
+        m_rxBuf.append(data, hdr.data_size);
+        while (getMessage()) {
+            processMessage();
+        }
+
+        if (statusTimer.elapsed() >= SERIAL_REPLAY_STATUS_MS) {
+            const double achieved = (double)(position - statusPosition) / statusTimer.nsecsElapsed();
+            emit this->replayPosition(position, reader.duration(), achieved);
+            statusPosition = position;
+            statusTimer.start();
+        }
+    }
+}
+
 /**
  * @brief SerialThread::getMessage
  * @return
@@ -154,6 +599,7 @@ bool SerialThread::getMessage()
              * Drop the message, clear the input buffer and start all over again.
              */
             m_rxBuf.clear();
+            m_link.incomplete++;
             qDebug() << "Message still not comlete!";
         }
     } else if (m_rxBuf.size() >= TELEMETRY_MSG_HDR_SIZE) {
@@ -174,6 +620,7 @@ bool SerialThread::getMessage()
         } else {
             /* Corrupted header received. Clear input buffer. */
             m_rxBuf.clear();
+            m_link.corrupt_headers++;
             qDebug() << "Message header corrupted!";
         }
     }
@@ -181,21 +628,102 @@ bool SerialThread::getMessage()
     return false;
 }
 
+/**
+ * @brief SerialThread::applyPendingSettings
+ * Takes over the settings requested by the GUI thread since the last
+ * stream message.
+ */
+void SerialThread::applyPendingSettings()
+{
+    m_mutex.lock();
+    if (m_decChanged) {
+        m_decimator.configure(m_decType, m_decRatio);
+        m_multi.configure(m_decType, m_decRatio);
+        m_plotBlockSize = m_decBlockSize;
+        m_plotBuf.clear();
+        m_decChanged = false;
+    }
+    if (m_filterChanged) {
+        /* New channel or new sections, old filter state does not apply. */
+        m_filter.setSections(m_filterSections, m_filterRate);
+        m_filterActive = !m_filter.isEmpty() && !(m_filterBypass & (1 << m_streamChannel));
+        m_decimator.reset();
+        m_filterChanged = false;
+    }
+    if (m_statsChanged) {
+        m_stats.setWindow(m_statsWindow);
+        m_statsChanged = false;
+    }
+    if (m_statsReset) {
+        m_stats.reset();
+        m_statsTimer.start();
+        m_statsReset = false;
+    }
+    if (m_trigChanged) {
+        m_trigger.setSettings(m_trigSettings);
+        m_triggerEnabled = m_trigEnabled;
+        m_trigChanged = false;
+    }
+    if (m_trigArm) {
+        m_trigger.arm();
+        m_trigArm = false;
+    }
+    if (m_multiChanged) {
+        m_multi.setChannels(m_multiMask);
+        for (int i = 0; i < STREAMING_CHANNEL_COUNT; i++) {
+            m_rateBase[i] = 0;
+        }
+        m_rateTimer.start();
+        m_multiChanged = false;
+    }
+    if (m_scanChanged) {
+        m_scanEnabled = m_scanRequested;
+        m_scan.reset();
+        m_scanChanged = false;
+    }
+    if (m_bodeStop) {
+        m_bode.stop();
+        m_bodeStop = false;
+    }
+    if (m_bodeStart) {
+        m_bode.start(m_bodeSettings);
+        m_bodeMsgId = 'A' + m_bodeActuator;
+        m_bodeRunning = true;
+        m_bodeStart = false;
+    }
+    m_mutex.unlock();
+}
+
 /**
  * @brief SerialThread::processMessage
  */
 void SerialThread::processMessage()
 {
-    qint16 *pBuf16;
+    const qint16 *pBuf16;
     int numPts;
-    static QVector<double> y(PLOTTING_BUF_DEPTH);
-    static qint32 avgAccum = 0;
-    static int avgCnt = 0;
-    static int bufCnt = 0;
-    bool fBufReady = false;
+
+    if (m_recorder) {
+        /* The data is still at the start of the buffer, nothing consumed it yet. */
+        m_recorder->addFrame(m_msg, m_rxBuf.constData());
+    }
+    if (m_blackBox && m_replayFileName.isEmpty()) {
+        m_blackBox->addFrame(m_msg, m_rxBuf.constData());
+    }
 
     switch (m_msg.msg_id) {
     case '.':
+        if (m_msg.data_size == 0) {
+            /* Period marker, the next stream sample starts a new sweep. */
+            applyPendingSettings();
+            if (m_scanEnabled) {
+                m_scan.startSweep();
+                while (m_scan.takeSweep(m_scanSweep, m_scanFeatures)) {
+                    emit this->scanSweepReady(m_scanSweep, m_scanFeatures);
+                }
+            }
+        }
+        /* The GUI gets the marker as well. */
+        Q_FALLTHROUGH();
     case 'a':
     case 'b':
     case 'c':
@@ -209,27 +737,73 @@ void SerialThread::processMessage()
         break;
     case 'r':
     case 's':
-        pBuf16 = (qint16 *)m_rxBuf.constData();
+        applyPendingSettings();
+
+        pBuf16 = (const qint16 *)m_rxBuf.constData();
         numPts = m_msg.data_size / 2;
-        for (int i = 0; i < numPts; i++) {
-            avgAccum += pBuf16[i];
-            avgCnt++;
-            avgCnt %= AVG_COUNTER_MAX;
-            if (avgCnt == 0) {
-                y[bufCnt++] = avgAccum / AVG_COUNTER_MAX;
-                avgAccum = 0;
-                bufCnt %= PLOTTING_BUF_DEPTH;
-                if (bufCnt == 0) {
-                    fBufReady = true;
-                }
+        if (m_recorder) {
+            m_recorder->addSamples(m_streamChannel, pBuf16, numPts);
+        }
+        if (m_filterActive) {
+            m_filterBuf.resize(numPts);
+            for (int i = 0; i < numPts; i++) {
+                m_filterBuf[i] = pBuf16[i];
+            }
+            m_filter.process(m_filterBuf.data(), numPts);
+            m_stats.add(m_filterBuf.constData(), numPts);
+            if (m_scanEnabled) {
+                m_scan.process(m_filterBuf.constData(), numPts);
             }
+            if (m_triggerEnabled) {
+                m_trigger.process(m_filterBuf.constData(), numPts);
+            }
+            m_bode.process(m_filterBuf.constData(), numPts);
+            m_decimator.process(m_filterBuf.constData(), numPts, m_plotBuf);
+        } else {
+            m_stats.add(pBuf16, numPts);
+            if (m_scanEnabled) {
+                m_scan.process(pBuf16, numPts);
+            }
+            if (m_triggerEnabled) {
+                m_trigger.process(pBuf16, numPts);
+            }
+            m_bode.process(pBuf16, numPts);
+            m_decimator.process(pBuf16, numPts, m_plotBuf);
         }
         m_rxBuf.remove(0, m_msg.data_size);
-        if (fBufReady) {
-            if (bufCnt) {
-                qDebug() << "Buffer size mismatch:" << bufCnt;
+        processBode();
+        while (m_plotBuf.size() >= m_plotBlockSize) {
+            m_blocksInFlight.ref();
+            emit this->streamDataReady(m_plotBuf.mid(0, m_plotBlockSize));
+            m_plotBuf.remove(0, m_plotBlockSize);
+        }
+        while (m_trigger.takeCapture(m_capture)) {
+            emit this->triggerCaptured(m_capture.samples, m_capture.preSamples, m_capture.forced);
+        }
+        if (!m_statsTimer.isValid() || m_statsTimer.elapsed() >= STREAMSTATS_UPDATE_MS) {
+            publishStatistics();
+            m_statsTimer.start();
+        }
+        break;
+    case 'm':
+        applyPendingSettings();
+
+        if (m_multi.process(m_rxBuf.constData(), m_msg.data_size)) {
+            if (m_recorder) {
+                recordMultiStream();
+            }
+            for (int i = 0; i < m_multi.channelCount(); i++) {
+                QVector<double> &out = m_multi.output(i);
+                while (out.size() >= m_plotBlockSize) {
+                    m_blocksInFlight.ref();
+                    emit this->multiStreamDataReady(m_multi.channelId(i), out.mid(0, m_plotBlockSize));
+                    out.remove(0, m_plotBlockSize);
+                }
             }
-            emit this->streamDataReady(y);
+        }
+        m_rxBuf.remove(0, m_msg.data_size);
+        if (m_rateTimer.elapsed() >= SERIAL_RATE_INTERVAL_MS) {
+            publishRates();
         }
         break;
     default:
@@ -238,3 +812,83 @@ void SerialThread::processMessage()
         break;
     }
 }
+
+/**
+ * @brief SerialThread::publishStatistics
+ */
+void SerialThread::publishStatistics()
+{
+    StreamStatistics session;
+    StreamStatistics window;
+
+    m_stats.session(session);
+    m_stats.window(window);
+    emit this->statisticsReady(session, window);
+}
+
+/**
+ * @brief SerialThread::publishRates
+ * Emits the raw sample rate of every channel of the multi-channel stream.
+ */
+void SerialThread::publishRates()
+{
+    QVector<double> rates(STREAMING_CHANNEL_COUNT, 0.0);
+    const double seconds = m_rateTimer.restart() / 1000.0;
+
+    for (int i = 0; i < m_multi.channelCount(); i++) {
+        const int id = m_multi.channelId(i);
+        rates[id] = (m_multi.sampleCount(i) - m_rateBase[id]) / seconds;
+        m_rateBase[id] = m_multi.sampleCount(i);
+    }
+    emit this->multiStreamRates(rates);
+}
+
+/**
+ * @brief SerialThread::recordMultiStream
+ * Passes the samples of the processed 'm' message to the recorder, they
+ * end at the ring position and may wrap around.
+ */
+void SerialThread::recordMultiStream()
+{
+    const int frames = (m_msg.data_size - MULTISTREAM_HDR_SIZE) /
+                       (m_multi.channelCount() * (int)sizeof(qint16));
+    const int start = (m_multi.ringPos() - frames + MULTISTREAM_RING_DEPTH) % MULTISTREAM_RING_DEPTH;
+    const int n = qMin(frames, MULTISTREAM_RING_DEPTH - start);
+
+    for (int i = 0; i < m_multi.channelCount(); i++) {
+        const qint16 *ring = m_multi.ring(i);
+        m_recorder->addSamples(m_multi.channelId(i), ring + start, n);
+        if (frames > n) {
+            m_recorder->addSamples(m_multi.channelId(i), ring, frames - n);
+        }
+    }
+}
+
+/**
+ * @brief SerialThread::processBode
+ * Queues the next excitation command ahead of any result, the actuator
+ * moves on while the finished points are published.
+ */
+void SerialThread::processBode()
+{
+    TelemetryMessage msg;
+    quint16 position;
+    BodePoint point;
+
+    if (m_bode.takeCommand(position)) {
+        msg.msg_id    = m_bodeMsgId;
+        msg.signature = TELEMETRY_MSG_SIGNATURE;
+        msg.data_size = sizeof(position);
+        memcpy((void *)msg.data, (void *)&position, msg.data_size);
+        m_mutex.lock();
+        m_txBuf.append((const char *)&msg, msg.data_size + TELEMETRY_MSG_HDR_SIZE);
+        m_mutex.unlock();
+    }
+    while (m_bode.takePoint(point)) {
+        emit this->bodePointReady(point);
+    }
+    if (m_bodeRunning && !m_bode.isRunning()) {
+        m_bodeRunning = false;
+        emit this->bodeFinished();
+    }
+}
@@ -3,8 +3,21 @@
 
 #include <QThread>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QElapsedTimer>
 
 #include "telemetry.h"
+#include "decimator.h"
+#include "biquad.h"
+#include "streamstats.h"
+#include "trigger.h"
+#include "multistream.h"
+#include "scananalyzer.h"
+#include "bodeanalyzer.h"
+#include "recorderthread.h"
+#include "recordingreader.h"
+#include "blackbox.h"
 
 class SerialThread : public QThread
 {
@@ -15,8 +28,27 @@ public:
     ~SerialThread();
 
     void connect(const QString &portName);
+    void replay(const QString &fileName);
     void disconnect();
     void write(const QByteArray &ba);
+    void setDecimation(Decimator::Type type, int ratio, int blockSize);
+    void setFilter(const QVector<BiquadChain::Section> &sections, double sampleRate, quint8 bypassMask);
+    void setStreamChannel(int channel);
+    void setStatisticsWindow(int samples);
+    void resetStatistics();
+    void setTrigger(const Trigger::Settings &settings, bool enabled);
+    void armTrigger();
+    void setMultiChannel(quint8 mask);
+    void setScanAnalysis(bool enabled);
+    void startBode(const BodeAnalyzer::Settings &settings, int actuator);
+    void stopBode();
+    void setRecorder(RecorderThread *recorder);
+    void setBlackBox(BlackBox *blackBox);
+    void setReplaySpeed(double speed);
+    void setReplayLoop(bool loop);
+    void seekReplay(qint64 timestamp);
+    void streamDataDone();
+    LinkStatistics linkStatistics();
 
 protected:
     void run() Q_DECL_OVERRIDE;
@@ -26,10 +58,26 @@ signals:
     void serialTimeout(const QString &s);
     void serialDataReady(const TelemetryMessage &msg);
     void streamDataReady(QVector<double> y);
+    void statisticsReady(const StreamStatistics &session, const StreamStatistics &window);
+    void triggerCaptured(QVector<double> samples, int preSamples, bool forced);
+    void multiStreamDataReady(int channel, QVector<double> y);
+    void multiStreamRates(QVector<double> samplesPerSecond);
+    void scanSweepReady(QVector<double> sweep, const ScanFeatures &features);
+    void bodePointReady(const BodePoint &point);
+    void bodeFinished();
+    void replayPosition(qint64 position, qint64 duration, double speed);
+    void replayFinished();
 
 private:
+    void runReplay();
+    void resetPipeline();
     bool getMessage();
     void processMessage();
+    void applyPendingSettings();
+    void publishStatistics();
+    void publishRates();
+    void processBode();
+    void recordMultiStream();
 
 private:
     QString m_portName;
@@ -38,6 +86,74 @@ private:
     QByteArray m_rxBuf;
     TelemetryMessage m_msg;
     bool m_quit;
+    Decimator m_decimator;
+    QVector<double> m_plotBuf;
+    int m_plotBlockSize;
+    /* Decimation settings requested by GUI thread, guarded by m_mutex. */
+    Decimator::Type m_decType;
+    int m_decRatio;
+    int m_decBlockSize;
+    bool m_decChanged;
+    BiquadChain m_filter;
+    QVector<double> m_filterBuf;
+    bool m_filterActive;
+    /* Filter settings requested by GUI thread, guarded by m_mutex. */
+    QVector<BiquadChain::Section> m_filterSections;
+    double m_filterRate;
+    quint8 m_filterBypass;  /* Bit n set bypasses the filter on channel n. */
+    int m_streamChannel;
+    bool m_filterChanged;
+    StreamStats m_stats;
+    QElapsedTimer m_statsTimer;
+    /* Statistics settings requested by GUI thread, guarded by m_mutex. */
+    int m_statsWindow;
+    bool m_statsChanged;
+    bool m_statsReset;
+    Trigger m_trigger;
+    Trigger::Capture m_capture;
+    bool m_triggerEnabled;
+    /* Trigger settings requested by GUI thread, guarded by m_mutex. */
+    Trigger::Settings m_trigSettings;
+    bool m_trigEnabled;
+    bool m_trigChanged;
+    bool m_trigArm;
+    MultiStream m_multi;
+    QElapsedTimer m_rateTimer;
+    qint64 m_rateBase[STREAMING_CHANNEL_COUNT];
+    /* Multi-channel selection requested by GUI thread, guarded by m_mutex. */
+    quint8 m_multiMask;
+    bool m_multiChanged;
+    ScanAnalyzer m_scan;
+    bool m_scanEnabled;
+    QVector<double> m_scanSweep;
+    ScanFeatures m_scanFeatures;
+    /* Scan analysis state requested by GUI thread, guarded by m_mutex. */
+    bool m_scanRequested;
+    bool m_scanChanged;
+    BodeAnalyzer m_bode;
+    quint8 m_bodeMsgId;     /* Actuator command of the running measurement. */
+    bool m_bodeRunning;
+    /* Measurement requested by GUI thread, guarded by m_mutex. */
+    BodeAnalyzer::Settings m_bodeSettings;
+    int m_bodeActuator;
+    bool m_bodeStart;
+    bool m_bodeStop;
+    RecorderThread *m_recorder;
+    BlackBox *m_blackBox;
+    /* Stream blocks emitted and not yet taken by the GUI, paces replay. */
+    QAtomicInt m_blocksInFlight;
+    /* Link counters of the serial thread, copied to m_linkShared under
+     * m_mutex for linkStatistics(). */
+    LinkStatistics m_link;
+    LinkStatistics m_linkShared;
+    QElapsedTimer m_linkTimer;
+    QWaitCondition m_replayWake;
+    /* Replay requested by GUI thread, guarded by m_mutex. */
+    QString m_replayFileName;   /* Replaces the serial port if not empty. */
+    double m_replaySpeed;       /* Recording time per wall time, 0 for no pacing. */
+    bool m_replayLoop;
+    qint64 m_replaySeekTo;
+    bool m_replaySeek;
 };
 
 #endif // SERIALTHREAD_H
@@ -0,0 +1,359 @@
+#include "spectrumthread.h"
+
+#include <QElapsedTimer>
+#include <qmath.h>
+
+/**
+ * @brief SpectrumThread::SpectrumThread
+ * @param parent
+ */
+SpectrumThread::SpectrumThread(QObject *parent) :
+    QThread(parent),
+    m_settingsChanged(true),
+    m_resetAveraging(false),
+    m_quit(true),
+    m_windowSum(1.0),
+    m_samplesPos(0),
+    m_avgCnt(0),
+    m_avgValid(false),
+    m_newFrames(0)
+{
+    m_settings.fftSize = SPECTRUM_FFT_SIZE_DEFAULT;
+    m_settings.window = WindowHann;
+    m_settings.overlap = SPECTRUM_OVERLAP_DEFAULT;
+    m_settings.averaging = AveragingExponential;
+    m_settings.averages = SPECTRUM_AVERAGES_DEFAULT;
+    m_settings.scale = ScaleDb;
+    m_settings.sampleRate = 1.0;
+    m_settings.updateMs = SPECTRUM_UPDATE_MS_DEFAULT;
+    m_active = m_settings;
+    m_active.fftSize = 0;
+}
+
+/**
+ * @brief SpectrumThread::~SpectrumThread
+ */
+SpectrumThread::~SpectrumThread()
+{
+    if (isRunning()) {
+        stopAnalysis();
+    }
+}
+
+/**
+ * @brief SpectrumThread::startAnalysis
+ */
+void SpectrumThread::startAnalysis()
+{
+    m_mutex.lock();
+    m_quit = false;
+    m_input.clear();
+    m_settingsChanged = true;
+    m_mutex.unlock();
+
+    if (!isRunning()) {
+        /* Worker state is idle, force a full rebuild on the first frame. */
+        m_active.fftSize = 0;
+        start(QThread::LowPriority);
+    }
+}
+
+/**
+ * @brief SpectrumThread::stopAnalysis
+ */
+void SpectrumThread::stopAnalysis()
+{
+    m_mutex.lock();
+    m_quit = true;
+    m_dataReady.wakeOne();
+    m_mutex.unlock();
+
+    wait();
+}
+
+/**
+ * @brief SpectrumThread::setSettings
+ * @param settings - analysis settings, applied before the next frame.
+ */
+void SpectrumThread::setSettings(const Settings &settings)
+{
+    m_mutex.lock();
+    m_settings = settings;
+    m_settings.fftSize = qBound(FFT_SIZE_MIN, settings.fftSize, FFT_SIZE_MAX);
+    m_settings.overlap = qBound(0, settings.overlap, SPECTRUM_OVERLAP_MAX);
+    m_settings.averages = qMax(1, settings.averages);
+    m_settings.sampleRate = qMax(1e-6, settings.sampleRate);
+    m_settings.updateMs = qMax(1, settings.updateMs);
+    m_settingsChanged = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SpectrumThread::settings
+ * @return most recently requested settings.
+ */
+SpectrumThread::Settings SpectrumThread::settings() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_settings;
+}
+
+/**
+ * @brief SpectrumThread::resetAveraging
+ */
+void SpectrumThread::resetAveraging()
+{
+    m_mutex.lock();
+    m_resetAveraging = true;
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SpectrumThread::addSamples
+ * @param y - new samples. May be called from any thread, only queues the data.
+ */
+void SpectrumThread::addSamples(QVector<double> y)
+{
+    m_mutex.lock();
+    if (!m_quit) {
+        m_input += y;
+        /* Drop the oldest samples if the worker does not keep up. */
+        int limit = m_settings.fftSize * SPECTRUM_BACKLOG_FRAMES;
+        if (m_input.size() > limit) {
+            m_input.remove(0, m_input.size() - limit);
+        }
+        m_dataReady.wakeOne();
+    }
+    m_mutex.unlock();
+}
+
+/**
+ * @brief SpectrumThread::run
+ */
+void SpectrumThread::run()
+{
+    QElapsedTimer updateTimer;
+
+    updateTimer.start();
+
+    forever {
+        m_mutex.lock();
+        if (!m_quit && m_input.isEmpty()) {
+            m_dataReady.wait(&m_mutex, m_active.updateMs);
+        }
+        if (m_quit) {
+            m_mutex.unlock();
+            break;
+        }
+
+        bool changed = m_settingsChanged;
+        Settings settings = m_settings;
+        m_settingsChanged = false;
+        bool reset = m_resetAveraging;
+        m_resetAveraging = false;
+
+        m_samples += m_input;
+        m_input.clear();
+        m_mutex.unlock();
+
+        if (changed) {
+            applySettings(settings);
+        }
+        if (reset) {
+            m_avgCnt = 0;
+            m_avgValid = false;
+        }
+
+        const int fftSize = m_active.fftSize;
+        const int hop = qMax(1, fftSize * (100 - m_active.overlap) / 100);
+
+        /* Skip ahead instead of falling behind real time. */
+        int backlog = fftSize * SPECTRUM_BACKLOG_FRAMES;
+        if (m_samples.size() - m_samplesPos > backlog) {
+            m_samplesPos = m_samples.size() - backlog;
+        }
+
+        while (m_samples.size() - m_samplesPos >= fftSize) {
+            processFrame(m_samples.constData() + m_samplesPos);
+            m_samplesPos += hop;
+        }
+
+        if (m_samplesPos > 0) {
+            int consumed = qMin(m_samplesPos, m_samples.size());
+            m_samples.remove(0, consumed);
+            m_samplesPos -= consumed;
+        }
+
+        if (m_newFrames && (updateTimer.elapsed() >= m_active.updateMs)) {
+            publish();
+            m_newFrames = 0;
+            updateTimer.restart();
+        }
+    }
+}
+
+/**
+ * @brief SpectrumThread::applySettings
+ * @param settings - settings to be used by the worker from now on.
+ */
+void SpectrumThread::applySettings(const Settings &settings)
+{
+    bool newFrame = (settings.fftSize != m_active.fftSize) ||
+                    (settings.window != m_active.window);
+    bool newData = (settings.fftSize != m_active.fftSize) ||
+                   (settings.sampleRate != m_active.sampleRate);
+    bool newAvg = newFrame || newData ||
+                  (settings.averaging != m_active.averaging) ||
+                  (settings.averages != m_active.averages);
+
+    m_active = settings;
+
+    if (newFrame) {
+        m_fft.setSize(settings.fftSize);
+        m_active.fftSize = m_fft.size();
+        const int n = m_active.fftSize;
+        m_window.resize(n);
+        m_windowSum = 0.0;
+        for (int i = 0; i < n; i++) {
+            double x = 2.0 * M_PI * i / n;
+            double w;
+            switch (settings.window) {
+            case WindowBlackmanHarris:
+                w = 0.35875 - 0.48829 * qCos(x) + 0.14128 * qCos(2 * x) - 0.01168 * qCos(3 * x);
+                break;
+            case WindowFlatTop:
+                w = 0.21557895 - 0.41663158 * qCos(x) + 0.277263158 * qCos(2 * x)
+                  - 0.083578947 * qCos(3 * x) + 0.006947368 * qCos(4 * x);
+                break;
+            default:
+                w = 0.5 - 0.5 * qCos(x);
+                break;
+            }
+            m_window[i] = w;
+            m_windowSum += w;
+        }
+        m_frame.resize(n);
+        m_power.resize(n / 2 + 1);
+        m_avg.resize(n / 2 + 1);
+        m_sum.resize(n / 2 + 1);
+    }
+
+    if (newData) {
+        m_samples.clear();
+        m_samplesPos = 0;
+    }
+
+    if (newAvg) {
+        m_avgCnt = 0;
+        m_avgValid = false;
+        m_newFrames = 0;
+    }
+}
+
+/**
+ * @brief SpectrumThread::processFrame
+ * @param samples - fftSize samples, windowed and accumulated into the average.
+ */
+void SpectrumThread::processFrame(const double *samples)
+{
+    const int n = m_active.fftSize;
+    const int bins = n / 2 + 1;
+    const double *window = m_window.constData();
+    double *frame = m_frame.data();
+    const double *power = m_power.constData();
+    double *avg = m_avg.data();
+
+    for (int i = 0; i < n; i++) {
+        frame[i] = samples[i] * window[i];
+    }
+    m_fft.powerSpectrum(frame, m_power.data());
+
+    switch (m_active.averaging) {
+    case AveragingLinear: {
+        double *sum = m_sum.data();
+        if (m_avgCnt == 0) {
+            m_sum.fill(0.0);
+        }
+        for (int k = 0; k < bins; k++) {
+            sum[k] += power[k];
+        }
+        if (++m_avgCnt == m_active.averages) {
+            for (int k = 0; k < bins; k++) {
+                avg[k] = sum[k] / m_avgCnt;
+            }
+            m_avgCnt = 0;
+            m_avgValid = true;
+        }
+        break;
+    }
+    case AveragingExponential: {
+        /* Plain mean until averages frames are in, so the start is not biased. */
+        m_avgCnt = qMin(m_avgCnt + 1, m_active.averages);
+        double alpha = m_avgValid ? (1.0 / m_avgCnt) : 1.0;
+        for (int k = 0; k < bins; k++) {
+            avg[k] += alpha * (power[k] - avg[k]);
+        }
+        m_avgValid = true;
+        break;
+    }
+    case AveragingPeakHold:
+        for (int k = 0; k < bins; k++) {
+            if (!m_avgValid || (power[k] > avg[k])) {
+                avg[k] = power[k];
+            }
+        }
+        m_avgValid = true;
+        break;
+    default:
+        for (int k = 0; k < bins; k++) {
+            avg[k] = power[k];
+        }
+        m_avgValid = true;
+        break;
+    }
+
+    m_newFrames++;
+}
+
+/**
+ * @brief SpectrumThread::publish
+ * Emits the one-sided amplitude spectrum, normalized by the window
+ * coherent gain so a sine shows its peak amplitude.
+ */
+void SpectrumThread::publish()
+{
+    const int n = m_active.fftSize;
+    const int bins = n / 2 + 1;
+    const double *power;
+    QVector<double> partial;
+
+    if (m_avgValid) {
+        power = m_avg.constData();
+    } else if (m_avgCnt) {
+        /* First linear block is not complete yet. */
+        partial.resize(bins);
+        for (int k = 0; k < bins; k++) {
+            partial[k] = m_sum[k] / m_avgCnt;
+        }
+        power = partial.constData();
+    } else {
+        return;
+    }
+
+    QVector<double> freq(bins);
+    QVector<double> mag(bins);
+    const double binHz = m_active.sampleRate / n;
+    const double scale = 2.0 / m_windowSum;
+
+    for (int k = 0; k < bins; k++) {
+        double amp = qSqrt(power[k]) * (((k == 0) || (k == bins - 1)) ? 0.5 * scale : scale);
+        freq[k] = k * binHz;
+        if (m_active.scale == ScaleDb) {
+            mag[k] = (amp > 0.0) ? qMax(SPECTRUM_DB_FLOOR, 20.0 * log10(amp)) : SPECTRUM_DB_FLOOR;
+        } else {
+            mag[k] = amp;
+        }
+    }
+
+    emit spectrumReady(freq, mag);
+}
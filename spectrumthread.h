@@ -0,0 +1,110 @@
+#ifndef SPECTRUMTHREAD_H
+#define SPECTRUMTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+
+#include "fft.h"
+
+/* Default FFT size in samples.            */
+#define SPECTRUM_FFT_SIZE_DEFAULT       4096
+/* Default frame overlap in percent.       */
+#define SPECTRUM_OVERLAP_DEFAULT        50
+/* Maximum frame overlap in percent.       */
+#define SPECTRUM_OVERLAP_MAX            90
+/* Default number of averaged frames.      */
+#define SPECTRUM_AVERAGES_DEFAULT       8
+/* Default spectrum update interval, ms.   */
+#define SPECTRUM_UPDATE_MS_DEFAULT      100
+/* Input backlog limit in FFT frames.      */
+#define SPECTRUM_BACKLOG_FRAMES         4
+/* Floor of the dB scale.                  */
+#define SPECTRUM_DB_FLOOR               -200.0
+
+class SpectrumThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    /* FFT frame windows. */
+    enum Window {
+        WindowHann = 0,
+        WindowBlackmanHarris,
+        WindowFlatTop
+    };
+
+    /* Frame averaging modes. */
+    enum Averaging {
+        AveragingNone = 0,
+        AveragingLinear,      /* Mean of blocks of averages frames.      */
+        AveragingExponential, /* Running mean with 1 / averages weight.  */
+        AveragingPeakHold     /* Maximum since the last reset.           */
+    };
+
+    /* Published magnitude scale. */
+    enum Scale {
+        ScaleDb = 0,
+        ScaleLinear
+    };
+
+    typedef struct tagSettings {
+        int fftSize;
+        Window window;
+        int overlap;        /* Frame overlap in percent of fftSize.     */
+        Averaging averaging;
+        int averages;
+        Scale scale;
+        double sampleRate;  /* Rate of the samples passed in, Hz.       */
+        int updateMs;       /* Minimum interval between spectra.        */
+    } Settings;
+
+    SpectrumThread(QObject *parent = 0);
+    ~SpectrumThread();
+
+    void startAnalysis();
+    void stopAnalysis();
+    void setSettings(const Settings &settings);
+    Settings settings() const;
+    void resetAveraging();
+
+public slots:
+    void addSamples(QVector<double> y);
+
+signals:
+    void spectrumReady(QVector<double> freq, QVector<double> mag);
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    void applySettings(const Settings &settings);
+    void processFrame(const double *samples);
+    void publish();
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_dataReady;
+    QVector<double> m_input;
+    Settings m_settings;
+    bool m_settingsChanged;
+    bool m_resetAveraging;
+    bool m_quit;
+    /* Worker thread state. */
+    Settings m_active;
+    RealFFT m_fft;
+    QVector<double> m_window;
+    double m_windowSum;
+    QVector<double> m_samples;  /* Sliding frame buffer.                */
+    int m_samplesPos;           /* Start of the next frame.             */
+    QVector<double> m_frame;
+    QVector<double> m_power;
+    QVector<double> m_avg;
+    QVector<double> m_sum;
+    int m_avgCnt;
+    bool m_avgValid;
+    int m_newFrames;
+};
+
+#endif // SPECTRUMTHREAD_H
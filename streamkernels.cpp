@@ -0,0 +1,420 @@
+#include "streamkernels.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define STREAM_KERNELS_X86
+  #include <immintrin.h>
+#endif // __GNUC__ && x86
+
+typedef void (*BoxcarKernel)(const qint16 *in, int groups, int ratio, double *out);
+typedef int (*FindRangeKernel)(const qint16 *in, int count, qint16 lo, qint16 hi, bool inside);
+typedef void (*DeinterleaveKernel)(const qint16 *in, int frames, int channels, qint16 *const *out);
+
+typedef struct tagKernelTable {
+    BoxcarKernel boxcar;
+    FindRangeKernel findRange;
+    DeinterleaveKernel deinterleave;
+    const char *name;
+} KernelTable;
+
+/**
+ * @brief boxcarScalar
+ * Portable reference kernel, also used for the tails of the SIMD kernels.
+ */
+static void boxcarScalar(const qint16 *in, int groups, int ratio, double *out)
+{
+    const double scale = 1.0 / ratio;
+
+    for (int g = 0; g < groups; g++) {
+        qint32 accum = 0;
+        for (int i = 0; i < ratio; i++) {
+            accum += in[i];
+        }
+        out[g] = accum * scale;
+        in += ratio;
+    }
+}
+
+/**
+ * @brief findRangeScalar
+ */
+static int findRangeScalar(const qint16 *in, int count, qint16 lo, qint16 hi, bool inside)
+{
+    for (int i = 0; i < count; i++) {
+        if (((in[i] >= lo) && (in[i] <= hi)) == inside) {
+            return i;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief deinterleaveScalar
+ */
+static void deinterleaveScalar(const qint16 *in, int frames, int channels, qint16 *const *out)
+{
+    for (int c = 0; c < channels; c++) {
+        const qint16 *p = in + c;
+        qint16 *q = out[c];
+        for (int f = 0; f < frames; f++) {
+            q[f] = *p;
+            p += channels;
+        }
+    }
+}
+
+#if defined(STREAM_KERNELS_X86)
+
+/**
+ * @brief boxcarSSE2
+ * Pairs of samples are summed to 32 bits by a multiply-add with ones,
+ * then the pair sums are folded into group sums and converted two at a time.
+ */
+__attribute__((target("sse2")))
+static void boxcarSSE2(const qint16 *in, int groups, int ratio, double *out)
+{
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128d scale = _mm_set1_pd(1.0 / ratio);
+    int g = 0;
+
+    if (ratio == 2) {
+        for (; g + 4 <= groups; g += 4) {
+            __m128i sums = _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(in + g * 2)), ones);
+            _mm_storeu_pd(out + g, _mm_mul_pd(_mm_cvtepi32_pd(sums), scale));
+            _mm_storeu_pd(out + g + 2, _mm_mul_pd(_mm_cvtepi32_pd(
+                _mm_shuffle_epi32(sums, _MM_SHUFFLE(1, 0, 3, 2))), scale));
+        }
+    } else if (ratio == 4) {
+        for (; g + 4 <= groups; g += 4) {
+            __m128 p0 = _mm_castsi128_ps(_mm_madd_epi16(
+                _mm_loadu_si128((const __m128i *)(in + g * 4)), ones));
+            __m128 p1 = _mm_castsi128_ps(_mm_madd_epi16(
+                _mm_loadu_si128((const __m128i *)(in + g * 4 + 8)), ones));
+            __m128i sums = _mm_add_epi32(
+                _mm_castps_si128(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0))),
+                _mm_castps_si128(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1))));
+            _mm_storeu_pd(out + g, _mm_mul_pd(_mm_cvtepi32_pd(sums), scale));
+            _mm_storeu_pd(out + g + 2, _mm_mul_pd(_mm_cvtepi32_pd(
+                _mm_shuffle_epi32(sums, _MM_SHUFFLE(1, 0, 3, 2))), scale));
+        }
+    } else if ((ratio % 8) == 0) {
+        /* Four groups are reduced at once by transposing their partial sums. */
+        for (; g + 4 <= groups; g += 4) {
+            const qint16 *p = in + g * ratio;
+            __m128i a = _mm_setzero_si128();
+            __m128i b = _mm_setzero_si128();
+            __m128i c = _mm_setzero_si128();
+            __m128i d = _mm_setzero_si128();
+            for (int i = 0; i < ratio; i += 8) {
+                a = _mm_add_epi32(a, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(p + i)), ones));
+                b = _mm_add_epi32(b, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(p + ratio + i)), ones));
+                c = _mm_add_epi32(c, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(p + 2 * ratio + i)), ones));
+                d = _mm_add_epi32(d, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(p + 3 * ratio + i)), ones));
+            }
+            __m128i ab = _mm_add_epi32(_mm_unpacklo_epi32(a, b), _mm_unpackhi_epi32(a, b));
+            __m128i cd = _mm_add_epi32(_mm_unpacklo_epi32(c, d), _mm_unpackhi_epi32(c, d));
+            __m128i sums = _mm_add_epi32(_mm_unpacklo_epi64(ab, cd), _mm_unpackhi_epi64(ab, cd));
+            _mm_storeu_pd(out + g, _mm_mul_pd(_mm_cvtepi32_pd(sums), scale));
+            _mm_storeu_pd(out + g + 2, _mm_mul_pd(_mm_cvtepi32_pd(
+                _mm_shuffle_epi32(sums, _MM_SHUFFLE(1, 0, 3, 2))), scale));
+        }
+    }
+
+    boxcarScalar(in + g * ratio, groups - g, ratio, out + g);
+}
+
+/**
+ * @brief findRangeSSE2
+ * Eight samples are compared against both limits at once, the byte mask
+ * of the matching lanes locates the first hit.
+ */
+__attribute__((target("sse2")))
+static int findRangeSSE2(const qint16 *in, int count, qint16 lo, qint16 hi, bool inside)
+{
+    const __m128i vlo = _mm_set1_epi16(lo);
+    const __m128i vhi = _mm_set1_epi16(hi);
+    const int flip = inside ? 0xFFFF : 0;
+    int i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128i outside = _mm_or_si128(_mm_cmplt_epi16(x, vlo), _mm_cmpgt_epi16(x, vhi));
+        int mask = _mm_movemask_epi8(outside) ^ flip;
+        if (mask) {
+            return i + __builtin_ctz(mask) / 2;
+        }
+    }
+
+    return i + findRangeScalar(in + i, count - i, lo, hi, inside);
+}
+
+/**
+ * @brief splitSSE2
+ * Even and odd samples of a and b (16 samples) as two vectors of 8. The
+ * lanes are sign extended to 32 bits first, so the pack never saturates.
+ */
+__attribute__((target("sse2")))
+static inline void splitSSE2(__m128i a, __m128i b, __m128i &even, __m128i &odd)
+{
+    even = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16),
+                           _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+    odd = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+}
+
+/**
+ * @brief deinterleaveSSE2
+ * Two channels take one even/odd split per 8 frames, four channels split
+ * the two halves once more. Other channel counts use the scalar kernel.
+ */
+__attribute__((target("sse2")))
+static void deinterleaveSSE2(const qint16 *in, int frames, int channels, qint16 *const *out)
+{
+    const __m128i *p = (const __m128i *)in;
+    int f = 0;
+
+    if (channels == 2) {
+        for (; f + 8 <= frames; f += 8, p += 2) {
+            __m128i c0, c1;
+            splitSSE2(_mm_loadu_si128(p), _mm_loadu_si128(p + 1), c0, c1);
+            _mm_storeu_si128((__m128i *)(out[0] + f), c0);
+            _mm_storeu_si128((__m128i *)(out[1] + f), c1);
+        }
+    } else if (channels == 4) {
+        for (; f + 8 <= frames; f += 8, p += 4) {
+            __m128i e0, o0, e1, o1, c0, c1, c2, c3;
+            splitSSE2(_mm_loadu_si128(p), _mm_loadu_si128(p + 1), e0, o0);
+            splitSSE2(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3), e1, o1);
+            splitSSE2(e0, e1, c0, c2);
+            splitSSE2(o0, o1, c1, c3);
+            _mm_storeu_si128((__m128i *)(out[0] + f), c0);
+            _mm_storeu_si128((__m128i *)(out[1] + f), c1);
+            _mm_storeu_si128((__m128i *)(out[2] + f), c2);
+            _mm_storeu_si128((__m128i *)(out[3] + f), c3);
+        }
+    }
+
+    if (f < frames) {
+        qint16 *tail[8];
+        for (int c = 0; c < channels; c++) {
+            tail[c] = out[c] + f;
+        }
+        deinterleaveScalar(in + f * channels, frames - f, channels, tail);
+    }
+}
+
+/**
+ * @brief boxcarAVX2
+ * Same scheme as boxcarSSE2 on 256 bit registers. Ratios without an AVX2
+ * path and the remaining groups are handed over to boxcarSSE2.
+ */
+__attribute__((target("avx2")))
+static void boxcarAVX2(const qint16 *in, int groups, int ratio, double *out)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256d scale = _mm256_set1_pd(1.0 / ratio);
+    int g = 0;
+
+    if (ratio == 2) {
+        for (; g + 8 <= groups; g += 8) {
+            __m256i sums = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)(in + g * 2)), ones);
+            _mm256_storeu_pd(out + g, _mm256_mul_pd(
+                _mm256_cvtepi32_pd(_mm256_castsi256_si128(sums)), scale));
+            _mm256_storeu_pd(out + g + 4, _mm256_mul_pd(
+                _mm256_cvtepi32_pd(_mm256_extracti128_si256(sums, 1)), scale));
+        }
+    } else if (ratio == 4) {
+        for (; g + 8 <= groups; g += 8) {
+            __m256 p0 = _mm256_castsi256_ps(_mm256_madd_epi16(
+                _mm256_loadu_si256((const __m256i *)(in + g * 4)), ones));
+            __m256 p1 = _mm256_castsi256_ps(_mm256_madd_epi16(
+                _mm256_loadu_si256((const __m256i *)(in + g * 4 + 16)), ones));
+            /* Groups come out as 0 1 4 5 | 2 3 6 7, the permute restores the order. */
+            __m256i sums = _mm256_add_epi32(
+                _mm256_castps_si256(_mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0))),
+                _mm256_castps_si256(_mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1))));
+            sums = _mm256_permute4x64_epi64(sums, _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_pd(out + g, _mm256_mul_pd(
+                _mm256_cvtepi32_pd(_mm256_castsi256_si128(sums)), scale));
+            _mm256_storeu_pd(out + g + 4, _mm256_mul_pd(
+                _mm256_cvtepi32_pd(_mm256_extracti128_si256(sums, 1)), scale));
+        }
+    } else if ((ratio % 16) == 0) {
+        for (; g < groups; g++) {
+            const qint16 *p = in + g * ratio;
+            __m256i accum = _mm256_setzero_si256();
+            for (int i = 0; i < ratio; i += 16) {
+                accum = _mm256_add_epi32(accum, _mm256_madd_epi16(
+                    _mm256_loadu_si256((const __m256i *)(p + i)), ones));
+            }
+            __m128i half = _mm_add_epi32(_mm256_castsi256_si128(accum), _mm256_extracti128_si256(accum, 1));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+            out[g] = _mm_cvtsi128_si32(half) * (1.0 / ratio);
+        }
+    }
+
+    /* The SSE2 kernel is legacy encoded, clear the upper halves first or
+     * every SSE instruction there pays for the AVX state transition. */
+    _mm256_zeroupper();
+    boxcarSSE2(in + g * ratio, groups - g, ratio, out + g);
+}
+
+/**
+ * @brief findRangeAVX2
+ * Same as findRangeSSE2 with sixteen samples per step.
+ */
+__attribute__((target("avx2")))
+static int findRangeAVX2(const qint16 *in, int count, qint16 lo, qint16 hi, bool inside)
+{
+    const __m256i vlo = _mm256_set1_epi16(lo);
+    const __m256i vhi = _mm256_set1_epi16(hi);
+    const unsigned int flip = inside ? 0xFFFFFFFFu : 0u;
+    int i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi16(vlo, x), _mm256_cmpgt_epi16(x, vhi));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(outside) ^ flip;
+        if (mask) {
+            return i + __builtin_ctz(mask) / 2;
+        }
+    }
+
+    _mm256_zeroupper();
+    return i + findRangeSSE2(in + i, count - i, lo, hi, inside);
+}
+
+#endif // STREAM_KERNELS_X86
+
+/**
+ * @brief makeKernels
+ * @param name - kernel variant, "scalar", "sse2" or "avx2".
+ * @param table - set to the kernels of the variant.
+ * @return false if the variant is unknown or the CPU lacks its instructions.
+ */
+static bool makeKernels(const char *name, KernelTable &table)
+{
+    if (strcmp(name, "scalar") == 0) {
+        table.boxcar = boxcarScalar;
+        table.findRange = findRangeScalar;
+        table.deinterleave = deinterleaveScalar;
+        table.name = "scalar";
+        return true;
+    }
+
+#if defined(STREAM_KERNELS_X86)
+    __builtin_cpu_init();
+    if ((strcmp(name, "avx2") == 0) && __builtin_cpu_supports("avx2")) {
+        table.boxcar = boxcarAVX2;
+        table.findRange = findRangeAVX2;
+        table.deinterleave = deinterleaveSSE2;
+        table.name = "avx2";
+        return true;
+    }
+    if ((strcmp(name, "sse2") == 0) && __builtin_cpu_supports("sse2")) {
+        table.boxcar = boxcarSSE2;
+        table.findRange = findRangeSSE2;
+        table.deinterleave = deinterleaveSSE2;
+        table.name = "sse2";
+        return true;
+    }
+#endif // STREAM_KERNELS_X86
+
+    return false;
+}
+
+/**
+ * @brief selectKernels
+ * @return kernels matching the instruction sets of the running CPU.
+ */
+static KernelTable selectKernels()
+{
+    KernelTable table;
+
+    if (!makeKernels("avx2", table) && !makeKernels("sse2", table)) {
+        (void)makeKernels("scalar", table);
+    }
+    return table;
+}
+
+/**
+ * @brief kernels
+ * @return kernel table, selected on first use.
+ */
+static KernelTable &kernels()
+{
+    static KernelTable table = selectKernels();
+    return table;
+}
+
+/**
+ * @brief streamBoxcar
+ * @param in - groups * ratio input samples.
+ * @param groups - number of output values.
+ * @param ratio - number of samples averaged into one output value.
+ * @param out - group means.
+ */
+void streamBoxcar(const qint16 *in, int groups, int ratio, double *out)
+{
+    if (groups > 0) {
+        kernels().boxcar(in, groups, ratio, out);
+    }
+}
+
+/**
+ * @brief streamFindRange
+ * @param in - samples to search.
+ * @param count - number of samples.
+ * @param lo - lower limit, inclusive.
+ * @param hi - upper limit, inclusive.
+ * @param inside - search for the first sample inside (true) or outside the limits.
+ * @return index of the first match, count if there is none.
+ */
+int streamFindRange(const qint16 *in, int count, qint16 lo, qint16 hi, bool inside)
+{
+    return kernels().findRange(in, count, lo, hi, inside);
+}
+
+/**
+ * @brief streamDeinterleave
+ * @param in - frames * channels interleaved samples.
+ * @param frames - number of frames.
+ * @param channels - samples per frame, at most 8.
+ * @param out - one destination per channel.
+ */
+void streamDeinterleave(const qint16 *in, int frames, int channels, qint16 *const *out)
+{
+    if ((frames > 0) && (channels > 0) && (channels <= 8)) {
+        kernels().deinterleave(in, frames, channels, out);
+    }
+}
+
+/**
+ * @brief streamKernelName
+ * @return name of the selected kernel variant.
+ */
+const char *streamKernelName()
+{
+    return kernels().name;
+}
+
+/**
+ * @brief streamKernelSelect
+ * @param name - kernel variant, "scalar", "sse2" or "avx2".
+ * @return false if the variant can't run on this CPU, the selection is
+ * left unchanged then.
+ *
+ * Meant for benchmarks and comparisons, call it before any stream is
+ * processed, the kernel table is not protected against concurrent use.
+ */
+bool streamKernelSelect(const char *name)
+{
+    KernelTable table;
+
+    if (!makeKernels(name, table)) {
+        return false;
+    }
+    kernels() = table;
+    return true;
+}
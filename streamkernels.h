@@ -0,0 +1,29 @@
+#ifndef STREAMKERNELS_H
+#define STREAMKERNELS_H
+
+#include <QtGlobal>
+
+/* Sums groups of ratio consecutive samples and stores their mean.
+ * in must hold groups * ratio samples, out must hold groups values.
+ */
+void streamBoxcar(const qint16 *in, int groups, int ratio, double *out);
+
+/* Index of the first sample whose membership in [lo, hi] equals inside,
+ * count if there is none.
+ */
+int streamFindRange(const qint16 *in, int count, qint16 lo, qint16 hi, bool inside);
+
+/* Splits frames of channels interleaved samples into one array per channel,
+ * out[c] must hold frames samples.
+ */
+void streamDeinterleave(const qint16 *in, int frames, int channels, qint16 *const *out);
+
+/* Name of the kernel variant selected for this CPU. */
+const char *streamKernelName();
+
+/* Forces a kernel variant ("scalar", "sse2" or "avx2") for benchmarks,
+ * false if this CPU can't run it. Call before any stream is processed.
+ */
+bool streamKernelSelect(const char *name);
+
+#endif // STREAMKERNELS_H
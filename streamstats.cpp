@@ -0,0 +1,309 @@
+#include "streamstats.h"
+
+#include <qmath.h>
+
+const double streamStatsQuantiles[STREAMSTATS_QUANTILES] = { 0.50, 0.95, 0.99 };
+
+/**
+ * @brief P2Quantile::P2Quantile
+ * @param p - probability of the estimated quantile, 0 .. 1.
+ */
+P2Quantile::P2Quantile(double p) :
+    m_p(p)
+{
+    reset();
+}
+
+/**
+ * @brief P2Quantile::reset
+ */
+void P2Quantile::reset()
+{
+    m_count = 0;
+    for (int i = 0; i < 5; i++) {
+        m_height[i] = 0.0;
+        m_pos[i] = i;
+    }
+    m_desired[0] = 0.0;
+    m_desired[1] = 2.0 * m_p;
+    m_desired[2] = 4.0 * m_p;
+    m_desired[3] = 2.0 + 2.0 * m_p;
+    m_desired[4] = 4.0;
+    m_increment[0] = 0.0;
+    m_increment[1] = m_p / 2.0;
+    m_increment[2] = m_p;
+    m_increment[3] = (1.0 + m_p) / 2.0;
+    m_increment[4] = 1.0;
+}
+
+/**
+ * @brief P2Quantile::add
+ * @param x - new observation.
+ *
+ * The first five observations are kept sorted as marker heights. After
+ * that every observation moves the marker positions, and the inner markers
+ * that drift off their desired position by more than one are adjusted with
+ * piecewise parabolic (or, if that breaks the ordering, linear) prediction.
+ */
+void P2Quantile::add(double x)
+{
+    if (m_count < 5) {
+        int i = m_count++;
+        while ((i > 0) && (m_height[i - 1] > x)) {
+            m_height[i] = m_height[i - 1];
+            i--;
+        }
+        m_height[i] = x;
+        return;
+    }
+    m_count++;
+
+    int k;
+    if (x < m_height[0]) {
+        m_height[0] = x;
+        k = 0;
+    } else if (x >= m_height[4]) {
+        m_height[4] = x;
+        k = 3;
+    } else {
+        k = 0;
+        while (x >= m_height[k + 1]) {
+            k++;
+        }
+    }
+
+    for (int i = k + 1; i < 5; i++) {
+        m_pos[i]++;
+    }
+    for (int i = 0; i < 5; i++) {
+        m_desired[i] += m_increment[i];
+    }
+
+    for (int i = 1; i < 4; i++) {
+        double d = m_desired[i] - m_pos[i];
+        if (((d >= 1.0) && (m_pos[i + 1] - m_pos[i] > 1)) ||
+            ((d <= -1.0) && (m_pos[i - 1] - m_pos[i] < -1))) {
+            int s = (d > 0.0) ? 1 : -1;
+            double np = m_pos[i + 1] - m_pos[i - 1];
+            double h = m_height[i] + s / np *
+                       ((m_pos[i] - m_pos[i - 1] + s) * (m_height[i + 1] - m_height[i]) / (m_pos[i + 1] - m_pos[i]) +
+                        (m_pos[i + 1] - m_pos[i] - s) * (m_height[i] - m_height[i - 1]) / (m_pos[i] - m_pos[i - 1]));
+            if ((h <= m_height[i - 1]) || (h >= m_height[i + 1])) {
+                h = m_height[i] + s * (m_height[i + s] - m_height[i]) / (m_pos[i + s] - m_pos[i]);
+            }
+            m_height[i] = h;
+            m_pos[i] += s;
+        }
+    }
+}
+
+/**
+ * @brief P2Quantile::value
+ * @return quantile estimate, exact while fewer than five observations are in.
+ */
+double P2Quantile::value() const
+{
+    if (m_count == 0) {
+        return 0.0;
+    }
+    if (m_count < 5) {
+        return m_height[qRound(m_p * (m_count - 1))];
+    }
+    return m_height[2];
+}
+
+/**
+ * @brief RunningStats::RunningStats
+ */
+RunningStats::RunningStats()
+{
+    for (int i = 0; i < STREAMSTATS_QUANTILES; i++) {
+        m_quantile[i] = P2Quantile(streamStatsQuantiles[i]);
+    }
+    reset();
+}
+
+/**
+ * @brief RunningStats::reset
+ */
+void RunningStats::reset()
+{
+    m_count = 0;
+    m_mean = 0.0;
+    m_m2 = 0.0;
+    m_min = 0.0;
+    m_max = 0.0;
+    for (int i = 0; i < STREAMSTATS_QUANTILES; i++) {
+        m_quantile[i].reset();
+    }
+}
+
+/**
+ * @brief RunningStats::add
+ * @param x - new sample. Mean and variance are updated after Welford.
+ */
+void RunningStats::add(double x)
+{
+    if (m_count == 0) {
+        m_min = x;
+        m_max = x;
+    } else {
+        m_min = qMin(m_min, x);
+        m_max = qMax(m_max, x);
+    }
+
+    m_count++;
+    double d = x - m_mean;
+    m_mean += d / m_count;
+    m_m2 += d * (x - m_mean);
+
+    for (int i = 0; i < STREAMSTATS_QUANTILES; i++) {
+        m_quantile[i].add(x);
+    }
+}
+
+/**
+ * @brief RunningStats::result
+ * @param stats - receives the statistics of the samples added so far.
+ */
+void RunningStats::result(StreamStatistics &stats) const
+{
+    stats.count = 0;
+    merge(stats);
+}
+
+/**
+ * @brief RunningStats::merge
+ * @param stats - statistics of another, disjoint sample set. Updated to
+ * describe both sets. Moments are combined exactly (Chan et al.), the
+ * quantiles as the count-weighted mean of both estimates.
+ */
+void RunningStats::merge(StreamStatistics &stats) const
+{
+    if (m_count == 0) {
+        return;
+    }
+    if (stats.count == 0) {
+        stats.count = m_count;
+        stats.mean = m_mean;
+        stats.std = (m_count > 1) ? qSqrt(m_m2 / (m_count - 1)) : 0.0;
+        stats.rms = qSqrt(m_mean * m_mean + m_m2 / m_count);
+        stats.min = m_min;
+        stats.max = m_max;
+        for (int i = 0; i < STREAMSTATS_QUANTILES; i++) {
+            stats.quantile[i] = m_quantile[i].value();
+        }
+        return;
+    }
+
+    const double na = stats.count;
+    const double nb = m_count;
+    const double n = na + nb;
+    const double m2a = (stats.count > 1) ? stats.std * stats.std * (na - 1.0) : 0.0;
+    const double d = m_mean - stats.mean;
+    const double m2 = m2a + m_m2 + d * d * na * nb / n;
+
+    stats.count += m_count;
+    stats.mean += d * nb / n;
+    stats.std = qSqrt(m2 / (n - 1.0));
+    stats.rms = qSqrt(stats.mean * stats.mean + m2 / n);
+    stats.min = qMin(stats.min, m_min);
+    stats.max = qMax(stats.max, m_max);
+    for (int i = 0; i < STREAMSTATS_QUANTILES; i++) {
+        stats.quantile[i] = (stats.quantile[i] * na + m_quantile[i].value() * nb) / n;
+    }
+}
+
+/**
+ * @brief StreamStats::StreamStats
+ */
+StreamStats::StreamStats() :
+    m_bucketSize(STREAMSTATS_WINDOW_DEFAULT / STREAMSTATS_WINDOW_BUCKETS),
+    m_current(0)
+{
+    // Empty;
+}
+
+/**
+ * @brief StreamStats::setWindow
+ * @param samples - sliding window length, rounded down to whole buckets.
+ * Restarts the window, the session statistics are kept.
+ */
+void StreamStats::setWindow(int samples)
+{
+    m_bucketSize = qMax(STREAMSTATS_WINDOW_MIN, samples) / STREAMSTATS_WINDOW_BUCKETS;
+    for (int i = 0; i < STREAMSTATS_WINDOW_BUCKETS; i++) {
+        m_bucket[i].reset();
+    }
+    m_current = 0;
+}
+
+/**
+ * @brief StreamStats::reset
+ */
+void StreamStats::reset()
+{
+    m_session.reset();
+    setWindow(windowSize());
+}
+
+/**
+ * @brief StreamStats::add
+ * @param samples - raw stream samples.
+ * @param count - number of samples.
+ */
+void StreamStats::add(const qint16 *samples, int count)
+{
+    addSamples(samples, count);
+}
+
+/**
+ * @brief StreamStats::add
+ * @param samples - filtered stream samples.
+ * @param count - number of samples.
+ */
+void StreamStats::add(const double *samples, int count)
+{
+    addSamples(samples, count);
+}
+
+/**
+ * @brief StreamStats::addSamples
+ * The window is a ring of buckets. The oldest bucket is dropped as a whole
+ * when the current one is full, so no sample history is kept and the
+ * window spans between (BUCKETS - 1) / BUCKETS and one window length.
+ */
+template <typename T>
+void StreamStats::addSamples(const T *samples, int count)
+{
+    for (int i = 0; i < count; i++) {
+        double x = samples[i];
+        m_session.add(x);
+        if (m_bucket[m_current].count() == m_bucketSize) {
+            m_current = (m_current + 1) % STREAMSTATS_WINDOW_BUCKETS;
+            m_bucket[m_current].reset();
+        }
+        m_bucket[m_current].add(x);
+    }
+}
+
+/**
+ * @brief StreamStats::session
+ * @param stats - receives the statistics since the last reset.
+ */
+void StreamStats::session(StreamStatistics &stats) const
+{
+    m_session.result(stats);
+}
+
+/**
+ * @brief StreamStats::window
+ * @param stats - receives the statistics of the sliding window.
+ */
+void StreamStats::window(StreamStatistics &stats) const
+{
+    stats.count = 0;
+    for (int i = 0; i < STREAMSTATS_WINDOW_BUCKETS; i++) {
+        m_bucket[i].merge(stats);
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef STREAMSTATS_H
+#define STREAMSTATS_H
+
+#include <QtGlobal>
+#include <QMetaType>
+#include <QVector>
+
+/* Number of tracked quantiles.            */
+#define STREAMSTATS_QUANTILES           3
+/* Buckets the sliding window is made of.  */
+#define STREAMSTATS_WINDOW_BUCKETS      8
+/* Default sliding window in samples.      */
+#define STREAMSTATS_WINDOW_DEFAULT      10000
+/* Minimum sliding window in samples.      */
+#define STREAMSTATS_WINDOW_MIN          STREAMSTATS_WINDOW_BUCKETS
+/* Interval between published results, ms. */
+#define STREAMSTATS_UPDATE_MS           250
+
+/* Probabilities of the tracked quantiles. */
+extern const double streamStatsQuantiles[STREAMSTATS_QUANTILES];
+
+typedef struct tagStreamStatistics {
+    qint64 count;
+    double mean;
+    double std;     /* Sample standard deviation. */
+    double rms;
+    double min;
+    double max;
+    double quantile[STREAMSTATS_QUANTILES];
+} StreamStatistics;
+
+Q_DECLARE_METATYPE(StreamStatistics);
+
+/* Single quantile estimate after Jain and Chlamtac (P-square algorithm),
+ * five markers and constant memory.
+ */
+class P2Quantile
+{
+public:
+    P2Quantile(double p = 0.5);
+
+    void reset();
+    void add(double x);
+    double value() const;
+
+private:
+    double m_p;
+    int m_count;
+    double m_height[5];
+    int m_pos[5];
+    double m_desired[5];
+    double m_increment[5];
+};
+
+/* Running moments, extremes and quantiles of a sample set. */
+class RunningStats
+{
+public:
+    RunningStats();
+
+    void reset();
+    void add(double x);
+    qint64 count() const { return m_count; }
+    void result(StreamStatistics &stats) const;
+    void merge(StreamStatistics &stats) const;
+
+private:
+    qint64 m_count;
+    double m_mean;
+    double m_m2;        /* Sum of squared deviations from the mean. */
+    double m_min;
+    double m_max;
+    P2Quantile m_quantile[STREAMSTATS_QUANTILES];
+};
+
+class StreamStats
+{
+public:
+    StreamStats();
+
+    void setWindow(int samples);
+    int windowSize() const { return m_bucketSize * STREAMSTATS_WINDOW_BUCKETS; }
+    void reset();
+    void add(const qint16 *samples, int count);
+    void add(const double *samples, int count);
+
+    void session(StreamStatistics &stats) const;
+    void window(StreamStatistics &stats) const;
+
+private:
+    template <typename T> void addSamples(const T *samples, int count);
+
+private:
+    RunningStats m_session;
+    RunningStats m_bucket[STREAMSTATS_WINDOW_BUCKETS];
+    int m_bucketSize;
+    int m_current;      /* Bucket being filled, the others are complete. */
+};
+
+#endif // STREAMSTATS_H
@@ -25,14 +25,27 @@
 #else // !USE_FDBKCTRL
   #define STREAMING_BUF_DEPTH           512
 #endif // USE_FDBKCTRL
-/* Averaging coefficient.                  */
+/* Default decimation ratio.              */
 #if defined(USE_FDBKCTRL)
-  #define AVG_COUNTER_MAX               4
+  #define DECIMATION_RATIO_DEFAULT      4
 #else // !USE_FDBKCTRL
-  #define AVG_COUNTER_MAX               16
+  #define DECIMATION_RATIO_DEFAULT      16
 #endif // USE_FDBKCTRL
-/* Number of samples in plotting buffer.   */
-#define PLOTTING_BUF_DEPTH              (STREAMING_BUF_DEPTH / AVG_COUNTER_MAX)
+/* Default samples in plotting buffer.     */
+#define PLOTTING_BUF_DEPTH_DEFAULT      (STREAMING_BUF_DEPTH / DECIMATION_RATIO_DEFAULT)
+/* Maximum samples in plotting buffer.     */
+#define PLOTTING_BUF_DEPTH_MAX          4096
+
+/* Available streaming channels.           */
+#define STREAMING_CHANNEL_FE            0x00
+#define STREAMING_CHANNEL_CE            0x01
+#define STREAMING_CHANNEL_SUM           0x02
+#define STREAMING_CHANNEL_A             0x03
+#define STREAMING_CHANNEL_B             0x04
+#define STREAMING_CHANNEL_C             0x05
+#define STREAMING_CHANNEL_D             0x06
+/* Number of streaming channels.           */
+#define STREAMING_CHANNEL_COUNT         7
 
 typedef struct tagTelemetryMessage {
     quint8 msg_id;     /* Telemetry message ID.           */
@@ -43,4 +56,14 @@ typedef struct tagTelemetryMessage {
 
 Q_DECLARE_METATYPE(TelemetryMessage);
 
+/* Serial link counters since connecting. */
+typedef struct tagLinkStatistics {
+    qint64 bytes_received;
+    qint64 bytes_sent;
+    qint64 messages;        /* Complete messages received.      */
+    qint64 corrupt_headers; /* Input dropped at a bad header.   */
+    qint64 incomplete;      /* Messages dropped unfinished.     */
+    qint64 connected_ms;    /* Time since connecting.           */
+} __attribute__((packed)) LinkStatistics;
+
 #endif // TELEMETRY_H
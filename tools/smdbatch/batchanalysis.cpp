@@ -0,0 +1,499 @@
+#include "batchanalysis.h"
+#include "workpool.h"
+#include "fft.h"
+#include "scananalyzer.h"
+#include "multistream.h"
+#include "recordingreader.h"
+#include "capturereader.h"
+
+#include <QAtomicInt>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QObject>
+#include <qmath.h>
+#include <limits>
+
+const char * const batchSeriesNames[BATCH_SERIES_COUNT] = {
+    "stream", "FE", "CE", "SUM", "A", "B", "C", "D"
+};
+
+/* Partial result of a series within a chunk. */
+typedef struct tagSeriesPart {
+    RunningStats stats;
+    qint64 timeFirst;       /* Times of the first and the last sample, ns.  */
+    qint64 timeLast;
+    int frames;
+    QVector<double> power;  /* Sum of the frame power spectra.              */
+} SeriesPart;
+
+typedef struct tagChunkPart {
+    bool ok;
+    QString error;
+    SeriesPart series[BATCH_SERIES_COUNT];
+    QVector<ScanFeatures> sweeps;
+} ChunkPart;
+
+/* A file being analyzed, shared by its chunk tasks. */
+typedef struct tagFileJob {
+    FileResult *result;
+    BatchSettings settings;
+    qint64 chunkTime;       /* ns. */
+    QVector<ChunkPart> parts;
+    QAtomicInt remaining;   /* Chunks not yet done. */
+} FileJob;
+
+/* Hann window of the spectra, the state of the series being framed. */
+class SpectrumFramer
+{
+public:
+    SpectrumFramer(int size) : m_fft(size)
+    {
+        const int n = m_fft.size();
+        m_window.resize(n);
+        m_windowed.resize(n);
+        m_power.resize(n / 2 + 1);
+        for (int i = 0; i < n; i++) {
+            m_window[i] = 0.5 - 0.5 * qCos(2.0 * M_PI * i / n);
+        }
+        for (int i = 0; i < BATCH_SERIES_COUNT; i++) {
+            m_fill[i] = 0;
+        }
+    }
+
+    void add(int series, SeriesPart &part, const qint16 *samples, int count, int stride);
+
+private:
+    RealFFT m_fft;
+    QVector<double> m_window;
+    QVector<double> m_windowed;
+    QVector<double> m_power;
+    QVector<double> m_frame[BATCH_SERIES_COUNT];
+    int m_fill[BATCH_SERIES_COUNT];
+};
+
+/**
+ * @brief SpectrumFramer::add
+ * @param series - series index, selects the frame being filled.
+ * @param part - receives the power of every completed frame.
+ * @param samples - first sample.
+ * @param count - number of samples.
+ * @param stride - distance between the samples.
+ *
+ * Frames overlap by half.
+ */
+void SpectrumFramer::add(int series, SeriesPart &part, const qint16 *samples, int count, int stride)
+{
+    const int n = m_fft.size();
+    QVector<double> &frame = m_frame[series];
+    int &fill = m_fill[series];
+
+    if (frame.isEmpty()) {
+        frame.resize(n);
+        part.power.fill(0.0, n / 2 + 1);
+    }
+    for (int i = 0; i < count; i++) {
+        frame[fill++] = samples[i * stride];
+        if (fill < n) {
+            continue;
+        }
+        for (int j = 0; j < n; j++) {
+            m_windowed[j] = frame[j] * m_window[j];
+        }
+        m_fft.powerSpectrum(m_windowed.constData(), m_power.data());
+        for (int k = 0; k <= n / 2; k++) {
+            part.power[k] += m_power[k];
+        }
+        part.frames++;
+        memmove((void *)frame.data(), (const void *)(frame.constData() + n / 2), (n - n / 2) * sizeof(double));
+        fill = n - n / 2;
+    }
+}
+
+/**
+ * @brief addSamples
+ * Adds samples sharing a time span to the statistics and the spectrum.
+ */
+static void addSamples(SpectrumFramer &framer, int series, SeriesPart &part,
+                       const qint16 *samples, int count, int stride, qint64 timeFirst, qint64 timeLast)
+{
+    if (count <= 0) {
+        return;
+    }
+    if (part.stats.count() == 0) {
+        part.timeFirst = timeFirst;
+    }
+    part.timeLast = timeLast;
+    for (int i = 0; i < count; i++) {
+        part.stats.add(samples[i * stride]);
+    }
+    framer.add(series, part, samples, count, stride);
+}
+
+/**
+ * @brief analyzeRecording
+ * @param from - start of the chunk, ns.
+ * @param to - end of the chunk, ns, excluded.
+ *
+ * The chunk reads on past its end to complete the sweep that started
+ * within it.
+ */
+static void analyzeRecording(const FileJob &job, qint64 from, qint64 to, ChunkPart &part)
+{
+    RecordingReader reader;
+    RecordHeader hdr;
+    const char *data;
+    SpectrumFramer framer(job.settings.fftSize);
+    ScanAnalyzer scan;
+    QVector<double> sweep;
+    ScanFeatures features;
+    bool sweeping = false;
+
+    if (!reader.open(job.result->fileName)) {
+        part.error = reader.errorString();
+        return;
+    }
+    reader.seek(from);
+    while (reader.next(hdr, &data)) {
+        if (hdr.signature != TELEMETRY_MSG_SIGNATURE) {
+            continue;
+        }
+        const bool inChunk = (hdr.timestamp < to);
+        if (!inChunk && !sweeping) {
+            break;
+        }
+        if ((hdr.msg_id == '.') && (hdr.data_size == 0)) {
+            scan.startSweep();
+            while (scan.takeSweep(sweep, features)) {
+                part.sweeps.append(features);
+            }
+            if (!inChunk) {
+                break;
+            }
+            sweeping = true;
+        } else if ((hdr.msg_id == 's') || (hdr.msg_id == 'r')) {
+            const qint16 *s = (const qint16 *)data;
+            const int n = hdr.data_size / (int)sizeof(qint16);
+            if (sweeping) {
+                scan.process(s, n);
+            }
+            if (inChunk) {
+                addSamples(framer, BATCH_SERIES_STREAM, part.series[BATCH_SERIES_STREAM],
+                           s, n, 1, hdr.timestamp, hdr.timestamp);
+            }
+        } else if (inChunk && (hdr.msg_id == 'm') && (hdr.data_size >= MULTISTREAM_HDR_SIZE)) {
+            /* Frames hold the selected channels in ascending ID order. */
+            const quint8 mask = (quint8)data[0];
+            const qint16 *s = (const qint16 *)(data + MULTISTREAM_HDR_SIZE);
+            int count = 0;
+            for (int c = 0; c < STREAMING_CHANNEL_COUNT; c++) {
+                count += (mask >> c) & 1;
+            }
+            if (count == 0) {
+                continue;
+            }
+            const int frames = (hdr.data_size - MULTISTREAM_HDR_SIZE) / (count * (int)sizeof(qint16));
+            int index = 0;
+            for (int c = 0; c < STREAMING_CHANNEL_COUNT; c++) {
+                if (mask & (1 << c)) {
+                    addSamples(framer, c + 1, part.series[c + 1], s + index, frames, count,
+                               hdr.timestamp, hdr.timestamp);
+                    index++;
+                }
+            }
+        }
+    }
+    part.ok = true;
+}
+
+/**
+ * @brief analyzeCapture
+ * @param from - start of the chunk, ns.
+ * @param to - end of the chunk, ns, excluded.
+ *
+ * A capture chunk belongs to the task its first sample falls into.
+ * Captures have no markers and no single stream.
+ */
+static void analyzeCapture(const FileJob &job, qint64 from, qint64 to, ChunkPart &part)
+{
+    CaptureReader reader;
+    SpectrumFramer framer(job.settings.fftSize);
+    qint16 samples[CAPTURE_CHUNK_SAMPLES];
+
+    if (!reader.open(job.result->fileName)) {
+        part.error = reader.errorString();
+        return;
+    }
+    for (int c = 0; c < STREAMING_CHANNEL_COUNT; c++) {
+        for (int i = reader.findTime(c, from); i < reader.chunkCount(c); i++) {
+            const CaptureChunk &chunk = reader.chunk(c, i).chunk;
+            if (chunk.time_first >= to) {
+                break;
+            }
+            if (chunk.time_first < from) {
+                continue;
+            }
+            if (!reader.readChunk(c, i, samples)) {
+                part.error = QObject::tr("Chunk %1 of channel %2 is corrupt").arg(i).arg(batchSeriesNames[c + 1]);
+                return;
+            }
+            addSamples(framer, c + 1, part.series[c + 1], samples, chunk.count, 1,
+                       chunk.time_first, chunk.time_last);
+        }
+    }
+    part.ok = true;
+}
+
+/**
+ * @brief finishSeries
+ * Merges the chunks of a series into its result.
+ */
+static void finishSeries(const FileJob &job, int series, SeriesResult &result)
+{
+    const int n = job.settings.fftSize;
+    const int bins = n / 2 + 1;
+    QVector<double> power(bins, 0.0);
+    qint64 timeFirst = 0;
+    qint64 timeLast = 0;
+
+    memset((void *)&result.stats, 0, sizeof(result.stats));
+    result.frames = 0;
+    for (int i = 0; i < job.parts.size(); i++) {
+        const SeriesPart &part = job.parts[i].series[series];
+        if (part.stats.count() == 0) {
+            continue;
+        }
+        if (result.stats.count == 0) {
+            timeFirst = part.timeFirst;
+        }
+        timeLast = part.timeLast;
+        part.stats.merge(result.stats);
+        for (int k = 0; (k < bins) && (k < part.power.size()); k++) {
+            power[k] += part.power[k];
+        }
+        result.frames += part.frames;
+    }
+
+    result.sampleRate = job.settings.sampleRate;
+    if ((result.sampleRate <= 0.0) && (timeLast > timeFirst)) {
+        result.sampleRate = (result.stats.count - 1) * 1e9 / (timeLast - timeFirst);
+    }
+    result.peakHz = 0.0;
+    result.peakDb = BATCH_DB_FLOOR;
+    result.spectrum.clear();
+    if (result.frames == 0) {
+        return;
+    }
+
+    /* One-sided amplitude, a sine shows its peak amplitude. */
+    const double scale = 2.0 / (0.5 * n);
+    if (job.settings.spectra) {
+        result.spectrum.resize(bins);
+    }
+    for (int k = 0; k < bins; k++) {
+        const double amp = qSqrt(power[k] / result.frames) * (((k == 0) || (k == bins - 1)) ? 0.5 * scale : scale);
+        const double db = (amp > 0.0) ? qMax(BATCH_DB_FLOOR, 20.0 * log10(amp)) : BATCH_DB_FLOOR;
+        if (job.settings.spectra) {
+            result.spectrum[k] = db;
+        }
+        if ((k > 0) && (db > result.peakDb)) {
+            result.peakDb = db;
+            result.peakHz = k * result.sampleRate / n;
+        }
+    }
+}
+
+/**
+ * @brief finishScan
+ * Summarizes the sweeps of all chunks in time order.
+ */
+static void finishScan(const FileJob &job, ScanSummary &scan)
+{
+    RunningStats stats[4];
+
+    scan.sweeps = 0;
+    scan.valid = 0;
+    for (int i = 0; i < job.parts.size(); i++) {
+        const QVector<ScanFeatures> &sweeps = job.parts[i].sweeps;
+        for (int j = 0; j < sweeps.size(); j++) {
+            scan.sweeps++;
+            if (!sweeps[j].valid) {
+                continue;
+            }
+            scan.valid++;
+            stats[0].add(sweeps[j].peakToPeak);
+            stats[1].add(sweeps[j].zeroPosition);
+            stats[2].add(sweeps[j].slope);
+            stats[3].add(sweeps[j].asymmetry);
+        }
+    }
+    stats[0].result(scan.peakToPeak);
+    stats[1].result(scan.zeroPosition);
+    stats[2].result(scan.slope);
+    stats[3].result(scan.asymmetry);
+}
+
+/**
+ * @brief finishFile
+ * Called by the task of the last chunk, frees the job.
+ */
+static void finishFile(FileJob *job)
+{
+    FileResult &result = *job->result;
+
+    result.ok = true;
+    for (int i = 0; i < job->parts.size(); i++) {
+        if (!job->parts[i].ok) {
+            result.ok = false;
+            result.error = job->parts[i].error;
+            break;
+        }
+    }
+    if (result.ok) {
+        for (int i = 0; i < BATCH_SERIES_COUNT; i++) {
+            finishSeries(*job, i, result.series[i]);
+        }
+        finishScan(*job, result.scan);
+    }
+    delete job;
+}
+
+/* Analysis of one time chunk of a file. */
+class ChunkTask : public WorkTask
+{
+public:
+    ChunkTask(FileJob *job, int index) : m_job(job), m_index(index) {}
+
+    void run(WorkPool &pool, int worker) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(pool);
+        Q_UNUSED(worker);
+        const qint64 from = m_index * m_job->chunkTime;
+        const qint64 to = (m_index == m_job->parts.size() - 1) ? std::numeric_limits<qint64>::max()
+                                                               : from + m_job->chunkTime;
+        ChunkPart &part = m_job->parts[m_index];
+
+        if (m_job->result->capture) {
+            analyzeCapture(*m_job, from, to, part);
+        } else {
+            analyzeRecording(*m_job, from, to, part);
+        }
+        if (!m_job->remaining.deref()) {
+            finishFile(m_job);
+        }
+    }
+
+private:
+    FileJob *m_job;
+    int m_index;
+};
+
+/* Opens a file and splits it into chunk tasks. */
+class FileTask : public WorkTask
+{
+public:
+    FileTask(FileResult *result, const BatchSettings &settings) : m_result(result), m_settings(settings) {}
+
+    void run(WorkPool &pool, int worker) Q_DECL_OVERRIDE
+    {
+        FileResult &result = *m_result;
+
+        if (result.capture) {
+            CaptureReader reader;
+            if (!reader.open(result.fileName)) {
+                result.error = reader.errorString();
+                return;
+            }
+            result.startTime = reader.startTime();
+            result.duration = reader.duration();
+        } else {
+            RecordingReader reader;
+            if (!reader.open(result.fileName)) {
+                result.error = reader.errorString();
+                return;
+            }
+            result.startTime = reader.startTime();
+            result.duration = reader.duration();
+        }
+
+        FileJob *job = new FileJob;
+        job->result = m_result;
+        job->settings = m_settings;
+        job->chunkTime = qMax((qint64)(m_settings.chunkSeconds * 1e9), (qint64)1);
+        result.chunks = (int)qMin(result.duration / job->chunkTime + 1, (qint64)0x10000);
+        job->parts.resize(result.chunks);
+        for (int i = 0; i < result.chunks; i++) {
+            job->parts[i].ok = false;
+            for (int j = 0; j < BATCH_SERIES_COUNT; j++) {
+                job->parts[i].series[j].frames = 0;
+            }
+        }
+        job->remaining.store(result.chunks);
+
+        /* The last chunk is run here, the others queue on this worker. */
+        for (int i = 0; i < result.chunks - 1; i++) {
+            pool.start(new ChunkTask(job, i), worker);
+        }
+        ChunkTask last(job, result.chunks - 1);
+        last.run(pool, worker);
+    }
+
+private:
+    FileResult *m_result;
+    BatchSettings m_settings;
+};
+
+/**
+ * @brief BatchAnalysis::BatchAnalysis
+ * @param settings - analysis settings.
+ */
+BatchAnalysis::BatchAnalysis(const BatchSettings &settings) :
+    m_settings(settings)
+{
+    // Empty;
+}
+
+/**
+ * @brief BatchAnalysis::findFiles
+ * @param path - file, or directory searched recursively.
+ * @return recordings and captures, sorted by path.
+ */
+QStringList BatchAnalysis::findFiles(const QString &path)
+{
+    QStringList files;
+
+    if (!QFileInfo(path).isDir()) {
+        files.append(path);
+        return files;
+    }
+    QDirIterator it(path, QStringList() << "*.smdrec" << "*.smdbnd" << "*.smdcap", QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        files.append(it.next());
+    }
+    files.sort();
+    return files;
+}
+
+/**
+ * @brief BatchAnalysis::run
+ * @param pool - runs the tasks.
+ * @param files - recordings and captures, told apart by the suffix.
+ * Returns when all files are analyzed, see results().
+ */
+void BatchAnalysis::run(WorkPool &pool, const QStringList &files)
+{
+    m_results.resize(files.size());
+    for (int i = 0; i < files.size(); i++) {
+        FileResult &result = m_results[i];
+        result.fileName = files[i];
+        result.ok = false;
+        result.capture = files[i].endsWith(".smdcap", Qt::CaseInsensitive);
+        result.startTime = 0;
+        result.duration = 0;
+        result.chunks = 0;
+    }
+    /* Results do not move from here on, the tasks write into them. */
+    for (int i = 0; i < files.size(); i++) {
+        pool.start(new FileTask(&m_results[i], m_settings));
+    }
+    pool.waitForDone();
+}
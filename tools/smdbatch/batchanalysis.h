@@ -0,0 +1,88 @@
+#ifndef BATCHANALYSIS_H
+#define BATCHANALYSIS_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "telemetry.h"
+#include "streamstats.h"
+
+/* Series of the 's' and 'r' messages.     */
+#define BATCH_SERIES_STREAM             0
+/* Stream plus the streaming channels.     */
+#define BATCH_SERIES_COUNT              (STREAMING_CHANNEL_COUNT + 1)
+/* Default FFT size in samples.            */
+#define BATCH_FFT_SIZE_DEFAULT          4096
+/* Default time analyzed by one task, s.   */
+#define BATCH_CHUNK_SECONDS_DEFAULT     60.0
+/* Floor of the dB scale.                  */
+#define BATCH_DB_FLOOR                  -200.0
+
+class WorkPool;
+
+/* Names of the series, "stream" then the channel names. */
+extern const char * const batchSeriesNames[BATCH_SERIES_COUNT];
+
+typedef struct tagBatchSettings {
+    int fftSize;            /* Hann window, 50 % overlap, power of two.     */
+    double chunkSeconds;    /* Files are split into tasks of this length.   */
+    double sampleRate;      /* Hz, 0 to estimate it from the timestamps.    */
+    bool spectra;           /* Keep the averaged spectra, not only peaks.   */
+} BatchSettings;
+
+typedef struct tagSeriesResult {
+    StreamStatistics stats; /* count 0 if the file has no such samples.     */
+    double sampleRate;      /* Hz, 0 if unknown.                            */
+    int frames;             /* Averaged FFT frames.                         */
+    double peakHz;          /* Largest bin above DC.                        */
+    double peakDb;
+    QVector<double> spectrum;   /* One-sided amplitude, dB, fftSize / 2 + 1
+                                 * bins, empty unless spectra are kept.     */
+} SeriesResult;
+
+typedef struct tagScanSummary {
+    int sweeps;             /* Complete sweeps of the stream.               */
+    int valid;              /* Sweeps with a zero crossing, the statistics
+                             * below are over these.                        */
+    StreamStatistics peakToPeak;
+    StreamStatistics zeroPosition;
+    StreamStatistics slope;
+    StreamStatistics asymmetry;
+} ScanSummary;
+
+typedef struct tagFileResult {
+    QString fileName;
+    bool ok;
+    QString error;
+    bool capture;           /* Capture, else recording.                     */
+    qint64 startTime;       /* ms since 1970-01-01 UTC.                     */
+    qint64 duration;        /* ns.                                          */
+    int chunks;             /* Tasks the file was split into.               */
+    SeriesResult series[BATCH_SERIES_COUNT];
+    ScanSummary scan;
+} FileResult;
+
+/* Statistics, averaged spectra and scan features of recordings and
+ * captures. Every file is split into time chunks analyzed in parallel on
+ * a WorkPool, the partial results are merged once the last chunk of the
+ * file is done. Moments and spectra merge exactly, the quantiles are
+ * count-weighted means of the chunk estimates. FFT frames do not cross
+ * chunk boundaries, a sweep is analyzed by the chunk of its marker.
+ */
+class BatchAnalysis
+{
+public:
+    BatchAnalysis(const BatchSettings &settings);
+
+    static QStringList findFiles(const QString &path);
+    void run(WorkPool &pool, const QStringList &files);
+    const QVector<FileResult> &results() const { return m_results; }
+    const BatchSettings &settings() const { return m_settings; }
+
+private:
+    BatchSettings m_settings;
+    QVector<FileResult> m_results;
+};
+
+#endif // BATCHANALYSIS_H
@@ -0,0 +1,215 @@
+#include "batchreport.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+/**
+ * @brief quantileName
+ * @return "p50" for the median and so on.
+ */
+static QString quantileName(int i)
+{
+    return QString("p%1").arg(streamStatsQuantiles[i] * 100.0);
+}
+
+/**
+ * @brief statsJson
+ */
+static QJsonObject statsJson(const StreamStatistics &stats)
+{
+    QJsonObject o;
+
+    o["count"] = (double)stats.count;
+    if (stats.count == 0) {
+        return o;
+    }
+    o["mean"] = stats.mean;
+    o["std"] = stats.std;
+    o["rms"] = stats.rms;
+    o["min"] = stats.min;
+    o["max"] = stats.max;
+    for (int i = 0; i < STREAMSTATS_QUANTILES; i++) {
+        o[quantileName(i)] = stats.quantile[i];
+    }
+    return o;
+}
+
+/**
+ * @brief batchReportJson
+ * @param analysis - finished analysis.
+ * @return indented JSON document.
+ */
+QByteArray batchReportJson(const BatchAnalysis &analysis)
+{
+    const BatchSettings &settings = analysis.settings();
+    const QVector<FileResult> &results = analysis.results();
+    QJsonObject root;
+    QJsonArray files;
+
+    QJsonObject s;
+    s["fft_size"] = settings.fftSize;
+    s["window"] = QString("hann");
+    s["overlap_percent"] = 50;
+    s["chunk_seconds"] = settings.chunkSeconds;
+    s["sample_rate_hz"] = settings.sampleRate;
+    root["settings"] = s;
+
+    for (int i = 0; i < results.size(); i++) {
+        const FileResult &r = results[i];
+        QJsonObject f;
+        f["file"] = r.fileName;
+        f["type"] = QString(r.capture ? "capture" : "recording");
+        f["ok"] = r.ok;
+        if (!r.ok) {
+            f["error"] = r.error;
+            files.append(f);
+            continue;
+        }
+        f["start"] = QDateTime::fromMSecsSinceEpoch(r.startTime).toUTC().toString(Qt::ISODate);
+        f["duration_s"] = r.duration * 1e-9;
+        f["chunks"] = r.chunks;
+
+        QJsonObject series;
+        for (int j = 0; j < BATCH_SERIES_COUNT; j++) {
+            const SeriesResult &sr = r.series[j];
+            if (sr.stats.count == 0) {
+                continue;
+            }
+            QJsonObject o;
+            o["stats"] = statsJson(sr.stats);
+            o["sample_rate_hz"] = sr.sampleRate;
+            QJsonObject spectrum;
+            spectrum["frames"] = sr.frames;
+            if (sr.frames) {
+                spectrum["peak_hz"] = sr.peakHz;
+                spectrum["peak_db"] = sr.peakDb;
+                spectrum["bin_hz"] = sr.sampleRate / settings.fftSize;
+            }
+            if (!sr.spectrum.isEmpty()) {
+                QJsonArray db;
+                for (int k = 0; k < sr.spectrum.size(); k++) {
+                    db.append(sr.spectrum[k]);
+                }
+                spectrum["amplitude_db"] = db;
+            }
+            o["spectrum"] = spectrum;
+            series[batchSeriesNames[j]] = o;
+        }
+        f["series"] = series;
+
+        if (!r.capture) {
+            QJsonObject scan;
+            scan["sweeps"] = r.scan.sweeps;
+            scan["valid"] = r.scan.valid;
+            if (r.scan.valid) {
+                scan["peak_to_peak"] = statsJson(r.scan.peakToPeak);
+                scan["zero_position"] = statsJson(r.scan.zeroPosition);
+                scan["slope"] = statsJson(r.scan.slope);
+                scan["asymmetry"] = statsJson(r.scan.asymmetry);
+            }
+            f["scan"] = scan;
+        }
+        files.append(f);
+    }
+    root["files"] = files;
+
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+/**
+ * @brief csvField
+ * @return text quoted if it holds a separator, quote or line break.
+ */
+static QString csvField(const QString &text)
+{
+    if (!text.contains(',') && !text.contains('"') && !text.contains('\n')) {
+        return text;
+    }
+    QString quoted = text;
+    quoted.replace("\"", "\"\"");
+    return "\"" + quoted + "\"";
+}
+
+/**
+ * @brief batchReportCsv
+ * @param analysis - finished analysis.
+ * @return CSV with a header row.
+ */
+QByteArray batchReportCsv(const BatchAnalysis &analysis)
+{
+    const QVector<FileResult> &results = analysis.results();
+    QStringList header;
+    QByteArray out;
+
+    header << "file" << "series" << "duration_s" << "samples" << "sample_rate_hz"
+           << "mean" << "std" << "rms" << "min" << "max";
+    for (int i = 0; i < STREAMSTATS_QUANTILES; i++) {
+        header << quantileName(i);
+    }
+    header << "peak_hz" << "peak_db" << "sweeps" << "valid_sweeps"
+           << "peak_to_peak_mean" << "peak_to_peak_std" << "zero_position_mean" << "zero_position_std"
+           << "slope_mean" << "slope_std" << "asymmetry_mean" << "asymmetry_std" << "error";
+    out.append(header.join(',').toUtf8());
+    out.append('\n');
+
+    for (int i = 0; i < results.size(); i++) {
+        const FileResult &r = results[i];
+        if (!r.ok) {
+            QStringList row;
+            row << csvField(r.fileName);
+            for (int k = 1; k < header.size() - 1; k++) {
+                row << QString();
+            }
+            row << csvField(r.error);
+            out.append(row.join(',').toUtf8());
+            out.append('\n');
+            continue;
+        }
+        for (int j = 0; j < BATCH_SERIES_COUNT; j++) {
+            const SeriesResult &sr = r.series[j];
+            if (sr.stats.count == 0) {
+                continue;
+            }
+            QStringList row;
+            row << csvField(r.fileName) << batchSeriesNames[j] << QString::number(r.duration * 1e-9, 'f', 6)
+                << QString::number(sr.stats.count) << QString::number(sr.sampleRate, 'g', 10)
+                << QString::number(sr.stats.mean, 'g', 10) << QString::number(sr.stats.std, 'g', 10)
+                << QString::number(sr.stats.rms, 'g', 10) << QString::number(sr.stats.min)
+                << QString::number(sr.stats.max);
+            for (int k = 0; k < STREAMSTATS_QUANTILES; k++) {
+                row << QString::number(sr.stats.quantile[k], 'g', 10);
+            }
+            if (sr.frames) {
+                row << QString::number(sr.peakHz, 'g', 10) << QString::number(sr.peakDb, 'f', 2);
+            } else {
+                row << QString() << QString();
+            }
+            if ((j == BATCH_SERIES_STREAM) && !r.capture) {
+                const ScanSummary &scan = r.scan;
+                row << QString::number(scan.sweeps) << QString::number(scan.valid);
+                const StreamStatistics *features[] = {
+                    &scan.peakToPeak, &scan.zeroPosition, &scan.slope, &scan.asymmetry
+                };
+                for (int k = 0; k < 4; k++) {
+                    if (scan.valid) {
+                        row << QString::number(features[k]->mean, 'g', 10)
+                            << QString::number(features[k]->std, 'g', 10);
+                    } else {
+                        row << QString() << QString();
+                    }
+                }
+            } else {
+                for (int k = 0; k < 10; k++) {
+                    row << QString();
+                }
+            }
+            row << QString();
+            out.append(row.join(',').toUtf8());
+            out.append('\n');
+        }
+    }
+    return out;
+}
@@ -0,0 +1,15 @@
+#ifndef BATCHREPORT_H
+#define BATCHREPORT_H
+
+#include <QByteArray>
+
+#include "batchanalysis.h"
+
+/* Reports of a batch analysis. JSON holds everything, one object per
+ * file. CSV has a row per file and series with samples, the scan columns
+ * are filled in the rows of the stream.
+ */
+QByteArray batchReportJson(const BatchAnalysis &analysis);
+QByteArray batchReportCsv(const BatchAnalysis &analysis);
+
+#endif // BATCHREPORT_H
@@ -0,0 +1,89 @@
+#include "batchanalysis.h"
+#include "batchreport.h"
+#include "workpool.h"
+#include "fft.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <stdio.h>
+
+/* Headless batch analysis of recordings and captures, see BatchAnalysis. */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("smdbatch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Statistics, spectra and scan features of SmartMD recordings and captures.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("paths", "Recordings, captures or directories searched recursively.", "paths...");
+    QCommandLineOption formatOption(QStringList() << "f" << "format", "Report format, json or csv.", "format", "json");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Report file, standard output if not given.", "file");
+    QCommandLineOption threadsOption(QStringList() << "j" << "threads", "Worker threads, 0 for one per core.", "n", "0");
+    QCommandLineOption fftOption("fft-size", "FFT size, power of two.", "n", QString::number(BATCH_FFT_SIZE_DEFAULT));
+    QCommandLineOption chunkOption("chunk", "Seconds of a file analyzed by one task.", "s",
+                                   QString::number(BATCH_CHUNK_SECONDS_DEFAULT));
+    QCommandLineOption rateOption("rate", "Sample rate in Hz, estimated from the timestamps if not given.", "hz", "0");
+    QCommandLineOption spectraOption("spectra", "Include the averaged spectra in the JSON report.");
+    parser.addOption(formatOption);
+    parser.addOption(outputOption);
+    parser.addOption(threadsOption);
+    parser.addOption(fftOption);
+    parser.addOption(chunkOption);
+    parser.addOption(rateOption);
+    parser.addOption(spectraOption);
+    parser.process(a);
+
+    const QString format = parser.value(formatOption).toLower();
+    BatchSettings settings;
+    settings.fftSize = parser.value(fftOption).toInt();
+    settings.chunkSeconds = parser.value(chunkOption).toDouble();
+    settings.sampleRate = parser.value(rateOption).toDouble();
+    settings.spectra = parser.isSet(spectraOption);
+    if (parser.positionalArguments().isEmpty() || ((format != "json") && (format != "csv")) ||
+        (settings.fftSize < FFT_SIZE_MIN) || (settings.fftSize > FFT_SIZE_MAX) ||
+        (settings.fftSize & (settings.fftSize - 1)) || (settings.chunkSeconds <= 0.0) ||
+        (settings.sampleRate < 0.0)) {
+        parser.showHelp(1);
+    }
+
+    QStringList files;
+    for (int i = 0; i < parser.positionalArguments().size(); i++) {
+        files.append(BatchAnalysis::findFiles(parser.positionalArguments()[i]));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    WorkPool pool(parser.value(threadsOption).toInt());
+    BatchAnalysis analysis(settings);
+    analysis.run(pool, files);
+
+    const QByteArray report = (format == "csv") ? batchReportCsv(analysis) : batchReportJson(analysis);
+    QFile out;
+    bool opened;
+    if (parser.isSet(outputOption)) {
+        out.setFileName(parser.value(outputOption));
+        opened = out.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    } else {
+        opened = out.open(stdout, QIODevice::WriteOnly);
+    }
+    if (!opened || (out.write(report) != report.size())) {
+        fprintf(stderr, "Can't write the report. %s.\n", qPrintable(out.errorString()));
+        return 1;
+    }
+    out.close();
+
+    int failed = 0;
+    for (int i = 0; i < analysis.results().size(); i++) {
+        if (!analysis.results()[i].ok) {
+            fprintf(stderr, "%s: %s\n", qPrintable(analysis.results()[i].fileName),
+                    qPrintable(analysis.results()[i].error));
+            failed++;
+        }
+    }
+    fprintf(stderr, "%d files, %d failed, %d threads, %lld ms.\n", files.size(), failed,
+            pool.threadCount(), timer.elapsed());
+    return failed ? 2 : 0;
+}
@@ -0,0 +1,39 @@
+#-------------------------------------------------
+#
+# Headless batch analysis of recordings and captures
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = smdbatch
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp\
+        batchanalysis.cpp\
+        batchreport.cpp\
+        ../../workpool.cpp\
+        ../../streamstats.cpp\
+        ../../fft.cpp\
+        ../../scananalyzer.cpp\
+        ../../recordingreader.cpp\
+        ../../capturecodec.cpp\
+        ../../capturereader.cpp
+
+HEADERS  += batchanalysis.h\
+        batchreport.h\
+        ../../workpool.h\
+        ../../telemetry.h\
+        ../../streamstats.h\
+        ../../fft.h\
+        ../../scananalyzer.h\
+        ../../recording.h\
+        ../../recordingreader.h\
+        ../../capturecodec.h\
+        ../../capture.h\
+        ../../capturereader.h
@@ -0,0 +1,134 @@
+#include "capturewriter.h"
+#include "captureview.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <qmath.h>
+#include <stdio.h>
+
+/* Samples of the generated capture.       */
+#define BENCH_SAMPLES_DEFAULT           300000000LL
+/* Sample rate of the generated capture.   */
+#define BENCH_RATE_DEFAULT              1000000.0
+/* Plot width the envelopes are made for.  */
+#define BENCH_PIXELS_DEFAULT            1000
+/* Envelopes timed per zoom level.         */
+#define BENCH_PANS_DEFAULT              20
+
+/**
+ * @brief generate
+ * @param fileName - capture to write.
+ * @param samples - samples of channel FE.
+ * @param rate - sample rate, Hz.
+ * @return false if writing failed.
+ *
+ * A slow sine with a fast one and noise on top, so the chunks do not
+ * compress to nothing and every zoom level has detail.
+ */
+static bool generate(const QString &fileName, qint64 samples, double rate)
+{
+    CaptureWriter writer;
+    qint16 block[STREAMING_BUF_DEPTH];
+    quint32 noise = 1;
+
+    if (!writer.open(fileName, 0)) {
+        fprintf(stderr, "Can't write %s. %s.\n", qPrintable(fileName), qPrintable(writer.errorString()));
+        return false;
+    }
+    for (qint64 n = 0; n < samples; n += STREAMING_BUF_DEPTH) {
+        const int count = (int)qMin((qint64)STREAMING_BUF_DEPTH, samples - n);
+        for (int i = 0; i < count; i++) {
+            const double t = (n + i) / rate;
+            noise = noise * 1664525 + 1013904223;
+            block[i] = (qint16)(8000.0 * qSin(2.0 * M_PI * 0.5 * t) + 2000.0 * qSin(2.0 * M_PI * 1000.0 * t) +
+                                (int)(noise >> 24) - 128);
+        }
+        if (!writer.addSamples(STREAMING_CHANNEL_FE, block, count, (qint64)((n + count) * 1e9 / rate))) {
+            fprintf(stderr, "Can't write %s. %s.\n", qPrintable(fileName), qPrintable(writer.errorString()));
+            return false;
+        }
+    }
+    return writer.close();
+}
+
+/* Times opening a capture and the envelopes the capture viewer draws,
+ * from the whole capture down to single samples.
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("smdcapbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Open and redraw timing of the SmartMD capture viewer.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("capture", "Capture file, generated if it does not exist.");
+    QCommandLineOption samplesOption("samples", "Samples of a generated capture.", "n",
+                                     QString::number(BENCH_SAMPLES_DEFAULT));
+    QCommandLineOption rateOption("rate", "Sample rate of a generated capture, Hz.", "hz",
+                                  QString::number(BENCH_RATE_DEFAULT));
+    QCommandLineOption pixelsOption("pixels", "Plot width in pixels.", "n", QString::number(BENCH_PIXELS_DEFAULT));
+    QCommandLineOption pansOption("pans", "Envelopes timed per zoom level.", "n", QString::number(BENCH_PANS_DEFAULT));
+    parser.addOption(samplesOption);
+    parser.addOption(rateOption);
+    parser.addOption(pixelsOption);
+    parser.addOption(pansOption);
+    parser.process(a);
+
+    const qint64 samples = parser.value(samplesOption).toLongLong();
+    const double rate = parser.value(rateOption).toDouble();
+    const int pixels = parser.value(pixelsOption).toInt();
+    const int pans = parser.value(pansOption).toInt();
+    if ((parser.positionalArguments().size() != 1) || (samples <= 0) || (rate <= 0.0) ||
+        (pixels <= 0) || (pans <= 0)) {
+        parser.showHelp(1);
+    }
+    const QString fileName = parser.positionalArguments()[0];
+
+    QElapsedTimer timer;
+    if (!QFileInfo(fileName).exists()) {
+        timer.start();
+        if (!generate(fileName, samples, rate)) {
+            return 1;
+        }
+        fprintf(stderr, "Generated %lld samples in %lld ms.\n", samples, timer.elapsed());
+    }
+
+    CaptureView view;
+    timer.start();
+    if (!view.open(fileName)) {
+        fprintf(stderr, "Can't open %s. %s.\n", qPrintable(fileName), qPrintable(view.reader().errorString()));
+        return 1;
+    }
+    const double openMs = timer.nsecsElapsed() / 1000000.0;
+    const qint64 count = view.reader().sampleCount(STREAMING_CHANNEL_FE);
+    printf("%s: %.1f MB, %lld samples, opened in %.2f ms\n", qPrintable(fileName),
+           QFileInfo(fileName).size() / (1024.0 * 1024.0), count, openMs);
+    if (count <= 0) {
+        return 0;
+    }
+
+    /* Each level halves the visible span, the pans are spread evenly. */
+    QVector<double> keys, min, max;
+    double worstMs = 0.0;
+    for (double span = count; span >= 1.0; span /= 2.0) {
+        double sumMs = 0.0;
+        double maxMs = 0.0;
+        int points = 0;
+        for (int i = 0; i < pans; i++) {
+            const double first = (count - span) * i / qMax(1, pans - 1);
+            timer.start();
+            points = view.envelope(STREAMING_CHANNEL_FE, first, first + span, pixels, keys, min, max);
+            const double ms = timer.nsecsElapsed() / 1000000.0;
+            sumMs += ms;
+            maxMs = qMax(maxMs, ms);
+        }
+        worstMs = qMax(worstMs, maxMs);
+        printf("span %14.0f samples: %5d points, mean %.3f ms, max %.3f ms\n",
+               span, points, sumMs / pans, maxMs);
+    }
+    printf("slowest envelope %.3f ms\n", worstMs);
+    return 0;
+}
@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Open and redraw timing of the capture viewer
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = smdcapbench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp\
+        ../../capturecodec.cpp\
+        ../../capturewriter.cpp\
+        ../../capturereader.cpp\
+        ../../captureview.cpp
+
+HEADERS  += ../../telemetry.h\
+        ../../capture.h\
+        ../../capturecodec.h\
+        ../../capturewriter.h\
+        ../../capturereader.h\
+        ../../captureview.h
@@ -0,0 +1,247 @@
+#include "streamkernels.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QVector>
+#include <string.h>
+#include <stdio.h>
+
+/* Input samples per kernel call.          */
+#define BENCH_SAMPLES_DEFAULT           65536
+/* Timed calls per kernel and parameter.   */
+#define BENCH_REPEATS_DEFAULT           200
+/* Channels of the multi-channel stream.   */
+#define BENCH_CHANNELS_MAX              8
+/* Random limits checked by findRange.     */
+#define BENCH_RANGE_CASES               256
+
+/* Decimation ratios timed, the odd ones only take the scalar tails. */
+static const int benchRatios[] = { 2, 3, 4, 8, 16, 24, 32, 64, 256 };
+/* Kernel variants, scalar first as the reference. */
+static const char *const benchKernels[] = { "scalar", "sse2", "avx2" };
+
+/* Outputs of one kernel variant, compared bit for bit against scalar. */
+typedef struct tagKernelResults {
+    QVector<QVector<double> > boxcar;           /* Per ratio.               */
+    QVector<int> findRange;                     /* Per case.                */
+    QVector<QVector<qint16> > deinterleave;     /* Per channel count.       */
+} KernelResults;
+
+/**
+ * @brief nextNoise
+ * @param state - generator state.
+ * @return next sample of a full scale linear congruential noise.
+ */
+static qint16 nextNoise(quint32 &state)
+{
+    state = state * 1664525 + 1013904223;
+    return (qint16)(state >> 16);
+}
+
+/**
+ * @brief nsPerSample
+ * @param ns - elapsed time.
+ * @param samples - samples per call.
+ * @param repeats - calls timed.
+ */
+static double nsPerSample(qint64 ns, int samples, int repeats)
+{
+    return (double)ns / ((double)samples * repeats);
+}
+
+/**
+ * @brief runBoxcar
+ * @param in - input samples, starts unaligned on purpose.
+ * @param samples - input samples.
+ * @param repeats - timed calls per ratio.
+ * @param results - set to the outputs per ratio.
+ *
+ * One group less than fits is averaged, so every ratio has a tail.
+ */
+static void runBoxcar(const qint16 *in, int samples, int repeats, KernelResults &results)
+{
+    QElapsedTimer timer;
+
+    results.boxcar.clear();
+    for (size_t r = 0; r < sizeof(benchRatios) / sizeof(benchRatios[0]); r++) {
+        const int ratio = benchRatios[r];
+        const int groups = samples / ratio - 1;
+        QVector<double> out(qMax(groups, 0));
+
+        timer.start();
+        for (int i = 0; i < repeats; i++) {
+            streamBoxcar(in, groups, ratio, out.data());
+        }
+        printf("  boxcar       ratio %3d: %.3f ns/sample\n", ratio,
+               nsPerSample(timer.nsecsElapsed(), groups * ratio, repeats));
+        results.boxcar.append(out);
+    }
+}
+
+/**
+ * @brief runFindRange
+ * @param in - input samples.
+ * @param samples - input samples.
+ * @param repeats - timed calls.
+ * @param results - set to the index found per case.
+ *
+ * The timed search spans the whole input without a hit, as a trigger
+ * waiting for its level does. The cases then place a single hit at every
+ * lane of the first vectors and the tail, and search the noise with
+ * random limits from unaligned starts.
+ */
+static void runFindRange(const qint16 *in, int samples, int repeats, KernelResults &results)
+{
+    QElapsedTimer timer;
+    int found = 0;
+
+    timer.start();
+    for (int i = 0; i < repeats; i++) {
+        found += streamFindRange(in, samples, -32768, 32767, false);
+    }
+    printf("  findRange    no hit   : %.3f ns/sample\n", nsPerSample(timer.nsecsElapsed(), samples, repeats));
+    results.findRange.clear();
+    results.findRange.append(found);
+
+    QVector<qint16> flat(64, 0);
+    for (int hit = 0; hit < flat.size(); hit++) {
+        flat[hit] = 1000;
+        results.findRange.append(streamFindRange(flat.constData(), flat.size(), 500, 2000, true));
+        results.findRange.append(streamFindRange(flat.constData(), flat.size(), -100, 100, false));
+        results.findRange.append(streamFindRange(flat.constData(), hit, 500, 2000, true));
+        flat[hit] = 0;
+    }
+
+    quint32 state = 12345;
+    for (int i = 0; i < BENCH_RANGE_CASES; i++) {
+        const qint16 a = nextNoise(state);
+        const qint16 b = nextNoise(state);
+        const int first = (quint16)nextNoise(state) % samples;
+        results.findRange.append(streamFindRange(in + first, samples - first, qMin(a, b), qMax(a, b),
+                                                 (i & 1) != 0));
+    }
+}
+
+/**
+ * @brief runDeinterleave
+ * @param in - interleaved input samples.
+ * @param samples - input samples.
+ * @param repeats - timed calls per channel count.
+ * @param results - set to the channels, concatenated, per channel count.
+ *
+ * One frame less than fits is split, so every channel count has a tail.
+ */
+static void runDeinterleave(const qint16 *in, int samples, int repeats, KernelResults &results)
+{
+    QElapsedTimer timer;
+
+    results.deinterleave.clear();
+    for (int channels = 1; channels <= BENCH_CHANNELS_MAX; channels++) {
+        const int frames = samples / channels - 1;
+        QVector<qint16> out(frames * channels);
+        qint16 *dest[BENCH_CHANNELS_MAX];
+        for (int c = 0; c < channels; c++) {
+            dest[c] = out.data() + c * frames;
+        }
+
+        timer.start();
+        for (int i = 0; i < repeats; i++) {
+            streamDeinterleave(in, frames, channels, dest);
+        }
+        printf("  deinterleave channels %d: %.3f ns/sample\n", channels,
+               nsPerSample(timer.nsecsElapsed(), frames * channels, repeats));
+        results.deinterleave.append(out);
+    }
+}
+
+/**
+ * @brief compare
+ * @param results - outputs of a SIMD variant.
+ * @param reference - outputs of the scalar kernels.
+ * @return number of mismatching outputs, printed as they are found.
+ */
+static int compare(const KernelResults &results, const KernelResults &reference)
+{
+    int mismatches = 0;
+
+    for (int r = 0; r < reference.boxcar.size(); r++) {
+        const QVector<double> &a = results.boxcar[r];
+        const QVector<double> &b = reference.boxcar[r];
+        if (memcmp(a.constData(), b.constData(), b.size() * sizeof(double)) != 0) {
+            printf("  MISMATCH boxcar ratio %d\n", benchRatios[r]);
+            mismatches++;
+        }
+    }
+    for (int i = 0; i < reference.findRange.size(); i++) {
+        if (results.findRange[i] != reference.findRange[i]) {
+            printf("  MISMATCH findRange case %d: %d, scalar %d\n", i,
+                   results.findRange[i], reference.findRange[i]);
+            mismatches++;
+        }
+    }
+    for (int c = 0; c < reference.deinterleave.size(); c++) {
+        if (results.deinterleave[c] != reference.deinterleave[c]) {
+            printf("  MISMATCH deinterleave channels %d\n", c + 1);
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+/* Times the boxcar, findRange and deinterleave kernels of every variant
+ * this CPU runs, and checks the SIMD outputs bit for bit against scalar.
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("smdkernelbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Timing and cross-check of the SmartMD stream kernels.");
+    parser.addHelpOption();
+    QCommandLineOption samplesOption("samples", "Input samples per kernel call.", "n",
+                                     QString::number(BENCH_SAMPLES_DEFAULT));
+    QCommandLineOption repeatsOption("repeats", "Timed calls per kernel and parameter.", "n",
+                                     QString::number(BENCH_REPEATS_DEFAULT));
+    parser.addOption(samplesOption);
+    parser.addOption(repeatsOption);
+    parser.process(a);
+
+    const int samples = parser.value(samplesOption).toInt();
+    const int repeats = parser.value(repeatsOption).toInt();
+    if (!parser.positionalArguments().isEmpty() || (samples < 1024) || (repeats <= 0)) {
+        parser.showHelp(1);
+    }
+
+    /* One spare sample so the kernels start off the vector alignment. */
+    QVector<qint16> noise(samples + 1);
+    quint32 state = 1;
+    for (int i = 0; i < noise.size(); i++) {
+        noise[i] = nextNoise(state);
+    }
+    const qint16 *in = noise.constData() + 1;
+
+    KernelResults reference;
+    int mismatches = 0;
+    for (size_t k = 0; k < sizeof(benchKernels) / sizeof(benchKernels[0]); k++) {
+        if (!streamKernelSelect(benchKernels[k])) {
+            printf("%s: not supported by this CPU\n", benchKernels[k]);
+            continue;
+        }
+        printf("%s:\n", streamKernelName());
+
+        KernelResults results;
+        runBoxcar(in, samples, repeats, results);
+        runFindRange(in, samples, repeats, results);
+        runDeinterleave(in, samples, repeats, results);
+        if (k == 0) {
+            reference = results;
+        } else {
+            const int count = compare(results, reference);
+            printf("  %s\n", count ? "differs from scalar" : "matches scalar bit for bit");
+            mismatches += count;
+        }
+    }
+    return mismatches ? 1 : 0;
+}
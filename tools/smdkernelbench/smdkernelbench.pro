@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# Timing and cross-check of the stream kernels
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = smdkernelbench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp\
+        ../../streamkernels.cpp
+
+HEADERS  += ../../streamkernels.h
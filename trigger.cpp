@@ -0,0 +1,310 @@
+#include "trigger.h"
+#include "streamkernels.h"
+
+#include <qmath.h>
+
+/**
+ * @brief Trigger::Trigger
+ */
+Trigger::Trigger() :
+    m_sampleCnt(0),
+    m_pulseStart(0),
+    m_postRemaining(0)
+{
+    Settings settings;
+
+    settings.mode = ModeAuto;
+    settings.condition = ConditionEdge;
+    settings.slope = SlopeRising;
+    settings.level = 0.0;
+    settings.levelHigh = 0.0;
+    settings.hysteresis = 0.0;
+    settings.widthMin = 0;
+    settings.widthMax = TRIGGER_SAMPLES_MAX;
+    settings.preSamples = 0;
+    settings.postSamples = 1;
+    settings.autoSamples = TRIGGER_SAMPLES_MAX;
+    setSettings(settings);
+}
+
+/**
+ * @brief Trigger::setSettings
+ * @param settings - new trigger settings. Pending captures are dropped and
+ * the trigger is armed again.
+ *
+ * Every condition is a sequence of range searches. The signal first has
+ * to pass the hysteresis band (arm range), then the trigger range; a pulse
+ * additionally has to come back to the arm range (end range).
+ */
+void Trigger::setSettings(const Settings &settings)
+{
+    const double h = qMax(0.0, settings.hysteresis);
+    const double lo = qMin(settings.level, settings.levelHigh);
+    const double hi = qMax(settings.level, settings.levelHigh);
+    const bool rising = (settings.slope == SlopeRising);
+
+    m_settings = settings;
+    m_settings.widthMin = qMax(0, settings.widthMin);
+    m_settings.widthMax = qMax(m_settings.widthMin, settings.widthMax);
+    m_settings.preSamples = qBound(0, settings.preSamples, TRIGGER_SAMPLES_MAX);
+    m_settings.postSamples = qBound(1, settings.postSamples, TRIGGER_SAMPLES_MAX);
+    m_settings.autoSamples = qMax(1, settings.autoSamples);
+
+    if (settings.condition == ConditionWindow) {
+        if (rising) {
+            m_armRange.lo = lo + h;
+            m_armRange.hi = hi - h;
+            m_armRange.inside = true;
+            m_fireRange.lo = lo;
+            m_fireRange.hi = hi;
+            m_fireRange.inside = false;
+        } else {
+            m_armRange.lo = lo - h;
+            m_armRange.hi = hi + h;
+            m_armRange.inside = false;
+            m_fireRange.lo = lo;
+            m_fireRange.hi = hi;
+            m_fireRange.inside = true;
+        }
+    } else {
+        m_armRange.lo = rising ? -HUGE_VAL : settings.level + h;
+        m_armRange.hi = rising ? settings.level - h : HUGE_VAL;
+        m_armRange.inside = true;
+        m_fireRange.lo = rising ? settings.level : -HUGE_VAL;
+        m_fireRange.hi = rising ? HUGE_VAL : settings.level;
+        m_fireRange.inside = true;
+    }
+    m_endRange = m_armRange;
+
+    m_history.fill(0.0, m_settings.preSamples);
+    m_historyPos = 0;
+    m_historyFill = 0;
+    m_captures.clear();
+    arm();
+}
+
+/**
+ * @brief Trigger::arm
+ * Starts looking for the trigger condition, also after a single capture.
+ */
+void Trigger::arm()
+{
+    m_state = StateArm;
+    m_armedAt = m_sampleCnt;
+    m_capture.samples.clear();
+}
+
+/**
+ * @brief Trigger::process
+ * @param samples - raw stream samples.
+ * @param count - number of samples.
+ */
+void Trigger::process(const qint16 *samples, int count)
+{
+    processSamples(samples, count);
+}
+
+/**
+ * @brief Trigger::process
+ * @param samples - filtered stream samples.
+ * @param count - number of samples.
+ */
+void Trigger::process(const double *samples, int count)
+{
+    processSamples(samples, count);
+}
+
+/**
+ * @brief Trigger::takeCapture
+ * @param capture - receives the oldest completed capture.
+ * @return false if there is no completed capture.
+ */
+bool Trigger::takeCapture(Capture &capture)
+{
+    if (m_captures.isEmpty()) {
+        return false;
+    }
+    capture = m_captures.first();
+    m_captures.remove(0);
+    return true;
+}
+
+/**
+ * @brief Trigger::processSamples
+ * Samples are not tested one by one, each state searches the block for
+ * the first sample of its range and jumps there.
+ */
+template <typename T>
+void Trigger::processSamples(const T *samples, int count)
+{
+    int pos = 0;
+
+    while ((pos < count) && (m_state != StateStopped)) {
+        if (m_state == StateCapture) {
+            int take = qMin(count - pos, m_postRemaining);
+            for (int i = 0; i < take; i++) {
+                m_capture.samples.append(samples[pos + i]);
+            }
+            pos += take;
+            m_postRemaining -= take;
+            if (m_postRemaining == 0) {
+                finishCapture();
+                m_armedAt = m_sampleCnt + pos;
+            }
+            continue;
+        }
+
+        int limit = count - pos;
+        bool timeout = false;
+        if (m_settings.mode == ModeAuto) {
+            qint64 remaining = m_armedAt + m_settings.autoSamples - (m_sampleCnt + pos);
+            if (remaining <= limit) {
+                limit = (int)qMax(Q_INT64_C(0), remaining);
+                timeout = true;
+            }
+        }
+
+        const Range &range = (m_state == StateArm) ? m_armRange :
+                             (m_state == StateFire) ? m_fireRange : m_endRange;
+        int i = find(samples + pos, limit, range);
+        pos += i;
+        if (i == limit) {
+            if (timeout) {
+                startCapture(samples, pos, true);
+            }
+            continue;
+        }
+
+        switch (m_state) {
+        case StateArm:
+            m_state = StateFire;
+            pos++;
+            break;
+        case StateFire:
+            if (m_settings.condition == ConditionPulseWidth) {
+                m_pulseStart = m_sampleCnt + pos;
+                m_state = StatePulse;
+                pos++;
+            } else {
+                startCapture(samples, pos, false);
+            }
+            break;
+        default: {
+            qint64 width = m_sampleCnt + pos - m_pulseStart;
+            if ((width >= m_settings.widthMin) && (width <= m_settings.widthMax)) {
+                startCapture(samples, pos, false);
+            } else {
+                /* The end of a pulse is already past the hysteresis. */
+                m_state = StateFire;
+                pos++;
+            }
+            break;
+        }
+        }
+    }
+
+    appendHistory(samples, count);
+    m_sampleCnt += count;
+}
+
+/**
+ * @brief Trigger::startCapture
+ * @param samples - current block.
+ * @param pos - trigger sample in the block, the first post-trigger sample.
+ * @param forced - capture started by the auto timeout.
+ */
+template <typename T>
+void Trigger::startCapture(const T *samples, int pos, bool forced)
+{
+    const int cap = m_history.size();
+    const int fromBlock = qMin(pos, m_settings.preSamples);
+    const int fromHistory = qMin(m_settings.preSamples - fromBlock, m_historyFill);
+
+    m_capture.samples.clear();
+    m_capture.samples.reserve(fromHistory + fromBlock + m_settings.postSamples);
+    for (int i = 0, k = (m_historyPos - fromHistory + cap) % qMax(cap, 1); i < fromHistory; i++) {
+        m_capture.samples.append(m_history[k]);
+        if (++k == cap) {
+            k = 0;
+        }
+    }
+    for (int i = pos - fromBlock; i < pos; i++) {
+        m_capture.samples.append(samples[i]);
+    }
+    m_capture.preSamples = fromHistory + fromBlock;
+    m_capture.forced = forced;
+    m_postRemaining = m_settings.postSamples;
+    m_state = StateCapture;
+}
+
+/**
+ * @brief Trigger::appendHistory
+ * Keeps the latest preSamples samples for the next capture.
+ */
+template <typename T>
+void Trigger::appendHistory(const T *samples, int count)
+{
+    const int cap = m_history.size();
+    double *history = m_history.data();
+
+    if (cap == 0) {
+        return;
+    }
+    if (count > cap) {
+        samples += count - cap;
+        count = cap;
+    }
+    for (int i = 0; i < count; i++) {
+        history[m_historyPos] = samples[i];
+        if (++m_historyPos == cap) {
+            m_historyPos = 0;
+        }
+    }
+    m_historyFill = qMin(cap, m_historyFill + count);
+}
+
+/**
+ * @brief Trigger::finishCapture
+ */
+void Trigger::finishCapture()
+{
+    if (m_captures.size() == TRIGGER_CAPTURES_MAX) {
+        /* Nobody takes them, keep the latest. */
+        m_captures.remove(0);
+    }
+    m_captures.append(m_capture);
+    m_capture.samples = QVector<double>();
+    m_state = (m_settings.mode == ModeSingle) ? StateStopped : StateArm;
+}
+
+/**
+ * @brief Trigger::find
+ * Limits are rounded inwards to the integer sample grid and handed to the
+ * vectorized search.
+ */
+int Trigger::find(const qint16 *samples, int count, const Range &range)
+{
+    double lo = qMax(range.lo, -32768.0);
+    double hi = qMin(range.hi, 32767.0);
+
+    lo = qCeil(lo);
+    hi = qFloor(hi);
+    if (lo > hi) {
+        /* Empty range, every sample is outside of it. */
+        return range.inside ? count : 0;
+    }
+    return streamFindRange(samples, count, (qint16)lo, (qint16)hi, range.inside);
+}
+
+/**
+ * @brief Trigger::find
+ */
+int Trigger::find(const double *samples, int count, const Range &range)
+{
+    for (int i = 0; i < count; i++) {
+        if (((samples[i] >= range.lo) && (samples[i] <= range.hi)) == range.inside) {
+            return i;
+        }
+    }
+    return count;
+}
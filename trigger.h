@@ -0,0 +1,103 @@
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <QVector>
+
+/* Maximum pre- or post-trigger length.    */
+#define TRIGGER_SAMPLES_MAX             (1 << 20)
+/* Completed captures kept until taken.    */
+#define TRIGGER_CAPTURES_MAX            4
+
+class Trigger
+{
+public:
+    enum Mode {
+        ModeNormal = 0, /* Capture on every trigger.                       */
+        ModeAuto,       /* Like normal, forced capture after a timeout.    */
+        ModeSingle      /* Stop after the first capture until armed again. */
+    };
+
+    enum Condition {
+        ConditionEdge = 0,
+        ConditionWindow,    /* Rising: leaves the window, falling: enters it. */
+        ConditionPulseWidth /* Rising: positive pulse, falling: negative one. */
+    };
+
+    enum Slope {
+        SlopeRising = 0,
+        SlopeFalling
+    };
+
+    typedef struct tagSettings {
+        Mode mode;
+        Condition condition;
+        Slope slope;
+        double level;       /* Edge and pulse level, lower window limit. */
+        double levelHigh;   /* Upper window limit.                       */
+        double hysteresis;
+        int widthMin;       /* Accepted pulse widths, samples.           */
+        int widthMax;
+        int preSamples;
+        int postSamples;
+        int autoSamples;    /* Auto mode timeout, samples.               */
+    } Settings;
+
+    typedef struct tagCapture {
+        QVector<double> samples;
+        int preSamples;     /* Index of the trigger sample.              */
+        bool forced;        /* Auto mode timeout, not a trigger.         */
+    } Capture;
+
+    Trigger();
+
+    void setSettings(const Settings &settings);
+    const Settings &settings() const { return m_settings; }
+    void arm();
+    bool isStopped() const { return m_state == StateStopped; }
+
+    void process(const qint16 *samples, int count);
+    void process(const double *samples, int count);
+    bool takeCapture(Capture &capture);
+
+private:
+    enum State {
+        StateArm = 0,   /* Waiting for the signal to pass the hysteresis. */
+        StateFire,      /* Waiting for the trigger condition.             */
+        StatePulse,     /* Inside a pulse, waiting for its end.           */
+        StateCapture,   /* Collecting post-trigger samples.               */
+        StateStopped
+    };
+
+    /* Search target of a state, a sample inside or outside [lo, hi]. */
+    typedef struct tagRange {
+        double lo;
+        double hi;
+        bool inside;
+    } Range;
+
+    template <typename T> void processSamples(const T *samples, int count);
+    template <typename T> void startCapture(const T *samples, int pos, bool forced);
+    template <typename T> void appendHistory(const T *samples, int count);
+    void finishCapture();
+
+    static int find(const qint16 *samples, int count, const Range &range);
+    static int find(const double *samples, int count, const Range &range);
+
+private:
+    Settings m_settings;
+    Range m_armRange;
+    Range m_fireRange;
+    Range m_endRange;       /* End of a pulse. */
+    State m_state;
+    qint64 m_sampleCnt;     /* Samples processed since the last reset.   */
+    qint64 m_armedAt;       /* Start of the current auto timeout.        */
+    qint64 m_pulseStart;
+    QVector<double> m_history;  /* Ring of the latest preSamples samples. */
+    int m_historyPos;
+    int m_historyFill;
+    Capture m_capture;
+    int m_postRemaining;
+    QVector<Capture> m_captures;
+};
+
+#endif // TRIGGER_H
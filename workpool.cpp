@@ -0,0 +1,147 @@
+#include "workpool.h"
+
+/**
+ * @brief WorkPool::WorkPool
+ * @param threads - number of workers, 0 for one per core.
+ */
+WorkPool::WorkPool(int threads) :
+    m_queued(0),
+    m_pending(0),
+    m_next(0),
+    m_quit(false)
+{
+    if (threads <= 0) {
+        threads = qMax(QThread::idealThreadCount(), 1);
+    }
+    for (int i = 0; i < threads; i++) {
+        m_threads.append(new Worker(this, i));
+    }
+    for (int i = 0; i < threads; i++) {
+        m_threads[i]->start();
+    }
+}
+
+/**
+ * @brief WorkPool::~WorkPool
+ * Waits for the queued tasks.
+ */
+WorkPool::~WorkPool()
+{
+    waitForDone();
+
+    m_mutex.lock();
+    m_quit = true;
+    m_wake.wakeAll();
+    m_mutex.unlock();
+
+    for (int i = 0; i < m_threads.size(); i++) {
+        m_threads[i]->wait();
+        delete m_threads[i];
+    }
+}
+
+/**
+ * @brief WorkPool::start
+ * @param task - task to run, owned by the pool.
+ * @param worker - index of the calling worker, -1 outside of the pool.
+ * Tasks from outside are spread over the queues in turn.
+ */
+void WorkPool::start(WorkTask *task, int worker)
+{
+    m_mutex.lock();
+    if (worker < 0) {
+        worker = m_next;
+        m_next = (m_next + 1) % m_threads.size();
+    }
+    m_queued++;
+    m_pending++;
+    m_mutex.unlock();
+
+    Worker *w = m_threads[worker];
+    w->mutex.lock();
+    w->tasks.append(task);
+    w->mutex.unlock();
+
+    m_mutex.lock();
+    m_wake.wakeOne();
+    m_mutex.unlock();
+}
+
+/**
+ * @brief WorkPool::waitForDone
+ * @param ms - longest wait, ms.
+ * @return true once all tasks, including the ones they started, are
+ * done, false if the time ran out.
+ */
+bool WorkPool::waitForDone(unsigned long ms)
+{
+    QMutexLocker locker(&m_mutex);
+
+    while (m_pending) {
+        if (!m_done.wait(&m_mutex, ms)) {
+            return m_pending == 0;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief WorkPool::take
+ * @param worker - index of the calling worker.
+ * @return newest task of the own queue, else the oldest task of another
+ * queue, 0 if all are empty.
+ */
+WorkTask *WorkPool::take(int worker)
+{
+    WorkTask *task = 0;
+    Worker *w = m_threads[worker];
+
+    w->mutex.lock();
+    if (!w->tasks.isEmpty()) {
+        task = w->tasks.takeLast();
+    }
+    w->mutex.unlock();
+
+    for (int i = 1; !task && (i < m_threads.size()); i++) {
+        Worker *victim = m_threads[(worker + i) % m_threads.size()];
+        victim->mutex.lock();
+        if (!victim->tasks.isEmpty()) {
+            task = victim->tasks.takeFirst();
+        }
+        victim->mutex.unlock();
+    }
+    return task;
+}
+
+/**
+ * @brief WorkPool::Worker::run
+ */
+void WorkPool::Worker::run()
+{
+    forever {
+        m_pool->m_mutex.lock();
+        while (!m_pool->m_queued && !m_pool->m_quit) {
+            m_pool->m_wake.wait(&m_pool->m_mutex);
+        }
+        if (!m_pool->m_queued) {
+            m_pool->m_mutex.unlock();
+            return;
+        }
+        /* Claim a task, it is in a queue or about to be. */
+        m_pool->m_queued--;
+        m_pool->m_mutex.unlock();
+
+        WorkTask *task;
+        while (!(task = m_pool->take(m_index))) {
+            yieldCurrentThread();
+        }
+        task->run(*m_pool, m_index);
+        delete task;
+
+        m_pool->m_mutex.lock();
+        if (--m_pool->m_pending == 0) {
+            m_pool->m_done.wakeAll();
+        }
+        m_pool->m_mutex.unlock();
+    }
+}
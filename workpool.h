@@ -0,0 +1,64 @@
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QList>
+
+class WorkPool;
+
+/* Unit of work, deleted by the pool after run(). */
+class WorkTask
+{
+public:
+    virtual ~WorkTask() {}
+    /* worker - index of the running worker, for WorkPool::start(). */
+    virtual void run(WorkPool &pool, int worker) = 0;
+};
+
+/* Work-stealing thread pool. Each worker has its own task queue, tasks
+ * started by a worker go to the back of its queue and are taken from
+ * there, so the pieces of a task stay on the core that split it. An idle
+ * worker steals from the front of the other queues, the oldest and
+ * largest tasks.
+ */
+class WorkPool
+{
+public:
+    WorkPool(int threads = 0);
+    ~WorkPool();
+
+    int threadCount() const { return m_threads.size(); }
+    void start(WorkTask *task, int worker = -1);
+    bool waitForDone(unsigned long ms = ULONG_MAX);
+
+private:
+    class Worker : public QThread
+    {
+    public:
+        Worker(WorkPool *pool, int index) : m_pool(pool), m_index(index) {}
+        QMutex mutex;
+        QList<WorkTask *> tasks;
+    protected:
+        void run() Q_DECL_OVERRIDE;
+    private:
+        WorkPool *m_pool;
+        int m_index;
+    };
+
+    WorkTask *take(int worker);
+
+private:
+    QVector<Worker *> m_threads;
+    QMutex m_mutex;
+    QWaitCondition m_wake;      /* A task was queued or the pool quits. */
+    QWaitCondition m_done;      /* No task is queued or running.        */
+    int m_queued;               /* Queued tasks not yet claimed.        */
+    int m_pending;              /* Queued and running tasks.            */
+    int m_next;                 /* Queue of the next outside task.      */
+    bool m_quit;
+};
+
+#endif // WORKPOOL_H